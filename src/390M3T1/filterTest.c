@@ -35,6 +35,7 @@
 #endif
 #include "src/390M3T1/histogram.h"
 #include "supportFiles/utils.h"
+#include "supportFiles/globalTimer.h"
 #include <stdio.h>
 #include <math.h>
  
@@ -87,6 +88,17 @@ void filterTest_init() {
 bool filterTest_floatingPointEqual(double a, double b) {
   return fabs(a-b) < TEST_FILTER_FLOATING_POINT_EPSILON;
 }
+
+// Compares a power from filter_iirFilterBank() with the expected one. With FILTER_BANK_SINGLE_PRECISION
+// the bank's biquads run in float32 lanes (see filter.h), so it is allowed a relative error.
+#define TEST_FILTER_BANK_RELATIVE_EPSILON 1.0E-4
+bool filterTest_bankPowerEqual(double expected, double actual) {
+#ifdef FILTER_BANK_SINGLE_PRECISION
+  return fabs(expected-actual) <= TEST_FILTER_BANK_RELATIVE_EPSILON * fabs(expected) + TEST_FILTER_FLOATING_POINT_EPSILON;
+#else
+  return filterTest_floatingPointEqual(expected, actual);
+#endif
+}
  
 // Returns the value most recently added to the queue.
 // Returns 0 if the queue was empty but does not report an error.
@@ -412,7 +424,7 @@ void filterTest_runSquareWaveIirPowerTest(uint16_t filterNumber, bool printMessa
     double power = 0.0;
     filterTest_fillQueue(filter_getXQueue(), 0.0);              // zero out the x-queue.
     filterTest_fillQueue(filter_getYQueue(), 0.0);              // zero out the x-queue.
-    filterTest_fillQueue(filter_getZQueue(filterNumber), 0.0);  // zero out the z-queue for the IIR filter under test.
+    filter_clearIirState(filterNumber);                         // zero out the z-queue (and biquad state) for the IIR filter under test.
     uint16_t currentPeriodTickCount = filterTest_firTestTickCounts[testPeriodIndex];              // You will be generating a frequency with this period.
     uint32_t totalTickCount = 0;  // Keep track of where you are in the given period.
     while (totalTickCount < FILTER_TEST_PULSE_WIDTH_LENGTH) { // Generate a pulse-width of periods.
@@ -712,6 +724,264 @@ bool filterTest_runPowerTest() {
   return firstComputeStatus & incrementalComputeStatus;
 }
  
+/******************************************************************************************
+ ********************** IIR response check against the direct form *************************
+ ******************************************************************************************/
+
+#define FILTER_TEST_RESPONSE_TOLERANCE 1.0E-4  // Largest allowed difference between normalized responses.
+#define IIR_REFERENCE_MAX_COEFFICIENT_COUNT 11  // Holds the B (11) and A (10) histories of the reference filter.
+
+// 10th-order direct-form I reference built straight from filter_getIirA/BCoefficientArray().
+// y[] and z[] hold the filter history, newest value last.
+static double filterTest_directFormIirFilter(uint16_t filterNumber, double newInput, double y[], double z[]) {
+  const double* b = filter_getIirBCoefficientArray(filterNumber);
+  const double* a = filter_getIirACoefficientArray(filterNumber);
+  uint32_t bCount = filter_getIirBCoefficientCount();
+  uint32_t aCount = filter_getIirACoefficientCount();
+  for (uint32_t i = 0; i < bCount-1; i++)  // Shift in the new input.
+    y[i] = y[i+1];
+  y[bCount-1] = newInput;
+  double output = 0.0;
+  for (uint32_t i = 0; i < bCount; i++)
+    output += b[i] * y[bCount-1-i];
+  for (uint32_t i = 0; i < aCount; i++)
+    output -= a[i] * z[aCount-1-i];
+  for (uint32_t i = 0; i < aCount-1; i++)  // Shift in the new output.
+    z[i] = z[i+1];
+  z[aCount-1] = output;
+  return output;
+}
+
+// Computes the same square-wave response that filterTest_runSquareWaveIirPowerTest() plots, once with
+// filter_iirFilter() (direct form or biquads, depending on FILTER_IIR_USE_SOS) and once with the direct-form
+// reference above, and compares the normalized responses. Returns true if they agree.
+bool filterTest_runIirResponseComparisonTest(uint16_t filterNumber, bool printMessageFlag) {
+  if (!filterTest_initFlag) {
+    printf("Must call filterTest_init() before running any filter tests.\n\r");
+    return false;
+  }
+  double filterPower[FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT];
+  double referencePower[FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT];
+  for (uint16_t testPeriodIndex=0; testPeriodIndex<FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT; testPeriodIndex++) {
+    double y[IIR_REFERENCE_MAX_COEFFICIENT_COUNT] = {0.0};  // Reference history.
+    double z[IIR_REFERENCE_MAX_COEFFICIENT_COUNT] = {0.0};
+    filterPower[testPeriodIndex] = 0.0;
+    referencePower[testPeriodIndex] = 0.0;
+    filterTest_fillQueue(filter_getXQueue(), 0.0);
+    filterTest_fillQueue(filter_getYQueue(), 0.0);
+    filter_clearIirState(filterNumber);
+    uint16_t currentPeriodTickCount = filterTest_firTestTickCounts[testPeriodIndex];
+    for (uint32_t totalTickCount = 0; totalTickCount < FILTER_TEST_PULSE_WIDTH_LENGTH; totalTickCount++) {
+      filter_addNewInput(computeFilterInput(totalTickCount % currentPeriodTickCount, currentPeriodTickCount));
+      if (filterTest_decimatingFirFilter()) {
+        double output = filter_iirFilter(filterNumber);
+        double referenceOutput = filterTest_directFormIirFilter(filterNumber,
+            filterTest_readMostRecentValueFromQueue(filter_getYQueue()), y, z);
+        filterPower[testPeriodIndex] += output * output;
+        referencePower[testPeriodIndex] += referenceOutput * referenceOutput;
+      }
+    }
+  }
+  double normalizedFilterPower[FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT];
+  double normalizedReferencePower[FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT];
+  filterTest_normalizeArrayValues(normalizedFilterPower, filterPower, FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT);
+  filterTest_normalizeArrayValues(normalizedReferencePower, referencePower, FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT);
+  double worstDifference = 0.0;
+  for (uint16_t i=0; i<FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT; i++) {
+    double difference = fabs(normalizedFilterPower[i] - normalizedReferencePower[i]);
+    if (difference > worstDifference)
+      worstDifference = difference;
+  }
+  bool success = worstDifference < FILTER_TEST_RESPONSE_TOLERANCE;
+  if (printMessageFlag || !success) {
+    printf("IIR filter %d response vs. direct form: worst normalized difference %le (%s).\n\r",
+        filterNumber, worstDifference, success ? "ok" : "FAILED");
+  }
+  return success;
+}
+
+/******************************************************************************************
+ ************************* Kernel cycle-count microbenchmark *******************************
+ ******************************************************************************************/
+
+#define FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES 1000  // Number of decimated samples timed per kernel.
+#define FILTER_TEST_CPU_CYCLES_PER_GLOBAL_TIMER_TICK 2  // The global timer runs at half the CPU clock.
+
+// The FIR kernel as it was before the delay lines were mirrored: one queue_readElementAt() per tap.
+static double filterTest_perTapFirFilter() {
+  const double* coefficients = filter_getFirCoefficientArray();
+  uint32_t lastIndex = filter_getFirCoefficientCount() - 1;
+  double output = 0.0;
+  for (uint32_t i = 0; i <= lastIndex; i++)
+    output += coefficients[i] * queue_readElementAt(filter_getXQueue(), lastIndex - i);
+  queue_overwritePush(filter_getYQueue(), output);
+  return output;
+}
+
+// The IIR kernel as it was before the delay lines were mirrored: one queue_readElementAt() per tap.
+static double filterTest_perTapIirFilter(uint16_t filterNumber) {
+  const double* b = filter_getIirBCoefficientArray(filterNumber);
+  const double* a = filter_getIirACoefficientArray(filterNumber);
+  uint32_t lastBIndex = filter_getIirBCoefficientCount() - 1;
+  uint32_t lastAIndex = filter_getIirACoefficientCount() - 1;
+  double output = 0.0;
+  for (uint32_t i = 0; i <= lastBIndex; i++)
+    output += b[i] * queue_readElementAt(filter_getYQueue(), lastBIndex - i);
+  for (uint32_t i = 0; i <= lastAIndex; i++)
+    output -= a[i] * queue_readElementAt(filter_getZQueue(filterNumber), lastAIndex - i);
+  queue_overwritePush(filter_getZQueue(filterNumber), output);
+  queue_overwritePush(filter_getIirOutputQueue(filterNumber), output);
+  return output;
+}
+
+// Feeds one decimation period of a square wave into the xQueue (not timed).
+static void filterTest_feedBenchmarkInput(uint32_t decimatedSample) {
+  for (uint16_t i = 0; i < FILTER_FIR_DECIMATION_FACTOR; i++) {
+    uint32_t tick = decimatedSample * FILTER_FIR_DECIMATION_FACTOR + i;
+    filter_addNewInput(computeFilterInput(tick % filter_frequencyTickTable[0], filter_frequencyTickTable[0]));
+  }
+}
+
+// Times the FIR + 10 IIR filters for each decimated sample, first with the per-tap queue reads
+// and then with the filter_* kernels (contiguous mirrored delay lines).
+// Prints the average CPU cycles per decimated sample for both.
+void filterTest_runKernelBenchmark() {
+  filter_init();
+  filterTest_init();
+  globalTimer_startTimer(false);
+  u64 perTapTicks = 0;
+  u64 contiguousTicks = 0;
+  for (uint32_t sample = 0; sample < FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES; sample++) {
+    filterTest_feedBenchmarkInput(sample);
+    u64 startTime = globalTimer_getTimerValue();
+    filterTest_perTapFirFilter();
+    for (uint16_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++)
+      filterTest_perTapIirFilter(filterNumber);
+    perTapTicks += globalTimer_getTimerValue() - startTime;
+  }
+  filter_init();
+  for (uint32_t sample = 0; sample < FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES; sample++) {
+    filterTest_feedBenchmarkInput(sample);
+    u64 startTime = globalTimer_getTimerValue();
+    filter_firFilter();
+    for (uint16_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++)
+      filter_iirFilter(filterNumber);
+    contiguousTicks += globalTimer_getTimerValue() - startTime;
+  }
+  printf("FIR + %d IIR filters, cycles per decimated sample:\n\r", FILTER_FREQUENCY_COUNT);
+  printf("  per-tap queue_readElementAt(): %lu\n\r",
+      (unsigned long) (perTapTicks * FILTER_TEST_CPU_CYCLES_PER_GLOBAL_TIMER_TICK / FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES));
+  printf("  contiguous delay lines:        %lu\n\r",
+      (unsigned long) (contiguousTicks * FILTER_TEST_CPU_CYCLES_PER_GLOBAL_TIMER_TICK / FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES));
+}
+
+// Times the ten IIR filters plus power computation for each decimated sample, first as the
+// per-filter loop the detector used to run and then with filter_iirFilterBank().
+// Prints the average CPU cycles per decimated sample for both and checks that the power values agree.
+// Returns true if both paths produced the same power values.
+bool filterTest_runIirBankBenchmark() {
+  double loopPowerValues[FILTER_FREQUENCY_COUNT];
+  double bankPowerValues[FILTER_FREQUENCY_COUNT];
+  u64 loopTicks = 0;
+  u64 bankTicks = 0;
+  filterTest_init();
+  globalTimer_startTimer(false);
+  filter_init();
+  for (uint32_t sample = 0; sample < FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES; sample++) {
+    filterTest_feedBenchmarkInput(sample);
+    filter_firFilter();
+    u64 startTime = globalTimer_getTimerValue();
+    for (uint16_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++) {
+      filter_iirFilter(filterNumber);
+      filter_computePower(filterNumber, false, false);
+    }
+    loopTicks += globalTimer_getTimerValue() - startTime;
+  }
+  filter_getCurrentPowerValues(loopPowerValues);
+  filter_init();
+  for (uint32_t sample = 0; sample < FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES; sample++) {
+    filterTest_feedBenchmarkInput(sample);
+    filter_firFilter();
+    u64 startTime = globalTimer_getTimerValue();
+    filter_iirFilterBank();
+    bankTicks += globalTimer_getTimerValue() - startTime;
+  }
+  filter_getCurrentPowerValues(bankPowerValues);
+  bool success = true;
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    if (!filterTest_bankPowerEqual(loopPowerValues[i], bankPowerValues[i])) {
+      printf("filterTest_runIirBankBenchmark: power[%d] is %le with the loop but %le with the bank.\n\r", i, loopPowerValues[i], bankPowerValues[i]);
+      success = false;
+    }
+  }
+  printf("%d IIR filters + power, cycles per decimated sample:\n\r", FILTER_FREQUENCY_COUNT);
+  printf("  per-filter loop:        %lu\n\r",
+      (unsigned long) (loopTicks * FILTER_TEST_CPU_CYCLES_PER_GLOBAL_TIMER_TICK / FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES));
+  printf("  filter_iirFilterBank(): %lu\n\r",
+      (unsigned long) (bankTicks * FILTER_TEST_CPU_CYCLES_PER_GLOBAL_TIMER_TICK / FILTER_TEST_BENCHMARK_DECIMATED_SAMPLES));
+  return success;
+}
+
+/******************************************************************************************
+ ************************* filter_processBlock() test **************************************
+ ******************************************************************************************/
+
+#define FILTER_TEST_BLOCK_SAMPLE_COUNT 2000  // ADC samples run through both paths.
+#define FILTER_TEST_BLOCK_VECTOR_COUNT (FILTER_TEST_BLOCK_SAMPLE_COUNT / FILTER_FIR_DECIMATION_FACTOR)
+#define FILTER_TEST_ADC_FULL_SCALE 2047.0     // Square wave amplitude in ADC codes.
+#define FILTER_TEST_BLOCK_LENGTH_COUNT 6
+// Block lengths cycled through by the test; most of them end part-way through a decimation period.
+static const uint32_t filterTest_blockLengths[FILTER_TEST_BLOCK_LENGTH_COUNT] = {1, 7, 13, 200, 3, 26};
+
+// Feeds the same square wave of raw ADC codes through filter_processBlock() in blocks of odd lengths
+// and through filter_addNewInput()/filter_firFilter()/filter_iirFilterBank() one sample at a time.
+// Returns true if both paths emit the same number of power vectors with the same values.
+bool filterTest_runProcessBlockTest(bool printMessageFlag) {
+  static uint32_t adcSamples[FILTER_TEST_BLOCK_SAMPLE_COUNT];
+  static filter_powerVector_t samplePowerVectors[FILTER_TEST_BLOCK_VECTOR_COUNT];
+  static filter_powerVector_t blockPowerVectors[FILTER_BLOCK_MAX_POWER_VECTORS(FILTER_TEST_BLOCK_SAMPLE_COUNT)];
+  uint16_t period = filter_frequencyTickTable[0];
+  for (uint32_t i = 0; i < FILTER_TEST_BLOCK_SAMPLE_COUNT; i++)
+    adcSamples[i] = (uint32_t) (FILTER_ADC_HALFWAY_POINT + computeFilterInput(i % period, period) * FILTER_TEST_ADC_FULL_SCALE);
+  // One sample at a time.
+  filter_init();
+  uint32_t sampleVectorCount = 0;
+  for (uint32_t i = 0; i < FILTER_TEST_BLOCK_SAMPLE_COUNT; i++) {
+    filter_addNewInput((adcSamples[i] - FILTER_ADC_HALFWAY_POINT) / FILTER_ADC_HALFWAY_POINT);
+    if ((i + 1) % FILTER_FIR_DECIMATION_FACTOR == 0) {
+      filter_firFilter();
+      filter_iirFilterBank();
+      filter_getCurrentPowerValues(samplePowerVectors[sampleVectorCount++]);
+    }
+  }
+  // In blocks.
+  filter_init();
+  uint32_t blockVectorCount = 0;
+  for (uint32_t i = 0, block = 0; i < FILTER_TEST_BLOCK_SAMPLE_COUNT; block++) {
+    uint32_t length = filterTest_blockLengths[block % FILTER_TEST_BLOCK_LENGTH_COUNT];
+    if (length > FILTER_TEST_BLOCK_SAMPLE_COUNT - i)
+      length = FILTER_TEST_BLOCK_SAMPLE_COUNT - i;
+    blockVectorCount += filter_processBlock(&adcSamples[i], length, &blockPowerVectors[blockVectorCount]);
+    i += length;
+  }
+  bool success = (blockVectorCount == sampleVectorCount);
+  if (!success)
+    printf("filterTest_runProcessBlockTest: %lu power vectors from filter_processBlock(), expected %lu.\n\r",
+        (unsigned long) blockVectorCount, (unsigned long) sampleVectorCount);
+  for (uint32_t v = 0; success && v < sampleVectorCount; v++) {
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+      if (!filterTest_bankPowerEqual(samplePowerVectors[v][i], blockPowerVectors[v][i])) {
+        printf("filterTest_runProcessBlockTest: vector %lu, power[%d] is %le per sample but %le in blocks.\n\r",
+            (unsigned long) v, i, samplePowerVectors[v][i], blockPowerVectors[v][i]);
+        success = false;
+      }
+    }
+  }
+  if (printMessageFlag)
+    printf("filterTest_runProcessBlockTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
 // Performs several tests of the filter code.
 // 1. Test alignment of FIR constants with input.
 // 2. Test the arithmetic performed by the FIR filter.
@@ -735,12 +1005,19 @@ bool filterTest_runTest() {
   success &= filterTest_runFirAlignmentTest(PRINT_INFO_MESSAGES);
   // Confirm that the FIR properly computes its output.
   success &= filterTest_runFirArithmeticTest(PRINT_INFO_MESSAGES);
+#ifndef FILTER_IIR_USE_SOS // The alignment tests poke the direct-form queues; the response comparison below covers the biquads.
   // Confirm that the IIR A coefficients are properly aligned with the incoming data.
   success &= filterTest_runIirAAlignmentTest(TEST_IIR_FILTER_NUMBER, PRINT_INFO_MESSAGES);
   // Confirm that the IIR B coefficients are properly aligned with the incoming data.
   success &= filterTest_runIirBAlignmentTest(TEST_IIR_FILTER_NUMBER, PRINT_INFO_MESSAGES);
+#endif
   // Verifies correct functionality of the power computation.
   success &= filterTest_runPowerTest();
+  // Confirm that filter_processBlock() carries the decimation phase across blocks of any length.
+  success &= filterTest_runProcessBlockTest(PRINT_INFO_MESSAGES);
+  // Confirm that every IIR filter (direct form or biquads) matches the direct-form reference response.
+  for (uint16_t i=0; i<FILTER_FREQUENCY_COUNT; i++)
+    success &= filterTest_runIirResponseComparisonTest(i, PRINT_INFO_MESSAGES);
   // Plots the frequency response of the FIR filter against all user and other test frequencies.
   // All frequencies are expressed as a square wave.
   filterTest_runSquareWaveFirPowerTest(PRINT_INFO_MESSAGES, PLOT_INPUT);
@@ -14,4 +14,12 @@ void filterTest_init();
 // Performs a comprehensive test of the FIR, IIR filters and plots frequency response on the TFT.
 bool filterTest_runTest();
 
+// Prints the CPU cycles per decimated sample for the FIR + IIR kernels, comparing per-tap
+// queue_readElementAt() reads with the contiguous (mirrored) delay lines used by filter.c.
+void filterTest_runKernelBenchmark();
+
+// Prints the CPU cycles per decimated sample for the ten IIR filters + power, comparing the
+// per-filter loop with filter_iirFilterBank(). Returns true if both give the same power values.
+bool filterTest_runIirBankBenchmark();
+
 #endif /* FILTERTEST_H_ */
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "supportFiles/utils.h"
+#include "src/390_libs/profiler.h"
+#include "src/390_libs/displayQueue.h"
 #include <string.h>
 
 
@@ -14,9 +16,10 @@ static uint16_t histogram_barCount = HISTOGRAM_DEFAULT_BAR_COUNT;
 static uint16_t histogram_barWidth;             // May share this with other functions in this package.
 static uint16_t topLabelMaxWidthInChars;    // How many chars will be printed.
 static histogram_data_t currentBarData[HISTOGRAM_MAX_BAR_COUNT];    // Current histogram data.
-static histogram_data_t previousBarData[HISTOGRAM_MAX_BAR_COUNT];   // Keep the old stuff around so you can erase things properly.
+static histogram_data_t previousBarData[HISTOGRAM_MAX_BAR_COUNT];   // What is on the screen, so you can erase things properly.
 static char topLabel[HISTOGRAM_MAX_BAR_COUNT][HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];      // Labels at top of histogram bars.
-static char oldTopLabel[HISTOGRAM_MAX_BAR_COUNT][HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];   // Old label so you only update as necessary.
+static char oldTopLabel[HISTOGRAM_MAX_BAR_COUNT][HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];   // Label on the screen so you only update as necessary.
+static bool histogram_queuedUpdates = false;  // Draw through the display queue (see histogram_useDisplayQueue()).
 
 #define ONE_HALF(x) ((x)/2)  // Integer divide by 2.
 
@@ -111,19 +114,14 @@ bool histogram_setBarData(histogram_index_t barIndex, histogram_data_t data, con
     printf("Error! histogram_setBarData(): data (%d) is greater than maximum (%d) for index(%d) \n\r", data, HISTOGRAM_MAX_BAR_DATA_IN_PIXELS-1, barIndex);
     return false;
   }
-  // If it has changed, update the data in the array but don't render anything on the display.
-  if (data != currentBarData[barIndex]) {                                                   // Only modify the data if it has changed.
-    previousBarData[barIndex] = currentBarData[barIndex];   // Save the old data so you render things properly.
-    // Copy the old string so that you can render things properly.
-    currentBarData[barIndex] = data;                                                            // Store the data because it changed.
-  }
-  // If the label has changed, move the previous data to old, new data to current.
+  // Update the data in the array but don't render anything on the display.
+  // previousBarData[] and oldTopLabel[] are left alone: they describe what is on the screen, which only
+  // changes when the bar is drawn. Several updates may come in before that (with the display queue).
+  currentBarData[barIndex] = data;
   // Labels are handled separately from data because the label may change even if the underlying bar data does not.
   // This allows the top label to change and to be redrawn even if the bars stay the same height.
   if (strncmp(barTopLabel, topLabel[barIndex], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS)) {
     // If you get here, the new label is different from the last one.
-    strncpy(oldTopLabel[barIndex], topLabel[barIndex], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
-    // Copy the current label to become the new old label.
     strncpy(topLabel[barIndex], barTopLabel, HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
     // Copy the new label to become the current label.
     uint16_t barTopLabelLength = strlen(barTopLabel);                                   // Get the length of the label.
@@ -156,40 +154,60 @@ void histogram_drawTopLabel(uint16_t barIndex, histogram_data_t data, const char
   display_print(topLabel);                                                                              // Draw the label.
 }
 
-// This updates the display.
-// It loops across all bars, checking:
+// True if the screen does not show the current data or label of the bar.
+static bool histogram_barNeedsUpdate(uint16_t barIndex) {
+  return (previousBarData[barIndex] != currentBarData[barIndex]) ||
+      ((currentBarData[barIndex] != 0) && strncmp(topLabel[barIndex], oldTopLabel[barIndex], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS));
+}
+
+// Brings one bar up to date with its current data, checking:
 // If the height of the bar has changed, redraw both the bar and the top label.
 // If the height of the bar has not changed, but the top label has changed, update the label.
+// Also the display-queue command for the bar, so it draws whatever the data is when it runs.
+static void histogram_updateBar(uint32_t barIndex) {
+  histogram_data_t oldData = previousBarData[barIndex];  // What is on the screen.
+  histogram_data_t data = currentBarData[barIndex];      // Get the current bar data.
+  if (oldData != data) {                                 // If the are not equal, redraw the bar and the top-label.
+    // Erase the old bar and extend the erase rectangle to include the top-label so that everything is erased at once.
+    // Also, redraw the top label.
+    display_fillRect(barIndex*(histogram_barWidth+HISTOGRAM_BAR_X_GAP), display_height() - oldData - HISTOGRAM_BAR_Y_GAP - DISPLAY_CHAR_HEIGHT - 1,
+        histogram_barWidth, oldData + DISPLAY_CHAR_HEIGHT + 1, DISPLAY_BLACK);
+    // Draw the new bar.
+    display_fillRect(barIndex*(histogram_barWidth+HISTOGRAM_BAR_X_GAP), display_height() - data - HISTOGRAM_BAR_Y_GAP,
+        histogram_barWidth, data-1, histogram_barColors[barIndex]);
+    if (data != 0)  // Only draw the top label if the bar-data != 0.
+      histogram_drawTopLabel(barIndex, data, topLabel[barIndex], false);  // false means that the old label does not need to be erased.
+  } else if ((data != 0) && strncmp(topLabel[barIndex], oldTopLabel[barIndex], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS)) {
+    histogram_drawTopLabel(barIndex, data, topLabel[barIndex], true);     // True means that the old label needs to be erased.
+  }
+  // The screen now shows the current data and label, so nothing is redrawn until the next change
+  // (a bar at 0 shows no label; its label is drawn with the bar when it grows again).
+  previousBarData[barIndex] = data;
+  strncpy(oldTopLabel[barIndex], topLabel[barIndex], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
+}
+
+// This updates the display: every bar whose data or label has changed is redrawn,
+// right away or (see histogram_useDisplayQueue()) by a display-queue command per bar.
 void histogram_updateDisplay() {
   if (!initFlag) {
     printf("Error! histogram_displayUpdate(): must call histogram_init() before calling this function.\n\r");
     return;
   }
   for (int i=0; i<histogram_barCount; i++) {
-    histogram_data_t oldData = previousBarData[i];  // Get the previous data.
-    histogram_data_t data = currentBarData[i];          // Get the current bar data.
-    if (oldData != data) {                                                  // If the are not equal, redraw the bar and the top-label.
-      // Erase the old bar and extend the erase rectangle to include the top-label so that everything is erased at once.
-      // Also, redraw the top label.
-      display_fillRect(i*(histogram_barWidth+HISTOGRAM_BAR_X_GAP), display_height() - oldData - HISTOGRAM_BAR_Y_GAP - DISPLAY_CHAR_HEIGHT - 1,
-          histogram_barWidth, oldData + DISPLAY_CHAR_HEIGHT + 1, DISPLAY_BLACK);
-      // Draw the new bar.
-      display_fillRect(i*(histogram_barWidth+HISTOGRAM_BAR_X_GAP), display_height() - data - HISTOGRAM_BAR_Y_GAP,
-          histogram_barWidth, data-1, histogram_barColors[i]);
-      if (data != 0) {  // Only draw the top label if the bar-data != 0.
-        histogram_drawTopLabel(i, data, topLabel[i], false);            // false means that the old label does not need to be erased.
-        previousBarData[i] = currentBarData[i]; // Old data and new data are the same after the update.
-        // Old label and new label are the same after the update.
-        strncpy(oldTopLabel[i], topLabel[i], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
-      }
-    } else if ((data != 0) && strncmp(topLabel[i], oldTopLabel[i], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS)) {
-      histogram_drawTopLabel(i, data, topLabel[i], true);       // True means that the old label needs to be erased.
-      // After the update, copy the label to old data so that it won't reupdate until the next change.
-      strncpy(oldTopLabel[i], topLabel[i], HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
-    }
+    if (!histogram_barNeedsUpdate(i))
+      continue;
+    if (histogram_queuedUpdates)
+      displayQueue_post(HISTOGRAM_DISPLAY_QUEUE_KEY + i, histogram_updateBar, i);  // Replaces a bar update still waiting.
+    else
+      histogram_updateBar(i);
   }
 }
 
+// Selects queued or immediate drawing for histogram_updateDisplay().
+void histogram_useDisplayQueue(bool enable) {
+  histogram_queuedUpdates = enable;
+}
+
 // Set the bar-color for each bar. This overwrites the defaults. Call histogram_init() to restore the defaults.
 void histogram_setBarColor(histogram_index_t barIndex, uint16_t color) {
   if (barIndex < 0 || barIndex > HISTOGRAM_MAX_BAR_COUNT) {
@@ -266,8 +284,11 @@ void histogram_normalizePowerValues(double normalizedValues[], double origValues
     normalizedValues[i] = origValues[i] / maxValue;
 }
 
+PROFILER_ZONE(histogramZone, "histogram render");  // Both plot functions, see profiler.h.
+
 // Used to plot the power response for user frequencies 0-9.
 void histogram_plotUserFrequencyPower(double powerValues[]) {
+  PROFILER_BEGIN(histogramZone);
   double normalizedPowerValues[FILTER_FREQUENCY_COUNT];
   histogram_normalizePowerValues(normalizedPowerValues, powerValues, FILTER_FREQUENCY_COUNT);
   for (int i=0; i<FILTER_FREQUENCY_COUNT; i++) {  // Update across all filters.
@@ -293,6 +314,7 @@ void histogram_plotUserFrequencyPower(double powerValues[]) {
     }
   }
   histogram_updateDisplay();
+  PROFILER_END(histogramZone);
 }
 
 // Used to display hit-counts in shooter mode.
@@ -311,6 +333,7 @@ void histogram_computeNormalizedHitValues(double normalizedHitValues[], uint16_t
 
 // Used to plot hits for frequencies 0-9.
 void histogram_plotUserHits(uint16_t hitCounts[]) {
+  PROFILER_BEGIN(histogramZone);
   double normalizedHitValues[FILTER_FREQUENCY_COUNT];               // Store normalized values here for the histogram.
   histogram_computeNormalizedHitValues(normalizedHitValues, hitCounts); // Get the normalized hit values.
   for (int i=0; i<FILTER_FREQUENCY_COUNT; i++) {                            // Iterate through the results for each channel.
@@ -321,6 +344,7 @@ void histogram_plotUserHits(uint16_t hitCounts[]) {
     histogram_setBarData(i, normalizedHitValues[i] * HISTOGRAM_MAX_BAR_DATA_IN_PIXELS, label);
     histogram_updateDisplay();  // Redraw the histogram.
   }
+  PROFILER_END(histogramZone);
 }
 
 // Normalizes the values in the array argument.
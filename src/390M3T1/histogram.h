@@ -37,6 +37,7 @@
 #define HISTOGRAM_BAR_Y_GAP (DISPLAY_CHAR_HEIGHT * HISTOGRAM_BOTTOM_LABEL_TEXT_SIZE)    // Leave room for a small label.
 #define HISTOGRAM_MAX_BAR_DATA_IN_PIXELS (DISPLAY_HEIGHT - HISTOGRAM_BAR_Y_GAP -  HISTOGRAM_TOP_LABEL_HEIGHT)   // Max value (height) for histogram bar, in pixels.
 #define HISTOGRAM_MAX_BAR_LABEL_WIDTH 6 // Defined in terms of characters.
+#define HISTOGRAM_DISPLAY_QUEUE_KEY 0x100  // Bar i is drawn by the display-queue command with key HISTOGRAM_DISPLAY_QUEUE_KEY + i.
 
 typedef uint16_t histogram_index_t; // Used to index each histogram bar.
 typedef uint16_t histogram_data_t;  // The data associated with each bar.
@@ -64,6 +65,11 @@ void histogram_setBottomLabelTextSize(uint16_t);
 // Call this to draw the histogram with the data from histogram_setBarData().
 void histogram_updateDisplay();
 
+// With enable true, histogram_updateDisplay() (and the plot functions) only post a command per changed bar
+// to the display queue (src/390_libs/displayQueue.h) and displayQueue_run() does the drawing. A bar that
+// changes again before it is drawn is drawn once, with its newest data. Off after reset.
+void histogram_useDisplayQueue(bool enable);
+
 // Used to plot the power response for user frequencies 0-9.
 void histogram_plotUserFrequencyPower(double powerValue[]);
 
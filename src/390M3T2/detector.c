@@ -1,12 +1,14 @@
 #include <stdio.h>
 #include "detector.h"
 #include "src/390_libs/filter.h"
-#include "supportFiles/interrupts.h"
 #include "supportFiles/switches.h"
 #include "isr.h"
 #include "lockoutTimer.h"
 #include "hitLedTimer.h"
 #include "src/390M5/game.h"
+#include "src/390_libs/profiler.h"
+#include "src/390_libs/cfar.h"
+#include "supportFiles/globalTimer.h"
 
 #define DETECTOR_ADC_HALFWAY_POINT 2048.0       // The half-way point for the ADC values
 #define DETECTOR_COMPUTE_FROM_SCRATCH false     // Since we are running continously, never compute from scratch
@@ -21,6 +23,19 @@
 
 #define DETECTOR_FUDGE_FACTOR 150               // The fudge factor: experimentation got us this value
 
+// Detect hits with the adaptive per-channel noise floors in cfar.h instead of max > median * DETECTOR_FUDGE_FACTOR.
+// Comment this out to go back to the fixed ratio.
+#define DETECTOR_USE_CFAR
+#define DETECTOR_FALSE_ALARM_PROBABILITY CFAR_DEFAULT_FALSE_ALARM_PROBABILITY  // Per channel and decimated sample
+
+// Drain the ADC buffer in blocks with filter_processBlock(), which runs all ten IIR filters and power
+// computations with filter_iirFilterBank().
+// Comment this out to go back to the per-sample filter_addNewInput() path and the per-player
+// filter_iirFilter()/filter_computePower() loop, which also fills the IIR output queues
+// (needed by ADC_THROUGH_DETECTOR_FILTER_TEST in filterTest.c).
+#define DETECTOR_USE_IIR_FILTER_BANK
+#define DETECTOR_BLOCK_SIZE 200                 // Most ADC samples claimed and handed to filter_processBlock() at once (20 decimated samples)
+
 
 // Values used for the run test
 static double fakeValues1[] = {30, 20, 31, 35, 38, 22, 28, 18, 99, 9500}; // Should detect hit
@@ -30,11 +45,30 @@ typedef uint16_t detector_hitCount_t;           // The number of hits detected
 
 static volatile bool hitDetected = false;                       // A flag when a hit is detected
 static detector_hitCount_t hitCounts[DETECTOR_PLAYER_COUNT];    // Array of number of hits from each channel
-static uint8_t decimationCounter = DETECTOR_DECIMATION_INIT;    // The counter to tell when it is time to run decimation
 static bool useFakeData = false;                                // Set to true to use fake data (for run test)
 static double fakePowerValues[DETECTOR_PLAYER_COUNT];           // An array used for supplying fake data to the dection algorithm
 static uint8_t playerNumber;                                    // The player number  (used for ignoring self)
 static uint8_t hitByPlayerNumber;
+static detector_powerVectorObserver_t powerVectorObserver = NULL; // Sees every decimated power vector (host tools)
+#ifdef DETECTOR_USE_IIR_FILTER_BANK
+static filter_powerVector_t blockPowerVectors[FILTER_BLOCK_MAX_POWER_VECTORS(DETECTOR_BLOCK_SIZE)]; // Its decimated power values
+static const double* currentPowerValues = NULL;                 // The power vector being checked for hits (NULL: ask the filter)
+#else
+static uint8_t decimationCounter = DETECTOR_DECIMATION_INIT;    // The counter to tell when it is time to run decimation
+#endif
+#ifdef DETECTOR_USE_CFAR
+static cfar_t cfar;                                             // The noise floor of every channel
+#endif
+
+// Profiler zones (see profiler.h); the block path's filter stages are timed inside filter_processBlock()
+PROFILER_ZONE(detectionZone, "detection");
+#ifdef DETECTOR_USE_IIR_FILTER_BANK
+PROFILER_ZONE(processBlockZone, "processBlock");
+#else
+PROFILER_ZONE(firZone, "FIR");
+PROFILER_ZONE(iirZone, "IIR bank");
+PROFILER_ZONE(powerZone, "power");
+#endif
 
 // Struct used for sorting (remembers the player number)
 typedef struct {
@@ -51,51 +85,130 @@ void detector_init() {
 
     // Initialize the filters
     filter_init();
+
+#ifdef DETECTOR_USE_CFAR
+    // Forget the noise floors; they are learned again over the first CFAR_WARMUP_VECTORS decimated samples
+    cfar_init(&cfar, DETECTOR_FALSE_ALARM_PROBABILITY);
+#endif
+}
+
+// Set the false-alarm target of the adaptive threshold (per channel and decimated sample)
+void detector_setFalseAlarmProbability(double falseAlarmProbability) {
+#ifdef DETECTOR_USE_CFAR
+    cfar_setFalseAlarmProbability(&cfar, falseAlarmProbability);
+#endif
 }
 
 // Declare the functions we need internally
 uint8_t detector_runDetectionAlgo(bool ignoreSelf, uint8_t playerNum);
+double detector_getCurrentPowerValueForPlayer(uint8_t player);
 void printElems(detector_elem_t values[]);
 
+// Hands the current power values to the observer
+static void detector_notifyPowerVectorObserver(bool hit, uint8_t hitPlayer) {
+    double powers[DETECTOR_PLAYER_COUNT];
+    for (uint8_t player = 0; player < DETECTOR_PLAYER_COUNT; player++) {
+        powers[player] = detector_getCurrentPowerValueForPlayer(player);
+    }
+    powerVectorObserver(powers, hit, hitPlayer);
+}
+
+// Runs the hit detection algorithm on the current power values, unless we are locked out
+static void detector_runHitDetection(bool ignoreSelf) {
+    bool hit = false;           // Set if these power values cause a hit
+    uint8_t hitPlayer = 0;      // Which player hit us
+
+    // If we are not getting a hit during the lockout time period
+    if (! lockoutTimer_running()) {
+        // Run the hit detection algorithm
+        PROFILER_BEGIN(detectionZone);
+        hitPlayer = detector_runDetectionAlgo(ignoreSelf, playerNumber);
+        PROFILER_END(detectionZone);
+
+        // If we have determine that the player has been hit
+        if (detector_hitDetected()) {
+            hit = true;
+
+            // Start the lockout timer
+            lockoutTimer_start();
+
+            // Increment the number of hits from the channel
+            hitCounts[hitPlayer]++;
+        }
+    }
+#ifdef DETECTOR_USE_CFAR
+    else {
+        // Keep the noise floors up to date through the lockout, so a step in one is censored for 1 s, not 1 s of calls
+        double powers[DETECTOR_PLAYER_COUNT];
+        for (uint8_t player = 0; player < DETECTOR_PLAYER_COUNT; player++) {
+            powers[player] = detector_getCurrentPowerValueForPlayer(player);
+        }
+        cfar_track(&cfar, powers);
+    }
+#endif
+
+    // Let the observer see the power values (only host tools set one)
+    if (powerVectorObserver != NULL) {
+        detector_notifyPowerVectorObserver(hit, hitPlayer);
+    }
+}
+
 uint8_t detector_getPlayerNumber() {
     return hitByPlayerNumber;
 }
 
+// Set the function that sees every decimated power vector (NULL for none)
+void detector_setPowerVectorObserver(detector_powerVectorObserver_t observer) {
+    powerVectorObserver = observer;
+}
+
 // A function for setting the player number
 void detector_setSelfFrequency(uint8_t nPlayerNumber) {
     playerNumber = nPlayerNumber;
 }
 
 // Runs the entire detector: decimating fir-filter, iir-filters, power-computation, hit-detection.
-// if interruptsEnabled = false, interrupts are not running. If interruptsEnabled = false
-// you can pop values from the ADC queue without disabling interrupts.
-// If interruptsEnabled = true, do the following:
-// 1. disable interrupts.
-// 2. pop the value from the ADC queue.
-// 3. re-enable interrupts.
-// Use this to determine whether you should disable and re-enable interrrupts when accessing the adc queue.
+// The ADC buffer is a single-producer/single-consumer ring, so values are read without disabling
+// interrupts whether or not they are running; interruptsEnabled is kept for existing callers.
 // if ignoreSelf == true, ignore hits that are detected on your frequency.
 // Your frequency is simply the frequency indicated by the slide switches.
 void detector(bool interruptsEnabled, bool ignoreSelf) {
+    (void) interruptsEnabled;   //Unused: the ring needs no interrupt masking, see above
 
     // Get the number of elements in the ADC input buffer
     uint32_t elementCount = isr_adcBufferElementCount();
 
+#ifdef DETECTOR_USE_IIR_FILTER_BANK
+    // Drain the ADC buffer a block at a time
+    while (elementCount > 0) {
+        // Claim the oldest run of samples straight out of the ADC buffer (no copy, no interrupt masking)
+        const uint32_t* adcSamples;
+        uint32_t blockCount = isr_adcBufferClaim(&adcSamples);
+        if (blockCount > elementCount) blockCount = elementCount;
+        if (blockCount > DETECTOR_BLOCK_SIZE) blockCount = DETECTOR_BLOCK_SIZE;
+        elementCount -= blockCount;
+
+        // Run the FIR and all the IIR filters over the block; the filter keeps the decimation phase between blocks
+        PROFILER_BEGIN(processBlockZone);
+        uint32_t vectorCount = filter_processBlock(adcSamples, blockCount, blockPowerVectors);
+        PROFILER_END(processBlockZone);
+
+        // The filters have copied what they need, so the ISR can reuse these slots
+        isr_adcBufferRelease(blockCount);
+
+        // Run hit detection on every decimated sample, in order
+        for (uint32_t v = 0; v < vectorCount; v++) {
+            currentPowerValues = blockPowerVectors[v];
+            detector_runHitDetection(ignoreSelf);
+        }
+    }
+    currentPowerValues = NULL;
+#else
     // If we have items to process
     for (uint32_t i = 0; i < elementCount; i++) {
-        // Disable interrrupts if needed
-        if (interruptsEnabled) {
-            interrupts_disableArmInts();
-        }
-
         // Read the raw value from the ADC buffer
         uint32_t rawAdcValue = isr_removeDataFromAdcBuffer();
 
-        // Enable interrrupts if needed
-        if (interruptsEnabled) {
-            interrupts_enableArmInts();
-        }
-
         // adc value is between 0 and 4095
         // we map it to -1 to 1
         double mappedValue = (rawAdcValue - DETECTOR_ADC_HALFWAY_POINT) / DETECTOR_ADC_HALFWAY_POINT;
@@ -109,39 +222,33 @@ void detector(bool interruptsEnabled, bool ignoreSelf) {
         // If we have 10 sames, its time to run decimation
         if (decimationCounter >= DETECTOR_DECIMATION_COUNT) {
             // Run the Low Pass Anti Aliasing Filter
+            PROFILER_BEGIN(firZone);
             filter_firFilter();
+            PROFILER_END(firZone);
 
             // Iterate through each player
             for (uint8_t player = 0; player < DETECTOR_PLAYER_COUNT; player++) {
                 // Run the Band Pass Player Filters, Compute Power
+                PROFILER_BEGIN(iirZone);
                 filter_iirFilter(player);
+                PROFILER_END(iirZone);
                 
                 // Compute the power
+                PROFILER_BEGIN(powerZone);
                 filter_computePower(player, DETECTOR_COMPUTE_FROM_SCRATCH, DETECTOR_DEBUG);
+                PROFILER_END(powerZone);
             }
 
-            // If we are not getting a hit during the lockout time period
-            if (! lockoutTimer_running()) {
-                // Run the hit detection algorithm
-                uint8_t hitPlayer = detector_runDetectionAlgo(ignoreSelf, playerNumber);
-
-                // If we have determine that the player has been hit
-                if (detector_hitDetected()) {
-
-                    // Start the lockout timer
-                    lockoutTimer_start();
-
-                    // Increment the number of hits from the channel
-                    hitCounts[hitPlayer]++;
-                }
-            }
+            detector_runHitDetection(ignoreSelf);
 
             // Reset the decimation counter
             decimationCounter = DETECTOR_DECIMATION_INIT;
         }
     }
+#endif
 }
 
+#ifndef DETECTOR_USE_CFAR
 // Swap function used for sorting
 void swap(detector_elem_t *xp, detector_elem_t *yp) {
     detector_elem_t temp = *xp;
@@ -159,6 +266,7 @@ void sort(detector_elem_t values[]) {
    }
 
 }
+#endif
 
 // Get the current power value for the given player number
 double detector_getCurrentPowerValueForPlayer(uint8_t player) {
@@ -166,6 +274,12 @@ double detector_getCurrentPowerValueForPlayer(uint8_t player) {
     if (useFakeData) {
         return fakePowerValues[player];
     }
+#ifdef DETECTOR_USE_IIR_FILTER_BANK
+    // Inside a block, use the power vector of the decimated sample being checked
+    else if (currentPowerValues != NULL) {
+        return currentPowerValues[player];
+    }
+#endif
     // Return real data for normal use
     else {
         // Just call our other function to get the power value :)
@@ -182,6 +296,29 @@ void detector_setFakePowerValues(double fake[]) {
 
 // This code actually runs our detection algorithm
 uint8_t detector_runDetectionAlgo(bool ignoreSelf, uint8_t playerNum) {
+#ifdef DETECTOR_USE_CFAR
+    // Copy the power values for the detector
+    double powers[DETECTOR_PLAYER_COUNT];
+    for (uint8_t player = 0; player < DETECTOR_PLAYER_COUNT; player++) {
+        powers[player] = detector_getCurrentPowerValueForPlayer(player);
+    }
+
+    // Update the noise floors and find the strongest channel above its threshold (never our own if ignoring self)
+    int8_t hitPlayer = cfar_detect(&cfar, powers, ignoreSelf ? (int8_t) playerNum : CFAR_NO_HIT);
+
+    // If a channel is above its threshold
+    if (hitPlayer != CFAR_NO_HIT) {
+        //Hit detected
+        if (game_runDetection()) {
+            hitDetected = true;
+        }
+
+        hitByPlayerNumber = hitPlayer;
+
+        //Return which player was detected
+        return hitPlayer;
+    }
+#else
     // Temporary variable for storing each player and their power
     detector_elem_t values[DETECTOR_PLAYER_COUNT];
 
@@ -218,6 +355,7 @@ uint8_t detector_runDetectionAlgo(bool ignoreSelf, uint8_t playerNum) {
         //Return which player was detected
         return max.playerNumber;
     }
+#endif
 
     // Assume a return value of 0, since we have to return a value, but there was no hit
     return DEFAULT_RETURN;
@@ -259,9 +397,20 @@ void detector_runTest() {
     
     //Two sets of fake data
 
-    //Set 1 (To detect a hit with fudge factor)
-    //The median here is 30 which means the threshold is 30*300 = 9000
     useFakeData = true;                         // We need to use the fake data
+#ifdef DETECTOR_USE_CFAR
+    //Learn a noise floor from set 2 first (the adaptive threshold reports nothing until it has one)
+    cfar_init(&cfar, DETECTOR_FALSE_ALARM_PROBABILITY);
+    detector_setFakePowerValues(fakeValues2);
+    for (uint32_t i = 0; i < CFAR_WARMUP_VECTORS; i++)
+        detector_runDetectionAlgo(false, 0);
+    if (detector_hitDetected())
+        printf("Detected a hit while learning the noise floor\n\r");
+#endif
+
+    //Set 1 (To detect a hit with fudge factor)
+    //The median here is 30 which means the threshold is 30*150 = 4500
+    //(adaptive threshold: 9500 is far above the learned floor of 50 and 10x the median)
     detector_setFakePowerValues(fakeValues1);   // Set the fake values
     detector_runDetectionAlgo(false, 0);        // Run the detection algo
     
@@ -275,6 +424,15 @@ void detector_runTest() {
     
     if (detector_hitDetected())                 // If a hit was detected, it's wrong
         printf("Detected a false hit\n\r");     // Print problem
+    detector_clearHit();
+    useFakeData = false;
+
+#ifdef DETECTOR_USE_CFAR
+    //Detection and false-alarm rates and time per call, adaptive threshold against the fudge factor
+    globalTimer_startTimer(false);
+    cfar_runTest(globalTimer_getTimerValue, GLOBAL_TIMER_TICKS_PER_SECOND);
+    cfar_init(&cfar, DETECTOR_FALSE_ALARM_PROBABILITY);
+#endif
 
    printf("runTest ended.\n\r");
 }
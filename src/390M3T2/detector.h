@@ -12,13 +12,8 @@ typedef uint16_t detector_hitCount_t;
 void detector_init();
 
 // Runs the entire detector: decimating fir-filter, iir-filters, power-computation, hit-detection.
-// if interruptsEnabled = false, interrupts are not running. If interruptsEnabled = false
-// you can pop values from the ADC queue without disabling interrupts.
-// If interruptsEnabled = true, do the following:
-// 1. disable interrupts.
-// 2. pop the value from the ADC queue.
-// 3. re-enable interrupts.
-// Use this to determine whether you should disable and re-enable interrrupts when accessing the adc queue.
+// The ADC buffer is a single-producer/single-consumer ring, so values are read without disabling
+// interrupts whether or not they are running; interruptsEnabled is kept for existing callers.
 // if ignoreSelf == true, ignore hits that are detected on your frequency.
 // Your frequency is simply the frequency indicated by the slide switches.
 void detector(bool interruptsEnabled, bool ignoreSelf);
@@ -34,6 +29,16 @@ void detector_clearHit();
 
 void detector_setSelfFrequency(uint8_t playerNumber);
 
+// Set the false-alarm target of the adaptive hit threshold, per channel and decimated sample
+// (default CFAR_DEFAULT_FALSE_ALARM_PROBABILITY, see src/390_libs/cfar.h). No effect with the fixed ratio.
+void detector_setFalseAlarmProbability(double falseAlarmProbability);
+
+// Called with the power of every channel for each decimated sample (10 kHz), once hit detection
+// has run on it. hit is true if this sample caused a hit, from player hitPlayer.
+// Lets host tools (see tools/traceReplay) record power traces and hit times; NULL (the default) for none.
+typedef void (*detector_powerVectorObserver_t)(const double power[], bool hit, uint8_t hitPlayer);
+void detector_setPowerVectorObserver(detector_powerVectorObserver_t observer);
+
 // Get the current hit counts.
 // Copy the current hit counts into the user-provided hitArray
 // using a for-loop.
@@ -4,10 +4,10 @@
 #include "supportFiles/leds.h"
 #include "supportFiles/mio.h"
 #include "supportFiles/utils.h"
+#include "src/390_libs/timerWheel.h"
 #include <stdio.h>
 
-#define DEBUG 0 //Enables our debugStatePrint
-#define COUNTER_INIT_VALUE 0
+#define DEBUG 0 //Enables debug prints in mio_init() and leds_init()
 
 #define LD0_OFF 0x00 //Byte to turn LED OFF
 #define LD0_ON 0x01 //Byte to turn LED ON
@@ -15,15 +15,18 @@
 #define LED_OFF 0  // Value to write to pin
 #define LED_ON 1  //Value to write to pin
 
-enum hitLedTimer_st_t {
-    init_st, //Initial state
-    wait_st, //Waiting for start
-    on_st   //Led on for 500ms
-} hitLedTimerState;
+// The old hitLedTimer_tick() spent one tick noticing hitLedTimer_start() before it counted
+// HIT_LED_TIMER_EXPIRE_VALUE ticks, so the timeout is one tick longer (checked by tools/timeoutCheck).
+#define HIT_LED_TIMER_TIMEOUT_TICKS (HIT_LED_TIMER_EXPIRE_VALUE + 1)
 
-static bool running = false; // State machine running (set true when hit)
+static timerWheel_timer_t hitLedTimer; // Expires when the LED should go off
+static volatile bool running = false; // True while the LED is on
 
-static void debugStatePrint(); // Debug function
+// Timer wheel callback: the LED has been on for HIT_LED_TIMER_EXPIRE_VALUE ticks.
+static void hitLedTimerExpired(timerWheel_timer_t*) {
+    hitLedTimer_turnLedOff();
+    running = false;
+}
 
 // Standard init function. Implement it even if it is not necessary. You may need it later.
 void hitLedTimer_init() {
@@ -33,17 +36,21 @@ void hitLedTimer_init() {
     //Init leds
     leds_init(DEBUG);
 
-    //Make sure led is off
+    //Make sure led is off and no timeout is pending
+    timerWheel_cancel(&hitLedTimer);
     hitLedTimer_turnLedOff();
-
-    // Start and initialize state machine as init_st
     running = false;
-    hitLedTimerState = init_st;
 }
 
 // Calling this starts the timer.
 void hitLedTimer_start() {
+    //A hit while the LED is already on does not extend it
+    if (running) {
+        return;
+    }
     running = true;
+    hitLedTimer_turnLedOn();
+    timerWheel_arm(&hitLedTimer, HIT_LED_TIMER_TIMEOUT_TICKS, hitLedTimerExpired);
 }
 
 // Returns true if the timer is currently running.
@@ -51,61 +58,6 @@ bool hitLedTimer_running() {
     return running;
 }
 
-// Standard tick function.
-void hitLedTimer_tick() {
-
-    //Print state changes
-    if (DEBUG) {
-        debugStatePrint();
-    }
-
-    //Counter to keep track of time
-    static uint16_t counter = 0;
-
-    // Transitions
-    switch(hitLedTimerState) {
-        case init_st: {
-            //Move to wait_st
-            hitLedTimerState = wait_st;
-        }
-        break;
-        case wait_st: {
-            //If state machine is running (hit detected) then turn on led
-            if (running) {
-                counter = COUNTER_INIT_VALUE;
-
-                hitLedTimer_turnLedOn();
-                //transition to on_st
-                hitLedTimerState = on_st;
-            }
-        }
-        break;
-        case on_st: {
-            //Remain in on_st for 500ms
-            if (counter >= HIT_LED_TIMER_EXPIRE_VALUE) {
-                running = false;
-                //Turn off led and return back to wait_st
-                hitLedTimer_turnLedOff();
-
-                hitLedTimerState = wait_st;
-            }
-        }
-        break;
-    }
-
-    // Actions
-    switch(hitLedTimerState) {
-        case init_st: break;
-        case wait_st: break;
-        case on_st: {
-            //Increment counter
-            counter++;
-        }
-        break;
-    }
-
-}
-
 // Turns the gun's hit-LED on.
 void hitLedTimer_turnLedOn() {
     //Turn both LED and Hit indicator on
@@ -131,29 +83,3 @@ void hitLedTimer_runTest() {
         utils_msDelay(HIT_LED_REPEAT_DELAY_MS); //Delay a little
     }
 }
-
-// This is a debug state print routine. It will print the names of the states each
-// time tick() is called. It only prints states if they are different than the
-// previous state.
-void debugStatePrint() {
-  static enum hitLedTimer_st_t previousState;
-  static bool firstPass = true;
-  // Only print the message if:
-  // 1. This the first pass and the value for previousState is unknown.
-  // 2. previousState != lockoutTimerState - this prevents reprinting the same state name over and over.
-  if (previousState != hitLedTimerState || firstPass) {
-    firstPass = false;                // previousState will be defined, firstPass is false.
-    previousState = hitLedTimerState;     // keep track of the last state that you were in.
-    switch(hitLedTimerState) {            // This prints messages based upon the state that you were in.
-      case init_st:
-        printf("init_st\n\r");
-        break;
-      case wait_st:
-        printf("wait_st\n\r");
-        break;
-      case on_st:
-        printf("on_st\n\r");
-        break;
-     }
-  }
-}
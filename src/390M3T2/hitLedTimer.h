@@ -2,8 +2,9 @@
 #define HITLEDTIMER_H_
 
 // The hitLedTimer illuminates the LEDs (LD0 and the LED attached to pin JF-3) for 1/2 second when activated.
+// The timer is a timerWheel timeout, so there is no tick function.
 
-#define HIT_LED_TIMER_EXPIRE_VALUE 50000    // Defined in terms of 100 kHz ticks.
+#define HIT_LED_TIMER_EXPIRE_VALUE 500      // Defined in terms of 1 kHz timerWheel ticks.
 #define HIT_LED_TIMER_OUTPUT_PIN 11 // JF-3
 
 // Standard init function. Implement it even if it is not necessary. You may need it later.
@@ -15,9 +16,6 @@ void hitLedTimer_start();
 // Returns true if the timer is currently running.
 bool hitLedTimer_running();
 
-// Standard tick function.
-void hitLedTimer_tick();
-
 // Turns the gun's hit-LED on.
 void hitLedTimer_turnLedOn();
 
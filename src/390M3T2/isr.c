@@ -8,6 +8,9 @@
 #include "transmitter.h"
 #include "supportFiles/interrupts.h"
 #include "src/390_libs/queue.h"
+#include "src/390_libs/spscRing.h"
+#include "src/390_libs/tickScheduler.h"
+#include "src/390_libs/timerWheel.h"
 #include "trigger.h"
 #include "lockoutTimer.h"
 #include "hitLedTimer.h"
@@ -20,42 +23,33 @@
 
 // This implements a dedicated buffer for storing values from the ADC
 // until they are read and processed by detector().
-// adcBuffer_t is similar to a queue.
-#define ADC_BUFFER_SIZE 100000
-typedef struct {
-    uint32_t indexIn;   // New values go here.
-    uint32_t indexOut;  // Pull old values from here.
-    uint32_t data[ADC_BUFFER_SIZE];  // Store values here.
-    uint32_t elementCount;  // Number of values contained in adcBuffer_t.
-} adcBuffer_t;
+// isr_function() is the only producer and detector() the only consumer, so the buffer is a
+// lock-free single-producer/single-consumer ring (see spscRing.h) and neither side masks interrupts.
+#define ADC_BUFFER_SIZE 131072  // Must be a power of two (a bit over 1.3 seconds of samples at 100 kHz).
 
 // This is the instantiation of adcBuffer.
-static adcBuffer_t adcBuffer;
+static uint32_t adcBufferData[ADC_BUFFER_SIZE];
+static spscRing_t adcBuffer;
 
 // Init adcBuffer.
 void adcBufferInit() {
-    adcBuffer.indexIn = 0;
-    adcBuffer.indexOut = 0;
-    adcBuffer.elementCount = 0;
+    spscRing_init(&adcBuffer, adcBufferData, ADC_BUFFER_SIZE);
 }
 
+static void tickTableInit();  // Defined next to the tick table below.
+
 // Init everything in isr.
 void isr_init() {
     adcBufferInit();  // init the local adcBuffer.
+    timerWheel_init();  // no timeouts pending.
+    tickTableInit();  // load the tick functions into the scheduler.
 }
 
-// Implemented as a fixed-size circular buffer.
-// indexIn always points to an empty location (by definition).
-// indexOut always points to the oldest element.
-// buffer is empty if indexIn == indexOut. Buffer is full if incremented indexIn == indexOut
+// Called from the ISR only. If detector() has fallen a whole buffer behind, the new value is
+// dropped and counted (see isr_adcBufferOverflowCount()): the ISR cannot discard the oldest value
+// without racing the detector.
 void isr_addDataToAdcBuffer(uint32_t adcData) {
-    if (adcBuffer.elementCount < (ADC_BUFFER_SIZE-1)) // Increment the element count unless you are already full.
-        adcBuffer.elementCount++;
-    adcBuffer.data[adcBuffer.indexIn] = adcData;                    // write,
-    adcBuffer.indexIn = (adcBuffer.indexIn + 1) % ADC_BUFFER_SIZE;  // then increment.
-    if (adcBuffer.indexIn == adcBuffer.indexOut) {                  // If you are now pointing at the out pointer,
-        adcBuffer.indexOut = (adcBuffer.indexOut + 1) % ADC_BUFFER_SIZE;  // move the out pointer up (essentially a pop).
-    }
+    spscRing_push(&adcBuffer, adcData);
 }
 
 // Removes a single item from the ADC buffer.
@@ -63,30 +57,66 @@ void isr_addDataToAdcBuffer(uint32_t adcData) {
 // emptu. Simply returns a default value of 0 if the buffer is currently empty.
 uint32_t isr_removeDataFromAdcBuffer() {
     uint32_t returnValue = 0;
-    if (adcBuffer.indexIn == adcBuffer.indexOut)  // Just return 0 if empty.
-        return 0;
-    else {
-        returnValue = adcBuffer.data[adcBuffer.indexOut];  // Not empty, get the return value from buffer.
-        adcBuffer.indexOut = (adcBuffer.indexOut + 1) % ADC_BUFFER_SIZE;  // increment the out index.
-        adcBuffer.elementCount--;  // One less element.
-    }
+    spscRing_pop(&adcBuffer, &returnValue);  // Leaves returnValue at 0 if empty.
     return returnValue;
 }
 
+// Points *samples at the oldest values; see isr.h.
+uint32_t isr_adcBufferClaim(const uint32_t** samples) {
+    return spscRing_claim(&adcBuffer, samples);
+}
+
+// Hands the claimed values back to the ISR.
+void isr_adcBufferRelease(uint32_t count) {
+    spscRing_release(&adcBuffer, count);
+}
+
 // Functional interface to access element count.
 uint32_t isr_adcBufferElementCount() {
-    return adcBuffer.elementCount;
+    return spscRing_elementCount(&adcBuffer);
+}
+
+// Number of ADC values dropped because the buffer was full.
+uint32_t isr_adcBufferOverflowCount() {
+    return spscRing_overflowCount(&adcBuffer);
+}
+
+// Worst backlog seen by the detector's claims.
+uint32_t isr_adcBufferMaxElementCount() {
+    return spscRing_maxElementCount(&adcBuffer);
+}
+
+// The tick functions run from isr_function(), with the rate divider each one needs (the divided
+// rates are the ones their timing constants are written for) and a phase that keeps functions with
+// the same divider off the same interrupt. Only the transmitter (and ADC capture) needs every interrupt.
+// lockoutTimer and hitLedTimer have no tick function: they arm timeouts on the timerWheel, which also
+// times the game's respawn delay and the gun's reloads.
+typedef struct {
+    const char* name;                   // Name shown in the statistics.
+    tickScheduler_tickFunction_t tick;  // The module's tick function.
+    uint32_t divider;                   // Runs on every divider-th interrupt.
+    uint32_t phase;                     // Interrupt (mod divider) it runs on.
+} isr_tickTableEntry_t;
+
+static const isr_tickTableEntry_t isr_tickTable[] = {
+    {"transmitter",  transmitter_tick,  1,                               0},
+    {"trigger",      trigger_tick,      TRIGGER_TICK_RATE_DIVIDER,       1},
+    {"sound",        sound_tick,        SOUND_TICK_RATE_DIVIDER,         6},
+    {"timerWheel",   timerWheel_tick,   TIMER_WHEEL_TICK_RATE_DIVIDER,   3},
+    {"game",         game_tick,         GAME_TICK_RATE_DIVIDER,          23},
+    {"gun",          gun_tick,          GUN_TICK_RATE_DIVIDER,           33},
+};
+#define ISR_TICK_TABLE_ENTRY_COUNT (sizeof(isr_tickTable) / sizeof(isr_tickTable[0]))
+
+// Register every tick function with the scheduler.
+static void tickTableInit() {
+    tickScheduler_init();
+    for (uint32_t i = 0; i < ISR_TICK_TABLE_ENTRY_COUNT; i++)
+        tickScheduler_register(isr_tickTable[i].name, isr_tickTable[i].tick, isr_tickTable[i].divider, isr_tickTable[i].phase);
 }
 
 void isr_function() {
     uint32_t adcData = interrupts_getAdcData();
     isr_addDataToAdcBuffer(adcData);
-    transmitter_tick();
-    trigger_tick();
-    lockoutTimer_tick();
-    hitLedTimer_tick();
-    
-    game_tick();
-    gun_tick();
-    sound_tick();
+    tickScheduler_tick();
 }
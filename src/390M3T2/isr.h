@@ -7,11 +7,16 @@
 // A buffer for storing values from the Analog to Digital Converter (ADC) is implemented in isr.c
 // Values are added to this buffer by the code in isr.c. Values are removed from this queue
 // by code in detector.c
+// The buffer is a lock-free single-producer/single-consumer ring: the remove/claim/release
+// functions can be called from the main loop without disabling interrupts, as long as only
+// one context consumes.
 
 // Performs inits for anything in isr.c
 void isr_init();
 
 // This function is invoked by the timer interrupt at 100 kHz.
+// It captures the ADC value and runs the tick functions that are due (see the table in isr.c
+// and tickScheduler_printStatistics() for the worst-case tick functions per interrupt).
 void isr_function();
 
 // This adds data to the ADC queue. Data are removed from this queue and used by the detector.
@@ -23,4 +28,17 @@ uint32_t isr_removeDataFromAdcBuffer();
 // This returns the number of values in the ADC buffer.
 uint32_t isr_adcBufferElementCount();
 
+// Points *samples at the oldest values in the ADC buffer and returns how many of them are
+// contiguous in memory (0 if the buffer is empty). They stay valid until isr_adcBufferRelease().
+uint32_t isr_adcBufferClaim(const uint32_t** samples);
+
+// Frees the oldest count values (at most the count returned by the last isr_adcBufferClaim()).
+void isr_adcBufferRelease(uint32_t count);
+
+// This returns the number of ADC values dropped because the buffer was full.
+uint32_t isr_adcBufferOverflowCount();
+
+// This returns the most values the detector has found waiting in the ADC buffer (its worst backlog).
+uint32_t isr_adcBufferMaxElementCount();
+
 #endif /* ISR_H_ */
@@ -5,29 +5,36 @@
 #include <stdio.h>
 #include "supportFiles/utils.h"
 #include "supportFiles/intervalTimer.h"
+#include "src/390_libs/timerWheel.h"
 
-#define DEBUG 0 //Enables our debugStatePrint
-#define COUNTER_INIT_VALUE 0 //Counter init value
+// The old lockoutTimer_tick() spent one tick noticing lockoutTimer_start() before it counted
+// LOCKOUT_TIMER_EXPIRE_VALUE ticks, so the timeout is one tick longer (checked by tools/timeoutCheck).
+#define LOCKOUT_TIMER_TIMEOUT_TICKS (LOCKOUT_TIMER_EXPIRE_VALUE + 1)
 
-enum lockoutTimer_st_t {
-    init_st, // Init state
-    wait_st, //Waiting for counter expire
-    running_st //Counter running
-} lockoutTimerState;
+static timerWheel_timer_t lockoutTimer; // Expires when the lockout is over
+static volatile bool running = false; // True from lockoutTimer_start() until the timer expires
 
-static volatile bool running = false; // State machine running (set true when activated)
+// Timer wheel callback: the lockout period is over.
+static void lockoutTimerExpired(timerWheel_timer_t*) {
+    running = false;
+}
 
 // Standard init function.
 void lockoutTimer_init() {
-    //Initialize state machine and go to init_st
+    //Make sure no lockout is pending
+    timerWheel_cancel(&lockoutTimer);
     running = false;
-
-    lockoutTimerState = init_st;
 }
 
 // Calling this starts the timer.
 void lockoutTimer_start() {
+    //A start during the lockout does not extend it
+    if (running) {
+        return;
+    }
     running = true;
+    //Arm the expiry; nothing runs until it fires
+    timerWheel_arm(&lockoutTimer, LOCKOUT_TIMER_TIMEOUT_TICKS, lockoutTimerExpired);
 }
 
 // Returns true if the timer is running.
@@ -35,56 +42,6 @@ bool lockoutTimer_running() {
     return running;
 }
 
-static void debugStatePrint();
-
-// Standard tick function.
-void lockoutTimer_tick() {
-    //If debug, print state changes
-    if (DEBUG) {
-        debugStatePrint();
-    }
-
-    static uint32_t counter = 0;
-
-    // Transitions
-    switch(lockoutTimerState) {
-        case init_st: {
-            //Transition to waiting for activate
-            lockoutTimerState = wait_st;
-        }
-        break;
-        case wait_st: {
-            //Once activated, transition to running state
-            if (running) {
-                counter = COUNTER_INIT_VALUE;
-                lockoutTimerState = running_st;
-            }
-        }
-        break;
-        case running_st: {
-            //Remain in running state until timer expires
-            if (counter >= LOCKOUT_TIMER_EXPIRE_VALUE) {
-                running = false;
-                //Return to waiting state
-                lockoutTimerState = wait_st;
-
-            }
-        }
-        break;
-    }
-
-    // Actions
-    switch(lockoutTimerState) {
-        case init_st: break;
-        case wait_st: break;
-        case running_st: {
-            //Increment counter
-            counter++;
-        }
-        break;
-    }
-}
-
 // Test function.
 void lockoutTimer_runTest() {
     intervalTimer_init(INTERVAL_TIMER_TIMER_1);
@@ -95,29 +52,3 @@ void lockoutTimer_runTest() {
     intervalTimer_stop(INTERVAL_TIMER_TIMER_1);
     printf("Time Duration: %f\r\n", intervalTimer_getTotalDurationInSeconds(INTERVAL_TIMER_TIMER_1));
 }
-
-// This is a debug state print routine. It will print the names of the states each
-// time tick() is called. It only prints states if they are different than the
-// previous state.
-static void debugStatePrint() {
-  static enum lockoutTimer_st_t previousState;
-  static bool firstPass = true;
-  // Only print the message if:
-  // 1. This the first pass and the value for previousState is unknown.
-  // 2. previousState != lockoutTimerState - this prevents reprinting the same state name over and over.
-  if (previousState != lockoutTimerState || firstPass) {
-    firstPass = false;                // previousState will be defined, firstPass is false.
-    previousState = lockoutTimerState;     // keep track of the last state that you were in.
-    switch(lockoutTimerState) {            // This prints messages based upon the state that you were in.
-      case init_st:
-        printf("init_st\n\r");
-        break;
-      case wait_st:
-        printf("wait_st\n\r");
-        break;
-      case running_st:
-        printf("running_st\n\r");
-        break;
-     }
-  }
-}
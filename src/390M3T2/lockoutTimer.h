@@ -4,8 +4,9 @@
 // The lockoutTimer is active for 1/2 second once it is started.
 // It is used to lock-out the detector once a hit has been detected.
 // This ensure that only one hit is detected per 1/2-second interval.
+// The timer is a timerWheel timeout, so there is no tick function.
 
-#define LOCKOUT_TIMER_EXPIRE_VALUE 50000    // Defined in terms of 100 kHz ticks.
+#define LOCKOUT_TIMER_EXPIRE_VALUE 500      // Defined in terms of 1 kHz timerWheel ticks.
 
 // Standard init function.
 void lockoutTimer_init();
@@ -16,9 +17,6 @@ void lockoutTimer_start();
 // Returns true if the timer is running.
 bool lockoutTimer_running();
 
-// Standard tick function.
-void lockoutTimer_tick();
-
 // Test function.
 void lockoutTimer_runTest();
 
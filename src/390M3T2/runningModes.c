@@ -11,6 +11,10 @@
 #include "supportFiles/intervalTimer.h"
 #include <stdbool.h>
 #include "src/390_libs/queue.h"
+#include "src/390_libs/tickScheduler.h"
+#include "src/390_libs/isrTiming.h"
+#include "src/390_libs/profiler.h"
+#include "src/390_libs/displayQueue.h"
 #include "xparameters.h"
 #include "src/390_libs/filter.h"
 #include "src/390M3T1/histogram.h"
@@ -39,6 +43,14 @@
 
 #define SYSTEM_TICKS_PER_HISTOGRAM_UPDATE 30000 // Update the histogram about 3 times per second.
 
+// The histogram is drawn through the display queue, a few bars per loop iteration, so a redraw never holds
+// detector() off for long. The queue only runs while the detector is keeping up: with more than
+// RUNNING_MODES_DISPLAY_MAX_BACKLOG samples waiting (1 ms of them at 100 kHz) the iteration goes to the
+// detector alone. Turn DISPLAY_QUEUE_ENABLE off (displayQueue.h) to draw synchronously, e.g. to compare the
+// ADC buffer high-water mark on the statistics screen.
+#define RUNNING_MODES_DISPLAY_BUDGET_TICKS (GLOBAL_TIMER_TICKS_PER_SECOND / 2000)  // 500 us of drawing per iteration.
+#define RUNNING_MODES_DISPLAY_MAX_BACKLOG 100  // ADC samples waiting, above which nothing is drawn.
+
 // The detector should run, on average, 2 times for each sample to keep up with the
 // incoming samples. Strictly speaking, this should be 1.0, but 1.0, on average,
 // but an average of 1.0 over a long period may still see short periods of less
@@ -62,6 +74,7 @@ static uint32_t countInterruptsViaInterruptsIsrFlag = 0;  // Keep track of inter
 static uint32_t detectorInvocationCount = 0;  // Keep track of detector invocations.
 
 #define PERCENTAGE_MULTIPLIER 100.0  // Need to multiply by this to get a percentage.
+#define RUNNING_MODE_ISR_PERCENTILE 990  // p99 (in parts per thousand) of the ISR timing shown on the TFT.
 
 // Prints out various run-time statistics on the TFT display.
 // Assumes the following:
@@ -70,14 +83,24 @@ static uint32_t detectorInvocationCount = 0;  // Keep track of detector invocati
 // interval_timer(1) is the total run-time,
 // interval_timer(2) is the time spent in main running the filters, updating the display, and so forth.
 // No comments in the code, the print statements are self-explanatory.
+PROFILER_ZONE(statisticsScreenZone, "statistics screen");  // Drawing the TFT report; console prints come after.
+
 void runningModes_printRunTimeStatistics() {
+  PROFILER_BEGIN(statisticsScreenZone);
   display_setTextSize(RUNNING_MODE_NORMAL_TEXT_SIZE);
-  display_setTextColor(RUNNING_MODE_NORMAL_TEXT_COLOR);
+  // On the cleared screen a black background changes nothing, but it lets each string go out as one block.
+  display_setTextColor(RUNNING_MODE_NORMAL_TEXT_COLOR, DISPLAY_BLACK);
   display_setCursor(RUNNING_MODE_SCREEN_X_ORIGIN, RUNNING_MODE_SCREEN_Y_ORIGIN);
   display_fillScreen(DISPLAY_BLACK);
   display_print("Elements remaining in ADC queue:");
   display_print(isr_adcBufferElementCount());
   display_println(); display_println();
+  display_print("ADC values dropped (buffer full):");
+  display_print(isr_adcBufferOverflowCount());
+  display_println(); display_println();
+  display_print("Most elements waiting in ADC queue:");
+  display_print(isr_adcBufferMaxElementCount());
+  display_println(); display_println();
   double runningSeconds, isrRunningSeconds, mainLoopRunningSeconds;
   runningSeconds = intervalTimer_getTotalDurationInSeconds(TOTAL_RUNTIME_TIMER);
   display_print("Measured run time in seconds: ");
@@ -97,10 +120,20 @@ void runningModes_printRunTimeStatistics() {
   display_println(detectorInvocationCount/runningSeconds); display_println();
   display_print("Detector invocation to interrupt ratio: ");
   double detectorInvocationToInterruptRatio = (double) detectorInvocationCount / (double) interruptCount;
-  display_println(detectorInvocationToInterruptRatio);
+  display_println(detectorInvocationToInterruptRatio); display_println();
+  display_print("Worst-case ticks per interrupt: ");
+  display_print(tickScheduler_getMaxTicksPerInterrupt()); display_print(" of ");
+  display_println(tickScheduler_getEntryCount());
+  display_println();
+  display_print("ISR latency p99/max (us): ");
+  display_print(isrTiming_ticksToMicroseconds(isrTiming_getPercentile(isrTiming_latency_e, RUNNING_MODE_ISR_PERCENTILE)));
+  display_print(" / "); display_println(isrTiming_ticksToMicroseconds(isrTiming_getMax(isrTiming_latency_e)));
+  display_print("ISR duration p99/max (us): ");
+  display_print(isrTiming_ticksToMicroseconds(isrTiming_getPercentile(isrTiming_duration_e, RUNNING_MODE_ISR_PERCENTILE)));
+  display_print(" / "); display_println(isrTiming_ticksToMicroseconds(isrTiming_getMax(isrTiming_duration_e)));
 #ifdef RUNNING_MODE_VERBOSE_MODE
   if (detectorInvocationToInterruptRatio < MIN_DETECTOR_TO_INTERRUPT_RATIO) {
-    display_setTextColor(RUNNING_MODE_WARNING_TEXT_COLOR);
+    display_setTextColor(RUNNING_MODE_WARNING_TEXT_COLOR, DISPLAY_BLACK);
     display_setTextSize(RUNNING_MODE_WARNING_TEXT_SIZE);
     display_println();
     display_println("NOTE: Ratio should be at ");
@@ -112,6 +145,14 @@ void runningModes_printRunTimeStatistics() {
     display_println("compiler optimization -O1");
     display_print("is enabled.");
   }
+#endif
+  PROFILER_END(statisticsScreenZone);
+  printf("ADC queue high-water mark: %lu samples.\n\r", (unsigned long) isr_adcBufferMaxElementCount());
+  displayQueue_printStatistics();
+  tickScheduler_printStatistics();  // Full table on the console.
+  isrTiming_printStatistics();      // Histograms and worst-case samples on the console (UART).
+#ifdef PROFILER_ENABLE
+  profiler_printReport();           // Per-zone cycle accounting on the console, the statistics screen included.
 #endif
 }
 
@@ -124,6 +165,12 @@ void runningModes_initAll() {
   display_init();
   intervalTimer_initAll();
   histogram_init(HISTOGRAM_BAR_COUNT);
+  globalTimer_startTimer(false);  // The time source of the display queue and the profiler.
+  displayQueue_init(globalTimer_getTimerValue);
+  histogram_useDisplayQueue(true);
+#ifdef PROFILER_ENABLE
+  profiler_init(globalTimer_getTimerValue, GLOBAL_TIMER_TICKS_PER_SECOND);
+#endif
   leds_init(true);
   transmitter_init();
   detector_init();
@@ -133,6 +180,12 @@ void runningModes_initAll() {
   trigger_init();
 }
 
+// Gives the display queue its share of the loop iteration, unless the detector has fallen behind.
+void runningModes_runDisplayQueue() {
+  if (isr_adcBufferElementCount() < RUNNING_MODES_DISPLAY_MAX_BACKLOG)
+    displayQueue_run(RUNNING_MODES_DISPLAY_BUDGET_TICKS);
+}
+
 // Returns the current switch-setting
 uint16_t runningModes_getFrequencySetting() {
   uint16_t switchSetting = switches_read() & 0xF;  // Bit-mask the results.
@@ -180,8 +233,10 @@ void runningModes_continuous() {
       histogram_plotUserFrequencyPower(powerValues); // Plot the power values on the TFT.
       histogramSystemTicks = 0;                        // Reset the tick count and wait for the next update time.
     }
+    runningModes_runDisplayQueue();  // Draw a little of the histogram.
   }
   interrupts_disableArmInts();            // Stop interrupts.
+  displayQueue_clear();                   // The statistics screen replaces the histogram.
   runningModes_printRunTimeStatistics();  // Print the run-time statistics.
 }
 
@@ -228,8 +283,10 @@ void runningModes_shooter() {
       transmitter_setFrequencyNumber(switchValue);
     }
     intervalTimer_stop(MAIN_CUMULATIVE_TIMER);  // All done with actual processing.
+    runningModes_runDisplayQueue();  // Draw a little of the histogram.
   }
   interrupts_disableArmInts();  // Done with loop, disable the interrupts.
+  displayQueue_clear();         // The statistics screen replaces the histogram.
   hitLedTimer_turnLedOff();     // Save power :-)
   runningModes_printRunTimeStatistics();  // Print the run-time statistics to the TFT.
   printf("Shooter mode terminated after detecting %d shots.\n\r", hitCount);
@@ -9,17 +9,11 @@
 #include "xiicps.h"
 #include "timer_ps.h"
 #include "sound.h"
-#include "src/sounds/bcfire01_48k.wav.h"
-#include "src/sounds/pacmanDeath.wav.h"
-#include "src/sounds/gameBoyStartup.wav.h"
-#include "src/sounds/gunEmpty48k.wav.h"
-#include "src/sounds/powerUp48k.wav.h"
-#include "src/sounds/screamAndDie48k.wav.h"
-#include "src/sounds/ouch48k.wav.h"
-#include "src/sounds/gameOver48k.wav.h"
-#include "src/sounds/healing_fixed.wav.h"
-#include "src/sounds/healed.wav.h"
-#include "src/sounds/low_health.wav.h"
+#include "src/sounds/sounds.h"
+#include "src/390_libs/adpcm.h"
+#include "src/390_libs/mixer.h"
+#include "src/390_libs/fifoRefill.h"
+#include "src/390_libs/soundPack.h"
 #include "supportFiles/interrupts.h"  // Just for sound_runTest().
 
 /***************************************************************
@@ -38,8 +32,7 @@
 
 #define SOUND_MULTIPLIER INT16_MAX/3  // Primitive volume control.
 
-#define ONE_SECOND_OF_SOUND_ARRAY_SIZE 48000  // The sample rate is 48k so that is 1 second's worth.
-uint16_t soundOfSilence[ONE_SECOND_OF_SOUND_ARRAY_SIZE];
+#define ONE_SECOND_OF_SOUND_SAMPLE_COUNT 48000  // The sample rate is 48k so that is 1 second's worth.
 
 // Declared below the sound state-machine code.
 int AudioInitialize(u16 timerID,  u16 iicID, u32 i2sAddr);
@@ -50,17 +43,34 @@ int AudioInitialize(u16 timerID,  u16 iicID, u32 i2sAddr);
 // True if sound_init() has been called, false otherwise.
 static bool sound_initFlag = false;
 
-// True if a sound should be played, false otherwise.
-// Note that the state-machine sets this back to false once it has completed playing a sound.
-static volatile bool sound_playSoundFlag = false;
-
-// Keep track of the base pointer to the sound array with current sample-rate
-// and sample count.
-static uint16_t* sound_array;     // Base pointer to the sound array.
+// The sound chosen with sound_setSound(), for sound_startSound(): its ADPCM data (see adpcm.h,
+// NULL for silence) and sample count. The sounds themselves play on the mixer's voices (see mixer.h).
+static bool sound_soundSet = false;           // False until sound_setSound() picks a valid sound.
+static sound_sounds_t sound_currentSound;     // The sound picked.
+static const uint8_t* sound_adpcmData;        // Its ADPCM blocks.
 
 //static uint32_t sound_sampleRate;  // Sample rate for this sound.
 static uint32_t sound_sampleCount; // Number of samples in this sound.
 
+// The mixer fills this a block at a time and sound_tick() empties it into the FIFO.
+// Mixing at most SOUND_MIX_BLOCKS_PER_TICK blocks per tick bounds the time sound_tick() spends in the ISR
+// (MIXER_VOICE_COUNT voices of MIXER_BLOCK_SIZE samples each); a block outlasts a burst (see sound.h).
+// The samples are scaled by the volume as soon as a block is mixed, so a burst only writes registers.
+#define SOUND_MIX_BLOCKS_PER_TICK 1
+static int16_t sound_mixBlock[MIXER_BLOCK_SIZE];  // Mixed samples (signed).
+static uint32_t sound_frameBlock[MIXER_BLOCK_SIZE]; // The same, offset and scaled by the volume for the FIFO.
+static uint32_t sound_mixCount = 0;               // Samples in sound_frameBlock.
+static uint32_t sound_mixIndex = 0;               // Next one to send.
+
+// Estimates the room in the TX FIFO, which only reports full (see fifoRefill.h).
+#define SOUND_TX_FIFO_MARGIN_FRAMES 4             // A burst leaves this much room for clock mismatch.
+#define SOUND_INTERRUPT_RATE 100000               // sound_tick() runs every SOUND_TICK_RATE_DIVIDER of these.
+#define SOUND_TX_FIFO_MEASURE_LIMIT_WORDS 4096    // sound_measureTxFifoDepth() gives up if the FIFO is not full by then.
+#define SOUND_TX_FIFO_FULL_MASK 0b0010            // TX full bit of I2S_FIFO_STS_REG.
+#define SOUND_WORDS_PER_FRAME 2                   // Left and right.
+static fifoRefill_t sound_txFifo;
+static uint32_t sound_txFifoDepthFrames = SOUND_TX_FIFO_DEPTH_FRAMES;  // Measured by sound_init().
+
 // Keep track of the current volume setting.
 static sound_volume_t sound_currentVolume = sound_minimumVolume_e;
 
@@ -86,6 +96,41 @@ void sound_disableTxFifo() {
   Xil_Out32(AUDIO_CTRL_BASEADDR + I2S_CTRL_REG, 0b00);  // Disable TX FIFO.
 }
 
+// Returns true if the TX FIFO is full.
+static bool sound_isTxFifoFull() {
+  return Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) & SOUND_TX_FIFO_FULL_MASK;
+}
+
+// Counts the frames the TX FIFO holds: with TX disabled nothing drains, so write silence until it
+// reports full, then reset it. Returns SOUND_TX_FIFO_DEPTH_FRAMES if it never fills.
+static uint32_t sound_measureTxFifoDepth() {
+  sound_disableTxFifo();
+  sound_resetTxFifo();
+  uint32_t words = 0;
+  while (!sound_isTxFifoFull() && words < SOUND_TX_FIFO_MEASURE_LIMIT_WORDS) {
+    Xil_Out32(AUDIO_CTRL_BASEADDR + I2S_TX_FIFO_REG, 0);
+    words++;
+  }
+  sound_resetTxFifo();
+  uint32_t frames = words / SOUND_WORDS_PER_FRAME;
+  if (!frames || words == SOUND_TX_FIFO_MEASURE_LIMIT_WORDS) {
+    printf("sound_init(): the TX FIFO did not report full; assuming %d frames\n", SOUND_TX_FIFO_DEPTH_FRAMES);
+    return SOUND_TX_FIFO_DEPTH_FRAMES;
+  }
+  return frames;
+}
+
+// Mixes the next block and scales it for the FIFO. Returns false once every voice is done.
+static bool sound_mixNextBlock() {
+  sound_mixCount = mixer_render(sound_mixBlock, MIXER_BLOCK_SIZE);
+  sound_mixIndex = 0;
+  for (uint32_t i = 0; i < sound_mixCount; i++) {
+    uint16_t sample = (uint16_t) (sound_mixBlock[i] + ADPCM_UNSIGNED_OFFSET);  // Unsigned, like the assets.
+    sound_frameBlock[i] = sample * sound_currentVolume;                       // Scale by volume.
+  }
+  return sound_mixCount != 0;
+}
+
 // sampleValue is sent to both the left and right channels.
 void sound_sendDataToBothChannels(uint32_t sampleValue) {
   Xil_Out32(AUDIO_CTRL_BASEADDR + I2S_TX_FIFO_REG, sampleValue); // add to left Channel.
@@ -102,11 +147,15 @@ void sound_setVolume(sound_volume_t volume) {
 sound_status_t sound_init() {
   AudioInitialize(SCU_TIMER_ID, AUDIO_IIC_ID, AUDIO_CTRL_BASEADDR);
 //  TimerInitialize(SCU_TIMER_ID);
-  sound_initFlag = true;
-  // Initialize the silence array.
-  for (uint32_t i=0; i<ONE_SECOND_OF_SOUND_ARRAY_SIZE; i++)
-    soundOfSilence[i] = NO_SOUND;
+  sound_txFifoDepthFrames = sound_measureTxFifoDepth();
+  mixer_init();  // No voices playing.
   sound_setVolume(sound_minimumVolume_e);  // Init the volume level.
+  if (!soundPack_isValid(sounds_pack, sounds_packEnd - sounds_pack, SOUND_SAMPLE_RATE)) {
+    printf("sound_init(): the sound pack is not valid or not at %d Hz; rebuild src/sounds/sounds.pack\n",
+        SOUND_SAMPLE_RATE);
+    return SOUND_STATUS_FAIL;
+  }
+  sound_initFlag = true;  // The state machine stays in sound_init_st without a valid pack.
   return SOUND_STATUS_OK;
 }
 
@@ -141,7 +190,6 @@ static void debugStatePrint() {
 
 void sound_tick() {
 //  debugStatePrint();
-  static uint32_t arrayIndex = 0;
   // Action switch statement.
   switch(currentState) {
   case sound_init_st:
@@ -162,111 +210,136 @@ void sound_tick() {
     }
     break;
   case sound_wait_st:
-    if (sound_playSoundFlag) {
-      arrayIndex = 0;
+    if (mixer_isBusy()) {
+      sound_mixCount = 0;   // Nothing mixed yet.
+      sound_mixIndex = 0;
       currentState = sound_play_st;
       sound_resetTxFifo();  // Reset the TX FIFO.
+      fifoRefill_init(&sound_txFifo, sound_txFifoDepthFrames, SOUND_TX_FIFO_MARGIN_FRAMES,
+          SOUND_SAMPLE_RATE * SOUND_TICK_RATE_DIVIDER, SOUND_INTERRUPT_RATE);
       sound_enableTxFifo(); // Enable the TX FIFO, disable mute.
     }
     break;
   case sound_play_st:
-    // Each time you enter this state, add as many samples as will fit in the FIFO.
-    if (sound_array == NULL) {
-      printf("ERROR, sound_tick: sound array has not been set.\n");
-      return;
-    }
-    // This while-loop continues to load sound-data into the FIFOs until it is full or
-    // the sound data are exhausted.
-    while (!(Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) & 0b0010)) { // while room in FIFO.
-      uint32_t sampleValue = sound_array[arrayIndex] * sound_currentVolume;   // Scale by volume.
-      sound_sendDataToBothChannels(sampleValue);  // Send the sound data to the left and right channels.
-      arrayIndex++;                               // Go to next sample.
-      if (arrayIndex == sound_sampleCount) {      // All done?
-        sound_playSoundFlag = false;              // Yes.
-        sound_disableTxFifo();                    // Disable the TX FIFO.
-        currentState = sound_wait_st;             // Go back to the wait state.
+    // Each time you enter this state, write a burst of the frames played since the last time
+    // (or as many as SOUND_MIX_BLOCKS_PER_TICK blocks hold), then read the FIFO status once.
+    {
+      uint32_t frames = fifoRefill_framesToWrite(&sound_txFifo);
+      uint32_t written = 0;
+      uint32_t blocksMixed = 0;
+      while (written < frames) {
+        if (sound_mixIndex == sound_mixCount) {     // Block used up: mix the next one.
+          if (blocksMixed == SOUND_MIX_BLOCKS_PER_TICK)
+            break;                                  // Enough work for this tick.
+          blocksMixed++;
+          if (!sound_mixNextBlock()) {              // All voices done?
+            sound_disableTxFifo();                  // Disable the TX FIFO.
+            currentState = sound_wait_st;           // Go back to the wait state.
+            return;                                 // Nothing left to send.
+          }
+        }
+        sound_sendDataToBothChannels(sound_frameBlock[sound_mixIndex++]);  // Left and right channels.
+        written++;
       }
+      fifoRefill_wrote(&sound_txFifo, written, sound_isTxFifoFull());
     }
     break;
   }
 }
 
 
-// Returns true if the sound state machine is not back in its initial state.
+// Returns true while any sound is playing.
 bool sound_isBusy() {
-  return (sound_playSoundFlag);  // Busy if NOT in the wait state.
+  return mixer_isBusy();
 }
 
-// Stops the sound and resets the state-machine to the wait state.
+// Stops every sound and resets the state-machine to the wait state.
 void sound_stopSound() {
-  sound_playSoundFlag = false;  // disable the state-machine.
+  mixer_stopAll();              // Silence every voice.
   currentState = sound_wait_st; // Force the state-machine back to the wait state.
 }
 
-// Use this to set the base address for the array containing sound data.
-// Allow sounds to be interrupted.
-void sound_setSound(sound_sounds_t sound) {
-  if (sound_isBusy()) {  // You are currently playing some sound.
-    sound_stopSound();   // Stop the sound and reset the state-machine, FIFO, etc.
-  }
-  sound_array = NULL;  // Set the pointer to NULL so you can detect it never being set.
+// Finds the ADPCM data (NULL for silence) and sample count of a sound in the sound pack.
+// Returns false for a bogus sound, or one missing from the pack.
+static bool sound_lookup(sound_sounds_t sound, const uint8_t** adpcmData, uint32_t* sampleCount) {
+  const char* name;  // Name in the pack: the sound's file name in assets/sounds.
   switch(sound) {
   case sound_gameStart_e:
-    sound_array = gameBoyStartup_wav;  // Set the array holding the data.
-    sound_sampleCount = GAMEBOYSTARTUP_WAV_NUMBER_OF_SAMPLES;  // Size of the array.
+    name = "gameBoyStartup";
     break;
   case sound_gunFire_e:
-    sound_array = bcfire01_48k_wav;  // Set the array holding the data.
-    sound_sampleCount = BCFIRE01_48K_WAV_NUMBER_OF_SAMPLES;  // Size of the array.
+    name = "bcfire01_48k";
     break;
   case sound_hit_e:
-    sound_array = ouch48k_wav;  // You get the idea...
-    sound_sampleCount = OUCH48K_WAV_NUMBER_OF_SAMPLES;
+    name = "ouch48k";
     break;
   case sound_gunClick_e:
-    sound_array = gunEmpty48k_wav;
-    sound_sampleCount = GUNEMPTY48K_WAV_NUMBER_OF_SAMPLES;
+    name = "gunEmpty48k";
     break;
   case sound_gunReload_e:
-    sound_array = powerUp48k_wav;
-    sound_sampleCount = POWERUP48K_WAV_NUMBER_OF_SAMPLES;
+    name = "powerUp48k";
     break;
   case sound_loseLife_e:
-    sound_array = screamAndDie48k_wav;
-    sound_sampleCount = SCREAMANDDIE48K_WAV_NUMBER_OF_SAMPLES;
+    name = "screamAndDie48k";
     break;
   case sound_gameOver_e:
-    sound_array = pacmanDeath_wav;
-    sound_sampleCount = PACMANDEATH_WAV_NUMBER_OF_SAMPLES;
+    name = "pacmanDeath";
     break;
   case sound_returnToBase_e:
-    sound_array = gameOver48k_wav;
-    sound_sampleCount = GAMEOVER48K_WAV_NUMBER_OF_SAMPLES;
+    name = "gameOver48k";
     break;
   case sound_low_health_e:
-    sound_array = low_health_wav;
-    sound_sampleCount = LOW_HEALTH_WAV_NUMBER_OF_SAMPLES;
+    name = "low_health";
     break;
   case sound_healing_e:
-    sound_array = healing_fixed_wav;
-    sound_sampleCount = HEALING_FIXED_WAV_NUMBER_OF_SAMPLES;
+    name = "healing_fixed";
     break;
   case sound_healed_e:
-    sound_array = healed_wav;
-    sound_sampleCount = HEALED_WAV_NUMBER_OF_SAMPLES;
+    name = "healed";
     break;
   case sound_oneSecondSilence_e:
-    sound_array = soundOfSilence;
-    sound_sampleCount = ONE_SECOND_OF_SOUND_ARRAY_SIZE;
-    break;
+    *adpcmData = NULL;  // The mixer plays NULL data as silence.
+    *sampleCount = ONE_SECOND_OF_SOUND_SAMPLE_COUNT;
+    return true;
   default:
     printf("sound_setSound(): bogus sound value(%d)\n", sound);
+    return false;
   }
+  const soundPack_entry_t* entry = soundPack_find(sounds_pack, name);
+  if (entry == NULL) {
+    printf("sound_setSound(): %s is not in the sound pack\n", name);
+    return false;
+  }
+  *adpcmData = soundPack_data(sounds_pack, entry);  // Set the array holding the data.
+  *sampleCount = entry->sampleCount;                // Size of the array.
+  return true;
+}
+
+// Use this to set the base address for the array containing sound data.
+// Allow sounds to be interrupted: everything that is playing stops.
+void sound_setSound(sound_sounds_t sound) {
+  if (sound_isBusy()) {  // You are currently playing some sound.
+    sound_stopSound();   // Stop the sound and reset the state-machine, FIFO, etc.
+  }
+  sound_soundSet = sound_lookup(sound, &sound_adpcmData, &sound_sampleCount);
+  sound_currentSound = sound;
 }
 
 // Tell the state machine to start playing the sound.
 void sound_startSound() {
-  sound_playSoundFlag = true;
+  if (!sound_soundSet) {
+    printf("ERROR, sound_startSound: sound array has not been set.\n");
+    return;
+  }
+  mixer_play(sound_currentSound, sound_adpcmData, sound_sampleCount, SOUND_GAIN_UNITY);
+}
+
+// Plays a sound on top of whatever is playing, scaled by gain.
+void sound_mixSound(sound_sounds_t sound, uint16_t gain) {
+  const uint8_t* adpcmData;
+  uint32_t sampleCount;
+  if (sound_lookup(sound, &adpcmData, &sampleCount))
+    mixer_play(sound, adpcmData, sampleCount, gain);
 }
 
 // Returns true if the sound has been played. State machine will have returned to its initial state.
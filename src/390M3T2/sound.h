@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "src/390_libs/mixer.h"
 
 typedef uint32_t sound_status_t;
 #define SOUND_STATUS_OK 0
@@ -35,6 +36,16 @@ typedef uint32_t sound_status_t;
 
 #define NO_SOUND 0 // A zero generates no sound.
 
+// Up to MIXER_VOICE_COUNT sounds play at once, each with its own gain (see mixer.h).
+#define SOUND_GAIN_UNITY MIXER_GAIN_UNITY // Gain of 1.0 for sound_mixSound().
+
+// sound_tick() only refills the I2S TX FIFO, in bursts, so it runs on every 30th 100 kHz interrupt (3.3 kHz):
+// 48 kHz audio drains 16 stereo frames, half of the FIFO, between calls.
+#define SOUND_TICK_RATE_DIVIDER 30
+#define SOUND_SAMPLE_RATE 48000          // Of every sound, and of the codec.
+#define SOUND_TX_FIFO_DEPTH_FRAMES 32    // Stereo frames the I2S TX FIFO is expected to hold (two words each); sound_init()
+                                         // measures the real depth and only falls back to this if that fails.
+
 // sound-specific defines.
 typedef enum {
   sound_gameStart_e,    // Play a sound when the game starts.
@@ -66,10 +77,11 @@ sound_status_t sound_init();
 // Standard tick function.
 void sound_tick();
 
-// Returns true if the sound state machine is not back in its initial state.
+// Returns true while any sound is playing.
 bool sound_isBusy();
 
 // Use this to set the base address for the array containing sound data.
+// Stops everything that is playing.
 void sound_setSound(sound_sounds_t sound);
 
 // Set the sample rate. Should only do this when no sound is currently playing.
@@ -81,9 +93,13 @@ void sound_setVolume(sound_volume_t);
 // Tell the state machine to start playing the sound.
 void sound_startSound();
 
-// Tell the state machine to stop playing the sound.
+// Tell the state machine to stop playing every sound.
 void sound_stopSound();
 
+// Plays a sound on top of whatever is playing, scaled by gain (SOUND_GAIN_UNITY for as recorded).
+// A sound that is already playing starts over; with every voice busy, the one closest to ending is replaced.
+void sound_mixSound(sound_sounds_t sound, uint16_t gain);
+
 // Returns true if the sound has been played. State machine will have returned to its initial state.
 bool sound_isSoundComplete();
 
@@ -8,6 +8,7 @@
 #include "hitLedTimer.h"
 #include "lockoutTimer.h"
 #include "trigger.h"
+#include "src/390_libs/timerWheel.h"
 
 void runTransmitterNonContinuousTest();
 void runTransmitterContinuousTest();
@@ -16,6 +17,7 @@ int main()
 {
     //trigger_init();
     //hitLedTimer_init();
+    timerWheel_init();
     lockoutTimer_init();
     interrupts_initAll(true);               // main interrupt init function.
     interrupts_enableTimerGlobalInts();     // enable global interrupts.
@@ -41,8 +43,11 @@ int main()
 void isr_function() {
        //transmitter_tick();
        //trigger_tick();
-       //hitLedTimer_tick();
-       lockoutTimer_tick();
+       static uint32_t timerWheelDivider = 0;                            // lockoutTimer and hitLedTimer time on 1 kHz timerWheel ticks.
+       if (++timerWheelDivider == TIMER_WHEEL_TICK_RATE_DIVIDER) {
+           timerWheelDivider = 0;
+           timerWheel_tick();
+       }
    }
 
 void runTransmitterNonContinuousTest()
@@ -4,6 +4,8 @@
 // The trigger state machine debounces both the press and release of gun trigger.
 // Ultimately, it will activate the transmitter when a debounced press is detected.
 
+#define TRIGGER_TICK_RATE_DIVIDER 10    // trigger_tick() runs on every 10th 100 kHz interrupt (10 kHz).
+
 // Init trigger data-structures.
 // Determines whether the trigger switch of the gun is connected (see discussion in lab web pages).
 // Initializes the mio subsystem.
@@ -6,13 +6,13 @@
 #include "soundutil.h"
 #include "src/390M3T2/hitLedTimer.h"
 #include "src/390M3T2/detector.h"
+#include "src/390_libs/timerWheel.h"
 
-#define GAME_RESPAWN_DELAY 500e3            // 5 seconds; time to hide after losing a life.
+#define GAME_RESPAWN_DELAY 5000             // 5 seconds of 1 kHz timerWheel ticks; time to hide after losing a life.
 #define GAME_NUM_LIFES 3                    // 3 lives for the game
 #define GAME_INITIAL_HITS 0                 // 0 initial hits
 #define GAME_HITS_PER_LIFE 4                // 5 hits per life
 #define GAME_HITS_LOW_HEALTH 3				// Hit # 3 is a low health warning
-#define GAME_INITIAL_DELAY_VALUE 0          // start delay counter at zero
 
 #define HEALING_CHANNEL 3
 
@@ -21,7 +21,8 @@ static volatile bool wasShot = false;       // A flag set by the detection loop
 
 static uint8_t hits = GAME_INITIAL_HITS;            // The number of times the player has been shot in this life
 static uint8_t livesRemaining = GAME_NUM_LIFES;     // The number of lives remaining for the player
-static uint32_t delay = GAME_INITIAL_DELAY_VALUE;   // A counter used to time how long to stay in the respawn state
+static timerWheel_timer_t respawnTimer;            // Times how long to stay in the respawn state
+static volatile bool respawnDelayExpired = false;  // Set by respawnTimer when it is time to respawn
 
 // Game States
 enum game_st_t {
@@ -34,6 +35,11 @@ enum game_st_t {
 // Needed to debug, but not public
 void game_debugStatePrint();
 
+// Timer wheel callback: the player has had GAME_RESPAWN_DELAY ticks to hide
+static void respawnTimerExpired(timerWheel_timer_t*) {
+    respawnDelayExpired = true;
+}
+
 // Initialize the game state machine
 void game_init () {
     // Start in the initial state
@@ -48,8 +54,9 @@ void game_init () {
     // Reset remaining lives to 3
     livesRemaining = GAME_NUM_LIFES;
     
-    // Reset delay counter
-    delay = GAME_INITIAL_DELAY_VALUE;
+    // Stop any pending respawn delay
+    timerWheel_cancel(&respawnTimer);
+    respawnDelayExpired = false;
 }
 
 // Game tick function
@@ -68,10 +75,10 @@ void game_tick () {
                     
                     // Play the heal sound
                     if (hits == 0) {
-	                    soundutil_forcePlay(sound_healed_e);
+	                    soundutil_play(sound_healed_e);
 					}
 					else {
-	                    soundutil_forcePlay(sound_healing_e);
+	                    soundutil_play(sound_healing_e);
 					}
                 }
                 // IF the player still has health (not 5 hits yet)
@@ -84,11 +91,11 @@ void game_tick () {
                     
 					if (hits >= GAME_HITS_LOW_HEALTH) {
 		                // Play the low health sound
-		                soundutil_forcePlay(sound_low_health_e);
+		                soundutil_play(sound_low_health_e);
 					}
 					else {
 		                // Play the hit sound
-		                soundutil_forcePlay(sound_hit_e);
+		                soundutil_play(sound_hit_e);
 					}
                 }
                 // Otherwise, 5 hits causes the player to lose a life
@@ -97,7 +104,7 @@ void game_tick () {
                     hits = GAME_INITIAL_HITS;
 
                     // Play the "lose life" sound
-                    soundutil_forcePlay(sound_loseLife_e);
+                    soundutil_play(sound_loseLife_e);
                     
                     // Shut off hit detection (give time for player to hide)
                     game_setRunDetection(false);
@@ -110,6 +117,10 @@ void game_tick () {
 
                     // If player has lives left
                     if (livesRemaining > 0) {
+                        // Start the respawn delay
+                        respawnDelayExpired = false;
+                        timerWheel_arm(&respawnTimer, GAME_RESPAWN_DELAY, respawnTimerExpired);
+
                         // Transition to respawn state
                         gameState = respawn_st;
                     }
@@ -126,10 +137,10 @@ void game_tick () {
         }
         break;
         case respawn_st: {
-            // If we hit our delay time
-            if (delay >= GAME_RESPAWN_DELAY) {
-                // Reset delay counter
-                delay = GAME_INITIAL_DELAY_VALUE;
+            // If the respawn timer has expired
+            if (respawnDelayExpired) {
+                // Consume the expiry
+                respawnDelayExpired = false;
                 
                 // Reset the gun
                 gun_init();
@@ -153,10 +164,7 @@ void game_tick () {
     switch (gameState) {
         case init_st: break;        // No action
         case alive_st: break;       // No action
-        case respawn_st: {          // When in respawn state
-            delay++;                // Increment the delay counter 
-        }
-        break;
+        case respawn_st: break;     // No action, respawnTimer does the timing
         case game_over_st: break;   // No action
         default: printf("Something is wrong"); break;
     }
@@ -1,6 +1,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define GAME_TICK_RATE_DIVIDER 100  // game_tick() runs on every 100th 100 kHz interrupt (1 kHz).
+
 void game_init();   // Initialize game SM
 void game_tick();   // Tick for Game SM
 
@@ -2,15 +2,16 @@
 #include "../390M3T2/trigger.h"
 #include "../390M3T2/transmitter.h"
 #include "soundutil.h"
+#include "../390_libs/timerWheel.h"
 #include <stdio.h>
 
 #define MAX_SHOTCOUNT 10			//The number of shots in the clip before reloading is necessary
 #define NO_SHOTS_LEFT 0				//The number of shots when there are no shots left
-#define RESET 0						//Used to reset most integer variables
 #define SHOT_SUCCESSFUL true		//the value to return when shots are fired
 #define SHOT_UNSUCCESSFUL false		//the value to return if no shot was actually fired
-#define FORCE_RELOAD_TIME 300000	//the length of time before reloading if forced ( = 3 seconds)
-#define AUTO_RELOAD_TIME 200000		//the length of the auto-reload time in ticks ( = 2 seconds)
+#define FORCE_RELOAD_TIME 3000		//the length of time before reloading if forced, in 1 kHz timerWheel ticks ( = 3 seconds)
+#define AUTO_RELOAD_TIME 2000		//the length of the auto-reload time in 1 kHz timerWheel ticks ( = 2 seconds)
+#define RELOAD_TIMEOUT(time) ((time) + 1)	//The old reload counter had to pass the time (>), so the gun reloads one tick after it
 #define DEBUG 0
 
 //States for the gun state machine
@@ -25,6 +26,28 @@ enum gun_st_t {
 
 static uint8_t shotCount = MAX_SHOTCOUNT;	//Initialize the gun with a full clip
 static bool gun_enabled = true;				//The gun should be initially enabled
+static timerWheel_timer_t reloadTimer;		//Times the force-reload and auto-reload states
+static volatile bool reloadTimeExpired = false;	//Set by reloadTimer when the reload time is up
+
+//Timer wheel callback: the gun has been in a reload state long enough
+static void reloadTimerExpired(timerWheel_timer_t*)
+{
+    reloadTimeExpired = true;
+}
+
+//Starts timing a reload state
+static void startReloadTimer(uint32_t ticks)
+{
+    reloadTimeExpired = false;
+    timerWheel_arm(&reloadTimer, ticks, reloadTimerExpired);
+}
+
+//Stops timing when a reload state is left early
+static void stopReloadTimer()
+{
+    timerWheel_cancel(&reloadTimer);
+    reloadTimeExpired = false;
+}
 
 //Initialize and resets the gun and sets the player frequency?
 void gun_init()
@@ -32,13 +55,14 @@ void gun_init()
     trigger_init();				//Also ensure that the trigger state machine is initialized
     gun_currentState = init_st;	//Start the state machine in the init state
     shotCount = MAX_SHOTCOUNT;	//Make sure the clip is full initially
+    stopReloadTimer();			//No reload in progress
     trigger_enable();			//Enable the trigger state machine
 }
 
 //Reloads the gun and plays the reload sound
 void gun_reload()
 {
-    soundutil_forcePlay(sound_gunReload_e);	//If the gun needs to be reloaded, play the reload sound
+    soundutil_play(sound_gunReload_e);	//If the gun needs to be reloaded, play the reload sound
     shotCount = MAX_SHOTCOUNT;				//refill the gun's clip
 }
 
@@ -46,12 +70,12 @@ bool gun_attemptShot()
 {
     if (shotCount > NO_SHOTS_LEFT)	//If we still have shots in our clip
     {
-        soundutil_forcePlay(sound_gunFire_e);//Play the shooting sound
+        soundutil_play(sound_gunFire_e);//Play the shooting sound
         transmitter_run();			//Shoot at our specified frequency
         shotCount--;				//decrement shot count
         return SHOT_SUCCESSFUL;		//Return that we've successfully shot
     }
-    soundutil_forcePlay(sound_gunClick_e);//play clicking sound if no shot was made because of an empty clip
+    soundutil_play(sound_gunClick_e);//play clicking sound if no shot was made because of an empty clip
     return SHOT_UNSUCCESSFUL;		//Otherwise, if our clip was empty, return that we did not successfully shoot
 }
 
@@ -99,13 +123,11 @@ void debugStatePrint() {
 void gun_tick()
 {
     if (DEBUG) debugStatePrint();		//If we are in DEBUG mode, then print out the current state
-    static uint32_t reloadTimer = RESET;//Initialize our timer that will keep track of how long we wait before reloading
     //State transitions
     switch (gun_currentState)
     {
     case init_st:
         gun_currentState = wait_st;	//Go to our first state where we will wait for the trigger to be pulled
-        reloadTimer = RESET;		//Reset the reload timer initially
         break;
 
     case wait_st:
@@ -119,7 +141,6 @@ void gun_tick()
         {
             gun_currentState = wait_st;	//If the trigger was not pulled or we are not enabled, keep waiting
             trigger_clearWantsToShoot();//Clear the flag that told us the player is trying to shoot (to indicate we have handled it)
-            reloadTimer = RESET;        //Reset the reload timer initially
         }
         break;
 
@@ -128,7 +149,6 @@ void gun_tick()
         {
             gun_currentState = wait_st;
             trigger_clearWantsToShoot();//Clear the flag that told us the player is trying to shoot (to indicate we have handled it)
-            reloadTimer = RESET;        //Reset the reload timer initially
         }
         else if(!transmitter_running()){ //If the transmitter is not running anymore
             gun_currentState = shot_st; //Go to the state where we have already shot and will decide if we need to reload
@@ -141,19 +161,19 @@ void gun_tick()
 
     case shot_st:
         //Check if we need to auto-reload (out of ammo), or if we should go to force-reload state
-        reloadTimer = RESET;	//Reset the reload timer before going into either reload state
         if (!gun_enabled)
         {
             gun_currentState = wait_st;
             trigger_clearWantsToShoot();//Clear the flag that told us the player is trying to shoot (to indicate we have handled it)
-            reloadTimer = RESET;        //Reset the reload timer initially
         }
         else if (shotCount == NO_SHOTS_LEFT)	//If we have no shots left
         {
+            startReloadTimer(RELOAD_TIMEOUT(AUTO_RELOAD_TIME));	//Start timing the auto-reload
             gun_currentState = auto_reload_st;	//Then we need to auto-reload no matter what
         }
         else
         {
+            startReloadTimer(RELOAD_TIMEOUT(FORCE_RELOAD_TIME));	//Start timing how long the trigger is held
             gun_currentState = force_reload_st;	//Otherwise, check to see if the player wants to force a reload
         }
         break;
@@ -163,13 +183,14 @@ void gun_tick()
         {
             gun_currentState = wait_st;
             trigger_clearWantsToShoot();//Clear the flag that told us the player is trying to shoot (to indicate we have handled it)
-            reloadTimer = RESET;        //Reset the reload timer initially
+            stopReloadTimer();          //Abandon the reload
         }
         else if (!trigger_debouncePressed())	//If the debounced trigger is no longer being pulled
         {
+            stopReloadTimer();			//The trigger was released before the reload time
             gun_currentState = wait_st;	//Go back to the state where we will wait for the next shot to be fired
         }
-        else if (reloadTimer > FORCE_RELOAD_TIME)	//if the trigger is still being pressed and 3 seconds have passed
+        else if (reloadTimeExpired)	//if the trigger is still being pressed and 3 seconds have passed
         {
             gun_reload();				//Reload the gun
             gun_currentState = wait_st;	//Go back to the wait state
@@ -185,9 +206,9 @@ void gun_tick()
         {
             gun_currentState = wait_st;
             trigger_clearWantsToShoot();//Clear the flag that told us the player is trying to shoot (to indicate we have handled it)
-            reloadTimer = RESET;        //Reset the reload timer initially
+            stopReloadTimer();          //Abandon the reload
         }
-        else if (reloadTimer > AUTO_RELOAD_TIME)	//If we reached the 2 second auto-reloading time
+        else if (reloadTimeExpired)	//If we reached the 2 second auto-reloading time
         {
 
             gun_reload();				//Reload the gun
@@ -221,11 +242,9 @@ void gun_tick()
         break;
 
     case force_reload_st:
-        reloadTimer++;		//Increment the reload timer while we are in this state
         break;
 
     case auto_reload_st:
-        reloadTimer++;		//Increment the reload timer while we are in this state
         break;
     }
 }
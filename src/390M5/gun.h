@@ -1,5 +1,7 @@
 #include <stdint.h>
 
+#define GUN_TICK_RATE_DIVIDER 100	//gun_tick() runs on every 100th 100 kHz interrupt (1 kHz)
+
 //Initializes and resets the gun state machine
 void gun_init();
 
@@ -9,6 +9,8 @@
 #include "src/390M3T2/trigger.h"
 #include "supportFiles/interrupts.h"
 #include "supportFiles/switches.h"
+#include "supportFiles/globalTimer.h"
+#include "src/390_libs/displayQueue.h"
 #include "src/390M3T2/lockoutTimer.h"
 #include "src/390M3T2/sound.h"
 #include "soundutil.h"
@@ -18,6 +20,8 @@
 #define DETECTOR_HIT_ARRAY_SIZE FILTER_FREQUENCY_COUNT  // The array contains one location per user frequency.
 #define HISTOGRAM_BAR_COUNT FILTER_FREQUENCY_COUNT      // As many histogram bars as user filter frequencies.
 #define SYSTEM_TICKS_PER_HISTOGRAM_UPDATE 30000         // Update the histogram about 3 times per second.
+#define GAME_DISPLAY_BUDGET_TICKS (GLOBAL_TIMER_TICKS_PER_SECOND / 2000)  // 500 us of histogram drawing per loop (see runningModes.c)
+#define GAME_DISPLAY_MAX_BACKLOG 100                    // Skip the drawing while more ADC samples than this are waiting
 
 #define GAME_MASK_SWITCH 0x1    // Mask for reading the position of the first switch
 #define GAME_FREQ_TEAM_A 6      // Channel for Team A
@@ -32,8 +36,11 @@ void init() {
     // Display
     display_init();
     
-    // Histogram
+    // Histogram, drawn a few bars at a time between detector() calls
     histogram_init(HISTOGRAM_BAR_COUNT);
+    globalTimer_startTimer(false);
+    displayQueue_init(globalTimer_getTimerValue);
+    histogram_useDisplayQueue(true);
     
     // Detector
     detector_init();
@@ -115,7 +122,12 @@ int main() {
                 histogram_plotUserHits(hitCounts); // Plot the hit counts on the TFT.
             }
         }
+
+        // Draw some of the histogram if the detector is keeping up
+        if (isr_adcBufferElementCount() < GAME_DISPLAY_MAX_BACKLOG)
+            displayQueue_run(GAME_DISPLAY_BUDGET_TICKS);
     }
+    displayQueue_flush();   // The last hit shows on the histogram
     
     // Pac-Man Death
     sound_setSound(sound_gameOver_e);   // Set it
@@ -16,3 +16,10 @@ void soundutil_forcePlay(sound_sounds_t sound) {
     // Play the new sound
     sound_startSound();
 }
+
+// Utility function that will play a sound on top of
+// whatever else is playing (see sound_mixSound())
+void soundutil_play(sound_sounds_t sound) {
+    // Mix it in at its recorded level (the mixer makes room when sounds overlap)
+    sound_mixSound(sound, SOUND_GAIN_UNITY);
+}
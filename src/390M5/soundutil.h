@@ -4,3 +4,7 @@
 // and play the new one
 void soundutil_forcePlay(sound_sounds_t sound);
 
+// Utility function that will play a sound on top of
+// whatever else is playing (see sound_mixSound())
+void soundutil_play(sound_sounds_t sound);
+
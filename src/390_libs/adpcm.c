@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <math.h>
+#include "adpcm.h"
+
+#define ADPCM_NIBBLE_SIGN 0x8       // Set for a negative difference.
+#define ADPCM_NIBBLE_MAGNITUDE 0x7  // Difference in units of step / 4 (plus step / 8).
+#define ADPCM_NIBBLE_MASK 0xF
+#define ADPCM_NIBBLE_BITS 4
+
+// Quantizer step sizes, about 10% apart (the standard IMA table).
+static const int16_t adpcm_stepTable[ADPCM_STEP_INDEX_MAX + 1] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// Step index change for each nibble magnitude: small differences shrink the step, large ones grow it.
+static const int8_t adpcm_indexTable[ADPCM_NIBBLE_MAGNITUDE + 1] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+// Applies one nibble to the predictor and step index; the encoder and decoder share it so they stay in step.
+static inline int32_t adpcm_applyNibble(int32_t* predictor, int32_t* stepIndex, uint8_t nibble) {
+  int32_t step = adpcm_stepTable[*stepIndex];
+  int32_t difference = step >> 3;
+  if (nibble & 4) difference += step;
+  if (nibble & 2) difference += step >> 1;
+  if (nibble & 1) difference += step >> 2;
+  int32_t sample = (nibble & ADPCM_NIBBLE_SIGN) ? *predictor - difference : *predictor + difference;
+  if (sample > INT16_MAX) sample = INT16_MAX;
+  if (sample < INT16_MIN) sample = INT16_MIN;
+  *predictor = sample;
+
+  int32_t index = *stepIndex + adpcm_indexTable[nibble & ADPCM_NIBBLE_MAGNITUDE];
+  if (index < 0) index = 0;
+  if (index > ADPCM_STEP_INDEX_MAX) index = ADPCM_STEP_INDEX_MAX;
+  *stepIndex = index;
+  return sample;
+}
+
+// Starts decoding an asset of sampleCount samples.
+void adpcm_decoderInit(adpcm_decoder_t* decoder, const uint8_t* data, uint32_t sampleCount) {
+  decoder->next = data;
+  decoder->samplesLeft = sampleCount;
+  decoder->blockSamplesLeft = 0;  // Start with a header.
+  decoder->predictor = 0;
+  decoder->stepIndex = 0;
+  decoder->nibbles = 0;
+  decoder->highNibble = false;
+}
+
+// A header restarts the predictor with an exact sample; otherwise the next nibble moves it.
+int16_t adpcm_decodeNext(adpcm_decoder_t* decoder) {
+  if (decoder->samplesLeft == 0)
+    return 0;
+  decoder->samplesLeft--;
+
+  if (decoder->blockSamplesLeft == 0) {
+    const uint8_t* header = decoder->next;
+    decoder->predictor = (int16_t) (header[0] | (header[1] << 8));
+    decoder->stepIndex = header[2] > ADPCM_STEP_INDEX_MAX ? ADPCM_STEP_INDEX_MAX : header[2];
+    decoder->next += ADPCM_BLOCK_HEADER_BYTES;
+    decoder->blockSamplesLeft = ADPCM_SAMPLES_PER_BLOCK - 1;
+    decoder->highNibble = false;
+    return decoder->predictor;
+  }
+
+  uint8_t nibble;
+  if (decoder->highNibble) {
+    nibble = decoder->nibbles >> ADPCM_NIBBLE_BITS;
+  } else {
+    decoder->nibbles = *decoder->next++;
+    nibble = decoder->nibbles & ADPCM_NIBBLE_MASK;
+  }
+  decoder->highNibble = !decoder->highNibble;
+  decoder->blockSamplesLeft--;
+  return adpcm_applyNibble(&decoder->predictor, &decoder->stepIndex, nibble);
+}
+
+// Decodes up to count samples into pcm[].
+uint32_t adpcm_decode(adpcm_decoder_t* decoder, int16_t pcm[], uint32_t count) {
+  if (count > decoder->samplesLeft)
+    count = decoder->samplesLeft;
+  for (uint32_t i = 0; i < count; i++)
+    pcm[i] = adpcm_decodeNext(decoder);
+  return count;
+}
+
+// Picks the nibble whose reconstruction is closest to the sample (the standard successive approximation
+// of the difference in step, step / 2, step / 4) and applies it exactly as the decoder will.
+static uint8_t adpcm_encodeSample(int32_t* predictor, int32_t* stepIndex, int32_t sample) {
+  int32_t step = adpcm_stepTable[*stepIndex];
+  int32_t difference = sample - *predictor;
+  uint8_t nibble = 0;
+  if (difference < 0) {
+    nibble = ADPCM_NIBBLE_SIGN;
+    difference = -difference;
+  }
+  if (difference >= step) {
+    nibble |= 4;
+    difference -= step;
+  }
+  step >>= 1;
+  if (difference >= step) {
+    nibble |= 2;
+    difference -= step;
+  }
+  step >>= 1;
+  if (difference >= step)
+    nibble |= 1;
+  adpcm_applyNibble(predictor, stepIndex, nibble);
+  return nibble;
+}
+
+// Picks the nibble for pcm[0] that minimizes its squared error plus that of the best nibble for pcm[1]
+// (pass count 1 at the end of a block), and applies it. Looking one sample ahead lets the encoder grow
+// the step early for a transient, which the one-sample choice does too late.
+static uint8_t adpcm_encodeSampleLookahead(int32_t* predictor, int32_t* stepIndex, const int16_t pcm[], uint32_t count) {
+  uint8_t bestNibble = 0;
+  double bestError = -1;
+  for (uint8_t nibble = 0; nibble <= ADPCM_NIBBLE_MASK; nibble++) {
+    int32_t p = *predictor, s = *stepIndex;
+    double difference = (double) pcm[0] - adpcm_applyNibble(&p, &s, nibble);
+    double error = difference * difference;
+    if (count > 1) {
+      double nextError = -1;
+      for (uint8_t next = 0; next <= ADPCM_NIBBLE_MASK; next++) {
+        int32_t p2 = p, s2 = s;
+        double nextDifference = (double) pcm[1] - adpcm_applyNibble(&p2, &s2, next);
+        if (nextError < 0 || nextDifference * nextDifference < nextError)
+          nextError = nextDifference * nextDifference;
+      }
+      error += nextError;
+    }
+    if (bestError < 0 || error < bestError) {
+      bestError = error;
+      bestNibble = nibble;
+    }
+  }
+  adpcm_applyNibble(predictor, stepIndex, bestNibble);
+  return bestNibble;
+}
+
+// Squared error of encoding pcm[1 .. count-1] after an exact pcm[0], starting at stepIndex.
+static double adpcm_blockError(const int16_t pcm[], uint32_t count, int32_t stepIndex) {
+  int32_t predictor = pcm[0];
+  double error = 0;
+  for (uint32_t i = 1; i < count; i++) {
+    adpcm_encodeSample(&predictor, &stepIndex, pcm[i]);
+    double difference = (double) pcm[i] - predictor;
+    error += difference * difference;
+  }
+  return error;
+}
+
+// Each block starts with its first sample and a step index; the nibbles follow. Encoding is done
+// offline, so every step index is tried and the block keeps the one with the least error, as estimated
+// with the one-sample choice (the one carried over from the previous block wins ties).
+uint32_t adpcm_encode(const int16_t pcm[], uint32_t sampleCount, uint8_t data[]) {
+  uint8_t* out = data;
+  int32_t predictor = 0;
+  int32_t stepIndex = 0;
+  for (uint32_t blockStart = 0; blockStart < sampleCount; blockStart += ADPCM_SAMPLES_PER_BLOCK) {
+    uint32_t blockEnd = blockStart + ADPCM_SAMPLES_PER_BLOCK;
+    if (blockEnd > sampleCount)
+      blockEnd = sampleCount;
+
+    double bestError = adpcm_blockError(pcm + blockStart, blockEnd - blockStart, stepIndex);
+    for (int32_t index = 0; index <= ADPCM_STEP_INDEX_MAX; index++) {
+      double error = adpcm_blockError(pcm + blockStart, blockEnd - blockStart, index);
+      if (error < bestError) {
+        bestError = error;
+        stepIndex = index;
+      }
+    }
+
+    predictor = pcm[blockStart];
+    *out++ = (uint8_t) predictor;
+    *out++ = (uint8_t) (predictor >> 8);
+    *out++ = (uint8_t) stepIndex;
+    *out++ = 0;
+
+    for (uint32_t i = blockStart + 1; i < blockEnd; i += 2) {
+      uint8_t byte = adpcm_encodeSampleLookahead(&predictor, &stepIndex, pcm + i, blockEnd - i);
+      if (i + 1 < blockEnd)
+        byte |= adpcm_encodeSampleLookahead(&predictor, &stepIndex, pcm + i + 1, blockEnd - i - 1) << ADPCM_NIBBLE_BITS;
+      *out++ = byte;
+    }
+  }
+  return out - data;
+}
+
+// 10 log10(signal energy / error energy).
+double adpcm_snr(const int16_t original[], const int16_t decoded[], uint32_t sampleCount) {
+  double signal = 0, noise = 0;
+  for (uint32_t i = 0; i < sampleCount; i++) {
+    double error = (double) original[i] - decoded[i];
+    signal += (double) original[i] * original[i];
+    noise += error * error;
+  }
+  if (noise == 0)
+    return INFINITY;
+  return 10 * log10(signal / noise);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Test code.
+
+#define ADPCM_TEST_MAX_SAMPLES (4 * ADPCM_SAMPLES_PER_BLOCK + ADPCM_SAMPLES_PER_BLOCK / 2)
+#define ADPCM_TEST_SAMPLE_RATE 48000.0
+#define ADPCM_TEST_CHUNK 37                         // Odd chunk size for the chunked decode.
+#define ADPCM_TEST_PI 3.14159265358979323846
+
+// The test signals and the SNR each must reach.
+typedef enum {
+  adpcm_testSilence_e,
+  adpcm_testSquare_e,       // Full scale, 1 kHz: each edge takes several samples to slew (the worst case).
+  adpcm_testTone_e,         // 440 Hz at -10 dBFS.
+  adpcm_testSweep_e,        // 100 Hz to 8 kHz.
+  adpcm_testNoise_e,        // White noise at -12 dBFS: nothing to predict.
+  adpcm_testSignalCount_e
+} adpcm_testSignal_t;
+
+static const char* adpcm_testNames[adpcm_testSignalCount_e] = {"silence", "square", "tone", "sweep", "noise"};
+static const double adpcm_testMinimumSnr[adpcm_testSignalCount_e] = {INFINITY, 10, 40, 22, 14};
+
+// Lengths that end mid-block (odd and even) and on a block boundary.
+static const uint32_t adpcm_testLengths[] = {1, 2, ADPCM_SAMPLES_PER_BLOCK, ADPCM_SAMPLES_PER_BLOCK + 2, ADPCM_TEST_MAX_SAMPLES};
+#define ADPCM_TEST_LENGTH_COUNT (sizeof(adpcm_testLengths) / sizeof(adpcm_testLengths[0]))
+
+static int16_t adpcm_testPcm[ADPCM_TEST_MAX_SAMPLES];
+static int16_t adpcm_testDecoded[ADPCM_TEST_MAX_SAMPLES];
+static int16_t adpcm_testChunked[ADPCM_TEST_MAX_SAMPLES];
+static uint8_t adpcm_testData[ADPCM_ENCODED_SIZE(ADPCM_TEST_MAX_SAMPLES)];
+
+// Fills adpcm_testPcm[] with a signal.
+static void adpcm_testFill(adpcm_testSignal_t signal, uint32_t sampleCount) {
+  uint32_t random = 1;
+  double phase = 0;
+  for (uint32_t i = 0; i < sampleCount; i++) {
+    double t = i / ADPCM_TEST_SAMPLE_RATE;
+    double value = 0;
+    switch (signal) {
+    case adpcm_testSilence_e:
+      value = 0;
+      break;
+    case adpcm_testSquare_e:
+      value = (i / 24) % 2 ? INT16_MAX : -INT16_MAX;
+      break;
+    case adpcm_testTone_e:
+      value = 10362 * sin(2 * ADPCM_TEST_PI * 440 * t);
+      break;
+    case adpcm_testSweep_e:
+      phase += 2 * ADPCM_TEST_PI * (100 + 7900.0 * i / ADPCM_TEST_MAX_SAMPLES) / ADPCM_TEST_SAMPLE_RATE;
+      value = 16000 * sin(phase);
+      break;
+    case adpcm_testNoise_e:
+      random = random * 1664525 + 1013904223;
+      value = (int32_t) (random >> 16) - 32768;
+      value /= 4;
+      break;
+    default:
+      break;
+    }
+    adpcm_testPcm[i] = (int16_t) value;
+  }
+}
+
+// Each signal at each length: encoded size, SNR, and one-at-a-time against chunked decoding.
+bool adpcm_runTest() {
+  bool success = true;
+  for (uint32_t signal = 0; signal < adpcm_testSignalCount_e; signal++) {
+    double snr = 0;
+    for (uint32_t l = 0; l < ADPCM_TEST_LENGTH_COUNT; l++) {
+      uint32_t sampleCount = adpcm_testLengths[l];
+      adpcm_testFill((adpcm_testSignal_t) signal, sampleCount);
+      uint32_t size = adpcm_encode(adpcm_testPcm, sampleCount, adpcm_testData);
+      if (size != ADPCM_ENCODED_SIZE(sampleCount)) {
+        printf("adpcm_runTest: %s, %lu samples encoded to %lu bytes, expected %lu.\n\r", adpcm_testNames[signal],
+            (unsigned long) sampleCount, (unsigned long) size, (unsigned long) ADPCM_ENCODED_SIZE(sampleCount));
+        success = false;
+      }
+
+      adpcm_decoder_t decoder;
+      adpcm_decoderInit(&decoder, adpcm_testData, sampleCount);
+      for (uint32_t i = 0; i < sampleCount; i++)
+        adpcm_testDecoded[i] = adpcm_decodeNext(&decoder);
+      if (adpcm_decodeNext(&decoder) != 0) {
+        printf("adpcm_runTest: %s, decoding past the end did not return 0.\n\r", adpcm_testNames[signal]);
+        success = false;
+      }
+
+      adpcm_decoderInit(&decoder, adpcm_testData, sampleCount);
+      uint32_t decodedCount = 0;
+      uint32_t count;
+      while ((count = adpcm_decode(&decoder, adpcm_testChunked + decodedCount, ADPCM_TEST_CHUNK)) > 0)
+        decodedCount += count;
+      bool chunkedMatches = decodedCount == sampleCount;
+      for (uint32_t i = 0; i < sampleCount && chunkedMatches; i++)
+        chunkedMatches = adpcm_testChunked[i] == adpcm_testDecoded[i];
+      if (!chunkedMatches) {
+        printf("adpcm_runTest: %s, %lu samples: chunked decoding differs.\n\r", adpcm_testNames[signal],
+            (unsigned long) sampleCount);
+        success = false;
+      }
+
+      // Every block starts with its exact first sample.
+      for (uint32_t i = 0; i < sampleCount; i += ADPCM_SAMPLES_PER_BLOCK) {
+        if (adpcm_testDecoded[i] != adpcm_testPcm[i]) {
+          printf("adpcm_runTest: %s, block at sample %lu does not start exactly.\n\r", adpcm_testNames[signal],
+              (unsigned long) i);
+          success = false;
+        }
+      }
+
+      // Only the longest signal is long enough for a meaningful SNR.
+      if (sampleCount == ADPCM_TEST_MAX_SAMPLES)
+        snr = adpcm_snr(adpcm_testPcm, adpcm_testDecoded, sampleCount);
+    }
+    printf("  %-8s SNR %6.1f dB\n\r", adpcm_testNames[signal], snr);
+    if (!(snr >= adpcm_testMinimumSnr[signal])) {
+      printf("adpcm_runTest: %s SNR %.1f dB is below %.1f dB.\n\r", adpcm_testNames[signal], snr,
+          adpcm_testMinimumSnr[signal]);
+      success = false;
+    }
+  }
+  printf("adpcm_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef ADPCM_HOST_TEST
+// Host entry point for adpcm_runTest(), see adpcm.h.
+int main() {
+  return adpcm_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,65 @@
+#ifndef ADPCM_H_
+#define ADPCM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// IMA-ADPCM (4 bits per sample) for the sound assets in src/sounds.
+// An asset is a sequence of blocks, each a 4-byte header followed by packed nibbles:
+//   bytes 0-1  first sample of the block, little-endian int16 (stored exactly)
+//   byte  2    step index (0 .. ADPCM_STEP_INDEX_MAX) for the block's first nibble
+//   byte  3    0
+//   then ADPCM_SAMPLES_PER_BLOCK - 1 nibbles, low nibble first.
+// The last block may be short. Restarting the predictor every block keeps an encoding error
+// from lasting more than ~21 ms, and lets a player start from any block.
+//
+// Samples are signed; the assets were unsigned 16-bit (silence at 32768), so players add
+// ADPCM_UNSIGNED_OFFSET to get the original representation back.
+//
+// tools/wav2adpcm converts WAV files (or wav2c arrays) to assets with adpcm_encode().
+
+#define ADPCM_BLOCK_HEADER_BYTES 4
+#define ADPCM_BLOCK_BYTES 516                                     // Header plus 512 bytes of nibbles.
+#define ADPCM_SAMPLES_PER_BLOCK 1025                              // The header sample plus 1024 nibbles.
+#define ADPCM_STEP_INDEX_MAX 88
+#define ADPCM_UNSIGNED_OFFSET 32768                               // Added to decoded samples for the unsigned assets.
+
+// Bytes needed to encode sampleCount samples.
+#define ADPCM_ENCODED_SIZE(sampleCount) \
+  (((sampleCount) / ADPCM_SAMPLES_PER_BLOCK) * ADPCM_BLOCK_BYTES \
+   + ((sampleCount) % ADPCM_SAMPLES_PER_BLOCK ? ADPCM_BLOCK_HEADER_BYTES + (sampleCount) % ADPCM_SAMPLES_PER_BLOCK / 2 : 0))
+
+// Streaming decoder: produces the samples of one asset in order, one or more at a time.
+typedef struct {
+  const uint8_t* next;        // Next byte of the asset (a block header or nibbles).
+  uint32_t samplesLeft;       // Samples of the asset not yet decoded.
+  uint32_t blockSamplesLeft;  // Nibbles left in the current block (0: a header comes next).
+  int32_t predictor;          // Last decoded sample.
+  int32_t stepIndex;          // Index into the step table.
+  uint8_t nibbles;            // The byte being decoded.
+  bool highNibble;            // True if the high nibble of nibbles comes next.
+} adpcm_decoder_t;
+
+// Starts decoding an asset of sampleCount samples.
+void adpcm_decoderInit(adpcm_decoder_t* decoder, const uint8_t* data, uint32_t sampleCount);
+
+// Returns the next sample, or 0 once all sampleCount have been decoded.
+int16_t adpcm_decodeNext(adpcm_decoder_t* decoder);
+
+// Decodes up to count samples into pcm[] and returns how many (fewer only at the end of the asset).
+uint32_t adpcm_decode(adpcm_decoder_t* decoder, int16_t pcm[], uint32_t count);
+
+// Encodes sampleCount samples into data[], which must hold ADPCM_ENCODED_SIZE(sampleCount) bytes.
+// Returns the number of bytes written.
+uint32_t adpcm_encode(const int16_t pcm[], uint32_t sampleCount, uint8_t data[]);
+
+// Signal-to-noise ratio (dB) of decoded against original; infinite if they are identical.
+double adpcm_snr(const int16_t original[], const int16_t decoded[], uint32_t sampleCount);
+
+// Encodes and decodes test signals (silence, full-scale square, tones, noise, a sweep) of lengths that
+// end inside and on block boundaries, and checks the SNR of each and that decoding one sample at a time
+// and in chunks agree. Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DADPCM_HOST_TEST src/390_libs/adpcm.c
+bool adpcm_runTest();
+
+#endif /* ADPCM_H_ */
@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <math.h>
+#include "cfar.h"
+
+#define CFAR_INIT_VALUE 0                 // Starting value of the counters.
+#define CFAR_MEDIAN_INDEX 4               // Lower median of ten values.
+#define CFAR_MAX_INDEX 9                  // Largest of ten values.
+#define CFAR_RESEED_COUNT 1               // A re-seeded floor has seen one vector: the one it starts from.
+
+// Rational approximation of the upper-tail normal quantile (Abramowitz & Stegun 26.2.23, |error| < 4.5e-4).
+#define CFAR_QUANTILE_C0 2.515517
+#define CFAR_QUANTILE_C1 0.802853
+#define CFAR_QUANTILE_C2 0.010328
+#define CFAR_QUANTILE_D1 1.432788
+#define CFAR_QUANTILE_D2 0.189269
+#define CFAR_QUANTILE_D3 0.001308
+
+// z with P(N(0,1) > z) = p, for 0 < p < 0.5.
+static double upperTailQuantile(double p) {
+  double t = sqrt(-2.0 * log(p));
+  return t - (CFAR_QUANTILE_C0 + t * (CFAR_QUANTILE_C1 + t * CFAR_QUANTILE_C2)) /
+      (1.0 + t * (CFAR_QUANTILE_D1 + t * (CFAR_QUANTILE_D2 + t * CFAR_QUANTILE_D3)));
+}
+
+// Empty floors.
+void cfar_init(cfar_t* cfar, double falseAlarmProbability) {
+  for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+    cfar->mean[c] = CFAR_INIT_VALUE;
+    cfar->variance[c] = CFAR_INIT_VALUE;
+    cfar->updateCount[c] = CFAR_INIT_VALUE;
+    cfar->censoredRun[c] = CFAR_INIT_VALUE;
+  }
+  cfar_setFalseAlarmProbability(cfar, falseAlarmProbability);
+}
+
+// Store z^2 so the threshold test needs no square root.
+void cfar_setFalseAlarmProbability(cfar_t* cfar, double falseAlarmProbability) {
+  double z = upperTailQuantile(falseAlarmProbability);
+  cfar->thresholdScaleSquared = z * z;
+}
+
+// Compare-exchange without a branch: the compiler turns both selects into conditional moves.
+#define CFAR_COMPARE_EXCHANGE(v, a, b) { \
+  double low = ((v)[a] < (v)[b]) ? (v)[a] : (v)[b]; \
+  double high = ((v)[a] < (v)[b]) ? (v)[b] : (v)[a]; \
+  (v)[a] = low; \
+  (v)[b] = high; \
+}
+
+// Waksman's 29-comparator network for ten inputs, minus the three comparators whose outputs never
+// reach position 4 (checked against sorting by cfar_runTest()).
+double cfar_median(const double power[]) {
+  double v[CFAR_CHANNEL_COUNT];
+  for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++)
+    v[c] = power[c];
+  CFAR_COMPARE_EXCHANGE(v, 0, 8); CFAR_COMPARE_EXCHANGE(v, 1, 9); CFAR_COMPARE_EXCHANGE(v, 2, 7);
+  CFAR_COMPARE_EXCHANGE(v, 3, 5); CFAR_COMPARE_EXCHANGE(v, 4, 6);
+  CFAR_COMPARE_EXCHANGE(v, 0, 2); CFAR_COMPARE_EXCHANGE(v, 1, 4); CFAR_COMPARE_EXCHANGE(v, 5, 8);
+  CFAR_COMPARE_EXCHANGE(v, 7, 9);
+  CFAR_COMPARE_EXCHANGE(v, 0, 3); CFAR_COMPARE_EXCHANGE(v, 2, 4); CFAR_COMPARE_EXCHANGE(v, 5, 7);
+  CFAR_COMPARE_EXCHANGE(v, 6, 9);
+  CFAR_COMPARE_EXCHANGE(v, 0, 1); CFAR_COMPARE_EXCHANGE(v, 3, 6); CFAR_COMPARE_EXCHANGE(v, 8, 9);
+  CFAR_COMPARE_EXCHANGE(v, 1, 5); CFAR_COMPARE_EXCHANGE(v, 2, 3); CFAR_COMPARE_EXCHANGE(v, 4, 8);
+  CFAR_COMPARE_EXCHANGE(v, 6, 7);
+  CFAR_COMPARE_EXCHANGE(v, 1, 2); CFAR_COMPARE_EXCHANGE(v, 3, 5); CFAR_COMPARE_EXCHANGE(v, 4, 6);
+  CFAR_COMPARE_EXCHANGE(v, 2, 3); CFAR_COMPARE_EXCHANGE(v, 4, 5);
+  CFAR_COMPARE_EXCHANGE(v, 3, 4);
+  return v[CFAR_MEDIAN_INDEX];
+}
+
+// Threshold test, floor update with censoring, and the strongest candidate, channel by channel.
+int8_t cfar_detect(cfar_t* cfar, const double power[], int8_t ignoreChannel) {
+  double guard = cfar_median(power) * CFAR_MEDIAN_GUARD_RATIO;
+  int8_t hitChannel = CFAR_NO_HIT;
+  double hitPower = CFAR_INIT_VALUE;
+  for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+    double x = power[c];
+    double mean = cfar->mean[c];
+    double deviation = x - mean;
+    double minVariance = CFAR_MIN_RELATIVE_DEVIATION * CFAR_MIN_RELATIVE_DEVIATION * mean * mean;
+    double variance = (cfar->variance[c] > minVariance) ? cfar->variance[c] : minVariance;
+    bool warm = cfar->updateCount[c] >= CFAR_WARMUP_VECTORS;
+    bool exceeds = warm && deviation > 0 && deviation * deviation > cfar->thresholdScaleSquared * variance;
+    if (exceeds && cfar->censoredRun[c] < CFAR_MAX_CENSORED_VECTORS) {
+      cfar->censoredRun[c]++;  // Keep the shot out of the floor.
+    } else if (exceeds) {
+      // Too long for a shot: the floor itself has moved. Start it over from here and warm up again.
+      cfar->mean[c] = x;
+      cfar->variance[c] = CFAR_INIT_VALUE;
+      cfar->updateCount[c] = CFAR_RESEED_COUNT;
+      cfar->censoredRun[c] = CFAR_INIT_VALUE;
+    } else {
+      // The first vectors are averaged evenly so the floor starts out right, then the EMA takes over.
+      double alpha = warm ? CFAR_NOISE_ALPHA : 1.0 / (cfar->updateCount[c] + 1);
+      cfar->mean[c] = mean + alpha * deviation;
+      cfar->variance[c] += alpha * (deviation * deviation - cfar->variance[c]);
+      cfar->updateCount[c] += !warm;
+      cfar->censoredRun[c] = CFAR_INIT_VALUE;
+    }
+    bool candidate = exceeds && x > guard && x > hitPower && (int8_t) c != ignoreChannel;
+    hitChannel = candidate ? (int8_t) c : hitChannel;
+    hitPower = candidate ? x : hitPower;
+  }
+  return hitChannel;
+}
+
+// The same floor update, with the answer thrown away.
+void cfar_track(cfar_t* cfar, const double power[]) {
+  cfar_detect(cfar, power, CFAR_NO_HIT);
+}
+
+/******************************************************************************************
+ ************************************ Evaluation code **************************************
+ ******************************************************************************************/
+
+#define CFAR_MICROSECONDS_PER_SECOND 1000000.0
+#define CFAR_PERCENT 100.0
+#define CFAR_VECTORS_PER_SECOND 10000     // Decimated sample rate, for false alarms per minute.
+#define CFAR_SECONDS_PER_MINUTE 60.0
+
+// One power and its channel, for the fixed rule's sort.
+typedef struct {
+  uint8_t channel;
+  double value;
+} cfar_element_t;
+
+// The detector's original algorithm, kept for comparison: bubble sort, then max > median * fixedRatio.
+static int8_t fixedRatioDetect(const double power[], double fixedRatio, int8_t ignoreChannel) {
+  cfar_element_t values[CFAR_CHANNEL_COUNT];
+  for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+    values[c].channel = c;
+    values[c].value = power[c];
+  }
+  for (uint32_t i = 0; i < CFAR_CHANNEL_COUNT - 1; i++) {
+    for (uint32_t j = 0; j < CFAR_CHANNEL_COUNT - i - 1; j++) {
+      if (values[j].value > values[j + 1].value) {
+        cfar_element_t temp = values[j];
+        values[j] = values[j + 1];
+        values[j + 1] = temp;
+      }
+    }
+  }
+  cfar_element_t max = values[CFAR_MAX_INDEX];
+  if (max.value > values[CFAR_MEDIAN_INDEX].value * fixedRatio && max.channel != ignoreChannel)
+    return max.channel;
+  return CFAR_NO_HIT;
+}
+
+// Per-algorithm bookkeeping while the trace runs.
+typedef struct {
+  cfar_evaluation_t* result;
+  uint32_t lockoutRemaining;  // Vectors left in the lockout after the last hit.
+  bool shotDetected;          // The current shot has already been counted as detected.
+} cfar_evaluationState_t;
+
+// Scores one algorithm's answer for the current vector.
+static void scoreHit(cfar_evaluationState_t* state, int8_t hit, int8_t shooter) {
+  if (hit == CFAR_NO_HIT)
+    return;
+  state->lockoutRemaining = CFAR_EVALUATION_LOCKOUT_VECTORS;
+  if (hit == shooter) {
+    state->result->detectedShotCount += !state->shotDetected;
+    state->shotDetected = true;
+  } else {
+    state->result->falseAlarmCount++;
+  }
+}
+
+// One line of the report.
+static void printEvaluation(const char* name, cfar_evaluation_t* result, uint64_t vectorCount, uint32_t ticksPerSecond) {
+  double minutes = vectorCount / (double) CFAR_VECTORS_PER_SECOND / CFAR_SECONDS_PER_MINUTE;
+  printf("%-9s %5lu/%-5lu shots (%5.1f%%) %7.2f false alarms/min %9.3f us/call\n\r", name,
+      (unsigned long) result->detectedShotCount, (unsigned long) result->shotCount,
+      result->shotCount ? CFAR_PERCENT * result->detectedShotCount / result->shotCount : 0.0,
+      result->falseAlarmCount / minutes,
+      result->callCount ? result->ticks * CFAR_MICROSECONDS_PER_SECOND / ticksPerSecond / result->callCount : 0.0);
+}
+
+// Both algorithms see every vector (outside their own lockout), timed one call at a time.
+void cfar_evaluate(cfar_traceReader_t reader, double falseAlarmProbability, double fixedRatio,
+    profiler_timeSource_t timeSource, uint32_t ticksPerSecond, cfar_evaluation_t* adaptive, cfar_evaluation_t* fixed) {
+  static cfar_t cfar;
+  cfar_init(&cfar, falseAlarmProbability);
+  cfar_evaluationState_t states[2] = {{adaptive, CFAR_INIT_VALUE, false}, {fixed, CFAR_INIT_VALUE, false}};
+  for (uint32_t i = 0; i < 2; i++) {
+    cfar_evaluation_t zero = {CFAR_INIT_VALUE, CFAR_INIT_VALUE, CFAR_INIT_VALUE, CFAR_INIT_VALUE, CFAR_INIT_VALUE};
+    *states[i].result = zero;
+  }
+  double power[CFAR_CHANNEL_COUNT];
+  int8_t shooter;
+  int8_t previousShooter = CFAR_NO_HIT;
+  uint64_t vectorCount = CFAR_INIT_VALUE;
+  while (reader(power, &shooter)) {
+    vectorCount++;
+    if (shooter != previousShooter) {
+      for (uint32_t i = 0; i < 2; i++) {
+        states[i].result->shotCount += (shooter != CFAR_NO_HIT);
+        states[i].shotDetected = false;
+      }
+      previousShooter = shooter;
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+      cfar_evaluationState_t* state = &states[i];
+      if (state->lockoutRemaining) {
+        state->lockoutRemaining--;
+        if (i == 0)
+          cfar_track(&cfar, power);  // As the detector does: the floors keep up through the lockout.
+        continue;
+      }
+      uint64_t start = timeSource();
+      int8_t hit = (i == 0) ? cfar_detect(&cfar, power, CFAR_NO_HIT) : fixedRatioDetect(power, fixedRatio, CFAR_NO_HIT);
+      state->result->ticks += timeSource() - start;
+      state->result->callCount++;
+      scoreHit(state, hit, shooter);
+    }
+  }
+  printf("cfar_evaluate: %lu vectors, false-alarm target %g, fixed ratio %g.\n\r",
+      (unsigned long) vectorCount, falseAlarmProbability, fixedRatio);
+  printEvaluation("adaptive", adaptive, vectorCount, ticksPerSecond);
+  printEvaluation("fixed", fixed, vectorCount, ticksPerSecond);
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define CFAR_TEST_RANDOM_VECTORS 100000       // Random inputs checked against sorting.
+#define CFAR_TEST_TRACE_VECTORS 600000        // 60 s of synthetic trace.
+#define CFAR_TEST_FLOOR_BASE 20.0             // Quietest channel's mean power.
+#define CFAR_TEST_FLOOR_STEP 2.0              // Each channel's floor is a little higher than the last.
+#define CFAR_TEST_INTERFERED_CHANNEL 7        // Steady interference on this channel...
+#define CFAR_TEST_INTERFERENCE_RATIO 200.0    // ...at this multiple of its floor (above the fixed ratio).
+#define CFAR_TEST_NOISE_DEVIATION 0.2         // Relative fluctuation of the floors.
+#define CFAR_TEST_DRIFT_DEPTH 0.5             // The whole room's floor swings by +-50%...
+#define CFAR_TEST_DRIFT_PERIOD 200000         // ...every 20 s.
+#define CFAR_TEST_SHOT_VECTORS 2000           // A shot lasts 200 ms.
+#define CFAR_TEST_MIN_GAP_VECTORS 10000       // 1 to 2 s between shots.
+#define CFAR_TEST_MIN_SHOT_RATIO 20.0         // Shots are 20x ...
+#define CFAR_TEST_MAX_SHOT_RATIO 2000.0       // ... to 2000x the floor of their channel (log-uniform).
+#define CFAR_TEST_FIXED_RATIO 150.0           // The detector's DETECTOR_FUDGE_FACTOR.
+#define CFAR_TEST_MIN_DETECTION_PERCENT 95.0  // The adaptive detector must find at least this share of the shots...
+#define CFAR_TEST_MAX_FALSE_ALARMS 2          // ...with at most this many false alarms in the whole trace.
+#define CFAR_TEST_GAUSSIAN_TERMS 12           // Uniforms summed for an approximately Gaussian value.
+#define CFAR_TEST_PI 3.14159265358979323846
+#define CFAR_TEST_STEP_CHANNEL 3              // This channel's floor steps up...
+#define CFAR_TEST_STEP_RATIO 200.0            // ...200x...
+#define CFAR_TEST_STEP_START 20000            // ...2 s into a 6 s trace...
+#define CFAR_TEST_STEP_TRACE_VECTORS 60000
+#define CFAR_TEST_STEP_SETTLE_VECTORS 12000   // ...and must stop hitting within 1.2 s (censoring and warm-up).
+
+static uint32_t testRandomState;
+static uint32_t testVector;
+static uint32_t testNextShotStart;
+static int8_t testShooter;
+static double testShotRatio;
+
+// Deterministic uniform in [0, 1).
+static double testUniform() {
+  testRandomState = testRandomState * 1103515245 + 12345;
+  return (testRandomState >> 8) / (double) (1UL << 24);
+}
+
+// Mean 0, deviation 1 (Irwin-Hall).
+static double testGaussian() {
+  double sum = CFAR_INIT_VALUE;
+  for (uint32_t i = 0; i < CFAR_TEST_GAUSSIAN_TERMS; i++)
+    sum += testUniform();
+  return sum - CFAR_TEST_GAUSSIAN_TERMS / 2;
+}
+
+// Trace reader: drifting floors, one interfered channel, and a shot on a random channel every 1-2 s.
+static bool testTraceReader(double power[], int8_t* shooter) {
+  if (testVector == CFAR_TEST_TRACE_VECTORS)
+    return false;
+  if (testVector == testNextShotStart) {
+    testShooter = testUniform() * CFAR_CHANNEL_COUNT;
+    testShotRatio = CFAR_TEST_MIN_SHOT_RATIO * pow(CFAR_TEST_MAX_SHOT_RATIO / CFAR_TEST_MIN_SHOT_RATIO, testUniform());
+  }
+  if (testVector == testNextShotStart + CFAR_TEST_SHOT_VECTORS) {
+    testShooter = CFAR_NO_HIT;
+    testNextShotStart = testVector + CFAR_TEST_MIN_GAP_VECTORS + testUniform() * CFAR_TEST_MIN_GAP_VECTORS;
+  }
+  double drift = 1.0 + CFAR_TEST_DRIFT_DEPTH * sin(2 * CFAR_TEST_PI * testVector / CFAR_TEST_DRIFT_PERIOD);
+  for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+    double floor = (CFAR_TEST_FLOOR_BASE + CFAR_TEST_FLOOR_STEP * c) * drift;
+    if (c == CFAR_TEST_INTERFERED_CHANNEL)
+      floor *= CFAR_TEST_INTERFERENCE_RATIO;
+    double noise = 1.0 + CFAR_TEST_NOISE_DEVIATION * testGaussian();
+    power[c] = floor * ((noise > 0) ? noise : 0) * (((int8_t) c == testShooter) ? testShotRatio : 1.0);
+  }
+  *shooter = testShooter;
+  testVector++;
+  return true;
+}
+
+// A lasting step in one floor: hits (with the lockout, tracking through it) until the floor starts over.
+static bool testStepChange() {
+  static cfar_t cfar;
+  cfar_init(&cfar, CFAR_DEFAULT_FALSE_ALARM_PROBABILITY);
+  testRandomState = 1;
+  uint32_t lockoutRemaining = CFAR_INIT_VALUE;
+  uint32_t hitCount = CFAR_INIT_VALUE;
+  uint32_t lateHitCount = CFAR_INIT_VALUE;
+  for (uint32_t v = 0; v < CFAR_TEST_STEP_TRACE_VECTORS; v++) {
+    double power[CFAR_CHANNEL_COUNT];
+    for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+      double noise = 1.0 + CFAR_TEST_NOISE_DEVIATION * testGaussian();
+      bool stepped = (c == CFAR_TEST_STEP_CHANNEL && v >= CFAR_TEST_STEP_START);
+      power[c] = (CFAR_TEST_FLOOR_BASE + CFAR_TEST_FLOOR_STEP * c) * ((noise > 0) ? noise : 0) *
+          (stepped ? CFAR_TEST_STEP_RATIO : 1.0);
+    }
+    if (lockoutRemaining) {
+      lockoutRemaining--;
+      cfar_track(&cfar, power);
+      continue;
+    }
+    if (cfar_detect(&cfar, power, CFAR_NO_HIT) != CFAR_NO_HIT) {
+      lockoutRemaining = CFAR_EVALUATION_LOCKOUT_VECTORS;
+      hitCount++;
+      lateHitCount += (v >= CFAR_TEST_STEP_START + CFAR_TEST_STEP_SETTLE_VECTORS);
+    }
+  }
+  printf("cfar_runTest: a %gx step in a floor gave %lu hits, %lu of them after %g s.\n\r", CFAR_TEST_STEP_RATIO,
+      (unsigned long) hitCount, (unsigned long) lateHitCount, CFAR_TEST_STEP_SETTLE_VECTORS / (double) CFAR_VECTORS_PER_SECOND);
+  return lateHitCount == 0;
+}
+
+// The network against a plain sort, then the two detectors on the synthetic trace, then a step in a floor.
+bool cfar_runTest(profiler_timeSource_t timeSource, uint32_t ticksPerSecond) {
+  bool success = true;
+  testRandomState = 1;
+  for (uint32_t n = 0; n < CFAR_TEST_RANDOM_VECTORS && success; n++) {
+    double power[CFAR_CHANNEL_COUNT];
+    double sorted[CFAR_CHANNEL_COUNT];
+    for (uint32_t c = 0; c < CFAR_CHANNEL_COUNT; c++) {
+      power[c] = (n & 1) ? testUniform() : (double) (uint32_t) (testUniform() * 4);  // Odd: distinct, even: many ties.
+      uint32_t i = c;
+      for (; i > 0 && sorted[i - 1] > power[c]; i--)
+        sorted[i] = sorted[i - 1];
+      sorted[i] = power[c];
+    }
+    if (cfar_median(power) != sorted[CFAR_MEDIAN_INDEX]) {
+      printf("cfar_runTest: median %f, expected %f.\n\r", cfar_median(power), sorted[CFAR_MEDIAN_INDEX]);
+      success = false;
+    }
+  }
+  testRandomState = 1;
+  testVector = CFAR_INIT_VALUE;
+  testNextShotStart = CFAR_TEST_MIN_GAP_VECTORS;
+  testShooter = CFAR_NO_HIT;
+  cfar_evaluation_t adaptive, fixed;
+  cfar_evaluate(testTraceReader, CFAR_DEFAULT_FALSE_ALARM_PROBABILITY, CFAR_TEST_FIXED_RATIO, timeSource, ticksPerSecond,
+      &adaptive, &fixed);
+  if (adaptive.detectedShotCount * CFAR_PERCENT < CFAR_TEST_MIN_DETECTION_PERCENT * adaptive.shotCount ||
+      adaptive.falseAlarmCount > CFAR_TEST_MAX_FALSE_ALARMS ||
+      adaptive.detectedShotCount <= fixed.detectedShotCount || adaptive.falseAlarmCount >= fixed.falseAlarmCount) {
+    printf("cfar_runTest: adaptive detector did not beat the fixed ratio on the synthetic trace.\n\r");
+    success = false;
+  }
+  if (!testStepChange())
+    success = false;
+  printf("cfar_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef CFAR_HOST_TEST
+#include <time.h>
+
+#define CFAR_HOST_NANOSECONDS_PER_SECOND 1000000000
+
+// Monotonic nanoseconds, standing in for the global timer.
+static uint64_t hostTimeSource() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * CFAR_HOST_NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+// Host entry point for cfar_runTest(), see cfar.h.
+int main() {
+  return cfar_runTest(hostTimeSource, CFAR_HOST_NANOSECONDS_PER_SECOND) ? 0 : 1;
+}
+#endif
@@ -0,0 +1,85 @@
+#ifndef CFAR_H_
+#define CFAR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "profiler.h"
+
+// Adaptive (constant false-alarm rate) hit detection on the ten channel powers.
+// Each channel tracks its own noise floor over time: an exponential moving mean and variance of its power.
+// A channel is a hit candidate when its power exceeds mean + z * deviation, with z chosen from a
+// false-alarm probability (nominal: it assumes Gaussian fluctuations of the floor). Values above the
+// threshold are censored from the floor, so a shot does not raise it; a channel that stays above its
+// threshold for CFAR_MAX_CENSORED_VECTORS is taken to have a new floor: it starts over from that level
+// and warms up again. The floors only see the vectors they are given, so during a lockout after a hit
+// pass every vector to cfar_track(), or a step in a floor would take a lockout per censored vector.
+// As a guard against broadband bursts that lift every channel, a candidate must also exceed the median
+// of the ten powers by CFAR_MEDIAN_GUARD_RATIO; the median comes from a branchless selection network.
+// The strongest candidate (other than the ignored channel) is the hit.
+//
+// Rates below are in power vectors: the detector produces one per decimated sample (10 kHz).
+
+#define CFAR_CHANNEL_COUNT 10                       // One per player frequency.
+#define CFAR_NO_HIT -1                              // Returned by cfar_detect() when no channel is hit.
+#define CFAR_DEFAULT_FALSE_ALARM_PROBABILITY 1e-6   // Per channel, per power vector.
+#define CFAR_NOISE_ALPHA (1.0 / 1024)               // EMA weight of a new power (about a 0.1 s time constant).
+#define CFAR_WARMUP_VECTORS 1024                    // Vectors per channel before it may report a hit.
+#define CFAR_MAX_CENSORED_VECTORS 10000             // 1 s above threshold: accept it as the new floor.
+#define CFAR_MEDIAN_GUARD_RATIO 10.0                // A hit must also be this many times the median power.
+#define CFAR_MIN_RELATIVE_DEVIATION 0.05            // Deviation is at least this fraction of the mean.
+
+// Detection state: one noise floor per channel.
+typedef struct {
+  double mean[CFAR_CHANNEL_COUNT];          // EMA of the power.
+  double variance[CFAR_CHANNEL_COUNT];      // EMA of the squared deviation from mean.
+  uint32_t updateCount[CFAR_CHANNEL_COUNT]; // Vectors folded into the floor (saturates at CFAR_WARMUP_VECTORS).
+  uint32_t censoredRun[CFAR_CHANNEL_COUNT]; // Consecutive vectors above threshold.
+  double thresholdScaleSquared;             // z^2, from the false-alarm probability.
+} cfar_t;
+
+// Forgets the noise floors and sets the false-alarm probability.
+void cfar_init(cfar_t* cfar, double falseAlarmProbability);
+
+// Changes the false-alarm probability (0 < p < 0.5) without forgetting the noise floors.
+void cfar_setFalseAlarmProbability(cfar_t* cfar, double falseAlarmProbability);
+
+// Updates the noise floors with power[] and returns the hit channel, or CFAR_NO_HIT.
+// ignoreChannel is never reported (pass CFAR_NO_HIT to ignore none), but its floor is still tracked.
+int8_t cfar_detect(cfar_t* cfar, const double power[], int8_t ignoreChannel);
+
+// Updates the noise floors with power[] without looking for a hit, e.g. while locked out after one.
+void cfar_track(cfar_t* cfar, const double power[]);
+
+// Lower median (5th smallest) of the ten powers, from a 26-comparator selection network
+// (the comparators of a 29-comparator sorting network that can reach position 4).
+double cfar_median(const double power[]);
+
+// Results of cfar_evaluate() for one algorithm.
+typedef struct {
+  uint32_t shotCount;           // Shots in the trace (runs of vectors labelled with the same channel).
+  uint32_t detectedShotCount;   // Shots reported on the right channel at least once.
+  uint32_t falseAlarmCount;     // Hits outside any shot, or on the wrong channel.
+  uint32_t callCount;           // Calls of the algorithm (not counting the lockout after each hit).
+  uint64_t ticks;               // Time spent in those calls.
+} cfar_evaluation_t;
+
+// Supplies a trace: fills power[] and *shooter (the channel being shot at the listener, or CFAR_NO_HIT)
+// with the next vector and returns true, or returns false at the end of the trace.
+typedef bool (*cfar_traceReader_t)(double power[], int8_t* shooter);
+
+#define CFAR_EVALUATION_LOCKOUT_VECTORS 5000        // Vectors skipped after a hit, like lockoutTimer (0.5 s).
+
+// Runs the adaptive detector and the fixed rule the detector used before (bubble sort, max > median * fixedRatio)
+// side by side over a trace, each with its own lockout, and prints detection rate, false alarms and time per call.
+// timeSource times each call (e.g. globalTimer_getTimerValue), ticksPerSecond converts its ticks for printing.
+void cfar_evaluate(cfar_traceReader_t reader, double falseAlarmProbability, double fixedRatio,
+    profiler_timeSource_t timeSource, uint32_t ticksPerSecond, cfar_evaluation_t* adaptive, cfar_evaluation_t* fixed);
+
+// Checks the selection network against sorting, then evaluates both algorithms on a synthetic trace
+// (drifting floors, a channel with steady interference, shots from 20x to 2000x the floor) and checks
+// that the adaptive detector finds more shots with fewer false alarms. Last, steps one channel's floor
+// up 200x and checks that its hits stop within CFAR_MAX_CENSORED_VECTORS and the warm-up. Host build, e.g.:
+//   g++ -x c++ -O2 -I. -DCFAR_HOST_TEST src/390_libs/cfar.c src/390_libs/profiler.c
+bool cfar_runTest(profiler_timeSource_t timeSource, uint32_t ticksPerSecond);
+
+#endif /* CFAR_H_ */
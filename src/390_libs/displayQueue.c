@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include "displayQueue.h"
+
+// A waiting command.
+typedef struct {
+  uint32_t key;
+  displayQueue_command_t command;
+  uint32_t argument;
+} displayQueue_entry_t;
+
+static displayQueue_entry_t displayQueue_entries[DISPLAY_QUEUE_SIZE];  // Circular, oldest at displayQueue_head.
+static uint32_t displayQueue_head = 0;
+static uint32_t displayQueue_count = 0;
+static displayQueue_timeSource_t displayQueue_timeSource = NULL;
+static displayQueue_statistics_t displayQueue_statistics;
+
+// Start empty.
+void displayQueue_init(displayQueue_timeSource_t timeSource) {
+  displayQueue_timeSource = timeSource;
+  displayQueue_clear();
+  memset(&displayQueue_statistics, 0, sizeof(displayQueue_statistics));
+}
+
+// The queue is short, so a linear search for the key is cheaper than keeping an index of keys.
+bool displayQueue_post(uint32_t key, displayQueue_command_t command, uint32_t argument) {
+  displayQueue_statistics.posted++;
+#ifdef DISPLAY_QUEUE_ENABLE
+  for (uint32_t i = 0; i < displayQueue_count; i++) {
+    displayQueue_entry_t* entry = &displayQueue_entries[(displayQueue_head + i) % DISPLAY_QUEUE_SIZE];
+    if (entry->key == key) {  // Newer state for something not drawn yet: keep the place in line.
+      entry->command = command;
+      entry->argument = argument;
+      displayQueue_statistics.replaced++;
+      return true;
+    }
+  }
+  if (displayQueue_count == DISPLAY_QUEUE_SIZE) {
+    displayQueue_statistics.dropped++;
+    return false;
+  }
+  displayQueue_entry_t* entry = &displayQueue_entries[(displayQueue_head + displayQueue_count) % DISPLAY_QUEUE_SIZE];
+  entry->key = key;
+  entry->command = command;
+  entry->argument = argument;
+  displayQueue_count++;
+  if (displayQueue_count > displayQueue_statistics.maxPending)
+    displayQueue_statistics.maxPending = displayQueue_count;
+#else
+  (void) key;
+  displayQueue_statistics.run++;
+  command(argument);
+#endif
+  return true;
+}
+
+// Removes the oldest command and runs it. It is removed first so that it may post again (even under its own key).
+static void displayQueue_runOldest() {
+  displayQueue_entry_t entry = displayQueue_entries[displayQueue_head];
+  displayQueue_head = (displayQueue_head + 1) % DISPLAY_QUEUE_SIZE;
+  displayQueue_count--;
+  displayQueue_statistics.run++;
+  entry.command(entry.argument);
+}
+
+// The clock is only read when there is something to run.
+uint32_t displayQueue_run(uint64_t budgetTicks) {
+  if (budgetTicks == 0 || displayQueue_count == 0)
+    return 0;
+  uint64_t startTime = displayQueue_timeSource();
+  uint32_t runCount = 0;
+  do {
+    displayQueue_runOldest();
+    runCount++;
+  } while (displayQueue_count != 0 && displayQueue_timeSource() - startTime < budgetTicks);
+  return runCount;
+}
+
+// Everything, however long it takes.
+void displayQueue_flush() {
+  while (displayQueue_count != 0)
+    displayQueue_runOldest();
+}
+
+// Drop everything.
+void displayQueue_clear() {
+  displayQueue_head = 0;
+  displayQueue_count = 0;
+}
+
+uint32_t displayQueue_pendingCount() {
+  return displayQueue_count;
+}
+
+void displayQueue_getStatistics(displayQueue_statistics_t* statistics) {
+  *statistics = displayQueue_statistics;
+}
+
+void displayQueue_printStatistics() {
+  printf("display queue: %lu posted, %lu replaced, %lu dropped, %lu run, at most %lu waiting.\n\r",
+      (unsigned long) displayQueue_statistics.posted, (unsigned long) displayQueue_statistics.replaced,
+      (unsigned long) displayQueue_statistics.dropped, (unsigned long) displayQueue_statistics.run,
+      (unsigned long) displayQueue_statistics.maxPending);
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define DISPLAY_QUEUE_TEST_COMMAND_TICKS 10   // Each test command advances the fake clock by this much.
+#define DISPLAY_QUEUE_TEST_BUDGET 25          // Enough for two commands to start within the budget and a third to overrun it.
+#define DISPLAY_QUEUE_TEST_RUN_PER_BUDGET 3
+#define DISPLAY_QUEUE_TEST_LOG_SIZE (DISPLAY_QUEUE_SIZE * 2)
+#define DISPLAY_QUEUE_TEST_REPLACED_KEY 1     // Posted again after the others.
+#define DISPLAY_QUEUE_TEST_REPLACEMENT 100    // The argument it is posted again with.
+
+static uint64_t displayQueue_testTime;
+static uint32_t displayQueue_testLog[DISPLAY_QUEUE_TEST_LOG_SIZE];  // Arguments in the order the commands ran.
+static uint32_t displayQueue_testLogCount;
+
+static uint64_t displayQueue_testClock() {
+  return displayQueue_testTime;
+}
+
+// Logs the argument and takes a fixed time.
+static void displayQueue_testCommand(uint32_t argument) {
+  if (displayQueue_testLogCount < DISPLAY_QUEUE_TEST_LOG_SIZE)
+    displayQueue_testLog[displayQueue_testLogCount++] = argument;
+  displayQueue_testTime += DISPLAY_QUEUE_TEST_COMMAND_TICKS;
+}
+
+// Prints a failure and returns false.
+static bool displayQueue_testFail(const char* what, uint32_t got, uint32_t expected) {
+  printf("displayQueue_runTest: %s was %lu, expected %lu.\n\r", what, (unsigned long) got, (unsigned long) expected);
+  return false;
+}
+
+bool displayQueue_runTest() {
+  bool success = true;
+  displayQueue_testTime = 0;
+  displayQueue_testLogCount = 0;
+  displayQueue_init(displayQueue_testClock);
+#ifdef DISPLAY_QUEUE_ENABLE
+  // Keys 0..3 with their key as the argument, then key 1 again with a new argument: it keeps its place.
+  for (uint32_t key = 0; key < 4; key++)
+    displayQueue_post(key, displayQueue_testCommand, key);
+  displayQueue_post(DISPLAY_QUEUE_TEST_REPLACED_KEY, displayQueue_testCommand, DISPLAY_QUEUE_TEST_REPLACEMENT);
+  if (displayQueue_pendingCount() != 4)
+    success = displayQueue_testFail("pending count after a replacement", displayQueue_pendingCount(), 4);
+  uint32_t runCount = displayQueue_run(0);
+  if (runCount != 0)
+    success = displayQueue_testFail("commands run with no budget", runCount, 0);
+  // Starts at 0, 10 and 20 ticks, each under the budget of 25; the third ends past it and the fourth waits.
+  runCount = displayQueue_run(DISPLAY_QUEUE_TEST_BUDGET);
+  if (runCount != DISPLAY_QUEUE_TEST_RUN_PER_BUDGET)
+    success = displayQueue_testFail("commands run in one budget", runCount, DISPLAY_QUEUE_TEST_RUN_PER_BUDGET);
+  displayQueue_flush();
+  const uint32_t expected[] = {0, DISPLAY_QUEUE_TEST_REPLACEMENT, 2, 3};
+  if (displayQueue_testLogCount != 4)
+    success = displayQueue_testFail("commands run", displayQueue_testLogCount, 4);
+  for (uint32_t i = 0; i < displayQueue_testLogCount && i < 4; i++) {
+    if (displayQueue_testLog[i] != expected[i])
+      success = displayQueue_testFail("argument run", displayQueue_testLog[i], expected[i]);
+  }
+  // Overflow: the extra commands are refused and the queue keeps the ones it had.
+  for (uint32_t key = 0; key < DISPLAY_QUEUE_SIZE + 2; key++) {
+    if (displayQueue_post(key, displayQueue_testCommand, key) != (key < DISPLAY_QUEUE_SIZE))
+      success = displayQueue_testFail("post result for key", key, key < DISPLAY_QUEUE_SIZE);
+  }
+  displayQueue_statistics_t statistics;
+  displayQueue_getStatistics(&statistics);
+  if (statistics.dropped != 2)
+    success = displayQueue_testFail("dropped count", statistics.dropped, 2);
+  if (statistics.maxPending != DISPLAY_QUEUE_SIZE)
+    success = displayQueue_testFail("max pending", statistics.maxPending, DISPLAY_QUEUE_SIZE);
+  displayQueue_clear();
+  if (displayQueue_pendingCount() != 0 || displayQueue_run(DISPLAY_QUEUE_TEST_BUDGET) != 0)
+    success = displayQueue_testFail("pending count after clear", displayQueue_pendingCount(), 0);
+#else
+  // Synchronous: every post runs at once.
+  displayQueue_post(0, displayQueue_testCommand, DISPLAY_QUEUE_TEST_REPLACEMENT);
+  if (displayQueue_testLogCount != 1 || displayQueue_pendingCount() != 0)
+    success = displayQueue_testFail("commands run by a post", displayQueue_testLogCount, 1);
+#endif
+  printf("displayQueue_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef DISPLAY_QUEUE_HOST_TEST
+int main() {
+  return displayQueue_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef DISPLAYQUEUE_H_
+#define DISPLAYQUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Display work as small queued commands, so the main loop can draw a little at a time between calls to
+// detector() instead of stalling it for a whole redraw (a full histogram is ~150 KB on the 8-bit bus).
+//
+// A command is a function and a 32-bit argument (e.g. "draw bar 3"), posted under a key chosen by the
+// caller. Posting under a key that is still waiting replaces that command in place: it keeps its turn
+// in the queue but runs with the new function and argument, so a screen that changes faster than it is
+// drawn only ever draws its newest state. Keys must not be shared by unrelated callers; each one gets a
+// range (e.g. HISTOGRAM_DISPLAY_QUEUE_KEY in histogram.h).
+//
+// The main loop calls displayQueue_run() with the time it can spare. Commands run oldest first until the
+// budget is spent; a command is never interrupted, so the budget can be overrun by one command and
+// commands should be kept short (one bar, one label, one strip of text).
+//
+// Everything runs in the main loop: nothing here may be called from an ISR.
+
+#define DISPLAY_QUEUE_ENABLE     // Comment out to run every command as it is posted (synchronous drawing).
+#define DISPLAY_QUEUE_SIZE 32    // Commands that can wait at once.
+
+// Returns the current time in ticks of a free-running counter (e.g. globalTimer_getTimerValue()).
+typedef uint64_t (*displayQueue_timeSource_t)();
+
+// A unit of drawing: called with the argument it was posted with.
+typedef void (*displayQueue_command_t)(uint32_t argument);
+
+// Counts since displayQueue_init().
+typedef struct {
+  uint32_t posted;        // Calls to displayQueue_post().
+  uint32_t replaced;      // Posts that replaced a waiting command with the same key.
+  uint32_t dropped;       // Posts refused because the queue was full.
+  uint32_t run;           // Commands run.
+  uint32_t maxPending;    // Most commands waiting at once.
+} displayQueue_statistics_t;
+
+// Empties the queue, clears the statistics and sets the clock used by displayQueue_run().
+void displayQueue_init(displayQueue_timeSource_t timeSource);
+
+// Queues command(argument) under key, replacing a waiting command with the same key.
+// Returns false if the queue is full (the command is dropped and counted).
+// With DISPLAY_QUEUE_ENABLE off the command runs right away.
+bool displayQueue_post(uint32_t key, displayQueue_command_t command, uint32_t argument);
+
+// Runs waiting commands, oldest first, until the queue is empty or budgetTicks have passed since the call.
+// A budget of 0 runs nothing. Returns the number of commands run.
+uint32_t displayQueue_run(uint64_t budgetTicks);
+
+// Runs every waiting command, e.g. before drawing something the queued commands must not draw over.
+void displayQueue_flush();
+
+// Forgets every waiting command without running it, e.g. when the screen is about to be cleared.
+void displayQueue_clear();
+
+// Number of commands waiting.
+uint32_t displayQueue_pendingCount();
+
+// Copies the statistics.
+void displayQueue_getStatistics(displayQueue_statistics_t* statistics);
+
+// Prints the statistics on the console.
+void displayQueue_printStatistics();
+
+// Checks ordering, replacement, overflow and the time budget against a fake clock.
+// Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DDISPLAY_QUEUE_HOST_TEST src/390_libs/displayQueue.c
+bool displayQueue_runTest();
+
+#endif /* DISPLAYQUEUE_H_ */
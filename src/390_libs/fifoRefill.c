@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include "fifoRefill.h"
+
+#define FIFO_REFILL_INIT_VALUE 0
+
+// Empty FIFO, no credit carried.
+void fifoRefill_init(fifoRefill_t* refill, uint32_t depth, uint32_t margin, uint32_t drainRate, uint32_t creditRate) {
+  refill->depth = depth;
+  refill->target = margin < depth ? depth - margin : FIFO_REFILL_INIT_VALUE;
+  refill->level = FIFO_REFILL_INIT_VALUE;
+  refill->drainRate = drainRate + drainRate / FIFO_REFILL_SURPLUS_DIVISOR;
+  refill->creditRate = creditRate;
+  refill->credit = FIFO_REFILL_INIT_VALUE;
+  refill->fullCount = FIFO_REFILL_INIT_VALUE;
+}
+
+// Whole frames played since the last call come off the estimate; the fraction waits for the next call.
+uint32_t fifoRefill_framesToWrite(fifoRefill_t* refill) {
+  refill->credit += refill->drainRate;
+  uint32_t drained = refill->credit / refill->creditRate;
+  refill->credit -= drained * refill->creditRate;
+  refill->level = drained >= refill->level ? FIFO_REFILL_INIT_VALUE : refill->level - drained;
+  return refill->level < refill->target ? refill->target - refill->level : FIFO_REFILL_INIT_VALUE;
+}
+
+// Full means exactly depth frames; not full means at most depth - 1, whatever the estimate says.
+void fifoRefill_wrote(fifoRefill_t* refill, uint32_t frames, bool full) {
+  refill->level += frames;
+  if (full) {
+    refill->level = refill->depth;
+    refill->fullCount++;
+  } else if (refill->level >= refill->depth) {
+    refill->level = refill->depth - 1;
+  }
+}
+
+uint32_t fifoRefill_getFullCount(const fifoRefill_t* refill) {
+  return refill->fullCount;
+}
+
+/****************************** Test ******************************/
+
+#define FIFO_REFILL_TEST_DEPTH 32                 // Frames; what sound.h assumes of the I2S TX FIFO.
+#define FIFO_REFILL_TEST_MARGIN 4                 // Frames below full that a burst aims for.
+#define FIFO_REFILL_TEST_WORDS_PER_FRAME 2        // Left, then right.
+#define FIFO_REFILL_TEST_SAMPLE_RATE 48000
+#define FIFO_REFILL_TEST_INTERRUPT_RATE 100000
+#define FIFO_REFILL_TEST_POLL_DIVIDER 10          // The old sound_tick() rate (10 kHz).
+#define FIFO_REFILL_TEST_BURST_DIVIDER 30         // Half of the FIFO plays between bursts.
+#define FIFO_REFILL_TEST_SECONDS 20
+#define FIFO_REFILL_TEST_MAX_DROPPED_FRAMES 4     // Per run; each is a 21 us glitch.
+#define FIFO_REFILL_TEST_MIN_READ_REDUCTION 10    // Bursts need at least 10x fewer status reads.
+#define FIFO_REFILL_TEST_PPM_SCALE 1e-6
+#define FIFO_REFILL_TEST_FULL_FLAG 0b0010         // I2S_FIFO_STS_REG bit sound.c tests.
+
+// Codec clock errors tried, in ppm (positive: the codec plays faster than nominal).
+static const int32_t fifoRefill_testPpm[] = {-200, 0, 200};
+#define FIFO_REFILL_TEST_PPM_COUNT (sizeof(fifoRefill_testPpm) / sizeof(fifoRefill_testPpm[0]))
+
+// The TX FIFO as the registers show it, and what happened to it.
+typedef struct {
+  uint32_t words;           // Words in the FIFO.
+  double phase;             // Frames the codec is due to take, carried between interrupts.
+  bool playing;             // Set by the first write; underruns count from then on.
+  uint64_t reads;           // Status register reads.
+  uint64_t writes;          // Data register writes.
+  uint64_t droppedWords;    // Written while full.
+  uint64_t underruns;       // Frames the codec wanted from an empty FIFO.
+} fifoRefill_testFifo_t;
+
+// Reads I2S_FIFO_STS_REG.
+static uint32_t fifoRefill_testReadStatus(fifoRefill_testFifo_t* fifo) {
+  fifo->reads++;
+  return fifo->words == FIFO_REFILL_TEST_DEPTH * FIFO_REFILL_TEST_WORDS_PER_FRAME ? FIFO_REFILL_TEST_FULL_FLAG : 0;
+}
+
+// Writes I2S_TX_FIFO_REG.
+static void fifoRefill_testWrite(fifoRefill_testFifo_t* fifo, uint32_t) {
+  fifo->writes++;
+  fifo->playing = true;
+  if (fifo->words == FIFO_REFILL_TEST_DEPTH * FIFO_REFILL_TEST_WORDS_PER_FRAME)
+    fifo->droppedWords++;
+  else
+    fifo->words++;
+}
+
+// The codec takes its frames for one interrupt period.
+static void fifoRefill_testDrain(fifoRefill_testFifo_t* fifo, double framesPerInterrupt) {
+  if (!fifo->playing)
+    return;
+  fifo->phase += framesPerInterrupt;
+  while (fifo->phase >= 1.0) {
+    fifo->phase -= 1.0;
+    if (fifo->words >= FIFO_REFILL_TEST_WORDS_PER_FRAME)
+      fifo->words -= FIFO_REFILL_TEST_WORDS_PER_FRAME;
+    else
+      fifo->underruns++;
+  }
+}
+
+// One second of audio's worth of an access count.
+static double fifoRefill_testPerSecond(uint64_t count) {
+  return (double) count / FIFO_REFILL_TEST_SECONDS;
+}
+
+// Plays FIFO_REFILL_TEST_SECONDS of audio with a codec ppm off nominal, refilling in bursts
+// (burst true) or by polling before every frame.
+static void fifoRefill_testRun(int32_t ppm, bool burst, fifoRefill_testFifo_t* fifo, uint32_t* fullCount) {
+  fifoRefill_testFifo_t empty = {0, 0.0, false, 0, 0, 0, 0};
+  *fifo = empty;
+  fifoRefill_t refill;
+  fifoRefill_init(&refill, FIFO_REFILL_TEST_DEPTH, FIFO_REFILL_TEST_MARGIN,
+      FIFO_REFILL_TEST_SAMPLE_RATE * FIFO_REFILL_TEST_BURST_DIVIDER, FIFO_REFILL_TEST_INTERRUPT_RATE);
+  double framesPerInterrupt = (double) FIFO_REFILL_TEST_SAMPLE_RATE / FIFO_REFILL_TEST_INTERRUPT_RATE *
+      (1.0 + ppm * FIFO_REFILL_TEST_PPM_SCALE);
+  uint32_t sample = 0;
+  for (uint32_t i = 0; i < FIFO_REFILL_TEST_SECONDS * FIFO_REFILL_TEST_INTERRUPT_RATE; i++) {
+    fifoRefill_testDrain(fifo, framesPerInterrupt);
+    if (burst && i % FIFO_REFILL_TEST_BURST_DIVIDER == 0) {
+      uint32_t frames = fifoRefill_framesToWrite(&refill);
+      for (uint32_t f = 0; f < frames; f++, sample++) {
+        fifoRefill_testWrite(fifo, sample);
+        fifoRefill_testWrite(fifo, sample);
+      }
+      fifoRefill_wrote(&refill, frames, fifoRefill_testReadStatus(fifo) & FIFO_REFILL_TEST_FULL_FLAG);
+    } else if (!burst && i % FIFO_REFILL_TEST_POLL_DIVIDER == 0) {
+      while (!(fifoRefill_testReadStatus(fifo) & FIFO_REFILL_TEST_FULL_FLAG)) {
+        fifoRefill_testWrite(fifo, sample);
+        fifoRefill_testWrite(fifo, sample);
+        sample++;
+      }
+    }
+  }
+  *fullCount = fifoRefill_getFullCount(&refill);
+}
+
+// Prints one run.
+static void fifoRefill_testPrint(const char* name, int32_t ppm, const fifoRefill_testFifo_t* fifo) {
+  printf("%-7s %+5d ppm: %8.0f reads/s %8.0f writes/s, %llu underruns, %llu dropped frames\n\r", name, (int) ppm,
+      fifoRefill_testPerSecond(fifo->reads), fifoRefill_testPerSecond(fifo->writes),
+      (unsigned long long) fifo->underruns, (unsigned long long) (fifo->droppedWords / FIFO_REFILL_TEST_WORDS_PER_FRAME));
+}
+
+bool fifoRefill_runTest() {
+  bool success = true;
+  for (uint32_t p = 0; p < FIFO_REFILL_TEST_PPM_COUNT; p++) {
+    int32_t ppm = fifoRefill_testPpm[p];
+    fifoRefill_testFifo_t polled, bursts;
+    uint32_t fullCount;
+    fifoRefill_testRun(ppm, false, &polled, &fullCount);
+    fifoRefill_testRun(ppm, true, &bursts, &fullCount);
+    fifoRefill_testPrint("polled", ppm, &polled);
+    fifoRefill_testPrint("bursts", ppm, &bursts);
+    if (bursts.underruns != 0) {
+      printf("fifoRefill_runTest: bursts underran %llu times at %+d ppm.\n\r", (unsigned long long) bursts.underruns, (int) ppm);
+      success = false;
+    }
+    if (bursts.droppedWords / FIFO_REFILL_TEST_WORDS_PER_FRAME > FIFO_REFILL_TEST_MAX_DROPPED_FRAMES) {
+      printf("fifoRefill_runTest: bursts dropped too many frames at %+d ppm.\n\r", (int) ppm);
+      success = false;
+    }
+    if (bursts.reads * FIFO_REFILL_TEST_MIN_READ_REDUCTION > polled.reads) {
+      printf("fifoRefill_runTest: bursts did not save enough status reads at %+d ppm.\n\r", (int) ppm);
+      success = false;
+    }
+    if (fullCount == 0) {
+      printf("fifoRefill_runTest: the FIFO never read full at %+d ppm, so the estimate was never corrected.\n\r", (int) ppm);
+      success = false;
+    }
+  }
+  if (success)
+    printf("fifoRefill_runTest passed.\n\r");
+  return success;
+}
+
+#ifdef FIFO_REFILL_HOST_TEST
+int main() {
+  return fifoRefill_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef FIFOREFILL_H_
+#define FIFOREFILL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Refills a transmit FIFO in bursts, with one status read per refill instead of one per sample.
+// The I2S TX FIFO only reports "full", not how much room it has, so the room is estimated:
+// the FIFO drains at the sample rate, so each refill is credited with the frames played since the last one.
+// Each burst tops the estimate up to depth - margin frames, and the full flag read after the burst corrects it.
+//
+// The credit is a little generous (FIFO_REFILL_SURPLUS_DIVISOR), so small clock mismatches move the level
+// up towards full, where the flag catches it, rather than down towards an underrun. Catching it can
+// drop at most the one frame that did not fit, once every few thousand refills.
+//
+// Call fifoRefill_framesToWrite() at a fixed rate slow enough for a burst to be a useful size
+// (e.g. when the FIFO should be half empty), write that many frames, then read the status and call
+// fifoRefill_wrote().
+
+#define FIFO_REFILL_SURPLUS_DIVISOR 4096   // Credit 1/4096 (about 244 ppm) more frames than the nominal rate.
+
+// Estimated state of one FIFO.
+typedef struct {
+  uint32_t depth;             // Capacity, in frames.
+  uint32_t target;            // depth - margin: where a burst leaves the estimate.
+  uint32_t level;             // Estimated frames in the FIFO.
+  uint32_t drainRate;         // Frames drained per creditRate calls...
+  uint32_t creditRate;        // ...so each call is credited drainRate / creditRate frames.
+  uint32_t credit;            // Fraction of a frame carried to the next call, in 1/creditRate.
+  uint32_t fullCount;         // Bursts after which the FIFO read full.
+} fifoRefill_t;
+
+// Starts with an empty FIFO (reset it as well). depth and margin are in frames; the FIFO drains
+// drainRate frames per creditRate calls, e.g. 48000 * divider and 100000 for a 48 kHz FIFO refilled
+// on every divider-th 100 kHz interrupt.
+void fifoRefill_init(fifoRefill_t* refill, uint32_t depth, uint32_t margin, uint32_t drainRate, uint32_t creditRate);
+
+// Credits the frames played since the last call and returns how many to write now.
+uint32_t fifoRefill_framesToWrite(fifoRefill_t* refill);
+
+// Records a burst of frames (may be fewer than asked) and the full flag read after it.
+void fifoRefill_wrote(fifoRefill_t* refill, uint32_t frames, bool full);
+
+// Number of bursts after which the FIFO read full.
+uint32_t fifoRefill_getFullCount(const fifoRefill_t* refill);
+
+// Simulates the I2S TX FIFO at register level (status reads, data writes, a codec draining it at 48 kHz
+// with its clock off by up to +/-200 ppm) and refills it both ways: polling the status before every
+// sample on every 10th 100 kHz interrupt, as sound_tick() did, and in bursts on every 30th interrupt.
+// Prints register accesses per second of audio, underruns and dropped frames, and checks that bursts
+// never underrun, drop almost nothing and need far fewer status reads. Host build, e.g.:
+//   g++ -x c++ -I. -DFIFO_REFILL_HOST_TEST src/390_libs/fifoRefill.c
+bool fifoRefill_runTest();
+
+#endif /* FIFOREFILL_H_ */
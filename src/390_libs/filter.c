@@ -1,5 +1,80 @@
 #include "filter.h"
+#include "profiler.h"
 #include <stdio.h>
+#ifdef FILTER_USE_FIXED_POINT
+#include "filterFixed.h"
+#endif
+
+// Vector type used by filter_iirFilterBank(). Each lane is one IIR filter (player channel).
+// ARMv7 NEON has no double-precision lanes, so the Cortex-A9 build runs the double-precision parts
+// (the direct form and the power) in the scalar lane loop, and only the biquads go to NEON (see below).
+#if defined(__AVX__)
+#include <immintrin.h>
+typedef __m256d filterBank_vector_t;
+#define FILTER_BANK_VECTOR_WIDTH 4
+#define filterBank_load(p) _mm256_loadu_pd(p)
+#define filterBank_store(p, v) _mm256_storeu_pd((p), (v))
+#define filterBank_broadcast(x) _mm256_set1_pd(x)
+#define filterBank_add(a, b) _mm256_add_pd((a), (b))
+#define filterBank_sub(a, b) _mm256_sub_pd((a), (b))
+#define filterBank_mul(a, b) _mm256_mul_pd((a), (b))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128d filterBank_vector_t;
+#define FILTER_BANK_VECTOR_WIDTH 2
+#define filterBank_load(p) _mm_loadu_pd(p)
+#define filterBank_store(p, v) _mm_storeu_pd((p), (v))
+#define filterBank_broadcast(x) _mm_set1_pd(x)
+#define filterBank_add(a, b) _mm_add_pd((a), (b))
+#define filterBank_sub(a, b) _mm_sub_pd((a), (b))
+#define filterBank_mul(a, b) _mm_mul_pd((a), (b))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+typedef float64x2_t filterBank_vector_t;
+#define FILTER_BANK_VECTOR_WIDTH 2
+#define filterBank_load(p) vld1q_f64(p)
+#define filterBank_store(p, v) vst1q_f64((p), (v))
+#define filterBank_broadcast(x) vdupq_n_f64(x)
+#define filterBank_add(a, b) vaddq_f64((a), (b))
+#define filterBank_sub(a, b) vsubq_f64((a), (b))
+#define filterBank_mul(a, b) vmulq_f64((a), (b))
+#else
+typedef double filterBank_vector_t;
+#define FILTER_BANK_VECTOR_WIDTH 1
+#define filterBank_load(p) (*(p))
+#define filterBank_store(p, v) (*(p) = (v))
+#define filterBank_broadcast(x) (x)
+#define filterBank_add(a, b) ((a) + (b))
+#define filterBank_sub(a, b) ((a) - (b))
+#define filterBank_mul(a, b) ((a) * (b))
+#endif
+
+// Vector type of the biquad (FILTER_IIR_USE_SOS) lanes. On ARMv7 NEON they run in single precision,
+// four filters per float32x4_t (three vectors for the twelve lanes): the sections are well conditioned
+// enough for it (power within 1e-4 of double on the host), while the 10th-order direct form diverges in
+// single precision and so stays in double. The outputs are widened to double for the power.
+#ifdef FILTER_BANK_SINGLE_PRECISION
+#include <arm_neon.h>
+typedef float filterBank_sosValue_t;
+typedef float32x4_t filterBank_sosVector_t;
+#define FILTER_BANK_SOS_VECTOR_WIDTH 4
+#define filterBank_sosLoad(p) vld1q_f32(p)
+#define filterBank_sosStore(p, v) vst1q_f32((p), (v))
+#define filterBank_sosBroadcast(x) vdupq_n_f32(x)
+#define filterBank_sosSub(a, b) vsubq_f32((a), (b))
+#define filterBank_sosMul(a, b) vmulq_f32((a), (b))
+#define filterBank_sosMultiplySubtract(acc, a, b) vmlsq_f32((acc), (a), (b))  //acc - a * b (not fused on the A9)
+#else
+typedef double filterBank_sosValue_t;
+typedef filterBank_vector_t filterBank_sosVector_t;
+#define FILTER_BANK_SOS_VECTOR_WIDTH FILTER_BANK_VECTOR_WIDTH
+#define filterBank_sosLoad(p) filterBank_load(p)
+#define filterBank_sosStore(p, v) filterBank_store((p), (v))
+#define filterBank_sosBroadcast(x) filterBank_broadcast(x)
+#define filterBank_sosSub(a, b) filterBank_sub((a), (b))
+#define filterBank_sosMul(a, b) filterBank_mul((a), (b))
+#define filterBank_sosMultiplySubtract(acc, a, b) filterBank_sub((acc), filterBank_mul((a), (b)))
+#endif
 
 #define FILTER_IIR_FILTER_COUNT 10                          //This is the number of IIR filters we are using
 #define IIR_A_COEFFICIENT_COUNT 10                          //This is how many 'A' coefficients there are per IIR filter
@@ -19,12 +94,24 @@
 #define FILTER_INIT_VAL 0.0                                 //This is an initializing value used for double-type variables
 #define DECIMATION_VALUE 10                                 //This is how much decimation we are performing. A decimation factor of 10 means we are down-sampling from 100kHz to 10kHz.
 #define RESET 0                                             //An initializing value used for int-type variables
+#define IIR_SOS_SECTION_COUNT 5                             //Number of biquads per IIR filter when FILTER_IIR_USE_SOS is defined
+#define IIR_SOS_A_COEFFICIENT_COUNT 2                       //a1 and a2 for each biquad (a0 is 1)
+#define IIR_SOS_W1_INDEX 0                                  //Index of w[n-1] in a biquad's state
+#define IIR_SOS_W2_INDEX 1                                  //Index of w[n-2] in a biquad's state
+#define FILTER_BANK_LANE_COUNT 12                           //IIR filters padded up to a multiple of every vector width (4 + 4 + 4 on NEON); the padding lanes have zero coefficients
+#define FILTER_BANK_Z_HISTORY_SIZE (2*IIR_A_COEFFICIENT_COUNT)  //The bank's zQueue equivalent is mirrored so the last 10 outputs are always contiguous
 
 static queue_t x_queue;                                         //the input to the FIR filter
 static queue_t y_queue;                                         //the output of the FIR filter and one of the inputs to the IIR filters
 static queue_t z_queue[FILTER_IIR_FILTER_COUNT];                //both an output and input for each IIR filter
 static queue_t output_queue[FILTER_IIR_FILTER_COUNT];           //Output for each IIR filter used to calculate power
 static double current_power_vals[FILTER_IIR_FILTER_COUNT];      //The most recently calculated power values for each IIR filter
+static double iirACoefficientsNegated[FILTER_IIR_FILTER_COUNT][IIR_A_COEFFICIENT_COUNT];   //-A, so the feedback can share the multiply-accumulate loop with the B side
+static uint32_t blockDecimationPhase;                           //Samples filter_processBlock() has pushed since its last decimated output
+
+PROFILER_ZONE(firZone, "FIR");                                  //filter_processBlock() stages, see profiler.h
+PROFILER_ZONE(iirBankZone, "IIR bank");                         //Includes the power updates, which run in the same lanes
+PROFILER_ZONE(powerZone, "power");                              //Copying out the power vector
 
 const static double firCoefficients[FIR_FILTER_TAP_COUNT] = {   //The coefficients for the FIR Filter. These are used to perform the anti-aliasing as we down-sample.
 5.3751585173668532e-04,
@@ -134,6 +221,42 @@ const static double iirBCoefficientConstants[FILTER_IIR_FILTER_COUNT][IIR_B_COEF
 {9.0926783827278939e-10, 0.0000000000000000e+00, -4.5463391913639461e-09, 0.0000000000000000e+00, 9.0926783827278922e-09, 0.0000000000000000e+00, -9.0926783827278922e-09, 0.0000000000000000e+00, 4.5463391913639461e-09, 0.0000000000000000e+00, -9.0926783827278939e-10},
 {9.0906302220838671e-10, 0.0000000000000000e+00, -4.5453151110419338e-09, 0.0000000000000000e+00, 9.0906302220838675e-09, 0.0000000000000000e+00, -9.0906302220838675e-09, 0.0000000000000000e+00, 4.5453151110419338e-09, 0.0000000000000000e+00, -9.0906302220838671e-10}
 };
+
+// Second-order-section (biquad) form of the same IIR filters, converted offline from the tables above.
+// Each 10th-order A polynomial was factored into 5 conjugate pole pairs (1 + a1 z^-1 + a2 z^-2),
+// ordered from the smallest pole radius to the largest, and each B row is b0 * (1 - z^-2)^5, so every
+// section has the numerator gain * (1 - z^-2). The product of the sections reproduces the
+// direct-form A coefficients to well below double precision. FILTER_IIR_USE_SOS runs them in filter.c,
+// and filterFixed.c runs them in integers.
+const static double iirSosACoefficients[FILTER_IIR_FILTER_COUNT][IIR_SOS_SECTION_COUNT][IIR_SOS_A_COEFFICIENT_COUNT] = {  //{a1, a2} for each section of each IIR filter.
+{{-1.1863680528691500e+00, 9.6906745361109836e-01}, {-1.1751239615341476e+00, 9.7473021920639591e-01}, {-1.2044435403256180e+00, 9.7507576075143010e-01}, {-1.1751208007967799e+00, 9.9023179923987470e-01}, {-1.2227163514907058e+00, 9.9044859796276252e-01}},
+{{-9.2259236548818069e-01, 9.6906741122925877e-01}, {-9.0908059007726838e-01, 9.7478164157074365e-01}, {-9.4141680268881478e-01, 9.7502435903303564e-01}, {-9.0604810924946888e-01, 9.9026403220160841e-01}, {-9.5865684440341170e-01, 9.9041636557658286e-01}},
+{{-6.0855036630702886e-01, 9.6906741246620387e-01}, {-5.9293576536640880e-01, 9.7482863216574467e-01}, {-6.2766922607985220e-01, 9.7497735807458707e-01}, {-5.8669556875892193e-01, 9.9029352875692012e-01}, {-6.4328086506288429e-01, 9.9038686504165752e-01}},
+{{-2.7992805690713296e-01, 9.6906741907271021e-01}, {-2.6267822786504325e-01, 9.7487012406005480e-01}, {-2.9878980996420318e-01, 9.7493585615121392e-01}, {-2.5345490939257376e-01, 9.9031956996958126e-01}, {-3.1232391447072161e-01, 9.9036082085922628e-01}},
+{{1.6314356691454904e-01, 9.6906741960676179e-01}, {1.4543810191898726e-01, 9.7488396437093294e-01}, {1.8178847075673335e-01, 9.7492201466480877e-01}, {1.3523718680887140e-01, 9.9032825554035797e-01}, {1.9450173477846039e-01, 9.9035213490283069e-01}},
+{{5.3871734250222836e-01, 9.6906742648676814e-01}, {5.2270990827898189e-01, 9.7483789641036189e-01}, {5.5782689048064282e-01, 9.7496808063995455e-01}, {5.1580591178677981e-01, 9.9029934730481417e-01}, {5.7302693256681836e-01, 9.9038104370283753e-01}},
+{{9.8429798184854889e-01, 9.6906744724736726e-01}, {9.7127092311944618e-01, 9.7477090830240920e-01}, {1.0029929355360319e+00, 9.7503506444935684e-01}, {9.6891634241525237e-01, 9.9025731217456536e-01}, {1.0205053420883099e+00, 9.9042308099751086e-01}},
+{{1.2274302868135658e+00, 9.6906738369357515e-01}, {1.2165897638497258e+00, 9.7472057147169922e-01}, {1.2453387811606846e+00, 9.7508547412983115e-01}, {1.2170923476231441e+00, 9.9022573290153049e-01}, {1.2637381557808642e+00, 9.9045467401971055e-01}},
+{{1.4739237472546753e+00, 9.6906737867966553e-01}, {1.4658797953259119e+00, 9.7464466595753452e-01}, {1.4904550428064696e+00, 9.7516142186435972e-01}, {1.4696759571090336e+00, 9.9017812802301619e-01}, {1.5093567445111493e+00, 9.9050228930430173e-01}},
+{{1.7056801465721305e+00, 9.6906783471185864e-01}, {1.7011303144121011e+00, 9.7450523853539417e-01}, {1.7200486576642546e+00, 9.7530062786010441e-01}, {1.7086465634346213e+00, 9.9009159886182185e-01}, {1.7387998955516617e+00, 9.9058870845043012e-01}}
+};
+
+const static double iirSosSectionGain[FILTER_IIR_FILTER_COUNT] = {  //Fifth root of B[0] for each IIR filter; every section applies it once.
+1.5550345281869798e-02,
+1.5550350937232308e-02,
+1.5550350638036670e-02,
+1.5550350878522707e-02,
+1.5550349242532320e-02,
+1.5550349126978488e-02,
+1.5550338806050472e-02,
+1.5550378663710973e-02,
+1.5550285463914055e-02,
+1.5549584848508453e-02
+};
+
+#ifdef FILTER_IIR_USE_SOS
+static double iirSosState[FILTER_IIR_FILTER_COUNT][IIR_SOS_SECTION_COUNT][IIR_SOS_A_COEFFICIENT_COUNT];  //Direct-form II state {w[n-1], w[n-2]} for each section.
+#endif
  
 // Filtering routines for the laser-tag project.
 // Filtering is performed by a two-stage filter, as described below.
@@ -148,13 +271,13 @@ const static double iirBCoefficientConstants[FILTER_IIR_FILTER_COUNT][IIR_B_COEF
  
 //Helper function which initializes an x-queue and fills it with 0's
 void initXQueue(){
-    queue_init(&x_queue, FILTER_XQUEUE_SIZE, "X_QUEUE");//initialize queue in memory, with correct size and name
+    queue_initMirrored(&x_queue, FILTER_XQUEUE_SIZE, "X_QUEUE");//initialize mirrored queue in memory, with correct size and name
     filter_fillQueue(&x_queue, FILTER_INIT_VAL);        //fill the queue with 0's
 }
 
 //Helper function which initializes a y-queue and fills it with 0's
 void initYQueue(){
-    queue_init(&y_queue, FILTER_YQUEUE_SIZE, "Y_QUEUE");//initialize queue in memory, with correct size and name
+    queue_initMirrored(&y_queue, FILTER_YQUEUE_SIZE, "Y_QUEUE");//initialize mirrored queue in memory, with correct size and name
     filter_fillQueue(&y_queue, FILTER_INIT_VAL);        //fill the queue with 0's
 }
 
@@ -164,7 +287,7 @@ void initZQueues(){
     {
         char filter_name[FILTER_NAME_SIZE];                         //generate a name for the queue
         sprintf(filter_name, "Z_QUEUE_%u", i);
-        queue_init(&(z_queue[i]), FILTER_ZQUEUE_SIZE, filter_name); //initialize queue in memory, with correct size and name
+        queue_initMirrored(&(z_queue[i]), FILTER_ZQUEUE_SIZE, filter_name); //initialize mirrored queue in memory, with correct size and name
         filter_fillQueue(&(z_queue[i]), FILTER_INIT_VAL);           //fill the queue with 0's
     }
 }
@@ -180,9 +303,191 @@ void initOutputQueues(){
     }
 }
 
+//Helper function which builds the negated A-coefficient table.
+//x - a*z and x + (-a)*z round identically, so the outputs do not change.
+void initNegatedACoefficients(){
+    for (uint8_t filter = RESET; filter < FILTER_IIR_FILTER_COUNT; filter++)
+    {
+        for (uint32_t i = RESET; i < IIR_A_COEFFICIENT_COUNT; i++)
+            iirACoefficientsNegated[filter][i] = -iirACoefficientConstants[filter][i];
+    }
+}
+
+//Adds coefficients[i] * newest[-i] to sum for i = 0..length-1.
+//newest points at the newest element of a contiguous (mirrored) delay line, so this is a plain
+//pointer loop the compiler can unroll, and the summation order matches the original per-tap reads.
+static inline double multiplyAccumulate(double sum, const double* __restrict coefficients, const queue_data_t* __restrict newest, uint32_t length)
+{
+    for (uint32_t i = RESET; i < length; i++)
+        sum += coefficients[i] * newest[-(int32_t)i];
+    return sum;
+}
+
+/*********************************************************************************************************
+****************************************** IIR filter bank ***********************************************
+* filter_iirFilterBank() runs all ten IIR filters at once with structure-of-arrays state: every array is *
+* indexed [tap][filter], so one vector operation advances the same tap of several filters. The arithmetic *
+* per filter is the same as filter_iirFilter() (direct form or biquads), in the same order.               *
+**********************************************************************************************************/
+
+typedef double filterBank_lanes_t[FILTER_BANK_LANE_COUNT];  //One value per IIR filter (plus padding)
+
+#ifdef FILTER_IIR_USE_SOS
+typedef filterBank_sosValue_t filterBank_sosLanes_t[FILTER_BANK_LANE_COUNT];  //The same, in the biquads' precision
+static filterBank_sosLanes_t bankSosA1[IIR_SOS_SECTION_COUNT];   //a1 of each section, one lane per IIR filter
+static filterBank_sosLanes_t bankSosA2[IIR_SOS_SECTION_COUNT];   //a2 of each section, one lane per IIR filter
+static filterBank_sosLanes_t bankSosGain;                        //Section gain of each IIR filter
+static filterBank_sosLanes_t bankSosW1[IIR_SOS_SECTION_COUNT];   //w[n-1] of each section
+static filterBank_sosLanes_t bankSosW2[IIR_SOS_SECTION_COUNT];   //w[n-2] of each section
+#else
+static filterBank_lanes_t bankB[IIR_B_COEFFICIENT_COUNT];     //B coefficients, one lane per IIR filter
+static filterBank_lanes_t bankNegatedA[IIR_A_COEFFICIENT_COUNT]; //-A coefficients, one lane per IIR filter
+static filterBank_lanes_t bankZ[FILTER_BANK_Z_HISTORY_SIZE];  //Mirrored output history of every IIR filter
+static uint32_t bankZNewestIndex;                             //Index (in the upper copy) of the newest outputs in bankZ
+#endif
+static filterBank_lanes_t bankOutputWindow[FILTER_OUTPUTQUEUE_SIZE];  //The last 2000 outputs of every IIR filter, for power
+static uint32_t bankOutputWindowIndex;                        //Slot holding the oldest outputs (overwritten next)
+static filterBank_lanes_t bankPower;                          //Running power of every IIR filter
+
+//Helper function which builds the lane-ordered coefficient tables and clears the bank state
+void initFilterBank(){
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane++)
+    {
+        bool used = lane < FILTER_IIR_FILTER_COUNT;   //Padding lanes get zero coefficients and stay at zero
+#ifdef FILTER_IIR_USE_SOS
+        bankSosGain[lane] = used ? iirSosSectionGain[lane] : FILTER_INIT_VAL;
+        for (uint32_t section = RESET; section < IIR_SOS_SECTION_COUNT; section++)
+        {
+            bankSosA1[section][lane] = used ? iirSosACoefficients[lane][section][0] : FILTER_INIT_VAL;
+            bankSosA2[section][lane] = used ? iirSosACoefficients[lane][section][1] : FILTER_INIT_VAL;
+            bankSosW1[section][lane] = bankSosW2[section][lane] = FILTER_INIT_VAL;
+        }
+#else
+        for (uint32_t i = RESET; i < IIR_B_COEFFICIENT_COUNT; i++)
+            bankB[i][lane] = used ? iirBCoefficientConstants[lane][i] : FILTER_INIT_VAL;
+        for (uint32_t i = RESET; i < IIR_A_COEFFICIENT_COUNT; i++)
+            bankNegatedA[i][lane] = used ? -iirACoefficientConstants[lane][i] : FILTER_INIT_VAL;
+        for (uint32_t i = RESET; i < FILTER_BANK_Z_HISTORY_SIZE; i++)
+            bankZ[i][lane] = FILTER_INIT_VAL;
+#endif
+        for (uint32_t i = RESET; i < FILTER_OUTPUTQUEUE_SIZE; i++)
+            bankOutputWindow[i][lane] = FILTER_INIT_VAL;
+        bankPower[lane] = FILTER_INIT_VAL;
+    }
+#ifndef FILTER_IIR_USE_SOS
+    bankZNewestIndex = FILTER_BANK_Z_HISTORY_SIZE - 1;
+#endif
+    bankOutputWindowIndex = RESET;
+}
+
+// Runs all ten IIR filters on the newest yQueue value and updates all ten power values.
+void filter_iirFilterBank()
+{
+#ifdef FILTER_USE_FIXED_POINT
+    for (uint16_t i = RESET; i < FILTER_IIR_FILTER_COUNT; i++)   //The integer engine has no bank; run it channel by channel
+    {
+        filterFixed_iirFilter(i);
+        filterFixed_computePower(i, false, false);
+    }
+    return;
+#endif
+    filterBank_lanes_t outputs;
+#ifdef FILTER_IIR_USE_SOS
+    filterBank_sosLanes_t sosOutputs;
+    filterBank_sosVector_t input = filterBank_sosBroadcast(queue_contiguousElements(&y_queue)[IIR_FILTER_LAST_B_INDEX]);
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane += FILTER_BANK_SOS_VECTOR_WIDTH)
+    {
+        filterBank_sosVector_t output = input;
+        filterBank_sosVector_t gain = filterBank_sosLoad(&bankSosGain[lane]);
+        for (uint32_t section = RESET; section < IIR_SOS_SECTION_COUNT; section++)
+        {
+            filterBank_sosVector_t w1 = filterBank_sosLoad(&bankSosW1[section][lane]);
+            filterBank_sosVector_t w2 = filterBank_sosLoad(&bankSosW2[section][lane]);
+            filterBank_sosVector_t w0 = filterBank_sosMultiplySubtract(filterBank_sosMultiplySubtract(output,
+                filterBank_sosLoad(&bankSosA1[section][lane]), w1), filterBank_sosLoad(&bankSosA2[section][lane]), w2);
+            output = filterBank_sosMul(gain, filterBank_sosSub(w0, w2));
+            filterBank_sosStore(&bankSosW2[section][lane], w1);
+            filterBank_sosStore(&bankSosW1[section][lane], w0);
+        }
+        filterBank_sosStore(&sosOutputs[lane], output);
+    }
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane++)   //Widen (a copy when the biquads run in double)
+        outputs[lane] = sosOutputs[lane];
+#else
+    const queue_data_t* newestY = queue_contiguousElements(&y_queue) + IIR_FILTER_LAST_B_INDEX;
+    uint32_t newestZ = bankZNewestIndex;
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane += FILTER_BANK_VECTOR_WIDTH)
+    {
+        filterBank_vector_t output = filterBank_broadcast(FILTER_INIT_VAL);
+        for (uint32_t i = RESET; i < IIR_B_COEFFICIENT_COUNT; i++)   //B side: every filter reads the same y value
+            output = filterBank_add(output, filterBank_mul(filterBank_load(&bankB[i][lane]), filterBank_broadcast(newestY[-(int32_t)i])));
+        for (uint32_t i = RESET; i < IIR_A_COEFFICIENT_COUNT; i++)   //A side: each filter reads its own history
+            output = filterBank_add(output, filterBank_mul(filterBank_load(&bankNegatedA[i][lane]), filterBank_load(&bankZ[newestZ - i][lane])));
+        filterBank_store(&outputs[lane], output);
+    }
+#endif
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane += FILTER_BANK_VECTOR_WIDTH)
+    {
+        //Power: subtract the oldest output squared and add the newest output squared, like filter_computePower()
+        filterBank_vector_t output = filterBank_load(&outputs[lane]);
+        filterBank_vector_t oldest = filterBank_load(&bankOutputWindow[bankOutputWindowIndex][lane]);
+        filterBank_vector_t power = filterBank_load(&bankPower[lane]);
+        power = filterBank_sub(power, filterBank_mul(oldest, oldest));
+        power = filterBank_add(power, filterBank_mul(output, output));
+        filterBank_store(&bankPower[lane], power);
+        filterBank_store(&bankOutputWindow[bankOutputWindowIndex][lane], output);
+    }
+#ifndef FILTER_IIR_USE_SOS
+    //Advance the mirrored history: write the new outputs into both copies
+    bankZNewestIndex = (bankZNewestIndex == FILTER_BANK_Z_HISTORY_SIZE - 1) ? IIR_A_COEFFICIENT_COUNT : bankZNewestIndex + 1;
+    for (uint32_t lane = RESET; lane < FILTER_BANK_LANE_COUNT; lane++)
+        bankZ[bankZNewestIndex][lane] = bankZ[bankZNewestIndex - IIR_A_COEFFICIENT_COUNT][lane] = outputs[lane];
+#endif
+    bankOutputWindowIndex = (bankOutputWindowIndex + 1 == FILTER_OUTPUTQUEUE_SIZE) ? RESET : bankOutputWindowIndex + 1;
+    for (uint16_t i = RESET; i < FILTER_IIR_FILTER_COUNT; i++)
+        current_power_vals[i] = bankPower[i];
+}
+
+// Runs the filter chain over a block of raw ADC codes and emits one power vector per decimated sample.
+uint32_t filter_processBlock(const uint32_t adcSamples[], uint32_t sampleCount, filter_powerVector_t powerVectors[])
+{
+    uint32_t vectorCount = RESET;
+    uint32_t i = RESET;
+    while (i < sampleCount)
+    {
+        //Push samples up to the next decimation boundary (or the end of the block) in one tight loop
+        uint32_t runLength = DECIMATION_VALUE - blockDecimationPhase;
+        if (runLength > sampleCount - i)
+            runLength = sampleCount - i;
+        for (uint32_t end = i + runLength; i < end; i++)
+        {
+#ifdef FILTER_USE_FIXED_POINT
+            filterFixed_addNewInput(filterFixed_adcToQ15(adcSamples[i]));   //Integer mapping of the same (code - 2048) / 2048
+#else
+            queue_overwritePush(&x_queue, (adcSamples[i] - FILTER_ADC_HALFWAY_POINT) / FILTER_ADC_HALFWAY_POINT);
+#endif
+        }
+        blockDecimationPhase += runLength;
+        if (blockDecimationPhase < DECIMATION_VALUE)                 //The block ended part-way through a decimation period
+            break;
+        blockDecimationPhase = RESET;
+        PROFILER_BEGIN(firZone);
+        filter_firFilter();
+        PROFILER_END(firZone);
+        PROFILER_BEGIN(iirBankZone);
+        filter_iirFilterBank();
+        PROFILER_END(iirBankZone);
+        PROFILER_BEGIN(powerZone);
+        filter_getCurrentPowerValues(powerVectors[vectorCount++]);
+        PROFILER_END(powerZone);
+    }
+    return vectorCount;
+}
+
 // Must call this prior to using any filter functions.
 void filter_init()
 {
+    initNegatedACoefficients();
     initXQueue();       // create x,y,z's, and output's queue's
     initYQueue();       // and initialize the queues with their own helper functions
     initZQueues();      // and set the values in the queues to 0
@@ -191,6 +496,13 @@ void filter_init()
     {
         current_power_vals[i] = FILTER_INIT_VAL;                //Initialize the most recently calculated power for each IIR filter to 0.
     }
+    for (uint8_t i = RESET; i < FILTER_IIR_FILTER_COUNT; i++)   //Clear the biquad state of every IIR filter (zQueues are already zeroed)
+        filter_clearIirState(i);
+    initFilterBank();                                           //Lane-ordered coefficients and state for filter_iirFilterBank()
+    blockDecimationPhase = RESET;                               //filter_processBlock() starts on a decimation boundary
+#ifdef FILTER_USE_FIXED_POINT
+    filterFixed_init();                                         //Build the Q15 coefficient tables and clear the integer delay lines
+#endif
 }
  
 
@@ -198,7 +510,11 @@ void filter_init()
 // Use this to copy an input into the input queue of the FIR-filter (xQueue).
 void filter_addNewInput(double x)
 {
+#ifdef FILTER_USE_FIXED_POINT
+    filterFixed_addNewInput(filterFixed_doubleToQ15(x));    //Convert to Q15 and push onto the integer delay line
+#else
     queue_overwritePush(&x_queue, x);    //Force push the value onto the x-queue
+#endif
 }
  
 // Fills a queue with the given fillValue. For example,
@@ -216,11 +532,12 @@ void filter_fillQueue(queue_t* q, double fillValue)
 // Output is returned and is also pushed on to yQueue.
 double filter_firFilter()
 {
-    double filtered_val = FILTER_INIT_VAL;                      //Initialize the output value
-    for (queue_index_t i = RESET; i < FIR_FILTER_TAP_COUNT; i++)//Loop through each value in the coeffecient array and XQueue
-    {
-        filtered_val += firCoefficients[i] * queue_readElementAt(&x_queue, FIR_FILTER_LAST_INDEX - i);  //Convolve
-    }
+#ifdef FILTER_USE_FIXED_POINT
+    return filterFixed_firFilter();                             //Integer FIR, see filterFixed.h
+#endif
+    //Convolve: the mirrored xQueue holds all 81 samples contiguously, so read back from the newest one
+    const queue_data_t* newest = queue_contiguousElements(&x_queue) + FIR_FILTER_LAST_INDEX;
+    double filtered_val = multiplyAccumulate(FILTER_INIT_VAL, firCoefficients, newest, FIR_FILTER_TAP_COUNT);
     queue_overwritePush(&y_queue, filtered_val);                //Push the filtered value onto the yQueue
     return filtered_val;                                        //Return the filtered value
 }
@@ -229,20 +546,45 @@ double filter_firFilter()
 // Output is returned and is also pushed onto zQueue[filterNumber].
 double filter_iirFilter(uint16_t filterNumber)
 {
-    double output = FILTER_INIT_VAL;                                //Initialize the output value to 0
-    for (queue_index_t i = RESET; i < IIR_B_COEFFICIENT_COUNT; i++) //Loop through each value in the B coefficient array and yQueue
+#ifdef FILTER_USE_FIXED_POINT
+    return filterFixed_iirFilter(filterNumber);                     //Integer biquads, see filterFixed.h
+#endif
+#ifdef FILTER_IIR_USE_SOS
+    //Run the newest yQueue value through the 5 biquads. Each section is gain * (1 - z^-2) / (1 + a1 z^-1 + a2 z^-2),
+    //so it costs two multiply-accumulates for the poles and one multiply for the gain.
+    double output = queue_contiguousElements(&y_queue)[IIR_FILTER_LAST_B_INDEX];
+    double gain = iirSosSectionGain[filterNumber];
+    for (uint8_t section = RESET; section < IIR_SOS_SECTION_COUNT; section++)
     {
-        output += iirBCoefficientConstants[filterNumber][i] * queue_readElementAt(&y_queue, IIR_FILTER_LAST_B_INDEX - i);                   //Multiply and sum to the total
-    }
-    for (queue_index_t i = RESET; i < IIR_A_COEFFICIENT_COUNT; i++) //Loop through each value in the A coefficient array and zQueue
-    {
-        output -= iirACoefficientConstants[filterNumber][i] * queue_readElementAt(&(z_queue[filterNumber]), IIR_FILTER_LAST_A_INDEX - i);   //Multiply and subtract from the total
+        const double* a = iirSosACoefficients[filterNumber][section];
+        double* w = iirSosState[filterNumber][section];
+        double w0 = output - a[0] * w[IIR_SOS_W1_INDEX] - a[1] * w[IIR_SOS_W2_INDEX];  //Poles
+        output = gain * (w0 - w[IIR_SOS_W2_INDEX]);                                     //Zeros at z = 1 and z = -1
+        w[IIR_SOS_W2_INDEX] = w[IIR_SOS_W1_INDEX];
+        w[IIR_SOS_W1_INDEX] = w0;
     }
+#else
+    //Multiply and sum the B side over the yQueue, then subtract the A side over the zQueue (both mirrored)
+    const queue_data_t* newestY = queue_contiguousElements(&y_queue) + IIR_FILTER_LAST_B_INDEX;
+    const queue_data_t* newestZ = queue_contiguousElements(&(z_queue[filterNumber])) + IIR_FILTER_LAST_A_INDEX;
+    double output = multiplyAccumulate(FILTER_INIT_VAL, iirBCoefficientConstants[filterNumber], newestY, IIR_B_COEFFICIENT_COUNT);
+    output = multiplyAccumulate(output, iirACoefficientsNegated[filterNumber], newestZ, IIR_A_COEFFICIENT_COUNT);
+#endif
     queue_overwritePush(&(z_queue[filterNumber]), output);          //Push the output onto the z-queue for future iterations of iirFilter()
     queue_overwritePush(&(output_queue[filterNumber]), output);     //Push the output onto the outputQueue for future calculations of power
     return output;                                                  //Return the filtered output value
 }
  
+// Zeros the history of a single IIR filter (its zQueue and, with FILTER_IIR_USE_SOS, its biquad state).
+void filter_clearIirState(uint16_t filterNumber)
+{
+    filter_fillQueue(&(z_queue[filterNumber]), FILTER_INIT_VAL);   //The direct-form state
+#ifdef FILTER_IIR_USE_SOS
+    for (uint8_t section = RESET; section < IIR_SOS_SECTION_COUNT; section++)  //The biquad state
+        iirSosState[filterNumber][section][IIR_SOS_W1_INDEX] = iirSosState[filterNumber][section][IIR_SOS_W2_INDEX] = FILTER_INIT_VAL;
+#endif
+}
+ 
 // Use this to compute the power for values contained in an outputQueue.
 // If force == true, then recompute power by using all values in the outputQueue.
 // This option is necessary so that you can correctly compute power values the first time.
@@ -255,6 +597,9 @@ double filter_iirFilter(uint16_t filterNumber)
 // of the 10 output queues.
 double filter_computePower(uint16_t filterNumber, bool forceComputeFromScratch, bool debugPrint)
 {
+#ifdef FILTER_USE_FIXED_POINT
+    return filterFixed_computePower(filterNumber, forceComputeFromScratch, debugPrint);
+#endif
     double power = FILTER_INIT_VAL;                     // Initialize the power variable for calculation
     queue_t* q = &(output_queue[filterNumber]);         // Get the address of the queue we want to access
     if (forceComputeFromScratch)                        // If we need to compute from scratch
@@ -280,6 +625,9 @@ double filter_computePower(uint16_t filterNumber, bool forceComputeFromScratch,
 // Returns the last-computed output power value for the IIR filter [filterNumber].
 double filter_getCurrentPowerValue(uint16_t filterNumber)
 {
+#ifdef FILTER_USE_FIXED_POINT
+   return filterFixed_getCurrentPowerValue(filterNumber);
+#endif
    return current_power_vals[filterNumber];
 }
  
@@ -290,6 +638,10 @@ double filter_getCurrentPowerValue(uint16_t filterNumber)
 // that function are reflected in the returned array.
 void filter_getCurrentPowerValues(double powerValues[])
 {
+#ifdef FILTER_USE_FIXED_POINT
+    filterFixed_getCurrentPowerValues(powerValues);
+    return;
+#endif
     for(uint8_t i = RESET; i < FILTER_IIR_FILTER_COUNT ; i++){//takes an array that was passed in and copies the contents of the power queue we want to remain private to the passed in queue
         powerValues[i] = current_power_vals[i];
     }
@@ -300,6 +652,10 @@ void filter_getCurrentPowerValues(double powerValues[])
 // all of the values in normalizedArray by the maximum power value contained in currentPowerValue[].
 void filter_getNormalizedPowerValues(double normalizedArray[], uint16_t* indexOfMaxValue)
 {
+#ifdef FILTER_USE_FIXED_POINT
+    filterFixed_getNormalizedPowerValues(normalizedArray, indexOfMaxValue);
+    return;
+#endif
     double largest_val = FILTER_INIT_VAL;						//sets the initial value to 0
     for(uint16_t i = RESET; i < FILTER_IIR_FILTER_COUNT; i++){	//sets up the for loop to iterate
         normalizedArray[i] = current_power_vals[i];				//copies the contents from current_power_vals to normalizedArray
@@ -349,6 +705,18 @@ const double* filter_getIirBCoefficientArray(uint16_t filterNumber)
     return iirBCoefficientConstants[filterNumber];
 }
  
+// Returns the {a1, a2} pairs of the biquad sections of a particular filter number, section by section.
+const double* filter_getIirSosACoefficientArray(uint16_t filterNumber)
+{
+    return iirSosACoefficients[filterNumber][RESET];
+}
+ 
+// Returns the gain that every biquad section of a particular filter number applies.
+double filter_getIirSosSectionGain(uint16_t filterNumber)
+{
+    return iirSosSectionGain[filterNumber];
+}
+ 
 // Returns the number of B coefficients.
 uint32_t filter_getIirBCoefficientCount()
 {
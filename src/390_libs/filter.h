@@ -9,11 +9,40 @@
 #define FILTER_FREQUENCY_COUNT 10
 #define FILTER_FIR_DECIMATION_FACTOR 10  // FIR-filter needs this many new inputs to compute a new output.
 #define FILTER_INPUT_PULSE_WIDTH 2000    // This is the width of the pulse you are looking for, in terms of decimated sample count.
+#define FILTER_ADC_HALFWAY_POINT 2048.0  // Raw ADC code that maps to 0.0; filter_processBlock() maps codes to (code - 2048) / 2048.
+
+// Largest number of power vectors filter_processBlock() can emit for a block of sampleCount samples
+// (up to FILTER_FIR_DECIMATION_FACTOR-1 samples may be left over from the previous block).
+#define FILTER_BLOCK_MAX_POWER_VECTORS(sampleCount) ((sampleCount) / FILTER_FIR_DECIMATION_FACTOR + 1)
+
+// One decimated output of filter_processBlock(): the power of every IIR filter.
+typedef double filter_powerVector_t[FILTER_FREQUENCY_COUNT];
+
+// Uncomment the line below to run the filter_* functions on the integer (Q15/Q31) engine in filterFixed.c.
+// It runs the FIR, the biquad IIR filters and the power sums without any double arithmetic and halves
+// the power windows (80 KB instead of 160 KB); its A9 cycle count has not been measured yet.
+// The queue accessors below still work but only reflect the double path, so the filterTest.c
+// alignment tests are only meaningful with this line commented out.
+//#define FILTER_USE_FIXED_POINT
+
+// Uncomment the line below to run the IIR filters as cascades of 5 biquads (second-order sections)
+// instead of 10th-order direct form. The responses are the same, the arithmetic is better conditioned
+// and each output costs 15 multiplies instead of 21. The zQueues still receive every output, but they
+// no longer hold the filter state, so the filterTest.c IIR A-alignment test does not apply.
+// On the Cortex-A9 this also moves filter_iirFilterBank() onto NEON (see below).
+//#define FILTER_IIR_USE_SOS
+
+// Defined when filter_iirFilterBank() runs its biquads in single precision: FILTER_IIR_USE_SOS on ARMv7 NEON
+// (build with -mfpu=neon). Its powers then match the per-filter functions to about 1e-5 relative, not exactly.
+#if defined(FILTER_IIR_USE_SOS) && defined(__ARM_NEON) && !defined(__aarch64__)
+#define FILTER_BANK_SINGLE_PRECISION
+#endif
+
 // These are the tick counts that are used to generate the user frequencies.
 // Not used in filter.h but are used to TEST the filter code.
 // Placed here for general access as they are essentially constant throughout
 // the code. The transmitter will also use these.
-const uint16_t filter_frequencyTickTable[FILTER_FREQUENCY_COUNT] = {68, 58, 50, 44, 38, 34, 30, 28, 26, 24};
+static const uint16_t filter_frequencyTickTable[FILTER_FREQUENCY_COUNT] = {68, 58, 50, 44, 38, 34, 30, 28, 26, 24};
 
 // Filtering routines for the laser-tag project.
 // Filtering is performed by a two-stage filter, as described below.
@@ -46,6 +75,28 @@ double filter_firFilter();
 // Output is returned and is also pushed onto zQueue[filterNumber].
 double filter_iirFilter(uint16_t filterNumber);
 
+// Runs all ten IIR filters on the newest yQueue value and updates all ten power values in one pass.
+// Computes what filter_iirFilter(i) and filter_computePower(i, false, false) would for every i, with the
+// filters processed in vector lanes (SSE/AVX on the host): the same values in double precision, and within
+// about 1e-5 relative with FILTER_BANK_SINGLE_PRECISION. The Cortex-A9's NEON unit has no double precision,
+// so there only the biquads of FILTER_IIR_USE_SOS run in NEON (float32x4) lanes. The default A9 build (the
+// direct form) gets no SIMD at all: its filters and the power run in scalar double lanes. The bank keeps
+// its own history: it does not update the zQueues or outputQueues, so use either this function or the
+// per-filter functions, not both.
+void filter_iirFilterBank();
+
+// Runs the whole filter chain over a block of raw ADC codes (0 - 4095), oldest sample first.
+// sampleCount can be any length: the decimation phase is kept between calls, so a block that ends
+// part-way through a decimation period is finished by the next call. Every FILTER_FIR_DECIMATION_FACTOR-th
+// sample runs filter_firFilter() and filter_iirFilterBank() and copies the ten power values into the next
+// entry of powerVectors[], which must hold FILTER_BLOCK_MAX_POWER_VECTORS(sampleCount) entries.
+// Returns the number of power vectors written. Like filter_iirFilterBank(), this does not update the
+// zQueues or outputQueues. Don't mix it with filter_addNewInput(), which does not advance the phase.
+uint32_t filter_processBlock(const uint32_t adcSamples[], uint32_t sampleCount, filter_powerVector_t powerVectors[]);
+
+// Zeros the history of a single IIR filter (its zQueue and, with FILTER_IIR_USE_SOS, its biquad state).
+void filter_clearIirState(uint16_t filterNumber);
+
 // Use this to compute the power for values contained in an outputQueue.
 // If force == true, then recompute power by using all values in the outputQueue.
 // This option is necessary so that you can correctly compute power values the first time.
@@ -97,6 +148,12 @@ const double* filter_getIirBCoefficientArray(uint16_t filterNumber);
 // Returns the number of B coefficients.
 uint32_t filter_getIirBCoefficientCount();
 
+// Returns the {a1, a2} pairs of the 5 biquad sections of a particular filter number (see FILTER_IIR_USE_SOS).
+const double* filter_getIirSosACoefficientArray(uint16_t filterNumber);
+
+// Returns the gain that every biquad section of a particular filter number applies.
+double filter_getIirSosSectionGain(uint16_t filterNumber);
+
 // Returns the size of the yQueue.
 uint32_t filter_getYQueueSize();
 
@@ -0,0 +1,261 @@
+#include "filterFixed.h"
+#include "filter.h"
+#include <stdio.h>
+#include <math.h>
+
+#define FILTER_FIXED_IIR_FILTER_COUNT FILTER_FREQUENCY_COUNT     // One IIR filter per user frequency.
+#define FILTER_FIXED_FIR_TAP_COUNT 81                            // Length of the FIR filter (same as filter.c).
+#define FILTER_FIXED_IIR_SECTION_COUNT 5                         // Biquads per IIR filter (same as filter.c).
+#define FILTER_FIXED_POWER_WINDOW_SIZE 2000                      // Number of IIR outputs summed for power (200 ms at 10 kHz).
+#define FILTER_FIXED_INIT_VAL 0                                  // Initial value for delay lines and indices.
+#define FILTER_FIXED_Q22_SHIFT 22                                // Fractional bits of the IIR state and outputs.
+#define FILTER_FIXED_Q30_SHIFT 30                                // Fractional bits of a1 and a2.
+#define FILTER_FIXED_Q31_SHIFT 31                                // Fractional bits of the section gain.
+#define FILTER_FIXED_Q15_TO_Q22_SHIFT (FILTER_FIXED_Q22_SHIFT - FILTER_FIXED_Q15_SHIFT)  // FIR output -> IIR input.
+#define FILTER_FIXED_POWER_ONE ((double) (1LL << (2 * FILTER_FIXED_Q22_SHIFT)))          // 1.0 in the Q44 power sums.
+#define FILTER_FIXED_A1_INDEX 0                                  // Index of a1 in a section's coefficients.
+#define FILTER_FIXED_A2_INDEX 1                                  // Index of a2 in a section's coefficients.
+#define FILTER_FIXED_W1_INDEX 0                                  // Index of w[n-1] in a section's state.
+#define FILTER_FIXED_W2_INDEX 1                                  // Index of w[n-2] in a section's state.
+#define FILTER_FIXED_SECTION_VALUE_COUNT 2                       // a1, a2 (or w[n-1], w[n-2]) per section.
+
+static filterFixed_q15_t firCoefficientsQ15[FILTER_FIXED_FIR_TAP_COUNT];                    // FIR coefficients in Q15.
+static int32_t iirSosAQ30[FILTER_FIXED_IIR_FILTER_COUNT][FILTER_FIXED_IIR_SECTION_COUNT][FILTER_FIXED_SECTION_VALUE_COUNT];  // {a1, a2} in Q30.
+static int32_t iirSosGainQ31[FILTER_FIXED_IIR_FILTER_COUNT];                               // Section gain in Q31.
+
+static filterFixed_q15_t xDelayLine[FILTER_FIXED_FIR_TAP_COUNT];                            // FIR input, Q15.
+static uint32_t xIndexIn;                                                                   // Next slot to write (also the oldest sample).
+static filterFixed_q22_t iirInput;                                                          // Newest FIR output, Q22.
+static filterFixed_q22_t iirSosState[FILTER_FIXED_IIR_FILTER_COUNT][FILTER_FIXED_IIR_SECTION_COUNT][FILTER_FIXED_SECTION_VALUE_COUNT];  // {w[n-1], w[n-2]}.
+static filterFixed_q22_t powerWindow[FILTER_FIXED_IIR_FILTER_COUNT][FILTER_FIXED_POWER_WINDOW_SIZE];  // The last 2000 outputs of each IIR filter.
+static uint32_t powerIndexIn[FILTER_FIXED_IIR_FILTER_COUNT];                                // Next slot to write (also the oldest output).
+static filterFixed_q22_t powerDroppedValue[FILTER_FIXED_IIR_FILTER_COUNT];                  // Output that just left the power window.
+static int64_t currentPowerValues[FILTER_FIXED_IIR_FILTER_COUNT];                           // Most recently computed power values, Q44.
+
+// Rounds and saturates a double that has already been scaled to Q15.
+static filterFixed_q15_t filterFixed_saturateQ15(double scaled) {
+  if (scaled >= FILTER_FIXED_Q15_MAX)
+    return FILTER_FIXED_Q15_MAX;
+  if (scaled <= FILTER_FIXED_Q15_MIN)
+    return FILTER_FIXED_Q15_MIN;
+  return (filterFixed_q15_t) lround(scaled);
+}
+
+// Squares a Q22 output into the Q44 power sum.
+static int64_t filterFixed_square(filterFixed_q22_t x) {
+  return (int64_t) x * x;
+}
+
+// Must call this prior to using any filterFixed functions.
+// Builds the rescaled coefficient tables from the double coefficients in filter.c.
+void filterFixed_init() {
+  const double* firCoefficients = filter_getFirCoefficientArray();
+  for (uint32_t i = 0; i < FILTER_FIXED_FIR_TAP_COUNT; i++)
+    firCoefficientsQ15[i] = filterFixed_saturateQ15(firCoefficients[i] * FILTER_FIXED_Q15_ONE);
+  for (uint16_t filter = 0; filter < FILTER_FIXED_IIR_FILTER_COUNT; filter++) {
+    const double* a = filter_getIirSosACoefficientArray(filter);   // {a1, a2} of each section, one after the other.
+    for (uint32_t section = 0; section < FILTER_FIXED_IIR_SECTION_COUNT; section++)
+      for (uint32_t i = 0; i < FILTER_FIXED_SECTION_VALUE_COUNT; i++)
+        iirSosAQ30[filter][section][i] = (int32_t) llround(a[section * FILTER_FIXED_SECTION_VALUE_COUNT + i] * (1LL << FILTER_FIXED_Q30_SHIFT));
+    iirSosGainQ31[filter] = (int32_t) llround(filter_getIirSosSectionGain(filter) * (1LL << FILTER_FIXED_Q31_SHIFT));
+  }
+  for (uint32_t i = 0; i < FILTER_FIXED_FIR_TAP_COUNT; i++)
+    xDelayLine[i] = FILTER_FIXED_INIT_VAL;
+  xIndexIn = FILTER_FIXED_INIT_VAL;
+  iirInput = FILTER_FIXED_INIT_VAL;
+  for (uint16_t filter = 0; filter < FILTER_FIXED_IIR_FILTER_COUNT; filter++) {
+    for (uint32_t section = 0; section < FILTER_FIXED_IIR_SECTION_COUNT; section++)
+      for (uint32_t i = 0; i < FILTER_FIXED_SECTION_VALUE_COUNT; i++)
+        iirSosState[filter][section][i] = FILTER_FIXED_INIT_VAL;
+    for (uint32_t i = 0; i < FILTER_FIXED_POWER_WINDOW_SIZE; i++)
+      powerWindow[filter][i] = FILTER_FIXED_INIT_VAL;
+    powerIndexIn[filter] = FILTER_FIXED_INIT_VAL;
+    powerDroppedValue[filter] = FILTER_FIXED_INIT_VAL;
+    currentPowerValues[filter] = FILTER_FIXED_INIT_VAL;
+  }
+}
+
+// Converts a double in [-1.0, 1.0) to Q15, saturating out-of-range values.
+filterFixed_q15_t filterFixed_doubleToQ15(double x) {
+  return filterFixed_saturateQ15(x * FILTER_FIXED_Q15_ONE);
+}
+
+// Converts a raw 12-bit ADC value to Q15 (same mapping as (x - 2048.0) / 2048.0).
+filterFixed_q15_t filterFixed_adcToQ15(uint32_t adcValue) {
+  return (filterFixed_q15_t) (((int32_t) adcValue - FILTER_FIXED_ADC_MIDSCALE) << FILTER_FIXED_ADC_TO_Q15_SHIFT);
+}
+
+// Copies a Q15 input into the FIR delay line.
+void filterFixed_addNewInput(filterFixed_q15_t x) {
+  xDelayLine[xIndexIn] = x;
+  xIndexIn = (xIndexIn + 1 == FILTER_FIXED_FIR_TAP_COUNT) ? 0 : xIndexIn + 1;
+}
+
+// Invokes the FIR-filter on the FIR delay line.
+// Output becomes the input of the IIR filters and is returned as a double.
+double filterFixed_firFilter() {
+  // The oldest sample (at xIndexIn) pairs with the last coefficient, the newest with the first.
+  // Walk the circular buffer in two straight runs so there is no index wrap inside the loops.
+  filterFixed_q31_t accumulator = 0;
+  uint32_t firstRunLength = FILTER_FIXED_FIR_TAP_COUNT - xIndexIn;
+  const filterFixed_q15_t* coefficient = &firCoefficientsQ15[FILTER_FIXED_FIR_TAP_COUNT - 1];
+  for (uint32_t i = xIndexIn; i < FILTER_FIXED_FIR_TAP_COUNT; i++)
+    accumulator += (filterFixed_q31_t) xDelayLine[i] * *coefficient--;
+  for (uint32_t i = 0; i < FILTER_FIXED_FIR_TAP_COUNT - firstRunLength; i++)
+    accumulator += (filterFixed_q31_t) xDelayLine[i] * *coefficient--;
+  // Q30 -> Q15 with rounding. The result is kept in 32 bits so FIR overshoot does not clip.
+  int32_t output = (accumulator + (1 << (FILTER_FIXED_Q15_SHIFT - 1))) >> FILTER_FIXED_Q15_SHIFT;
+  iirInput = output << FILTER_FIXED_Q15_TO_Q22_SHIFT;
+  return (double) output / FILTER_FIXED_Q15_ONE;
+}
+
+// Invokes a single IIR filter. Output is returned and is also pushed into the power window.
+double filterFixed_iirFilter(uint16_t filterNumber) {
+  // Same biquads as filter.c with FILTER_IIR_USE_SOS: poles from the Q30 a1/a2, then gain * (w0 - w[n-2]).
+  filterFixed_q22_t output = iirInput;
+  int64_t gain = iirSosGainQ31[filterNumber];
+  for (uint32_t section = 0; section < FILTER_FIXED_IIR_SECTION_COUNT; section++) {
+    const int32_t* a = iirSosAQ30[filterNumber][section];
+    filterFixed_q22_t* w = iirSosState[filterNumber][section];
+    int64_t feedback = (int64_t) a[FILTER_FIXED_A1_INDEX] * w[FILTER_FIXED_W1_INDEX] + (int64_t) a[FILTER_FIXED_A2_INDEX] * w[FILTER_FIXED_W2_INDEX];
+    filterFixed_q22_t w0 = output - (filterFixed_q22_t) ((feedback + (1LL << (FILTER_FIXED_Q30_SHIFT - 1))) >> FILTER_FIXED_Q30_SHIFT);
+    output = (filterFixed_q22_t) ((gain * (w0 - w[FILTER_FIXED_W2_INDEX]) + (1LL << (FILTER_FIXED_Q31_SHIFT - 1))) >> FILTER_FIXED_Q31_SHIFT);
+    w[FILTER_FIXED_W2_INDEX] = w[FILTER_FIXED_W1_INDEX];
+    w[FILTER_FIXED_W1_INDEX] = w0;
+  }
+  uint32_t powerIndex = powerIndexIn[filterNumber];
+  powerDroppedValue[filterNumber] = powerWindow[filterNumber][powerIndex];
+  powerWindow[filterNumber][powerIndex] = output;
+  powerIndexIn[filterNumber] = (powerIndex + 1 == FILTER_FIXED_POWER_WINDOW_SIZE) ? 0 : powerIndex + 1;
+  return (double) output / (1 << FILTER_FIXED_Q22_SHIFT);
+}
+
+// Same contract as filter_computePower().
+// The sum is exact in integers, so the running update gives the same value as the from-scratch one.
+double filterFixed_computePower(uint16_t filterNumber, bool forceComputeFromScratch, bool debugPrint) {
+  int64_t power = FILTER_FIXED_INIT_VAL;
+  if (forceComputeFromScratch) {
+    for (uint32_t i = 0; i < FILTER_FIXED_POWER_WINDOW_SIZE; i++)
+      power += filterFixed_square(powerWindow[filterNumber][i]);
+  } else {
+    uint32_t newestIndex = (powerIndexIn[filterNumber] == 0) ? FILTER_FIXED_POWER_WINDOW_SIZE - 1 : powerIndexIn[filterNumber] - 1;
+    power = currentPowerValues[filterNumber] - filterFixed_square(powerDroppedValue[filterNumber]) + filterFixed_square(powerWindow[filterNumber][newestIndex]);
+  }
+  currentPowerValues[filterNumber] = power;
+  if (debugPrint)
+    printf("filterFixed power[%d]: %le\n\r", filterNumber, filterFixed_getCurrentPowerValue(filterNumber));
+  return filterFixed_getCurrentPowerValue(filterNumber);
+}
+
+// Returns the last-computed output power value for the IIR filter [filterNumber].
+double filterFixed_getCurrentPowerValue(uint16_t filterNumber) {
+  return currentPowerValues[filterNumber] / FILTER_FIXED_POWER_ONE;
+}
+
+// Copies the current power values into powerValues[].
+void filterFixed_getCurrentPowerValues(double powerValues[]) {
+  for (uint16_t i = 0; i < FILTER_FIXED_IIR_FILTER_COUNT; i++)
+    powerValues[i] = filterFixed_getCurrentPowerValue(i);
+}
+
+// Same contract as filter_getNormalizedPowerValues().
+void filterFixed_getNormalizedPowerValues(double normalizedArray[], uint16_t* indexOfMaxValue) {
+  double largest = FILTER_FIXED_INIT_VAL;
+  for (uint16_t i = 0; i < FILTER_FIXED_IIR_FILTER_COUNT; i++) {
+    normalizedArray[i] = filterFixed_getCurrentPowerValue(i);
+    if (normalizedArray[i] > largest) {
+      largest = normalizedArray[i];
+      *indexOfMaxValue = i;
+    }
+  }
+  for (uint16_t i = 0; i < FILTER_FIXED_IIR_FILTER_COUNT; i++)
+    normalizedArray[i] = normalizedArray[i] / largest;
+}
+
+/*********************************************************************************************************
+************************************ Accuracy report against filter.c ************************************
+**********************************************************************************************************/
+
+#define FILTER_FIXED_TEST_AMPLITUDE_COUNT 3                           // Number of input amplitudes that are tried.
+#define FILTER_FIXED_TEST_INPUT_LENGTH 25000                          // Input samples per run: enough to fill the power window.
+#define FILTER_FIXED_TEST_DECIMATION 10                               // Same decimation factor as the detector.
+#ifndef FILTER_USE_FIXED_POINT
+static const double filterFixed_testAmplitudes[FILTER_FIXED_TEST_AMPLITUDE_COUNT] = {0.99, 0.1, 0.01};  // Full-scale down to a weak hit.
+
+// Clears the filter.c queues through the verification accessors so filter_init() (which allocates) is only called once.
+static void filterFixed_resetDoublePath() {
+  filter_fillQueue(filter_getXQueue(), 0.0);
+  filter_fillQueue(filter_getYQueue(), 0.0);
+  for (uint16_t i = 0; i < FILTER_FIXED_IIR_FILTER_COUNT; i++) {
+    filter_fillQueue(filter_getZQueue(i), 0.0);
+    filter_fillQueue(filter_getIirOutputQueue(i), 0.0);
+    filter_computePower(i, true, false);
+  }
+}
+
+// Feeds a square wave with the given period (in 100 kHz ticks) through both paths.
+static void filterFixed_runSquareWave(uint16_t periodTicks, double amplitude) {
+  for (uint32_t sample = 0; sample < FILTER_FIXED_TEST_INPUT_LENGTH; sample++) {
+    double x = ((sample % periodTicks) < periodTicks / 2) ? amplitude : -amplitude;
+    filter_addNewInput(x);
+    filterFixed_addNewInput(filterFixed_doubleToQ15(x));
+    if ((sample + 1) % FILTER_FIXED_TEST_DECIMATION == 0) {
+      filter_firFilter();
+      filterFixed_firFilter();
+      for (uint16_t i = 0; i < FILTER_FIXED_IIR_FILTER_COUNT; i++) {
+        filter_iirFilter(i);
+        filterFixed_iirFilter(i);
+        filter_computePower(i, false, false);
+        filterFixed_computePower(i, false, false);
+      }
+    }
+  }
+}
+
+// Runs the same square-wave inputs through the fixed-point path and the double filter_* path
+// and prints the worst normalized-power difference for each user frequency.
+bool filterFixed_runAccuracyTest() {
+  bool success = true;
+  double worstOverall = 0.0;
+  filter_init();
+  printf("filterFixed accuracy report (tolerance %lf)\n\r", FILTER_FIXED_NORMALIZED_POWER_TOLERANCE);
+  for (uint16_t frequency = 0; frequency < FILTER_FREQUENCY_COUNT; frequency++) {
+    double worst = 0.0;
+    for (uint16_t amplitude = 0; amplitude < FILTER_FIXED_TEST_AMPLITUDE_COUNT; amplitude++) {
+      filterFixed_resetDoublePath();
+      filterFixed_init();
+      filterFixed_runSquareWave(filter_frequencyTickTable[frequency], filterFixed_testAmplitudes[amplitude]);
+      double doubleValues[FILTER_FREQUENCY_COUNT];
+      double fixedValues[FILTER_FREQUENCY_COUNT];
+      uint16_t doubleMax = 0, fixedMax = 0;
+      filter_getNormalizedPowerValues(doubleValues, &doubleMax);
+      filterFixed_getNormalizedPowerValues(fixedValues, &fixedMax);
+      for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        double difference = fabs(doubleValues[i] - fixedValues[i]);
+        if (difference > worst)
+          worst = difference;
+      }
+    }
+    printf("frequency %d (%d ticks): max normalized power difference %le\n\r", frequency, filter_frequencyTickTable[frequency], worst);
+    if (worst > FILTER_FIXED_NORMALIZED_POWER_TOLERANCE)
+      success = false;
+    if (worst > worstOverall)
+      worstOverall = worst;
+  }
+  printf("filterFixed accuracy report %s (worst difference %le)\n\r", success ? "passed" : "FAILED", worstOverall);
+  return success;
+}
+#else
+// filter_* is the fixed-point path in this build, so there is nothing to compare against.
+bool filterFixed_runAccuracyTest() {
+  printf("filterFixed_runAccuracyTest: filter_* is the fixed-point path in this build; undefine FILTER_USE_FIXED_POINT.\n\r");
+  return false;
+}
+#endif
+
+#ifdef FILTER_FIXED_HOST_MAIN
+// Host entry point for the accuracy report, see filterFixed.h.
+int main() {
+  return filterFixed_runAccuracyTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,86 @@
+#ifndef FILTERFIXED_H_
+#define FILTERFIXED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Integer version of the laser-tag filter chain. filter.c forwards to these functions
+// when FILTER_USE_FIXED_POINT is defined in filter.h; the double path stays the default.
+//
+// Number formats:
+// - Inputs are Q15 (int16_t, 1.0 == 32768).
+// - FIR coefficients are Q15, so every product is Q30 and the 81-tap sum is accumulated in an int32_t.
+//   The sum of the absolute FIR coefficients is about 1.46, so the accumulator cannot overflow.
+// - The FIR output (the IIR input) is kept as a Q15 value in an int32_t to leave room for overshoot.
+// - The IIR filters run as the 5 biquad sections of FILTER_IIR_USE_SOS, each gain * (1 - z^-2) /
+//   (1 + a1 z^-1 + a2 z^-2), in direct form II. Their state and outputs are Q22 in an int32_t: a full-scale
+//   input at a filter's own frequency takes a section's state to about 110, well inside the 2^9 the
+//   integer bits hold. a1 and a2 are Q30 (|a1| < 2), the gain is Q31, and products are 64 bits wide.
+//   The 10th-order direct form is not used: quantizing its A coefficients (above 160, with the poles
+//   very close together) makes it unstable, even with 30 fractional bits.
+// - Power is the sum of the squared Q22 outputs over the window, kept exactly in an int64_t (Q44; the
+//   window of 2000 outputs of at most about 1.7 needs 57 bits), so the running update never drifts.
+//
+// Per decimated sample, the FIR, the ten filters and their power updates are integer multiplies and
+// adds only; doubles appear only in the values the functions below return. Against filter.c that turns
+// 210 double multiply-accumulates (21 per direct-form filter) into 150 32x32->64 multiplies (3 per
+// section), makes the power update 2 integer squares, and halves the power windows (80 KB instead of
+// 160 KB). The A9 cycle count has not been measured yet.
+
+#define FILTER_FIXED_Q15_SHIFT 15                            // Number of fractional bits in a Q15 value.
+#define FILTER_FIXED_Q15_ONE (1 << FILTER_FIXED_Q15_SHIFT)   // 1.0 in Q15.
+#define FILTER_FIXED_Q15_MAX INT16_MAX                       // Largest representable Q15 value (just under 1.0).
+#define FILTER_FIXED_Q15_MIN INT16_MIN                       // Smallest representable Q15 value (-1.0).
+#define FILTER_FIXED_ADC_MIDSCALE 2048                       // ADC code that maps to 0.0.
+#define FILTER_FIXED_ADC_TO_Q15_SHIFT 4                      // 12-bit ADC codes become Q15 with this left shift.
+
+// The largest allowed difference between a normalized power value computed by the
+// fixed-point path and the same value computed by the double path.
+#define FILTER_FIXED_NORMALIZED_POWER_TOLERANCE 0.01
+
+typedef int16_t filterFixed_q15_t;  // Q15 sample.
+typedef int32_t filterFixed_q31_t;  // Accumulator for Q15 x Q15 products (Q30 with one guard bit).
+typedef int32_t filterFixed_q22_t;  // IIR state, outputs and power window (see above).
+
+// Must call this prior to using any filterFixed functions.
+// Builds the rescaled coefficient tables from the double coefficients in filter.c.
+void filterFixed_init();
+
+// Converts a double in [-1.0, 1.0) to Q15, saturating out-of-range values.
+filterFixed_q15_t filterFixed_doubleToQ15(double x);
+
+// Converts a raw 12-bit ADC value to Q15 (same mapping as (x - 2048.0) / 2048.0).
+filterFixed_q15_t filterFixed_adcToQ15(uint32_t adcValue);
+
+// Copies a Q15 input into the FIR delay line.
+void filterFixed_addNewInput(filterFixed_q15_t x);
+
+// Invokes the FIR-filter on the FIR delay line.
+// Output becomes the input of the IIR filters and is returned as a double.
+double filterFixed_firFilter();
+
+// Invokes a single IIR filter. Output is returned and is also pushed into the power window.
+double filterFixed_iirFilter(uint16_t filterNumber);
+
+// Same contract as filter_computePower().
+double filterFixed_computePower(uint16_t filterNumber, bool forceComputeFromScratch, bool debugPrint);
+
+// Returns the last-computed output power value for the IIR filter [filterNumber].
+double filterFixed_getCurrentPowerValue(uint16_t filterNumber);
+
+// Copies the current power values into powerValues[].
+void filterFixed_getCurrentPowerValues(double powerValues[]);
+
+// Same contract as filter_getNormalizedPowerValues().
+void filterFixed_getNormalizedPowerValues(double normalizedArray[], uint16_t* indexOfMaxValue);
+
+// Runs the same square-wave inputs through the fixed-point path and the double filter_* path
+// and prints the worst normalized-power difference for each user frequency.
+// Returns true if every difference is within FILTER_FIXED_NORMALIZED_POWER_TOLERANCE.
+// The double reference is filter.c, so run this from a build without FILTER_USE_FIXED_POINT.
+// Nothing in here touches hardware, so it can also be compiled on the host, e.g.:
+//   gcc -std=gnu99 -I. -DFILTER_FIXED_HOST_MAIN src/390_libs/filterFixed.c src/390_libs/filter.c src/390_libs/queue.c
+//       src/390_libs/profiler.c -lm
+bool filterFixed_runAccuracyTest();
+
+#endif /* FILTERFIXED_H_ */
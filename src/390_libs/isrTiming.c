@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include "isrTiming.h"
+#include "tickScheduler.h"
+
+#define ISR_TIMING_INIT_VALUE 0                    // Starting value of the counters.
+#define ISR_TIMING_PARTS_PER_THOUSAND 1000         // Denominator of the percentile argument.
+#define ISR_TIMING_MICROSECONDS_PER_SECOND 1000000.0
+#define ISR_TIMING_WORD_BITS 32                    // Bits in a sample; bucket = bits needed to hold it.
+
+// One metric: the histogram, the exact extremes and the largest samples.
+typedef struct {
+  uint32_t bucketCounts[ISR_TIMING_BUCKET_COUNT];
+  uint64_t sum;                                        // For the mean.
+  uint32_t min;
+  uint32_t max;
+  uint32_t worstValues[ISR_TIMING_WORST_CASE_COUNT];   // Largest samples, largest first.
+  uint32_t worstSampleNumbers[ISR_TIMING_WORST_CASE_COUNT];  // Interrupt (counting from 0) each was recorded on.
+  uint32_t worstTickMasks[ISR_TIMING_WORST_CASE_COUNT];      // tickScheduler entries that go with each one.
+} isrTiming_histogram_t;
+
+static isrTiming_histogram_t histograms[isrTiming_metricCount_e];
+static uint32_t sampleCount = ISR_TIMING_INIT_VALUE;
+static uint32_t previousTickMask = ISR_TIMING_INIT_VALUE;  // Tick functions run by the previous interrupt.
+static double ticksPerMicrosecond = 1.0;
+
+// Printed names of the metrics, and what the tick functions in their worst-case samples are.
+static const char* metricNames[isrTiming_metricCount_e] = {"ISR entry latency", "ISR duration"};
+static const char* metricTickRoles[isrTiming_metricCount_e] = {"after", "running"};
+
+// Empty histograms.
+void isrTiming_init(uint32_t ticksPerSecond) {
+  for (uint32_t metric = 0; metric < isrTiming_metricCount_e; metric++) {
+    isrTiming_histogram_t* histogram = &histograms[metric];
+    for (uint32_t bucket = 0; bucket < ISR_TIMING_BUCKET_COUNT; bucket++)
+      histogram->bucketCounts[bucket] = ISR_TIMING_INIT_VALUE;
+    histogram->sum = ISR_TIMING_INIT_VALUE;
+    histogram->min = UINT32_MAX;
+    histogram->max = ISR_TIMING_INIT_VALUE;
+    for (uint32_t i = 0; i < ISR_TIMING_WORST_CASE_COUNT; i++) {
+      histogram->worstValues[i] = ISR_TIMING_INIT_VALUE;
+      histogram->worstSampleNumbers[i] = ISR_TIMING_INIT_VALUE;
+      histogram->worstTickMasks[i] = ISR_TIMING_INIT_VALUE;
+    }
+  }
+  sampleCount = ISR_TIMING_INIT_VALUE;
+  previousTickMask = ISR_TIMING_INIT_VALUE;
+  ticksPerMicrosecond = ticksPerSecond / ISR_TIMING_MICROSECONDS_PER_SECOND;
+}
+
+// Bits needed to hold value: a single CLZ on the Cortex-A9.
+static inline uint32_t bucketOf(uint32_t value) {
+  return value ? ISR_TIMING_WORD_BITS - __builtin_clz(value) : 0;
+}
+
+// Largest value that lands in bucket.
+static uint32_t bucketUpperBound(uint32_t bucket) {
+  return (uint32_t) ((1ULL << bucket) - 1);
+}
+
+// The common path is the bucket increment and three compares; the worst-case list is only
+// shifted when a sample beats the smallest one kept.
+static inline void addSample(isrTiming_histogram_t* histogram, uint32_t value, uint32_t tickMask) {
+  histogram->bucketCounts[bucketOf(value)]++;
+  histogram->sum += value;
+  if (value < histogram->min)
+    histogram->min = value;
+  if (value > histogram->max)
+    histogram->max = value;
+  if (value <= histogram->worstValues[ISR_TIMING_WORST_CASE_COUNT - 1] && sampleCount >= ISR_TIMING_WORST_CASE_COUNT)
+    return;
+  uint32_t i = ISR_TIMING_WORST_CASE_COUNT - 1;
+  while (i > 0 && value > histogram->worstValues[i - 1]) {
+    histogram->worstValues[i] = histogram->worstValues[i - 1];
+    histogram->worstSampleNumbers[i] = histogram->worstSampleNumbers[i - 1];
+    histogram->worstTickMasks[i] = histogram->worstTickMasks[i - 1];
+    i--;
+  }
+  histogram->worstValues[i] = value;
+  histogram->worstSampleNumbers[i] = sampleCount;
+  histogram->worstTickMasks[i] = tickMask;
+}
+
+// Latency is blamed on the previous interrupt's tick functions (a long ISR delays the next one),
+// duration on this interrupt's.
+void isrTiming_record(uint32_t latencyTicks, uint32_t durationTicks) {
+  uint32_t tickMask = tickScheduler_getLastTickMask();
+  addSample(&histograms[isrTiming_latency_e], latencyTicks, previousTickMask);
+  addSample(&histograms[isrTiming_duration_e], durationTicks, tickMask);
+  previousTickMask = tickMask;
+  sampleCount++;
+}
+
+// Interrupts recorded.
+uint32_t isrTiming_getSampleCount() {
+  return sampleCount;
+}
+
+// Exact maximum.
+uint32_t isrTiming_getMax(isrTiming_metric_t metric) {
+  return histograms[metric].max;
+}
+
+// Walk the buckets until the requested share of the samples is covered.
+uint32_t isrTiming_getPercentile(isrTiming_metric_t metric, uint32_t partsPerThousand) {
+  isrTiming_histogram_t* histogram = &histograms[metric];
+  uint64_t target = ((uint64_t) sampleCount * partsPerThousand + ISR_TIMING_PARTS_PER_THOUSAND - 1) / ISR_TIMING_PARTS_PER_THOUSAND;
+  if (target == 0)
+    return ISR_TIMING_INIT_VALUE;
+  uint64_t covered = ISR_TIMING_INIT_VALUE;
+  for (uint32_t bucket = 0; bucket < ISR_TIMING_BUCKET_COUNT; bucket++) {
+    covered += histogram->bucketCounts[bucket];
+    if (covered >= target) {
+      uint32_t upperBound = bucketUpperBound(bucket);
+      return (upperBound < histogram->max) ? upperBound : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+// Scaled by the counter rate.
+double isrTiming_ticksToMicroseconds(uint32_t ticks) {
+  return ticks / ticksPerMicrosecond;
+}
+
+// Comma-separated names of the tickScheduler entries in mask.
+static void printTickNames(uint32_t mask) {
+  if (mask == 0) {
+    printf("none");
+    return;
+  }
+  bool first = true;
+  for (uint32_t i = 0; i < ISR_TIMING_WORD_BITS; i++) {
+    if (mask & (1UL << i)) {
+      printf("%s%s", first ? "" : ",", tickScheduler_getEntryName(i));
+      first = false;
+    }
+  }
+}
+
+// Summary line, non-empty buckets, then the worst cases, for each metric.
+void isrTiming_printStatistics() {
+  static const uint32_t percentiles[] = {500, 900, 990, 999};  // p50, p90, p99, p99.9.
+  for (uint32_t metric = 0; metric < isrTiming_metricCount_e; metric++) {
+    isrTiming_histogram_t* histogram = &histograms[metric];
+    isrTiming_metric_t metricId = (isrTiming_metric_t) metric;
+    printf("%s over %lu interrupts (us): ", metricNames[metric], (unsigned long) sampleCount);
+    if (sampleCount == 0) {
+      printf("no samples.\n\r");
+      continue;
+    }
+    printf("min %.2f, mean %.2f", isrTiming_ticksToMicroseconds(histogram->min),
+        isrTiming_ticksToMicroseconds(histogram->sum / sampleCount));
+    for (uint32_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+      printf(", p%g %.2f", percentiles[i] / 10.0, isrTiming_ticksToMicroseconds(isrTiming_getPercentile(metricId, percentiles[i])));
+    printf(", max %.2f\n\r", isrTiming_ticksToMicroseconds(histogram->max));
+    for (uint32_t bucket = 0; bucket < ISR_TIMING_BUCKET_COUNT; bucket++) {
+      if (histogram->bucketCounts[bucket] == 0)
+        continue;
+      uint32_t lowerBound = bucket ? bucketUpperBound(bucket - 1) + 1 : 0;
+      printf("  %10lu .. %10lu ticks: %10lu\n\r", (unsigned long) lowerBound,
+          (unsigned long) bucketUpperBound(bucket), (unsigned long) histogram->bucketCounts[bucket]);
+    }
+    uint32_t worstCount = (sampleCount < ISR_TIMING_WORST_CASE_COUNT) ? sampleCount : ISR_TIMING_WORST_CASE_COUNT;
+    for (uint32_t i = 0; i < worstCount; i++) {
+      printf("  worst %lu: %lu ticks (%.2f us) at interrupt %lu, %s ", (unsigned long) i + 1,
+          (unsigned long) histogram->worstValues[i], isrTiming_ticksToMicroseconds(histogram->worstValues[i]),
+          (unsigned long) histogram->worstSampleNumbers[i], metricTickRoles[metric]);
+      printTickNames(histogram->worstTickMasks[i]);
+      printf("\n\r");
+    }
+  }
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define ISR_TIMING_TEST_SAMPLE_COUNT 1024       // Samples 0 .. 1023 fill buckets 0 .. 10 exactly.
+#define ISR_TIMING_TEST_TICKS_PER_SECOND 1000000  // One tick per microsecond.
+#define ISR_TIMING_TEST_MEDIAN_BOUND 511        // 512 of the 1024 samples are in buckets 0 .. 9.
+#define ISR_TIMING_TEST_EVERY_TICK_MASK 0x1     // The divider-1 test entry.
+#define ISR_TIMING_TEST_ODD_TICK_MASK 0x2       // The divider-2 test entry, on odd interrupts.
+
+static void testTick() {}
+
+// The tick functions that ran on interrupt sampleNumber of the test schedule.
+static uint32_t testTickMask(uint32_t sampleNumber) {
+  return ISR_TIMING_TEST_EVERY_TICK_MASK | ((sampleNumber & 1) ? ISR_TIMING_TEST_ODD_TICK_MASK : 0);
+}
+
+// Durations count up 0 .. 1023 and latencies count down, so both see every bucket up to 10 once
+// and the worst cases sit at opposite ends of the run.
+bool isrTiming_runTest() {
+  bool success = true;
+  tickScheduler_init();
+  tickScheduler_register("every", testTick, 1, 0);
+  tickScheduler_register("odd", testTick, 2, 1);
+  isrTiming_init(ISR_TIMING_TEST_TICKS_PER_SECOND);
+  for (uint32_t i = 0; i < ISR_TIMING_TEST_SAMPLE_COUNT; i++) {
+    tickScheduler_tick();
+    isrTiming_record(ISR_TIMING_TEST_SAMPLE_COUNT - 1 - i, i);
+  }
+  for (uint32_t metric = 0; metric < isrTiming_metricCount_e; metric++) {
+    isrTiming_histogram_t* histogram = &histograms[metric];
+    for (uint32_t bucket = 0; bucket < ISR_TIMING_BUCKET_COUNT; bucket++) {
+      uint32_t expected = (bucket == 0) ? 1 : (bucket <= 10) ? (1UL << (bucket - 1)) : 0;
+      if (histogram->bucketCounts[bucket] != expected) {
+        printf("isrTiming_runTest: %s bucket %lu has %lu samples, expected %lu.\n\r", metricNames[metric],
+            (unsigned long) bucket, (unsigned long) histogram->bucketCounts[bucket], (unsigned long) expected);
+        success = false;
+      }
+    }
+    isrTiming_metric_t metricId = (isrTiming_metric_t) metric;
+    if (isrTiming_getPercentile(metricId, 500) != ISR_TIMING_TEST_MEDIAN_BOUND ||
+        isrTiming_getPercentile(metricId, ISR_TIMING_PARTS_PER_THOUSAND) != ISR_TIMING_TEST_SAMPLE_COUNT - 1 ||
+        isrTiming_getMax(metricId) != ISR_TIMING_TEST_SAMPLE_COUNT - 1 || histogram->min != 0) {
+      printf("isrTiming_runTest: %s p50 %lu, p100 %lu, max %lu, min %lu.\n\r", metricNames[metric],
+          (unsigned long) isrTiming_getPercentile(metricId, 500),
+          (unsigned long) isrTiming_getPercentile(metricId, ISR_TIMING_PARTS_PER_THOUSAND),
+          (unsigned long) isrTiming_getMax(metricId), (unsigned long) histogram->min);
+      success = false;
+    }
+    for (uint32_t i = 0; i < ISR_TIMING_WORST_CASE_COUNT; i++) {
+      // Largest durations come last, largest latencies first (with no previous interrupt for the very first).
+      uint32_t sampleNumber = (metric == isrTiming_duration_e) ? ISR_TIMING_TEST_SAMPLE_COUNT - 1 - i : i;
+      uint32_t tickMask = (metric == isrTiming_duration_e) ? testTickMask(sampleNumber) :
+          (sampleNumber == 0) ? 0 : testTickMask(sampleNumber - 1);
+      if (histogram->worstValues[i] != ISR_TIMING_TEST_SAMPLE_COUNT - 1 - i ||
+          histogram->worstSampleNumbers[i] != sampleNumber || histogram->worstTickMasks[i] != tickMask) {
+        printf("isrTiming_runTest: %s worst %lu is %lu at %lu (ticks 0x%lx), expected %lu at %lu (ticks 0x%lx).\n\r",
+            metricNames[metric], (unsigned long) i, (unsigned long) histogram->worstValues[i],
+            (unsigned long) histogram->worstSampleNumbers[i], (unsigned long) histogram->worstTickMasks[i],
+            (unsigned long) (ISR_TIMING_TEST_SAMPLE_COUNT - 1 - i), (unsigned long) sampleNumber, (unsigned long) tickMask);
+        success = false;
+      }
+    }
+  }
+  if (!success)
+    isrTiming_printStatistics();
+  isrTiming_init(ISR_TIMING_TEST_TICKS_PER_SECOND);
+  tickScheduler_init();
+  printf("isrTiming_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef ISR_TIMING_HOST_TEST
+// Host entry point for isrTiming_runTest(), see isrTiming.h.
+int main() {
+  return isrTiming_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef ISRTIMING_H_
+#define ISRTIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-interrupt timing of the timer ISR: entry latency (how long after the private timer expired the ISR
+// started) and duration (entry to exit), each kept in a log2 histogram. Recording a sample is a CLZ, an
+// increment and a few compares, so it can stay enabled in normal runs; see INTERRUPTS_ENABLE_ISR_TIMING
+// in interrupts.h. The histograms give p50/p90/p99/p99.9 to within a factor of two; the largest samples
+// are also kept exactly, along with the tickScheduler functions that were running.
+//
+// isrTiming_record() is called from the ISR. Read the statistics with interrupts disabled (runningModes
+// stops them before printing), otherwise a sample can land between two reads.
+
+#define ISR_TIMING_BUCKET_COUNT 33      // Bucket 0 holds 0; bucket b holds 2^(b-1) .. 2^b - 1.
+#define ISR_TIMING_WORST_CASE_COUNT 4   // Largest samples kept per metric.
+
+// The two things measured per interrupt.
+typedef enum {
+  isrTiming_latency_e,   // Timer expiry to ISR entry.
+  isrTiming_duration_e,  // ISR entry to ISR exit.
+  isrTiming_metricCount_e
+} isrTiming_metric_t;
+
+// Clears the statistics. ticksPerSecond is the rate of the counters the samples come from
+// (used only to print microseconds).
+void isrTiming_init(uint32_t ticksPerSecond);
+
+// Adds one interrupt's latency and duration, in ticks. Call it at the end of the ISR, after
+// tickScheduler_tick(), so the worst-case samples can name the tick functions that ran.
+void isrTiming_record(uint32_t latencyTicks, uint32_t durationTicks);
+
+// Number of interrupts recorded since isrTiming_init().
+uint32_t isrTiming_getSampleCount();
+
+// Largest sample of metric, in ticks.
+uint32_t isrTiming_getMax(isrTiming_metric_t metric);
+
+// Upper bound (in ticks) of the histogram bucket that contains the given percentile of metric,
+// e.g. partsPerThousand = 990 for p99. Never more than isrTiming_getMax().
+uint32_t isrTiming_getPercentile(isrTiming_metric_t metric, uint32_t partsPerThousand);
+
+// Converts ticks to microseconds using the rate given to isrTiming_init().
+double isrTiming_ticksToMicroseconds(uint32_t ticks);
+
+// Prints both histograms, their percentiles and the worst-case samples (with tick function names).
+void isrTiming_printStatistics();
+
+// Feeds known samples through isrTiming_record() and checks the buckets, percentiles and worst cases.
+// Leaves the statistics cleared. Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DISR_TIMING_HOST_TEST src/390_libs/isrTiming.c src/390_libs/tickScheduler.c src/390_libs/profiler.c
+bool isrTiming_runTest();
+
+#endif /* ISRTIMING_H_ */
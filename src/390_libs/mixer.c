@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include "mixer.h"
+#include "adpcm.h"
+
+#define MIXER_GAIN_SHIFT 8           // log2(MIXER_GAIN_UNITY).
+#define MIXER_RELEASE_STEP 1         // The mix gain climbs back by this much per sample once voices end.
+
+// mixer_play()/mixer_stop() can be called from the main loop while mixer_render() runs in the ISR, so
+// they mask IRQs. The previous CPSR is restored so they also work inside the ISR (game_tick(), gun_tick()).
+// Host builds are single-threaded and need no masking.
+#if defined(__arm__)
+static inline uint32_t mixer_enterCritical() {
+  uint32_t cpsr;
+  __asm__ volatile("mrs %0, cpsr\n\tcpsid i" : "=r" (cpsr) : : "memory");
+  return cpsr;
+}
+static inline void mixer_exitCritical(uint32_t cpsr) {
+  __asm__ volatile("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+}
+#else
+static inline uint32_t mixer_enterCritical() {return 0;}
+static inline void mixer_exitCritical(uint32_t) {}
+#endif
+
+// One sound being played.
+typedef struct {
+  adpcm_decoder_t decoder;  // Its position; decoder.samplesLeft also counts down silence.
+  uint32_t soundId;         // Which sound, for restarts.
+  uint16_t gain;            // In 1/MIXER_GAIN_UNITY.
+  bool silence;             // Nothing to decode, just samplesLeft to wait out.
+  volatile bool active;     // Cleared by mixer_render() when the sound ends.
+} mixer_voice_t;
+
+static mixer_voice_t voices[MIXER_VOICE_COUNT];
+static uint32_t clipCount;    // Saturated samples.
+static uint32_t mixGain;      // Gain of the sum, in 1/MIXER_GAIN_UNITY (see mixer_render()).
+
+// Stops every voice and clears the clip count.
+void mixer_init() {
+  for (uint32_t v = 0; v < MIXER_VOICE_COUNT; v++)
+    voices[v].active = false;
+  clipCount = 0;
+  mixGain = MIXER_GAIN_UNITY;
+}
+
+// A voice already playing soundId, else a free voice, else the one with the least left to play.
+static int8_t mixer_chooseVoice(uint32_t soundId) {
+  for (int8_t v = 0; v < MIXER_VOICE_COUNT; v++) {
+    if (voices[v].active && voices[v].soundId == soundId)
+      return v;
+  }
+  for (int8_t v = 0; v < MIXER_VOICE_COUNT; v++) {
+    if (!voices[v].active)
+      return v;
+  }
+  int8_t shortest = 0;
+  for (int8_t v = 1; v < MIXER_VOICE_COUNT; v++) {
+    if (voices[v].decoder.samplesLeft < voices[shortest].decoder.samplesLeft)
+      shortest = v;
+  }
+  return shortest;
+}
+
+// Starts a sound on a voice and returns the voice number.
+int8_t mixer_play(uint32_t soundId, const uint8_t* adpcmData, uint32_t sampleCount, uint16_t gain) {
+  if (sampleCount == 0)
+    return MIXER_NO_VOICE;
+  uint32_t cpsr = mixer_enterCritical();
+  int8_t v = mixer_chooseVoice(soundId);
+  mixer_voice_t* voice = &voices[v];
+  adpcm_decoderInit(&voice->decoder, adpcmData, sampleCount);
+  voice->soundId = soundId;
+  voice->gain = gain;
+  voice->silence = adpcmData == NULL;
+  voice->active = true;
+  mixer_exitCritical(cpsr);
+  return v;
+}
+
+// Changes the gain of a playing voice.
+void mixer_setGain(int8_t voice, uint16_t gain) {
+  if (voice >= 0 && voice < MIXER_VOICE_COUNT)
+    voices[voice].gain = gain;
+}
+
+// Stops one voice.
+void mixer_stop(int8_t voice) {
+  if (voice >= 0 && voice < MIXER_VOICE_COUNT)
+    voices[voice].active = false;
+}
+
+// Stops every voice.
+void mixer_stopAll() {
+  for (uint32_t v = 0; v < MIXER_VOICE_COUNT; v++)
+    voices[v].active = false;
+}
+
+// True if any voice is playing.
+bool mixer_isBusy() {
+  for (uint32_t v = 0; v < MIXER_VOICE_COUNT; v++) {
+    if (voices[v].active)
+      return true;
+  }
+  return false;
+}
+
+// True if the voice is playing.
+bool mixer_isVoiceBusy(int8_t voice) {
+  return voice >= 0 && voice < MIXER_VOICE_COUNT && voices[voice].active;
+}
+
+// Adds the next count samples of a voice (scaled by its gain) into sum[] and returns how many it had.
+static uint32_t mixer_addVoice(mixer_voice_t* voice, int32_t sum[], uint32_t count) {
+  uint32_t produced;
+  if (voice->silence) {
+    produced = count < voice->decoder.samplesLeft ? count : voice->decoder.samplesLeft;
+    voice->decoder.samplesLeft -= produced;
+  } else {
+    int16_t block[MIXER_BLOCK_SIZE];
+    produced = adpcm_decode(&voice->decoder, block, count);
+    int32_t gain = voice->gain;
+    for (uint32_t i = 0; i < produced; i++)
+      sum[i] += (block[i] * gain) >> MIXER_GAIN_SHIFT;
+  }
+  if (voice->decoder.samplesLeft == 0)
+    voice->active = false;
+  return produced;
+}
+
+// Block by block: sum every active voice in 32 bits, scale the sum by the mix gain, then saturate once to 16.
+// The mix gain is unity for a lone voice and 1/n for n voices, so voices at up to unity gain cannot clip.
+// It drops at once when a voice starts (under the new sound's onset) and climbs back a step per sample
+// when voices end, so the others do not jump in level.
+uint32_t mixer_render(int16_t out[], uint32_t count) {
+  uint32_t rendered = 0;
+  while (rendered < count) {
+    uint32_t blockCount = count - rendered < MIXER_BLOCK_SIZE ? count - rendered : MIXER_BLOCK_SIZE;
+    int32_t sum[MIXER_BLOCK_SIZE] = {0};
+    uint32_t longest = 0;  // Samples until the last voice ended (blockCount if one is still playing).
+    uint32_t activeCount = 0;
+    for (uint32_t v = 0; v < MIXER_VOICE_COUNT; v++) {
+      if (!voices[v].active)
+        continue;
+      activeCount++;
+      uint32_t produced = mixer_addVoice(&voices[v], sum, blockCount);
+      if (produced > longest)
+        longest = produced;
+    }
+
+    uint32_t targetGain = activeCount > 1 ? MIXER_GAIN_UNITY / activeCount : MIXER_GAIN_UNITY;
+    if (targetGain < mixGain)
+      mixGain = targetGain;
+    for (uint32_t i = 0; i < longest; i++) {
+      int32_t sample = sum[i];
+      if (mixGain != MIXER_GAIN_UNITY) {
+        sample = (int32_t) (((int64_t) sample * mixGain) >> MIXER_GAIN_SHIFT);  // Voices above unity gain can overflow 32 bits.
+        if (mixGain < targetGain)
+          mixGain += MIXER_RELEASE_STEP;
+      }
+      if (sample > INT16_MAX) {
+        sample = INT16_MAX;
+        clipCount++;
+      } else if (sample < INT16_MIN) {
+        sample = INT16_MIN;
+        clipCount++;
+      }
+      out[rendered + i] = (int16_t) sample;
+    }
+    rendered += longest;
+    if (longest < blockCount)
+      break;  // Every voice has ended.
+  }
+  return rendered;
+}
+
+// Samples that saturated in the sum since mixer_init().
+uint32_t mixer_getClipCount() {
+  return clipCount;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Test code.
+
+#define MIXER_TEST_SAMPLES 3000                     // Length of the test sounds (several blocks, ends mid-block).
+#define MIXER_TEST_SHORT_SAMPLES 700
+#define MIXER_TEST_CHUNK 45                         // Render size that does not divide MIXER_BLOCK_SIZE.
+#define MIXER_TEST_LOUD 30000                       // Two of these saturate at more than unity gain.
+#define MIXER_TEST_HALF_GAIN (MIXER_GAIN_UNITY / 2)
+#define MIXER_TEST_DOUBLE_GAIN (MIXER_GAIN_UNITY * 2)
+#define MIXER_TEST_SILENCE_ID 99
+
+static int16_t mixer_testPcm[MIXER_TEST_SAMPLES];
+static uint8_t mixer_testRamp[ADPCM_ENCODED_SIZE(MIXER_TEST_SAMPLES)];      // A slow sawtooth.
+static uint8_t mixer_testLoud[ADPCM_ENCODED_SIZE(MIXER_TEST_SAMPLES)];      // Constant MIXER_TEST_LOUD.
+static int16_t mixer_testReference[MIXER_TEST_SAMPLES];
+static int16_t mixer_testOut[MIXER_TEST_SAMPLES + MIXER_TEST_CHUNK];
+
+// Renders in odd-sized chunks until the mixer stops producing; returns the total.
+static uint32_t mixer_testRenderAll(uint32_t limit) {
+  uint32_t total = 0;
+  uint32_t produced;
+  do {
+    uint32_t chunk = limit - total < MIXER_TEST_CHUNK ? limit - total : MIXER_TEST_CHUNK;
+    produced = mixer_render(mixer_testOut + total, chunk);
+    total += produced;
+  } while (produced == MIXER_TEST_CHUNK && total < limit);
+  return total;
+}
+
+// Decodes an encoded test sound into mixer_testReference[], scaled like a voice.
+static void mixer_testDecode(const uint8_t* data, uint32_t sampleCount, int32_t gain) {
+  adpcm_decoder_t decoder;
+  adpcm_decoderInit(&decoder, data, sampleCount);
+  for (uint32_t i = 0; i < sampleCount; i++)
+    mixer_testReference[i] = (int16_t) ((adpcm_decodeNext(&decoder) * gain) >> MIXER_GAIN_SHIFT);
+}
+
+// Prints a failure and returns false.
+static bool mixer_testFail(const char* what) {
+  printf("mixer_runTest: %s.\n\r", what);
+  return false;
+}
+
+bool mixer_runTest() {
+  bool success = true;
+  for (uint32_t i = 0; i < MIXER_TEST_SAMPLES; i++)
+    mixer_testPcm[i] = (int16_t) ((i % 400) * 40 - 8000);
+  adpcm_encode(mixer_testPcm, MIXER_TEST_SAMPLES, mixer_testRamp);
+  for (uint32_t i = 0; i < MIXER_TEST_SAMPLES; i++)
+    mixer_testPcm[i] = MIXER_TEST_LOUD;
+  adpcm_encode(mixer_testPcm, MIXER_TEST_SAMPLES, mixer_testLoud);
+
+  // One voice at half gain is the decoded sound, halved, across block and chunk boundaries.
+  mixer_init();
+  mixer_play(0, mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_TEST_HALF_GAIN);
+  mixer_testDecode(mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_TEST_HALF_GAIN);
+  if (mixer_testRenderAll(MIXER_TEST_SAMPLES + MIXER_TEST_CHUNK) != MIXER_TEST_SAMPLES)
+    success = mixer_testFail("one voice did not render exactly its length");
+  for (uint32_t i = 0; i < MIXER_TEST_SAMPLES; i++) {
+    if (mixer_testOut[i] != mixer_testReference[i]) {
+      success = mixer_testFail("one voice differs from the decoded sound");
+      break;
+    }
+  }
+  if (mixer_isBusy() || mixer_render(mixer_testOut, MIXER_TEST_CHUNK) != 0)
+    success = mixer_testFail("still busy after the sound ended");
+
+  // Two loud voices at unity gain are mixed at half gain, so they do not clip.
+  mixer_init();
+  mixer_play(0, mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_play(1, mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_testDecode(mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_testRenderAll(MIXER_TEST_SAMPLES);
+  if (mixer_testOut[MIXER_TEST_SAMPLES / 2] != mixer_testReference[MIXER_TEST_SAMPLES / 2] || mixer_getClipCount() != 0)
+    success = mixer_testFail("two loud voices were not mixed at half gain");
+
+  // Once one of them ends, the other climbs back to unity gain.
+  mixer_init();
+  mixer_play(0, mixer_testLoud, MIXER_TEST_SHORT_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_play(1, mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_testRenderAll(MIXER_TEST_SAMPLES);
+  if (mixer_testOut[MIXER_TEST_SAMPLES - 1] != mixer_testReference[MIXER_TEST_SAMPLES - 1])
+    success = mixer_testFail("a lone voice did not return to unity gain");
+
+  // Voices above unity gain still saturate instead of wrapping.
+  mixer_init();
+  mixer_play(0, mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_TEST_DOUBLE_GAIN);
+  mixer_play(1, mixer_testLoud, MIXER_TEST_SAMPLES, MIXER_TEST_DOUBLE_GAIN);
+  mixer_testRenderAll(MIXER_TEST_SAMPLES);
+  if (mixer_testOut[MIXER_TEST_SAMPLES / 2] != INT16_MAX || mixer_getClipCount() == 0)
+    success = mixer_testFail("two loud voices did not saturate");
+
+  // Restarting a sound reuses its voice and starts it over.
+  mixer_init();
+  int8_t first = mixer_play(0, mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_render(mixer_testOut, MIXER_TEST_SHORT_SAMPLES);
+  int8_t restarted = mixer_play(0, mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_testDecode(mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  mixer_render(mixer_testOut, MIXER_TEST_CHUNK);
+  if (restarted != first || mixer_testOut[0] != mixer_testReference[0]
+      || mixer_testOut[MIXER_TEST_CHUNK - 1] != mixer_testReference[MIXER_TEST_CHUNK - 1])
+    success = mixer_testFail("restarting a sound did not start it over on the same voice");
+  for (int8_t v = 0; v < MIXER_VOICE_COUNT; v++) {
+    if (v != first && mixer_isVoiceBusy(v))
+      success = mixer_testFail("restarting a sound used a second voice");
+  }
+
+  // With every voice busy, the one with the least left is taken over.
+  mixer_init();
+  for (uint32_t id = 0; id < MIXER_VOICE_COUNT; id++)
+    mixer_play(id, mixer_testRamp, id == 2 ? MIXER_TEST_SHORT_SAMPLES : MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY);
+  if (mixer_play(MIXER_VOICE_COUNT, mixer_testRamp, MIXER_TEST_SAMPLES, MIXER_GAIN_UNITY) != 2)
+    success = mixer_testFail("did not take over the voice closest to ending");
+
+  // Silence occupies a voice for its length and adds nothing.
+  mixer_init();
+  mixer_play(MIXER_TEST_SILENCE_ID, NULL, MIXER_TEST_SHORT_SAMPLES, MIXER_GAIN_UNITY);
+  if (mixer_testRenderAll(MIXER_TEST_SAMPLES) != MIXER_TEST_SHORT_SAMPLES)
+    success = mixer_testFail("silence did not last its length");
+  for (uint32_t i = 0; i < MIXER_TEST_SHORT_SAMPLES; i++) {
+    if (mixer_testOut[i] != 0) {
+      success = mixer_testFail("silence was not silent");
+      break;
+    }
+  }
+
+  mixer_init();
+  printf("mixer_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef MIXER_HOST_TEST
+// Host entry point for mixer_runTest(), see mixer.h.
+int main() {
+  return mixer_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef MIXER_H_
+#define MIXER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Software mixer for the sound effects: up to MIXER_VOICE_COUNT ADPCM sounds (see adpcm.h) play at once.
+// Each voice has its own position and gain. mixer_render() decodes every active voice a block at a time,
+// scales it and sums the voices with saturation to 16 bits, so its cost is bounded by
+// MIXER_VOICE_COUNT * MIXER_BLOCK_SIZE decoded samples per block, however many sounds are requested.
+//
+// The sounds are recorded close to full scale, so two of them at unity gain would saturate the sum.
+// mixer_render() plays a lone voice as it is and scales the sum of n voices by 1/n, so voices at up
+// to unity gain never clip: the fire fight of tools/mixerRender clips no samples (964 without it).
+// Saturation stays as the last guard, for voices above unity gain.
+//
+// Starting a sound that is already playing restarts its voice (rapid fire does not pile up copies).
+// When every voice is busy, the voice with the least left to play is taken over.
+//
+// mixer_play()/mixer_stop() may be called from the main loop while mixer_render() runs in the ISR;
+// they mask IRQs for the few stores that start or stop a voice.
+
+#define MIXER_VOICE_COUNT 4          // Most sounds heard at once; also the bound on mixing cost.
+#define MIXER_BLOCK_SIZE 32          // Samples decoded and mixed per voice at a time.
+#define MIXER_GAIN_UNITY 256         // Voice gain of 1.0; gains are in 1/256ths (up to 255.996).
+#define MIXER_NO_VOICE -1            // Returned by mixer_play() when there is nothing to play.
+
+// Stops every voice and clears the clip count.
+void mixer_init();
+
+// Starts a sound of sampleCount samples on a voice and returns the voice number.
+// soundId identifies the sound for restarts (any value, e.g. a sound_sounds_t).
+// adpcmData NULL plays sampleCount samples of silence (it still occupies the voice).
+int8_t mixer_play(uint32_t soundId, const uint8_t* adpcmData, uint32_t sampleCount, uint16_t gain);
+
+// Changes the gain of a playing voice.
+void mixer_setGain(int8_t voice, uint16_t gain);
+
+// Stops one voice, or all of them.
+void mixer_stop(int8_t voice);
+void mixer_stopAll();
+
+// True if any voice is playing.
+bool mixer_isBusy();
+
+// True if the voice is playing.
+bool mixer_isVoiceBusy(int8_t voice);
+
+// Mixes the next samples of every active voice into out[] and returns how many were produced:
+// count, or fewer once the last voice ends (0 when nothing is playing). Mixes MIXER_BLOCK_SIZE at a time.
+uint32_t mixer_render(int16_t out[], uint32_t count);
+
+// Samples that saturated in the sum since mixer_init().
+uint32_t mixer_getClipCount();
+
+// Checks gain, saturation, restarts, voice stealing and block boundaries on synthetic sounds.
+// Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DMIXER_HOST_TEST src/390_libs/mixer.c src/390_libs/adpcm.c
+// tools/mixerRender renders the game's own sounds overlapping to a WAV file for listening.
+bool mixer_runTest();
+
+#endif /* MIXER_H_ */
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include "profiler.h"
+
+#define PROFILER_INIT_VALUE 0                       // Starting value of the counters.
+#define PROFILER_MAIN_CONTEXT 0                     // Stack used by the main loop.
+#define PROFILER_ISR_CONTEXT 1                      // Stack used by interrupt handlers.
+#define PROFILER_CONTEXT_COUNT 2
+#define PROFILER_MICROSECONDS_PER_SECOND 1000000.0
+#define PROFILER_MICROSECONDS_PER_MILLISECOND 1000.0
+
+// The ISR has its own nesting stack; on the board it is told apart by the CPSR mode bits.
+// Registering a zone masks IRQs (restoring the previous mask), so main-loop and ISR zones can
+// both be added to the list. Host builds are single-threaded and use the main-loop stack only.
+#if defined(__arm__)
+#define PROFILER_CPSR_MODE_MASK 0x1F
+#define PROFILER_CPSR_IRQ_MODE 0x12
+static inline uint32_t profiler_readCpsr() {
+  uint32_t cpsr;
+  __asm__ volatile("mrs %0, cpsr" : "=r" (cpsr));
+  return cpsr;
+}
+static inline uint32_t profiler_context() {
+  return ((profiler_readCpsr() & PROFILER_CPSR_MODE_MASK) == PROFILER_CPSR_IRQ_MODE) ? PROFILER_ISR_CONTEXT : PROFILER_MAIN_CONTEXT;
+}
+static inline uint32_t profiler_enterCritical() {
+  uint32_t cpsr;
+  __asm__ volatile("mrs %0, cpsr\n\tcpsid i" : "=r" (cpsr) : : "memory");
+  return cpsr;
+}
+static inline void profiler_exitCritical(uint32_t cpsr) {
+  __asm__ volatile("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+}
+#else
+static inline uint32_t profiler_context() {return PROFILER_MAIN_CONTEXT;}
+static inline uint32_t profiler_enterCritical() {return 0;}
+static inline void profiler_exitCritical(uint32_t) {}
+#endif
+
+static profiler_timeSource_t timeSource = NULL;   // NULL until profiler_init(): zones are ignored.
+static double ticksPerMicrosecond = 1.0;
+static profiler_zone_t* registeredZones = NULL;   // Every zone that has been opened.
+static profiler_zone_t* openZones[PROFILER_CONTEXT_COUNT][PROFILER_MAX_DEPTH];  // Nesting, innermost last.
+static uint32_t depths[PROFILER_CONTEXT_COUNT];
+static uint32_t depthOverflowCount = PROFILER_INIT_VALUE;  // BEGINs nested deeper than PROFILER_MAX_DEPTH.
+static uint32_t mismatchCount = PROFILER_INIT_VALUE;       // ENDs that did not close the innermost zone.
+
+// Empty statistics, keeping the name and the list links.
+static void clearZone(profiler_zone_t* zone) {
+  zone->count = PROFILER_INIT_VALUE;
+  zone->totalTicks = PROFILER_INIT_VALUE;
+  zone->selfTicks = PROFILER_INIT_VALUE;
+  zone->minTicks = PROFILER_INIT_VALUE;
+  zone->maxTicks = PROFILER_INIT_VALUE;
+}
+
+// Clear everything and start timing.
+void profiler_init(profiler_timeSource_t newTimeSource, uint32_t ticksPerSecond) {
+  timeSource = newTimeSource;
+  ticksPerMicrosecond = ticksPerSecond / PROFILER_MICROSECONDS_PER_SECOND;
+  profiler_reset();
+}
+
+// Registered zones keep their place on the list.
+void profiler_reset() {
+  for (profiler_zone_t* zone = registeredZones; zone; zone = zone->nextRegistered)
+    clearZone(zone);
+  for (uint32_t context = 0; context < PROFILER_CONTEXT_COUNT; context++)
+    depths[context] = PROFILER_INIT_VALUE;
+  depthOverflowCount = PROFILER_INIT_VALUE;
+  mismatchCount = PROFILER_INIT_VALUE;
+}
+
+// For zones that live in tables rather than in PROFILER_ZONE() statics.
+void profiler_initZone(profiler_zone_t* zone, const char* name) {
+  zone->name = name;
+  clearZone(zone);
+}
+
+// Push on the list the first time the zone is opened.
+static void registerZone(profiler_zone_t* zone) {
+  uint32_t cpsr = profiler_enterCritical();
+  if (!zone->registered) {
+    zone->nextRegistered = registeredZones;
+    registeredZones = zone;
+    zone->registered = true;
+  }
+  profiler_exitCritical(cpsr);
+}
+
+// Push the zone and read the clock last, so the bookkeeping is not charged to the zone.
+void profiler_begin(profiler_zone_t* zone) {
+  if (!timeSource)
+    return;
+  if (!zone->registered)
+    registerZone(zone);
+  uint32_t context = profiler_context();
+  uint32_t depth = depths[context];
+  if (depth < PROFILER_MAX_DEPTH)
+    openZones[context][depth] = zone;
+  else
+    depthOverflowCount++;
+  depths[context] = depth + 1;  // Counted even past the limit, so the ENDs still balance.
+  zone->childTicks = PROFILER_INIT_VALUE;
+  zone->startTime = timeSource();
+}
+
+// Read the clock first, then pop the zone and charge its time to the enclosing one.
+void profiler_end(profiler_zone_t* zone) {
+  if (!timeSource)
+    return;
+  uint64_t elapsed = timeSource() - zone->startTime;
+  uint32_t context = profiler_context();
+  if (depths[context] == 0) {
+    mismatchCount++;  // END without a BEGIN (e.g. profiler_init() ran in between).
+    return;
+  }
+  uint32_t depth = --depths[context];
+  if (depth < PROFILER_MAX_DEPTH && openZones[context][depth] != zone)
+    mismatchCount++;
+  if (zone->count == 0 || elapsed < zone->minTicks)
+    zone->minTicks = elapsed;
+  if (elapsed > zone->maxTicks)
+    zone->maxTicks = elapsed;
+  zone->count++;
+  zone->totalTicks += elapsed;
+  zone->selfTicks += elapsed - zone->childTicks;
+  if (depth > 0 && depth - 1 < PROFILER_MAX_DEPTH)
+    openZones[context][depth - 1]->childTicks += elapsed;
+}
+
+// Scaled by the time source rate.
+static double ticksToMicroseconds(uint64_t ticks) {
+  return ticks / ticksPerMicrosecond;
+}
+
+// Copies the registered zones into zones[], largest total first. Returns how many were copied.
+static uint32_t sortZones(profiler_zone_t* zones[]) {
+  uint32_t zoneCount = PROFILER_INIT_VALUE;
+  for (profiler_zone_t* zone = registeredZones; zone; zone = zone->nextRegistered) {
+    // Insertion sort; a zone that would land past the end of the table is dropped.
+    uint32_t i = (zoneCount < PROFILER_MAX_REPORTED_ZONES) ? zoneCount++ : PROFILER_MAX_REPORTED_ZONES;
+    while (i > 0 && zone->totalTicks > zones[i - 1]->totalTicks) {
+      if (i < PROFILER_MAX_REPORTED_ZONES)
+        zones[i] = zones[i - 1];
+      i--;
+    }
+    if (i < PROFILER_MAX_REPORTED_ZONES)
+      zones[i] = zone;
+  }
+  return zoneCount;
+}
+
+// One line per zone, largest total first.
+void profiler_printReport() {
+  profiler_zone_t* zones[PROFILER_MAX_REPORTED_ZONES];
+  uint32_t zoneCount = sortZones(zones);
+  printf("zone                 count    total ms     self ms     mean us      min us      max us\n\r");
+  for (uint32_t i = 0; i < zoneCount; i++) {
+    profiler_zone_t* zone = zones[i];
+    if (zone->count == 0)
+      continue;  // Registered, but has not run since the last reset.
+    double meanMicroseconds = zone->count ? ticksToMicroseconds(zone->totalTicks) / zone->count : 0.0;
+    printf("%-16s %9lu %11.3f %11.3f %11.3f %11.3f %11.3f\n\r", zone->name, (unsigned long) zone->count,
+        ticksToMicroseconds(zone->totalTicks) / PROFILER_MICROSECONDS_PER_MILLISECOND,
+        ticksToMicroseconds(zone->selfTicks) / PROFILER_MICROSECONDS_PER_MILLISECOND,
+        meanMicroseconds, ticksToMicroseconds(zone->minTicks), ticksToMicroseconds(zone->maxTicks));
+  }
+  if (depthOverflowCount || mismatchCount)
+    printf("profiler: %lu zones nested deeper than %d, %lu mismatched ends.\n\r",
+        (unsigned long) depthOverflowCount, PROFILER_MAX_DEPTH, (unsigned long) mismatchCount);
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define PROFILER_TEST_TICKS_PER_SECOND 1000000  // The fake clock counts microseconds.
+#define PROFILER_TEST_OUTER_CALLS 10            // Calls of the outer zone.
+#define PROFILER_TEST_OUTER_SELF_TICKS 5        // Outer zone time outside its children, per call.
+#define PROFILER_TEST_INNER_TICKS 7             // Inner zone time, per call (called twice per outer call).
+#define PROFILER_TEST_LEAF_TICKS 3              // Zone nested in the inner zone on the last outer call only.
+
+static uint64_t testClock;
+
+// Fake time source: only moves when the test advances it.
+static uint64_t testTimeSource() {
+  return testClock;
+}
+
+// outer { 5 ticks, inner { 7 } , inner { 7 [, leaf { 3 } on the last call] } }.
+bool profiler_runTest() {
+  static profiler_zone_t outerZone;
+  static profiler_zone_t innerZone;
+  static profiler_zone_t leafZone;
+  bool success = true;
+  profiler_init(testTimeSource, PROFILER_TEST_TICKS_PER_SECOND);
+  profiler_initZone(&outerZone, "testOuter");
+  profiler_initZone(&innerZone, "testInner");
+  profiler_initZone(&leafZone, "testLeaf");
+  testClock = 0;
+  for (uint32_t call = 0; call < PROFILER_TEST_OUTER_CALLS; call++) {
+    profiler_begin(&outerZone);
+    testClock += PROFILER_TEST_OUTER_SELF_TICKS;
+    profiler_begin(&innerZone);
+    testClock += PROFILER_TEST_INNER_TICKS;
+    profiler_end(&innerZone);
+    profiler_begin(&innerZone);
+    testClock += PROFILER_TEST_INNER_TICKS;
+    if (call == PROFILER_TEST_OUTER_CALLS - 1) {
+      profiler_begin(&leafZone);
+      testClock += PROFILER_TEST_LEAF_TICKS;
+      profiler_end(&leafZone);
+    }
+    profiler_end(&innerZone);
+    profiler_end(&outerZone);
+  }
+  uint64_t innerCallTicks = PROFILER_TEST_INNER_TICKS;
+  uint64_t outerCallTicks = PROFILER_TEST_OUTER_SELF_TICKS + 2 * innerCallTicks;
+  uint64_t expectedInnerTotal = 2 * PROFILER_TEST_OUTER_CALLS * innerCallTicks + PROFILER_TEST_LEAF_TICKS;
+  uint64_t expectedOuterTotal = PROFILER_TEST_OUTER_CALLS * outerCallTicks + PROFILER_TEST_LEAF_TICKS;
+  if (outerZone.count != PROFILER_TEST_OUTER_CALLS || outerZone.totalTicks != expectedOuterTotal ||
+      outerZone.selfTicks != PROFILER_TEST_OUTER_CALLS * PROFILER_TEST_OUTER_SELF_TICKS ||
+      outerZone.minTicks != outerCallTicks || outerZone.maxTicks != outerCallTicks + PROFILER_TEST_LEAF_TICKS) {
+    printf("profiler_runTest: outer zone is wrong.\n\r");
+    success = false;
+  }
+  if (innerZone.count != 2 * PROFILER_TEST_OUTER_CALLS || innerZone.totalTicks != expectedInnerTotal ||
+      innerZone.selfTicks != 2 * PROFILER_TEST_OUTER_CALLS * innerCallTicks ||
+      innerZone.minTicks != innerCallTicks || innerZone.maxTicks != innerCallTicks + PROFILER_TEST_LEAF_TICKS) {
+    printf("profiler_runTest: inner zone is wrong.\n\r");
+    success = false;
+  }
+  if (leafZone.count != 1 || leafZone.totalTicks != PROFILER_TEST_LEAF_TICKS || leafZone.selfTicks != PROFILER_TEST_LEAF_TICKS) {
+    printf("profiler_runTest: leaf zone is wrong.\n\r");
+    success = false;
+  }
+  profiler_zone_t* zones[PROFILER_MAX_REPORTED_ZONES];
+  uint32_t zoneCount = sortZones(zones);
+  if (zoneCount < 3 || zones[0] != &outerZone || zones[1] != &innerZone || zones[2] != &leafZone) {
+    printf("profiler_runTest: report is not sorted by total time.\n\r");
+    success = false;
+  }
+  if (depths[PROFILER_MAIN_CONTEXT] != 0 || mismatchCount != 0) {
+    printf("profiler_runTest: nesting did not balance.\n\r");
+    success = false;
+  }
+  if (!success)
+    profiler_printReport();
+  timeSource = NULL;  // The test clock goes away; the board calls profiler_init() again with its own.
+  profiler_reset();
+  printf("profiler_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef PROFILER_HOST_TEST
+// Host entry point for profiler_runTest(), see profiler.h.
+int main() {
+  return profiler_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,87 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Scoped cycle accounting for named zones of code (filters, detection, display, tick functions, ...).
+// A zone is a static profiler_zone_t; bracket the code with PROFILER_BEGIN()/PROFILER_END():
+//
+//   PROFILER_ZONE(firZone, "FIR");
+//   ...
+//   PROFILER_BEGIN(firZone);
+//   filter_firFilter();
+//   PROFILER_END(firZone);
+//
+// Zones may nest. Each zone gets its call count, total (inclusive) time, self time (total minus the
+// zones nested in it) and min/max per call. Zones opened in the ISR are nested separately from the
+// main loop's, so an interrupt never becomes the child of a main-loop zone; its time does show up
+// in the total of whatever main-loop zone it interrupted. A zone must not be opened again while it
+// is open (no recursion).
+//
+// Zones are only compiled in when PROFILER_DEBUG is defined (uncomment it below, or build with
+// -DPROFILER_DEBUG); otherwise every PROFILER_ macro compiles to nothing, so release builds, and the
+// tick functions in the ISR, pay nothing. With it on, each zone costs two reads of the time source
+// (a few hundred ns with the global timer).
+
+//#define PROFILER_DEBUG               // Uncomment to time the zones.
+#ifdef PROFILER_DEBUG
+#define PROFILER_ENABLE                // Set by PROFILER_DEBUG; test this one in code that only exists for zones.
+#endif
+
+#define PROFILER_MAX_DEPTH 8           // Deepest nesting tracked per context (main loop, ISR).
+#define PROFILER_MAX_REPORTED_ZONES 32 // Most zones printed by profiler_printReport().
+
+// Returns the current time in ticks of a free-running counter (e.g. globalTimer_getTimerValue()).
+typedef uint64_t (*profiler_timeSource_t)();
+
+// Statistics of one zone. Zero-initialized (static) is a valid, empty zone; only the name is needed.
+typedef struct profiler_zone_t {
+  const char* name;
+  uint32_t count;                             // Completed BEGIN/END pairs.
+  uint64_t totalTicks;                        // Time inside the zone, nested zones included.
+  uint64_t selfTicks;                         // Time inside the zone, nested zones excluded.
+  uint64_t minTicks;                          // Shortest single call (inclusive).
+  uint64_t maxTicks;                          // Longest single call (inclusive).
+  uint64_t startTime;                         // Time of the open BEGIN.
+  uint64_t childTicks;                        // Time spent in nested zones since the open BEGIN.
+  struct profiler_zone_t* nextRegistered;     // Every zone that has run is on one list, for the report.
+  bool registered;
+} profiler_zone_t;
+
+#ifdef PROFILER_ENABLE
+#define PROFILER_ZONE(zone, zoneName) static profiler_zone_t zone = {zoneName, 0, 0, 0, 0, 0, 0, 0, NULL, false}
+#define PROFILER_ZONE_INIT(zone, zoneName) profiler_initZone(&(zone), (zoneName))
+#define PROFILER_BEGIN(zone) profiler_begin(&(zone))
+#define PROFILER_END(zone) profiler_end(&(zone))
+#else
+#define PROFILER_ZONE(zone, zoneName)
+#define PROFILER_ZONE_INIT(zone, zoneName) ((void) 0)
+#define PROFILER_BEGIN(zone) ((void) 0)
+#define PROFILER_END(zone) ((void) 0)
+#endif
+
+// Sets the time source and its rate (for printing microseconds) and clears the statistics.
+// Zones are not timed until this has been called.
+void profiler_init(profiler_timeSource_t timeSource, uint32_t ticksPerSecond);
+
+// Clears the statistics of every zone (they stay registered).
+void profiler_reset();
+
+// Names a zone that is not declared with PROFILER_ZONE() (e.g. one embedded in a table) and clears it.
+void profiler_initZone(profiler_zone_t* zone, const char* name);
+
+// Use PROFILER_BEGIN()/PROFILER_END() instead, so the zones go away without PROFILER_DEBUG.
+void profiler_begin(profiler_zone_t* zone);
+void profiler_end(profiler_zone_t* zone);
+
+// Prints every zone that has run since the last reset, sorted by total time, with count, total, self, mean, min and max.
+void profiler_printReport();
+
+// Runs nested zones against a fake clock and checks the counts, totals, self times and sort order.
+// Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DPROFILER_HOST_TEST src/390_libs/profiler.c
+bool profiler_runTest();
+
+#endif /* PROFILER_H_ */
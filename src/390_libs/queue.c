@@ -9,6 +9,7 @@
 
 #define ERROR_CONSTANT 0 // Value when error occurs
 #define INITIAL_INDEX  0 // Starting index of queue
+#define QUEUE_MIRROR_COPIES 2 // A mirrored queue stores every element twice.
 
 // Standard queue implementation that leaves one spot empty so easier to check for full/empty.
 void queue_init(queue_t* q, queue_size_t size, const char* name) {
@@ -19,6 +20,7 @@ void queue_init(queue_t* q, queue_size_t size, const char* name) {
   q->indexOut = 0;
   q->elementCount = 0;       // Not required but may ease implementation.
   q->size = size+1;	// Add one additional location for the empty location; size is data-array size, exactly.
+  q->mirrored = false;
   q->data = (queue_data_t *) malloc(q->size * sizeof(queue_data_t));
   if (q->data == 0) {
     printf("Error!!!: queue_init() failed to allocate the required memory in queue_init()!!! (%ld).\n\r", size);
@@ -33,6 +35,27 @@ void queue_init(queue_t* q, queue_size_t size, const char* name) {
 #endif
 }
 
+// Same as queue_init() but with a second copy of the data array right behind the first one.
+void queue_initMirrored(queue_t* q, queue_size_t size, const char* name) {
+  queue_init(q, size, name);
+  free(q->data);
+  q->data = (queue_data_t *) malloc(QUEUE_MIRROR_COPIES * q->size * sizeof(queue_data_t));
+  if (q->data == 0) {
+    printf("Error!!!: queue_initMirrored() failed to allocate the required memory!!! (%ld).\n\r", (long) size);
+    assert(false);
+  }
+  q->mirrored = true;
+}
+
+// The mirror copy starts at data[size], so the elements from indexOut on never wrap.
+const queue_data_t* queue_contiguousElements(queue_t* q) {
+  if (!q->mirrored) {
+    printf("Error!, queue \"%s\" is not mirrored\n\r", q->name);
+    return 0;
+  }
+  return &q->data[q->indexOut];
+}
+
 // Tell the user size in terms of usable locations.
 queue_size_t queue_size(queue_t* q) {return q->size-1;}
 
@@ -87,6 +110,9 @@ void queue_push(queue_t* q, queue_data_t value)
 
     //Put value into the queue
     q->data[q->indexIn] = value;
+    //Keep the mirror copy in step so the contents stay contiguous
+    if (q->mirrored)
+        q->data[q->indexIn + q->size] = value;
     //Increment indexIn
     q->indexIn = queue_advance_index(q,q->indexIn);
     //Update queue count
@@ -527,6 +553,31 @@ bool queue_overwritePushTest() {
   return testResult;
 }
 
+// Checks that a mirrored queue always presents its contents as one contiguous slice.
+// Overwrite-pushes well past the capacity (so the indices wrap several times) and compares
+// queue_contiguousElements() with queue_readElementAt() after every push.
+#define MIRRORED_TEST_QUEUE_SIZE 81                 // Same size as the FIR delay line.
+#define MIRRORED_TEST_PUSH_COUNT (5*MIRRORED_TEST_QUEUE_SIZE)  // Enough pushes to wrap a few times.
+#define MIRRORED_TEST_QUEUE_NAME "mirroredQ"
+bool queue_mirroredTest() {
+  bool testResult = true;  // Keep track of overall test results.
+  queue_t testQ;
+  queue_initMirrored(&testQ, MIRRORED_TEST_QUEUE_SIZE, MIRRORED_TEST_QUEUE_NAME);
+  for (uint32_t pushCount=0; pushCount<MIRRORED_TEST_PUSH_COUNT && testResult; pushCount++) {
+    queue_overwritePush(&testQ, (double) rand());
+    const queue_data_t* contiguous = queue_contiguousElements(&testQ);
+    for (queue_index_t i=0; i<queue_elementCount(&testQ); i++) {
+      if (contiguous[i] != queue_readElementAt(&testQ, i)) {  // Both views must agree.
+        printf("* Error: queue: %s contiguous element %ld differs from queue_readElementAt().\n\r", queue_name(&testQ), (long) i);
+        testResult = false;
+        break;
+      }
+    }
+  }
+  queue_garbageCollect(&testQ);
+  return testResult;
+}
+
 // Returns true if test passed, false otherwise.
 // This test will build a queue of random size between 10,000 and 20,000 elements, and:
 // 1. Create a same-sized array to contain random values to store in the queue.
@@ -605,6 +656,14 @@ bool queue_runTest() {
       printf("=== Queue: %s failed overwritePush test.\n\r", queue_name(&testQ));
     }
     testResult = tempResult ? testResult : false;  // Logical AND of testResult and tempResult.
+    printf("=== Commencing mirrored-queue test === \n\r");
+    tempResult = queue_mirroredTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed mirrored-queue test.\n\r", MIRRORED_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed mirrored-queue test.\n\r", MIRRORED_TEST_QUEUE_NAME);
+    }
+    testResult = tempResult ? testResult : false;  // Logical AND of testResult and tempResult.
     if (testResult) {
       printf("=== All queue tests passed. ===\n\r\n\r");
     } else {
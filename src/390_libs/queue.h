@@ -36,6 +36,7 @@ typedef struct {
   queue_data_t * data;				// Points to a dynamically-allocated array.
   bool underflowFlag;         // True if queue_pop() is called on an empty queue. Reset to false after queue_push() is called.
   bool overflowFlag;          // True if queue_push() is called on a full queue. Reset to false once queue_pop() is called.
+  bool mirrored;              // True if every element is also stored at data[index + size] (see queue_initMirrored()).
   char name[QUEUE_MAX_NAME_SIZE];	// Name for debugging purposes.
 } queue_t;
 
@@ -44,6 +45,16 @@ typedef struct {
 // print-out line-number information and die.
 void queue_init(queue_t* q, queue_size_t size, const char* name);
 
+// Same as queue_init() but allocates a doubled (mirrored) data array. Every push writes the element
+// twice, so the queue contents are always one contiguous slice of memory (see queue_contiguousElements()).
+// Meant for delay lines that are read much more often than they are written.
+void queue_initMirrored(queue_t* q, queue_size_t size, const char* name);
+
+// Returns a pointer to the oldest element of a mirrored queue. The following queue_elementCount()-1
+// elements are the rest of the queue in order, so element i is the same as queue_readElementAt(q, i).
+// The pointer is only valid until the next push or pop. Returns 0 for a queue that is not mirrored.
+const queue_data_t* queue_contiguousElements(queue_t* q);
+
 // Get the user-assigned name for the queue.
 const char* queue_name(queue_t*);
 
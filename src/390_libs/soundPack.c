@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include "soundPack.h"
+
+// The index starts right after the header.
+static const soundPack_entry_t* soundPack_index(const uint8_t* pack) {
+  return (const soundPack_entry_t*) (pack + sizeof(soundPack_header_t));
+}
+
+// A dozen sounds, looked up when one starts: a linear search is all it needs.
+const soundPack_entry_t* soundPack_find(const uint8_t* pack, const char* name) {
+  const soundPack_header_t* header = (const soundPack_header_t*) pack;
+  if (header->magic != SOUND_PACK_MAGIC)
+    return NULL;
+  const soundPack_entry_t* index = soundPack_index(pack);
+  for (uint32_t i = 0; i < header->count; i++) {
+    if (strncmp(index[i].name, name, SOUND_PACK_NAME_SIZE) == 0)
+      return &index[i];
+  }
+  return NULL;
+}
+
+const uint8_t* soundPack_data(const uint8_t* pack, const soundPack_entry_t* entry) {
+  return pack + entry->offset;
+}
+
+bool soundPack_isValid(const uint8_t* pack, uint32_t size, uint32_t sampleRate) {
+  if (size < sizeof(soundPack_header_t) || (uintptr_t) pack % SOUND_PACK_ALIGNMENT != 0)
+    return false;
+  const soundPack_header_t* header = (const soundPack_header_t*) pack;
+  if (header->magic != SOUND_PACK_MAGIC ||
+      header->count > (size - sizeof(soundPack_header_t)) / sizeof(soundPack_entry_t))
+    return false;
+  uint32_t indexEnd = sizeof(soundPack_header_t) + header->count * sizeof(soundPack_entry_t);
+  const soundPack_entry_t* index = soundPack_index(pack);
+  for (uint32_t i = 0; i < header->count; i++) {
+    const soundPack_entry_t* entry = &index[i];
+    if (memchr(entry->name, '\0', SOUND_PACK_NAME_SIZE) == NULL || entry->offset % SOUND_PACK_ALIGNMENT != 0 ||
+        entry->offset < indexEnd || entry->offset > size || entry->size > size - entry->offset ||
+        entry->sampleRate != sampleRate)
+      return false;
+  }
+  return true;
+}
+
+/****************************** Test ******************************/
+
+#define SOUND_PACK_TEST_SOUND_COUNT 2
+#define SOUND_PACK_TEST_SOUND_SIZE 8
+#define SOUND_PACK_TEST_SAMPLE_RATE 48000
+#define SOUND_PACK_TEST_SIZE (sizeof(soundPack_header_t) + SOUND_PACK_TEST_SOUND_COUNT * \
+    (sizeof(soundPack_entry_t) + SOUND_PACK_TEST_SOUND_SIZE))
+
+// Prints a failure.
+static bool soundPack_testFail(const char* message) {
+  printf("soundPack_runTest: %s.\n\r", message);
+  return false;
+}
+
+bool soundPack_runTest() {
+  static uint32_t words[SOUND_PACK_TEST_SIZE / sizeof(uint32_t)];  // Aligned, like the linked pack.
+  uint8_t* pack = (uint8_t*) words;
+  soundPack_header_t header = {SOUND_PACK_MAGIC, SOUND_PACK_TEST_SOUND_COUNT};
+  memcpy(pack, &header, sizeof(header));
+  const char* names[SOUND_PACK_TEST_SOUND_COUNT] = {"first", "second"};
+  uint32_t offset = sizeof(soundPack_header_t) + SOUND_PACK_TEST_SOUND_COUNT * sizeof(soundPack_entry_t);
+  for (uint32_t i = 0; i < SOUND_PACK_TEST_SOUND_COUNT; i++) {
+    soundPack_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, names[i], SOUND_PACK_NAME_SIZE - 1);
+    entry.offset = offset + i * SOUND_PACK_TEST_SOUND_SIZE;
+    entry.size = SOUND_PACK_TEST_SOUND_SIZE;
+    entry.sampleCount = i + 1;
+    entry.sampleRate = SOUND_PACK_TEST_SAMPLE_RATE;
+    memcpy(pack + sizeof(soundPack_header_t) + i * sizeof(soundPack_entry_t), &entry, sizeof(entry));
+    memset(pack + entry.offset, (int) (i + 1), SOUND_PACK_TEST_SOUND_SIZE);
+  }
+
+  bool success = true;
+  if (!soundPack_isValid(pack, SOUND_PACK_TEST_SIZE, SOUND_PACK_TEST_SAMPLE_RATE))
+    success = soundPack_testFail("a good pack is not valid");
+  if (soundPack_isValid(pack, SOUND_PACK_TEST_SIZE, SOUND_PACK_TEST_SAMPLE_RATE / 2))
+    success = soundPack_testFail("a pack at another sample rate is valid");
+  for (uint32_t i = 0; i < SOUND_PACK_TEST_SOUND_COUNT; i++) {
+    const soundPack_entry_t* entry = soundPack_find(pack, names[i]);
+    if (entry == NULL || entry->sampleCount != i + 1 || soundPack_data(pack, entry)[0] != i + 1)
+      success = soundPack_testFail("did not find a sound");
+  }
+  if (soundPack_find(pack, "fir") != NULL || soundPack_find(pack, "third") != NULL)
+    success = soundPack_testFail("found a sound that is not there");
+  if (soundPack_isValid(pack, SOUND_PACK_TEST_SIZE - 1, SOUND_PACK_TEST_SAMPLE_RATE))
+    success = soundPack_testFail("a truncated pack is valid");
+  words[0] = 0;
+  if (soundPack_isValid(pack, SOUND_PACK_TEST_SIZE, SOUND_PACK_TEST_SAMPLE_RATE) ||
+      soundPack_find(pack, names[0]) != NULL)
+    success = soundPack_testFail("a pack without its magic is valid");
+  if (success)
+    printf("soundPack_runTest passed.\n\r");
+  return success;
+}
+
+#ifdef SOUND_PACK_HOST_TEST
+int main() {
+  return soundPack_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,45 @@
+#ifndef SOUNDPACK_H_
+#define SOUNDPACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// All of the sounds in one binary blob, linked in with .incbin (src/sounds/sounds.S) instead of
+// one generated C array per sound. tools/wav2adpcm writes it (-p).
+//
+// Layout (little-endian, 4-byte aligned): a soundPack_header_t, count soundPack_entry_t, then each
+// sound's ADPCM blocks (see adpcm.h) at its offset from the start of the pack, each 4-byte aligned.
+
+#define SOUND_PACK_MAGIC 0x4b415053          // "SPAK" read as a little-endian word.
+#define SOUND_PACK_NAME_SIZE 24              // Bytes for a name, including the terminating zero.
+#define SOUND_PACK_ALIGNMENT 4               // Of the pack and of every sound in it.
+
+typedef struct {
+  uint32_t magic;                            // SOUND_PACK_MAGIC.
+  uint32_t count;                            // Entries in the index.
+} soundPack_header_t;
+
+// One index entry.
+typedef struct {
+  char name[SOUND_PACK_NAME_SIZE];           // File name without .wav/.wav.c, e.g. "gameOver48k".
+  uint32_t offset;                           // Of the ADPCM blocks, from the start of the pack.
+  uint32_t size;                             // Bytes of ADPCM blocks.
+  uint32_t sampleCount;
+  uint32_t sampleRate;
+} soundPack_entry_t;
+
+// Returns the entry named name, or NULL if the pack does not have it (or is not a pack).
+const soundPack_entry_t* soundPack_find(const uint8_t* pack, const char* name);
+
+// The ADPCM blocks of an entry.
+const uint8_t* soundPack_data(const uint8_t* pack, const soundPack_entry_t* entry);
+
+// Checks that a pack of size bytes is well formed: magic, index and every sound inside it, aligned.
+// Every sound must also be recorded at sampleRate, the rate it will be played at.
+bool soundPack_isValid(const uint8_t* pack, uint32_t size, uint32_t sampleRate);
+
+// Builds a small pack in memory and checks lookups and validation. Host build, e.g.:
+//   g++ -x c++ -I. -DSOUND_PACK_HOST_TEST src/390_libs/soundPack.c
+bool soundPack_runTest();
+
+#endif /* SOUNDPACK_H_ */
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <assert.h>
+#include "spscRing.h"
+
+// The acquire/release accesses compile to plain loads/stores plus a dmb on the Cortex-A9
+// and to plain loads/stores on x86. They also keep the compiler from reordering around them.
+#define spscRing_loadAcquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define spscRing_loadRelaxed(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define spscRing_storeRelease(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#define SPSC_RING_INIT_COUNT 0  // Starting value of the counters.
+
+// Set up an empty ring on the caller's storage.
+void spscRing_init(spscRing_t* ring, uint32_t data[], uint32_t size) {
+  assert(size != 0 && (size & (size - 1)) == 0);  // Must be a power of two.
+  ring->data = data;
+  ring->mask = size - 1;
+  ring->overflowCount = SPSC_RING_INIT_COUNT;
+  ring->maxElementCount = SPSC_RING_INIT_COUNT;
+  spscRing_storeRelease(&ring->readCount, SPSC_RING_INIT_COUNT);
+  spscRing_storeRelease(&ring->writeCount, SPSC_RING_INIT_COUNT);
+}
+
+// Capacity of the ring.
+uint32_t spscRing_size(spscRing_t* ring) {
+  return ring->mask + 1;
+}
+
+// The counters are free-running, so unsigned subtraction gives the count even after they wrap.
+uint32_t spscRing_elementCount(spscRing_t* ring) {
+  return spscRing_loadAcquire(&ring->writeCount) - spscRing_loadAcquire(&ring->readCount);
+}
+
+// Number of dropped values.
+uint32_t spscRing_overflowCount(spscRing_t* ring) {
+  return spscRing_loadRelaxed(&ring->overflowCount);
+}
+
+// Only the consumer writes it, so no atomics are needed.
+uint32_t spscRing_maxElementCount(spscRing_t* ring) {
+  return ring->maxElementCount;
+}
+
+// Write the slot first, then publish it by advancing writeCount.
+bool spscRing_push(spscRing_t* ring, uint32_t value) {
+  uint32_t writeCount = spscRing_loadRelaxed(&ring->writeCount);            // Only we write this.
+  if (writeCount - spscRing_loadAcquire(&ring->readCount) > ring->mask) {  // Full: drop the newest value.
+    spscRing_storeRelease(&ring->overflowCount, ring->overflowCount + 1);
+    return false;
+  }
+  ring->data[writeCount & ring->mask] = value;
+  spscRing_storeRelease(&ring->writeCount, writeCount + 1);
+  return true;
+}
+
+// Hand out everything from the oldest slot up to the newest value or the end of the storage.
+uint32_t spscRing_claim(spscRing_t* ring, const uint32_t** run) {
+  uint32_t readCount = spscRing_loadRelaxed(&ring->readCount);              // Only we write this.
+  uint32_t available = spscRing_loadAcquire(&ring->writeCount) - readCount;
+  uint32_t first = readCount & ring->mask;
+  uint32_t untilEnd = ring->mask + 1 - first;
+  if (available > ring->maxElementCount)
+    ring->maxElementCount = available;
+  *run = &ring->data[first];
+  return (available < untilEnd) ? available : untilEnd;
+}
+
+// Give the slots back to the producer once we are done reading them.
+void spscRing_release(spscRing_t* ring, uint32_t count) {
+  spscRing_storeRelease(&ring->readCount, spscRing_loadRelaxed(&ring->readCount) + count);
+}
+
+// One-value claim and release.
+bool spscRing_pop(spscRing_t* ring, uint32_t* value) {
+  const uint32_t* run;
+  if (spscRing_claim(ring, &run) == 0)
+    return false;
+  *value = *run;
+  spscRing_release(ring, 1);
+  return true;
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define SPSC_RING_TEST_SIZE 8             // Small ring so the test wraps many times.
+#define SPSC_RING_TEST_LAPS 5             // Fill and drain the ring this many times.
+#define SPSC_RING_TEST_PARTIAL_FILL 5     // Values pushed per lap (not a divisor of the size, so runs get split).
+
+// Checks ordering across wrap-around, run lengths at the end of the storage, and drop-newest overflow.
+bool spscRing_runTest() {
+  static uint32_t data[SPSC_RING_TEST_SIZE];
+  spscRing_t ring;
+  bool success = true;
+  uint32_t nextPushed = 0;
+  uint32_t nextExpected = 0;
+  spscRing_init(&ring, data, SPSC_RING_TEST_SIZE);
+  // Partial fills drained with claims: a run never crosses the end of the storage.
+  for (uint32_t lap = 0; lap < SPSC_RING_TEST_LAPS * SPSC_RING_TEST_SIZE; lap++) {
+    for (uint32_t i = 0; i < SPSC_RING_TEST_PARTIAL_FILL; i++)
+      spscRing_push(&ring, nextPushed++);
+    const uint32_t* run;
+    uint32_t length;
+    while ((length = spscRing_claim(&ring, &run)) != 0) {
+      if ((uint32_t) (run - data) + length > SPSC_RING_TEST_SIZE) {
+        printf("spscRing_runTest: claimed run of %lu crosses the end of the storage.\n\r", (unsigned long) length);
+        success = false;
+      }
+      for (uint32_t i = 0; i < length; i++) {
+        if (run[i] != nextExpected) {
+          printf("spscRing_runTest: read %lu, expected %lu.\n\r", (unsigned long) run[i], (unsigned long) nextExpected);
+          success = false;
+        }
+        nextExpected++;
+      }
+      spscRing_release(&ring, length);
+    }
+  }
+  // Overflow: the ring keeps the oldest values and counts the dropped ones.
+  for (uint32_t i = 0; i < SPSC_RING_TEST_SIZE + SPSC_RING_TEST_PARTIAL_FILL; i++)
+    spscRing_push(&ring, i);
+  if (spscRing_elementCount(&ring) != SPSC_RING_TEST_SIZE || spscRing_overflowCount(&ring) != SPSC_RING_TEST_PARTIAL_FILL) {
+    printf("spscRing_runTest: %lu elements and %lu dropped after overflow, expected %d and %d.\n\r",
+        (unsigned long) spscRing_elementCount(&ring), (unsigned long) spscRing_overflowCount(&ring),
+        SPSC_RING_TEST_SIZE, SPSC_RING_TEST_PARTIAL_FILL);
+    success = false;
+  }
+  uint32_t value;
+  for (uint32_t i = 0; spscRing_pop(&ring, &value); i++) {
+    if (value != i) {
+      printf("spscRing_runTest: popped %lu after overflow, expected %lu.\n\r", (unsigned long) value, (unsigned long) i);
+      success = false;
+    }
+  }
+  if (spscRing_maxElementCount(&ring) != SPSC_RING_TEST_SIZE) {
+    printf("spscRing_runTest: most elements seen was %lu, expected %d.\n\r",
+        (unsigned long) spscRing_maxElementCount(&ring), SPSC_RING_TEST_SIZE);
+    success = false;
+  }
+  printf("spscRing_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
+
+#ifdef SPSC_RING_HOST_STRESS_TEST
+#include <pthread.h>
+
+#define SPSC_RING_STRESS_SIZE 1024          // Small enough that the producer regularly finds the ring full.
+#define SPSC_RING_STRESS_VALUES 20000000    // Values offered by the producer thread.
+#define SPSC_RING_STRESS_PRODUCER_SPIN 16   // Busy-wait between pushes, like the gap between timer interrupts.
+
+static uint32_t stressData[SPSC_RING_STRESS_SIZE];
+static spscRing_t stressRing;
+static bool stressProducerDone = false;
+
+// Stands in for the ISR: pushes 1, 2, 3, ... and never waits for the consumer (full means dropped).
+static void* stressProducer(void*) {
+  for (uint32_t value = 1; value <= SPSC_RING_STRESS_VALUES; value++) {
+    spscRing_push(&stressRing, value);
+    for (volatile uint32_t spin = 0; spin < SPSC_RING_STRESS_PRODUCER_SPIN; spin++)
+      ;
+  }
+  __atomic_store_n(&stressProducerDone, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+// Stands in for detector(): claims runs and checks that the values only go up.
+// A slot read before it was published (or after it was reused) would show an older value.
+int main() {
+  bool success = spscRing_runTest();
+  spscRing_init(&stressRing, stressData, SPSC_RING_STRESS_SIZE);
+  pthread_t producer;
+  pthread_create(&producer, NULL, stressProducer, NULL);
+  uint32_t received = 0;
+  uint32_t lastValue = 0;
+  uint32_t runCount = 0;
+  for (;;) {
+    bool producerDone = __atomic_load_n(&stressProducerDone, __ATOMIC_ACQUIRE);
+    const uint32_t* run;
+    uint32_t length = spscRing_claim(&stressRing, &run);
+    if (length == 0 && producerDone)
+      break;
+    for (uint32_t i = 0; i < length; i++) {
+      if (run[i] <= lastValue) {
+        printf("Out of order: %lu after %lu.\n\r", (unsigned long) run[i], (unsigned long) lastValue);
+        success = false;
+      }
+      lastValue = run[i];
+    }
+    received += length;
+    runCount += (length != 0);
+    spscRing_release(&stressRing, length);
+  }
+  pthread_join(producer, NULL);
+  uint32_t dropped = spscRing_overflowCount(&stressRing);
+  printf("received %lu in %lu runs, dropped %lu, offered %d.\n\r",
+      (unsigned long) received, (unsigned long) runCount, (unsigned long) dropped, SPSC_RING_STRESS_VALUES);
+  success &= (received + dropped == SPSC_RING_STRESS_VALUES);
+  printf("spscRing stress test %s.\n\r", success ? "passed" : "failed");
+  return success ? 0 : 1;
+}
+#endif
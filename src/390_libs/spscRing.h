@@ -0,0 +1,67 @@
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Lock-free single-producer/single-consumer ring of uint32_t values.
+// Exactly one context may call the producer functions (e.g. the timer ISR) and exactly one context
+// may call the consumer functions (e.g. the main loop). Neither side ever has to mask interrupts:
+// - The producer only writes writeCount and the consumer only writes readCount. Both are free-running
+//   counters, so the element count is simply writeCount - readCount and no field is shared for writing.
+// - The producer stores the data before publishing the new writeCount (release), and the consumer reads
+//   writeCount (acquire) before touching the data. The consumer likewise finishes with the data before
+//   publishing the new readCount, so the producer never overwrites a slot that is still being read.
+// - When the ring is full the producer drops the new value and counts it in overflowCount,
+//   because it cannot move readCount without racing the consumer.
+// The size must be a power of two so the slot index is just (counter & mask).
+
+typedef struct {
+  uint32_t writeCount;      // Number of values ever pushed. Written by the producer only.
+  uint32_t readCount;       // Number of values ever released. Written by the consumer only.
+  uint32_t overflowCount;   // Number of values dropped because the ring was full. Written by the producer only.
+  uint32_t maxElementCount; // Most values seen waiting by a claim. Written by the consumer only.
+  uint32_t mask;            // size - 1.
+  uint32_t* data;           // Caller-supplied storage of size elements.
+} spscRing_t;
+
+// Initializes an empty ring on top of data[size]. size must be a power of two (asserts otherwise).
+// Call this before either side starts running.
+void spscRing_init(spscRing_t* ring, uint32_t data[], uint32_t size);
+
+// Returns the number of values the ring can hold.
+uint32_t spscRing_size(spscRing_t* ring);
+
+// Returns the number of values in the ring. Safe to call from either side.
+uint32_t spscRing_elementCount(spscRing_t* ring);
+
+// Returns the number of values dropped by spscRing_push() since spscRing_init().
+uint32_t spscRing_overflowCount(spscRing_t* ring);
+
+// Returns the most values spscRing_claim() (or spscRing_pop()) has found waiting since spscRing_init():
+// how far the consumer has fallen behind at worst. Consumer side only.
+uint32_t spscRing_maxElementCount(spscRing_t* ring);
+
+// Producer: adds value to the ring. If the ring is full, value is dropped,
+// overflowCount is incremented and false is returned.
+bool spscRing_push(spscRing_t* ring, uint32_t value);
+
+// Consumer: points *run at the oldest value in the ring and returns how many values follow it
+// contiguously in memory (the run stops at the end of the storage; the rest comes with the next claim).
+// Returns 0 if the ring is empty. The values stay valid until they are released.
+uint32_t spscRing_claim(spscRing_t* ring, const uint32_t** run);
+
+// Consumer: frees the oldest count values (count must not exceed the last claim).
+void spscRing_release(spscRing_t* ring, uint32_t count);
+
+// Consumer: removes the oldest value into *value. Returns false if the ring is empty.
+bool spscRing_pop(spscRing_t* ring, uint32_t* value);
+
+// Single-threaded test of wrap-around, claims and overflow. Returns true if everything passed.
+bool spscRing_runTest();
+
+// A two-thread stress test (one thread stands in for the ISR, the other for the main loop) is
+// included for the host and is built with, e.g.:
+//   g++ -x c++ -O2 -pthread -I. -DSPSC_RING_HOST_STRESS_TEST src/390_libs/spscRing.c
+
+#endif /* SPSCRING_H_ */
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include "tickScheduler.h"
+#include "profiler.h"
+
+#define TICK_SCHEDULER_MAX_HYPERPERIOD 1000000  // Longest repeat period searched by tickScheduler_getScheduledMaxTicksPerInterrupt().
+#define TICK_SCHEDULER_INIT_VALUE 0             // Starting value of the counters.
+
+// One row of the table.
+typedef struct {
+  const char* name;                   // For the statistics printout.
+  tickScheduler_tickFunction_t tick;  // Called when countdown reaches 0.
+  uint32_t divider;                   // Run once every divider interrupts.
+  uint32_t phase;                     // Interrupt (mod divider) the function runs on.
+  uint32_t countdown;                 // Interrupts left until the next call.
+#ifdef PROFILER_ENABLE
+  profiler_zone_t zone;               // Times each call, under the entry's name.
+#endif
+} tickScheduler_entry_t;
+
+static tickScheduler_entry_t entries[TICK_SCHEDULER_MAX_ENTRIES];
+static uint32_t entryCount = TICK_SCHEDULER_INIT_VALUE;
+static uint32_t maxTicksPerInterrupt = TICK_SCHEDULER_INIT_VALUE;  // Measured by tickScheduler_tick().
+static uint32_t lastTickMask = TICK_SCHEDULER_INIT_VALUE;          // Entries run by the last tickScheduler_tick().
+
+// Empty table, no statistics.
+void tickScheduler_init() {
+  entryCount = TICK_SCHEDULER_INIT_VALUE;
+  maxTicksPerInterrupt = TICK_SCHEDULER_INIT_VALUE;
+  lastTickMask = TICK_SCHEDULER_INIT_VALUE;
+}
+
+// Append a row; the first call happens phase interrupts from now.
+bool tickScheduler_register(const char* name, tickScheduler_tickFunction_t tick, uint32_t divider, uint32_t phase) {
+  if (entryCount == TICK_SCHEDULER_MAX_ENTRIES) {
+    printf("tickScheduler_register(): table is full, %s not registered.\n\r", name);
+    return false;
+  }
+  if (phase >= divider) {
+    printf("tickScheduler_register(): %s has phase %lu, must be less than its divider %lu.\n\r",
+        name, (unsigned long) phase, (unsigned long) divider);
+    return false;
+  }
+  tickScheduler_entry_t* entry = &entries[entryCount];
+  entry->name = name;
+  entry->tick = tick;
+  entry->divider = divider;
+  entry->phase = phase;
+  entry->countdown = phase;
+  PROFILER_ZONE_INIT(entry->zone, name);
+  entryCount++;
+  return true;
+}
+
+// Count every row down and run the ones that reach 0.
+void tickScheduler_tick() {
+  uint32_t ticksThisInterrupt = TICK_SCHEDULER_INIT_VALUE;
+  uint32_t tickMask = TICK_SCHEDULER_INIT_VALUE;
+  for (uint32_t i = 0; i < entryCount; i++) {
+    tickScheduler_entry_t* entry = &entries[i];
+    if (entry->countdown == 0) {
+      entry->countdown = entry->divider - 1;
+      PROFILER_BEGIN(entry->zone);
+      entry->tick();
+      PROFILER_END(entry->zone);
+      ticksThisInterrupt++;
+      tickMask |= 1UL << i;
+    } else {
+      entry->countdown--;
+    }
+  }
+  if (ticksThisInterrupt > maxTicksPerInterrupt)
+    maxTicksPerInterrupt = ticksThisInterrupt;
+  lastTickMask = tickMask;
+}
+
+// Measured worst case.
+uint32_t tickScheduler_getMaxTicksPerInterrupt() {
+  return maxTicksPerInterrupt;
+}
+
+// Greatest common divisor, for the hyperperiod.
+static uint32_t greatestCommonDivisor(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    uint32_t remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+  return a;
+}
+
+// The schedule repeats every lcm(dividers) interrupts, so checking one hyperperiod covers every interrupt.
+uint32_t tickScheduler_getScheduledMaxTicksPerInterrupt() {
+  uint32_t hyperperiod = 1;
+  for (uint32_t i = 0; i < entryCount; i++) {
+    hyperperiod = hyperperiod / greatestCommonDivisor(hyperperiod, entries[i].divider) * entries[i].divider;
+    if (hyperperiod > TICK_SCHEDULER_MAX_HYPERPERIOD) {
+      hyperperiod = TICK_SCHEDULER_MAX_HYPERPERIOD;  // Dividers with no common factors: settle for a long sample.
+      break;
+    }
+  }
+  uint32_t worstCase = TICK_SCHEDULER_INIT_VALUE;
+  for (uint32_t interrupt = 0; interrupt < hyperperiod; interrupt++) {
+    uint32_t ticks = TICK_SCHEDULER_INIT_VALUE;
+    for (uint32_t i = 0; i < entryCount; i++)
+      ticks += (interrupt % entries[i].divider == entries[i].phase);
+    if (ticks > worstCase)
+      worstCase = ticks;
+  }
+  return worstCase;
+}
+
+// Number of rows.
+uint32_t tickScheduler_getEntryCount() {
+  return entryCount;
+}
+
+// Name of a row.
+const char* tickScheduler_getEntryName(uint32_t index) {
+  return (index < entryCount) ? entries[index].name : "";
+}
+
+// Bit i set if entry i ran.
+uint32_t tickScheduler_getLastTickMask() {
+  return lastTickMask;
+}
+
+// One line per row, then the worst cases.
+void tickScheduler_printStatistics() {
+  printf("tick function    divider  phase\n\r");
+  for (uint32_t i = 0; i < entryCount; i++)
+    printf("%-16s %7lu  %5lu\n\r", entries[i].name, (unsigned long) entries[i].divider, (unsigned long) entries[i].phase);
+  printf("Worst-case ticks per interrupt: %lu measured, %lu scheduled, %lu without the table.\n\r",
+      (unsigned long) tickScheduler_getMaxTicksPerInterrupt(),
+      (unsigned long) tickScheduler_getScheduledMaxTicksPerInterrupt(), (unsigned long) entryCount);
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define TICK_SCHEDULER_TEST_INTERRUPTS 1000  // Interrupts simulated by the test.
+#define TICK_SCHEDULER_TEST_ENTRY_COUNT 4
+#define TICK_SCHEDULER_TEST_WORST_CASE 2      // The full-rate function plus the one on phase 0.
+
+static uint32_t testCallCounts[TICK_SCHEDULER_TEST_ENTRY_COUNT];
+static uint32_t testFirstCall[TICK_SCHEDULER_TEST_ENTRY_COUNT];
+static uint32_t testInterrupt;
+
+// Records the first interrupt a test tick function ran on and how often it ran.
+static void testRecord(uint32_t index) {
+  if (testCallCounts[index] == 0)
+    testFirstCall[index] = testInterrupt;
+  testCallCounts[index]++;
+}
+static void testTick0() {testRecord(0);}
+static void testTick1() {testRecord(1);}
+static void testTick2() {testRecord(2);}
+static void testTick3() {testRecord(3);}
+
+// Four functions: full rate, and three at a tenth of the rate on different phases.
+// Only two of them may ever run on the same interrupt.
+bool tickScheduler_runTest() {
+  static const tickScheduler_tickFunction_t ticks[TICK_SCHEDULER_TEST_ENTRY_COUNT] = {testTick0, testTick1, testTick2, testTick3};
+  static const uint32_t dividers[TICK_SCHEDULER_TEST_ENTRY_COUNT] = {1, 10, 10, 10};
+  static const uint32_t phases[TICK_SCHEDULER_TEST_ENTRY_COUNT] = {0, 0, 3, 7};
+  bool success = true;
+  tickScheduler_init();
+  for (uint32_t i = 0; i < TICK_SCHEDULER_TEST_ENTRY_COUNT; i++) {
+    testCallCounts[i] = 0;
+    tickScheduler_register("test", ticks[i], dividers[i], phases[i]);
+  }
+  success &= !tickScheduler_register("badPhase", testTick0, 10, 10);  // Must be rejected.
+  for (testInterrupt = 0; testInterrupt < TICK_SCHEDULER_TEST_INTERRUPTS; testInterrupt++)
+    tickScheduler_tick();
+  for (uint32_t i = 0; i < TICK_SCHEDULER_TEST_ENTRY_COUNT; i++) {
+    if (testCallCounts[i] != TICK_SCHEDULER_TEST_INTERRUPTS / dividers[i] || testFirstCall[i] != phases[i]) {
+      printf("tickScheduler_runTest: entry %lu ran %lu times starting at %lu, expected %lu times starting at %lu.\n\r",
+          (unsigned long) i, (unsigned long) testCallCounts[i], (unsigned long) testFirstCall[i],
+          (unsigned long) (TICK_SCHEDULER_TEST_INTERRUPTS / dividers[i]), (unsigned long) phases[i]);
+      success = false;
+    }
+  }
+  if (tickScheduler_getMaxTicksPerInterrupt() != TICK_SCHEDULER_TEST_WORST_CASE ||
+      tickScheduler_getScheduledMaxTicksPerInterrupt() != TICK_SCHEDULER_TEST_WORST_CASE) {
+    printf("tickScheduler_runTest: worst case %lu measured, %lu scheduled, expected %d.\n\r",
+        (unsigned long) tickScheduler_getMaxTicksPerInterrupt(), (unsigned long) tickScheduler_getScheduledMaxTicksPerInterrupt(),
+        TICK_SCHEDULER_TEST_WORST_CASE);
+    success = false;
+  }
+  tickScheduler_init();
+  printf("tickScheduler_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
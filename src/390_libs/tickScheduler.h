@@ -0,0 +1,53 @@
+#ifndef TICKSCHEDULER_H_
+#define TICKSCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Table-driven scheduler for the state-machine tick functions called from a periodic interrupt.
+// Each tick function is registered with a rate divider and a phase: it runs on the interrupts where
+// (interruptNumber % divider) == phase, so a divider of 10 runs it at a tenth of the interrupt rate.
+// Giving modules with the same divider different phases spreads them over different interrupts,
+// which keeps the worst-case work per interrupt close to the average.
+// Each entry keeps a countdown instead of computing a modulo (the Cortex-A9 has no divide instruction).
+
+#define TICK_SCHEDULER_MAX_ENTRIES 16   // Most tick functions that can be registered (at most 32, see tickScheduler_getLastTickMask()).
+
+typedef void (*tickScheduler_tickFunction_t)();
+
+// Clears the table and the statistics.
+void tickScheduler_init();
+
+// Adds tick() to the table. It runs every divider-th call of tickScheduler_tick(), starting with
+// call number phase (counting from 0). Returns false (and prints an error) if the table is full
+// or phase is not smaller than divider.
+bool tickScheduler_register(const char* name, tickScheduler_tickFunction_t tick, uint32_t divider, uint32_t phase);
+
+// Call this once per interrupt: runs every tick function that is due on this interrupt, in table order.
+void tickScheduler_tick();
+
+// Returns the most tick functions that ran during a single tickScheduler_tick() call so far.
+uint32_t tickScheduler_getMaxTicksPerInterrupt();
+
+// Returns the most tick functions that the current table will ever run on one interrupt,
+// computed from the dividers and phases (independent of how long the scheduler has been running).
+uint32_t tickScheduler_getScheduledMaxTicksPerInterrupt();
+
+// Returns the number of registered tick functions.
+uint32_t tickScheduler_getEntryCount();
+
+// Returns the name given to tickScheduler_register() for entry index (in registration order).
+const char* tickScheduler_getEntryName(uint32_t index);
+
+// Returns a mask of the entries that ran during the last tickScheduler_tick() call
+// (bit i set means entry i ran), e.g. to blame a slow interrupt on its tick functions.
+uint32_t tickScheduler_getLastTickMask();
+
+// Prints the table (name, divider, phase) and the worst-case ticks per interrupt.
+void tickScheduler_printStatistics();
+
+// Registers a few counting tick functions and checks their call counts, phases and the worst case.
+// Restores an empty table when done, so call tickScheduler_init() and register again afterwards.
+bool tickScheduler_runTest();
+
+#endif /* TICKSCHEDULER_H_ */
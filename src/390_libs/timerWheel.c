@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include "timerWheel.h"
+
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOT_COUNT - 1)
+#define TIMER_WHEEL_INIT_VALUE 0  // Starting tick count.
+
+// Shift that turns a tick number into the slot number at a given level.
+#define TIMER_WHEEL_LEVEL_SHIFT(level) (TIMER_WHEEL_SLOT_BITS * (level))
+
+// arm/cancel can be called from the main loop while timerWheel_tick() runs in the ISR, so they mask IRQs.
+// The previous CPSR is restored (instead of unconditionally enabling IRQs) so they also work inside the ISR.
+// Host builds are single-threaded and need no masking.
+#if defined(__arm__)
+static inline uint32_t timerWheel_enterCritical() {
+  uint32_t cpsr;
+  __asm__ volatile("mrs %0, cpsr\n\tcpsid i" : "=r" (cpsr) : : "memory");
+  return cpsr;
+}
+static inline void timerWheel_exitCritical(uint32_t cpsr) {
+  __asm__ volatile("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+}
+#else
+static inline uint32_t timerWheel_enterCritical() {return 0;}
+static inline void timerWheel_exitCritical(uint32_t) {}
+#endif
+
+static timerWheel_timer_t* slots[TIMER_WHEEL_LEVEL_COUNT][TIMER_WHEEL_SLOT_COUNT];  // Singly-linked lists with back-pointers.
+static uint32_t now = TIMER_WHEEL_INIT_VALUE;  // Number of ticks processed.
+
+// Links timer into the slot for its expiry: the lowest level whose range covers expiry - now.
+static void insert(timerWheel_timer_t* timer) {
+  uint32_t delta = timer->expiry - now;
+  uint32_t level = 0;
+  while (level < TIMER_WHEEL_LEVEL_COUNT - 1 && delta >= (1UL << TIMER_WHEEL_LEVEL_SHIFT(level + 1)))
+    level++;
+  timerWheel_timer_t** head = &slots[level][(timer->expiry >> TIMER_WHEEL_LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK];
+  timer->next = *head;
+  if (timer->next)
+    timer->next->pprev = &timer->next;
+  timer->pprev = head;
+  *head = timer;
+}
+
+// Unlinks timer from whatever list it is on.
+static void unlink(timerWheel_timer_t* timer) {
+  *timer->pprev = timer->next;
+  if (timer->next)
+    timer->next->pprev = timer->pprev;
+  timer->next = 0;
+  timer->pprev = 0;
+}
+
+// Moves a whole list out of the wheel into a local head, so it can be emptied while timers are re-inserted.
+static timerWheel_timer_t* detach(timerWheel_timer_t** head) {
+  timerWheel_timer_t* list = *head;
+  *head = 0;
+  return list;
+}
+
+// Empty every slot and start counting from 0.
+void timerWheel_init() {
+  uint32_t cpsr = timerWheel_enterCritical();
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVEL_COUNT; level++) {
+    for (uint32_t slot = 0; slot < TIMER_WHEEL_SLOT_COUNT; slot++) {
+      while (slots[level][slot])
+        unlink(slots[level][slot]);  // Leaves each timer disarmed, not just forgotten.
+    }
+  }
+  now = TIMER_WHEEL_INIT_VALUE;
+  timerWheel_exitCritical(cpsr);
+}
+
+// (Re)arm: O(1), one unlink and one insert.
+void timerWheel_arm(timerWheel_timer_t* timer, uint32_t ticks, timerWheel_callback_t callback) {
+  if (ticks == 0)
+    ticks = 1;  // The current tick has already been processed.
+  if (ticks > TIMER_WHEEL_MAX_TICKS)
+    ticks = TIMER_WHEEL_MAX_TICKS;
+  uint32_t cpsr = timerWheel_enterCritical();
+  if (timer->pprev)
+    unlink(timer);
+  timer->expiry = now + ticks;
+  timer->callback = callback;
+  insert(timer);
+  timerWheel_exitCritical(cpsr);
+}
+
+// O(1) thanks to the back-pointer.
+void timerWheel_cancel(timerWheel_timer_t* timer) {
+  uint32_t cpsr = timerWheel_enterCritical();
+  if (timer->pprev)
+    unlink(timer);
+  timerWheel_exitCritical(cpsr);
+}
+
+// Armed timers are always on a list.
+bool timerWheel_armed(timerWheel_timer_t* timer) {
+  return timer->pprev != 0;
+}
+
+// Cascade the higher levels whose slot boundary was just crossed, then fire level 0's slot for this tick.
+void timerWheel_tick() {
+  uint32_t cpsr = timerWheel_enterCritical();
+  now++;
+  for (uint32_t level = 1; level < TIMER_WHEEL_LEVEL_COUNT; level++) {
+    if (now & ((1UL << TIMER_WHEEL_LEVEL_SHIFT(level)) - 1))
+      break;  // Not on a boundary of this level, so not of the higher ones either.
+    // Every timer in this slot expires within the next 64^level ticks, so it moves down a level (or more).
+    timerWheel_timer_t* list = detach(&slots[level][(now >> TIMER_WHEEL_LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK]);
+    if (list)
+      list->pprev = &list;
+    while (list) {
+      timerWheel_timer_t* timer = list;
+      unlink(timer);
+      insert(timer);
+    }
+  }
+  timerWheel_timer_t* expired = detach(&slots[0][now & TIMER_WHEEL_SLOT_MASK]);
+  if (expired)
+    expired->pprev = &expired;
+  while (expired) {
+    timerWheel_timer_t* timer = expired;
+    unlink(timer);  // Disarmed before the callback, so the callback can re-arm it.
+    timer->callback(timer);
+  }
+  timerWheel_exitCritical(cpsr);
+}
+
+// Ticks since timerWheel_init().
+uint32_t timerWheel_now() {
+  return now;
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define TIMER_WHEEL_TEST_TIMER_COUNT 32          // Timers in play at once.
+#define TIMER_WHEEL_TEST_TICK_COUNT 300000       // Ticks simulated (5 minutes at 1 kHz, so every level cascades).
+#define TIMER_WHEEL_TEST_ACTION_PERCENT 20       // Chance per tick of arming or cancelling a random timer.
+#define TIMER_WHEEL_TEST_CANCEL_PERCENT 20       // Share of those actions that are cancels.
+#define TIMER_WHEEL_TEST_REARM_PERCENT 50        // Chance that a callback re-arms its own timer.
+#define TIMER_WHEEL_TEST_PERCENT 100
+#define TIMER_WHEEL_TEST_DISARMED 0              // Countdown value of a disarmed reference counter.
+#define TIMER_WHEEL_TEST_RANGE_COUNT 4
+// Timeouts are drawn from these ranges so that every level of the wheel is used.
+static const uint32_t timerWheel_testRanges[TIMER_WHEEL_TEST_RANGE_COUNT] = {64, 4096, 100000, TIMER_WHEEL_TEST_TICK_COUNT};
+
+static timerWheel_timer_t testTimers[TIMER_WHEEL_TEST_TIMER_COUNT];
+static uint32_t testCountdown[TIMER_WHEEL_TEST_TIMER_COUNT];  // Reference: ticks left, like the old state-machine counters.
+static bool testDueNow[TIMER_WHEEL_TEST_TIMER_COUNT];         // Reference says the timer expires on this tick.
+static uint32_t testRandomState;
+static uint32_t testFiredCount;
+static bool testSuccess;
+
+// Small deterministic generator so the test repeats exactly.
+static uint32_t testRandom(uint32_t limit) {
+  testRandomState = testRandomState * 1103515245 + 12345;
+  return (testRandomState >> 8) % limit;
+}
+
+// A timeout from 1 up to a random range.
+static uint32_t testRandomTicks() {
+  return 1 + testRandom(timerWheel_testRanges[testRandom(TIMER_WHEEL_TEST_RANGE_COUNT)]);
+}
+
+static void testCallback(timerWheel_timer_t* timer);
+
+// Arms the wheel timer and its reference counter together.
+static void testArm(uint32_t index, uint32_t ticks) {
+  timerWheel_arm(&testTimers[index], ticks, testCallback);
+  testCountdown[index] = ticks;
+}
+
+// Must only run on the tick the reference counter ran out.
+static void testCallback(timerWheel_timer_t* timer) {
+  uint32_t index = timer - testTimers;
+  if (!testDueNow[index]) {
+    printf("timerWheel_runTest: timer %lu fired at tick %lu, too early.\n\r", (unsigned long) index, (unsigned long) timerWheel_now());
+    testSuccess = false;
+  }
+  testDueNow[index] = false;
+  testFiredCount++;
+  if (testRandom(TIMER_WHEEL_TEST_PERCENT) < TIMER_WHEEL_TEST_REARM_PERCENT)
+    testArm(index, testRandomTicks());
+}
+
+// Random arms, re-arms and cancels; the reference counters are decremented every tick like the old code.
+bool timerWheel_runTest() {
+  testRandomState = 1;
+  testFiredCount = 0;
+  testSuccess = true;
+  timerWheel_init();
+  for (uint32_t i = 0; i < TIMER_WHEEL_TEST_TIMER_COUNT; i++) {
+    testCountdown[i] = TIMER_WHEEL_TEST_DISARMED;
+    testDueNow[i] = false;
+  }
+  for (uint32_t tick = 0; tick < TIMER_WHEEL_TEST_TICK_COUNT && testSuccess; tick++) {
+    if (testRandom(TIMER_WHEEL_TEST_PERCENT) < TIMER_WHEEL_TEST_ACTION_PERCENT) {
+      uint32_t index = testRandom(TIMER_WHEEL_TEST_TIMER_COUNT);
+      if (testRandom(TIMER_WHEEL_TEST_PERCENT) < TIMER_WHEEL_TEST_CANCEL_PERCENT) {
+        timerWheel_cancel(&testTimers[index]);
+        testCountdown[index] = TIMER_WHEEL_TEST_DISARMED;
+      } else {
+        testArm(index, testRandomTicks());
+      }
+    }
+    for (uint32_t i = 0; i < TIMER_WHEEL_TEST_TIMER_COUNT; i++) {
+      if (testCountdown[i] != TIMER_WHEEL_TEST_DISARMED && --testCountdown[i] == 0)
+        testDueNow[i] = true;
+    }
+    timerWheel_tick();
+    for (uint32_t i = 0; i < TIMER_WHEEL_TEST_TIMER_COUNT; i++) {
+      if (testDueNow[i]) {
+        printf("timerWheel_runTest: timer %lu did not fire at tick %lu.\n\r", (unsigned long) i, (unsigned long) timerWheel_now());
+        testSuccess = false;
+      }
+      if (timerWheel_armed(&testTimers[i]) != (testCountdown[i] != TIMER_WHEEL_TEST_DISARMED)) {
+        printf("timerWheel_runTest: timer %lu armed state is wrong at tick %lu.\n\r", (unsigned long) i, (unsigned long) timerWheel_now());
+        testSuccess = false;
+      }
+    }
+  }
+  timerWheel_init();
+  printf("timerWheel_runTest %s (%lu expiries checked).\n\r", testSuccess ? "passed" : "failed", (unsigned long) testFiredCount);
+  return testSuccess;
+}
+
+#ifdef TIMER_WHEEL_HOST_TEST
+// Host entry point for timerWheel_runTest(), see timerWheel.h.
+int main() {
+  return timerWheel_runTest() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hierarchical timer wheel: one-shot timeouts with callbacks, driven by timerWheel_tick() from the ISR.
+// Arming or cancelling a timer is O(1) and a timer costs nothing while it waits, so state machines can
+// arm a timeout when they enter a state instead of incrementing a counter on every tick.
+//
+// The wheel has TIMER_WHEEL_LEVEL_COUNT levels of TIMER_WHEEL_SLOT_COUNT slots. Level 0 holds the timers
+// that expire within the next 64 ticks (one slot per tick); level n holds timers up to 64^(n+1) ticks out
+// (one slot per 64^n ticks). Every 64 ticks the next slot of level 1 is cascaded down into level 0, and so on.
+// Timers fire on exactly the tick they were armed for.
+//
+// Callbacks run inside timerWheel_tick() (interrupt context on the board). They may arm or cancel timers.
+// timerWheel_arm() and timerWheel_cancel() may be called from the main loop or from the ISR: they mask
+// IRQs for a few instructions and restore the previous mask, so they also nest inside the ISR.
+
+#define TIMER_WHEEL_SLOT_BITS 6                                   // 64 slots per level.
+#define TIMER_WHEEL_SLOT_COUNT (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVEL_COUNT 4                                 // Timeouts of up to 64^4 - 1 ticks.
+#define TIMER_WHEEL_MAX_TICKS ((1UL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVEL_COUNT)) - 1)
+
+// timerWheel_tick() is called on every 100th 100 kHz interrupt, so timeouts are in 1 kHz (1 ms) ticks.
+#define TIMER_WHEEL_TICK_RATE_DIVIDER 100
+
+struct timerWheel_timer_t;
+
+// Called with the timer that fired (useful when several timers share one callback).
+typedef void (*timerWheel_callback_t)(struct timerWheel_timer_t* timer);
+
+// A timer. Declare it static (zero-initialized is a valid, disarmed timer) and only touch it through
+// the functions below.
+typedef struct timerWheel_timer_t {
+  struct timerWheel_timer_t* next;    // Next timer in the same slot.
+  struct timerWheel_timer_t** pprev;  // The pointer that points at this timer (0 if not armed).
+  uint32_t expiry;                    // Tick number to fire on.
+  timerWheel_callback_t callback;     // Called when the timer fires.
+} timerWheel_timer_t;
+
+// Disarms every timer and restarts the tick count at 0.
+void timerWheel_init();
+
+// Fires callback once, ticks calls of timerWheel_tick() from now (ticks is clamped to 1..TIMER_WHEEL_MAX_TICKS).
+// Re-arming a timer that is already armed moves it to the new expiry.
+void timerWheel_arm(timerWheel_timer_t* timer, uint32_t ticks, timerWheel_callback_t callback);
+
+// Disarms the timer; its callback will not be called. Does nothing if it is not armed.
+void timerWheel_cancel(timerWheel_timer_t* timer);
+
+// Returns true if the timer is armed and has not fired yet.
+bool timerWheel_armed(timerWheel_timer_t* timer);
+
+// Advances the wheel by one tick and calls the callbacks of the timers that expire on it.
+void timerWheel_tick();
+
+// Returns the number of timerWheel_tick() calls since timerWheel_init().
+uint32_t timerWheel_now();
+
+// Arms and cancels random timers and checks every expiry, to the tick, against plain countdown
+// counters (the way the state machines used to time themselves). Returns true if all of them matched.
+// Nothing in here touches hardware, so it also runs on the host, e.g.:
+//   g++ -x c++ -I. -DTIMER_WHEEL_HOST_TEST src/390_libs/timerWheel.c
+// tools/timeoutCheck checks the modules that time themselves with the wheel against their old counters.
+bool timerWheel_runTest();
+
+#endif /* TIMERWHEEL_H_ */
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "touchQueue.h"
+#include "spscRing.h"
+#include "supportFiles/display.h"
+
+// Raw codes to pixels: pixel = (code - edge) * scale >> TOUCH_QUEUE_FRACTION_BITS. The scales are rounded up,
+// which keeps every result equal to the exact quotient truncated: with 20 fraction bits the rounding adds
+// less than 0.002 of a pixel, smaller than the closest any quotient comes to the next whole pixel.
+#define TOUCH_QUEUE_FRACTION_BITS 20
+#define TOUCH_QUEUE_X_SPAN (DISPLAY_TOUCH_MAX_X_CODE - DISPLAY_TOUCH_MIN_X_CODE)
+#define TOUCH_QUEUE_Y_SPAN (DISPLAY_TOUCH_MAX_Y_CODE - DISPLAY_TOUCH_MIN_Y_CODE)
+#define TOUCH_QUEUE_X_SCALE ((((int32_t) DISPLAY_WIDTH << TOUCH_QUEUE_FRACTION_BITS) + TOUCH_QUEUE_X_SPAN - 1) / TOUCH_QUEUE_X_SPAN)
+#define TOUCH_QUEUE_Y_SCALE ((((int32_t) DISPLAY_HEIGHT << TOUCH_QUEUE_FRACTION_BITS) + TOUCH_QUEUE_Y_SPAN - 1) / TOUCH_QUEUE_Y_SPAN)
+
+// An event packed into one ring slot.
+#define TOUCH_QUEUE_COORDINATE_BITS 10
+#define TOUCH_QUEUE_COORDINATE_MASK ((1 << TOUCH_QUEUE_COORDINATE_BITS) - 1)
+#define TOUCH_QUEUE_Y_SHIFT TOUCH_QUEUE_COORDINATE_BITS
+#define TOUCH_QUEUE_Z_SHIFT (2 * TOUCH_QUEUE_COORDINATE_BITS)
+#define TOUCH_QUEUE_TYPE_SHIFT (TOUCH_QUEUE_Z_SHIFT + 8)
+#define TOUCH_QUEUE_Z_MASK 0xFF
+
+static uint32_t touchQueue_ringData[TOUCH_QUEUE_SIZE];
+static spscRing_t touchQueue_ring;
+
+// Filter state; only touchQueue_service() (the ISR) touches it.
+static int16_t touchQueue_rawX[TOUCH_QUEUE_MEDIAN_SIZE];  // The last samples of the touch, circular.
+static int16_t touchQueue_rawY[TOUCH_QUEUE_MEDIAN_SIZE];
+static uint32_t touchQueue_sampleCount = 0;               // Samples since the touch began.
+static bool touchQueue_pressed = false;                   // A press has been published for this touch.
+static int16_t touchQueue_lastX, touchQueue_lastY;        // Point of the last published event.
+
+// Empty queue, no touch in progress.
+static void touchQueue_reset() {
+  spscRing_init(&touchQueue_ring, touchQueue_ringData, TOUCH_QUEUE_SIZE);
+  touchQueue_sampleCount = 0;
+  touchQueue_pressed = false;
+}
+
+void touchQueue_init() {
+  touchQueue_reset();
+  display_clearOldTouchData();
+}
+
+// Raw y to the LCD's x, clamped to the screen.
+static int16_t touchQueue_mapX(int16_t rawY) {
+  int32_t offset = rawY - DISPLAY_TOUCH_MIN_X_CODE;
+  if (offset <= 0)
+    return 0;
+  int32_t x = (offset * TOUCH_QUEUE_X_SCALE) >> TOUCH_QUEUE_FRACTION_BITS;
+  return (x < DISPLAY_WIDTH) ? x : DISPLAY_WIDTH - 1;
+}
+
+// Raw x to the LCD's y (which runs the other way), clamped to the screen.
+static int16_t touchQueue_mapY(int16_t rawX) {
+  int32_t offset = DISPLAY_TOUCH_MAX_Y_CODE - rawX;
+  if (offset <= 0)
+    return 0;
+  int32_t y = (offset * TOUCH_QUEUE_Y_SCALE) >> TOUCH_QUEUE_FRACTION_BITS;
+  return (y < DISPLAY_HEIGHT) ? y : DISPLAY_HEIGHT - 1;
+}
+
+// Median of the window by insertion sort: it only holds a few samples.
+static int16_t touchQueue_median(const int16_t window[]) {
+  int16_t sorted[TOUCH_QUEUE_MEDIAN_SIZE];
+  for (uint32_t i = 0; i < TOUCH_QUEUE_MEDIAN_SIZE; i++) {
+    uint32_t j = i;
+    for (; j > 0 && sorted[j - 1] > window[i]; j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = window[i];
+  }
+  return sorted[TOUCH_QUEUE_MEDIAN_SIZE / 2];
+}
+
+// Packs the event into the ring; a full ring drops it (and counts it).
+static void touchQueue_publish(touchQueue_eventType_t type, int16_t x, int16_t y, uint8_t z) {
+  spscRing_push(&touchQueue_ring, ((uint32_t) type << TOUCH_QUEUE_TYPE_SHIFT) | ((uint32_t) z << TOUCH_QUEUE_Z_SHIFT) |
+      ((uint32_t) y << TOUCH_QUEUE_Y_SHIFT) | (uint32_t) x);
+  touchQueue_lastX = x;
+  touchQueue_lastY = y;
+}
+
+// One raw sample of the touch in progress.
+static void touchQueue_addSample(int16_t rawX, int16_t rawY, uint8_t z) {
+  touchQueue_rawX[touchQueue_sampleCount % TOUCH_QUEUE_MEDIAN_SIZE] = rawX;
+  touchQueue_rawY[touchQueue_sampleCount % TOUCH_QUEUE_MEDIAN_SIZE] = rawY;
+  touchQueue_sampleCount++;
+  if (touchQueue_sampleCount < TOUCH_QUEUE_MEDIAN_SIZE)
+    return;  // Not enough for the median yet.
+  int16_t x = touchQueue_mapX(touchQueue_median(touchQueue_rawY));
+  int16_t y = touchQueue_mapY(touchQueue_median(touchQueue_rawX));
+  if (!touchQueue_pressed) {
+    touchQueue_pressed = true;
+    touchQueue_publish(touchQueue_press_e, x, y, z);
+  } else if (abs(x - touchQueue_lastX) >= TOUCH_QUEUE_MOVE_HYSTERESIS || abs(y - touchQueue_lastY) >= TOUCH_QUEUE_MOVE_HYSTERESIS) {
+    touchQueue_publish(touchQueue_move_e, x, y, z);
+  }
+}
+
+// The finger is up and its samples are all in.
+static void touchQueue_endTouch() {
+  if (touchQueue_pressed)
+    touchQueue_publish(touchQueue_release_e, touchQueue_lastX, touchQueue_lastY, 0);
+  touchQueue_sampleCount = 0;
+  touchQueue_pressed = false;
+}
+
+// The touched bit is read before the FIFO is drained: if it was already clear, every sample read
+// belongs to the touch that ended, and the release goes after them.
+void touchQueue_service() {
+  bool touched = display_isTouched();
+  int16_t x[TOUCH_QUEUE_BURST_SIZE], y[TOUCH_QUEUE_BURST_SIZE];
+  uint8_t z[TOUCH_QUEUE_BURST_SIZE];
+  uint8_t count;
+  do {
+    count = display_readTouchSamples(x, y, z, TOUCH_QUEUE_BURST_SIZE);
+    for (uint8_t i = 0; i < count; i++)
+      touchQueue_addSample(x[i], y[i], z[i]);
+  } while (count == TOUCH_QUEUE_BURST_SIZE);
+  if (!touched)
+    touchQueue_endTouch();
+}
+
+bool touchQueue_getEvent(touchQueue_event_t* event) {
+  uint32_t packed;
+  if (!spscRing_pop(&touchQueue_ring, &packed))
+    return false;
+  event->type = (touchQueue_eventType_t) (packed >> TOUCH_QUEUE_TYPE_SHIFT);
+  event->z = (packed >> TOUCH_QUEUE_Z_SHIFT) & TOUCH_QUEUE_Z_MASK;
+  event->y = (packed >> TOUCH_QUEUE_Y_SHIFT) & TOUCH_QUEUE_COORDINATE_MASK;
+  event->x = packed & TOUCH_QUEUE_COORDINATE_MASK;
+  return true;
+}
+
+bool touchQueue_getPressOrRelease(touchQueue_event_t* event) {
+  while (touchQueue_getEvent(event)) {
+    if (event->type != touchQueue_move_e)
+      return true;
+  }
+  return false;
+}
+
+void touchQueue_clear() {
+  touchQueue_event_t event;
+  while (touchQueue_getEvent(&event))
+    ;
+}
+
+uint32_t touchQueue_overflowCount() {
+  return spscRing_overflowCount(&touchQueue_ring);
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define TOUCH_QUEUE_TEST_RAW_MAX 4095     // 12-bit samples.
+#define TOUCH_QUEUE_TEST_Z 50
+#define TOUCH_QUEUE_TEST_SPIKE 1000       // Raw codes a spike sample is off by.
+#define TOUCH_QUEUE_TEST_HOLD_SAMPLES 10  // Samples at each point of the scripted touch.
+
+// Raw codes aimed at the middle of pixel (x, y), as the controller would give them.
+static void touchQueue_testRaw(int16_t x, int16_t y, int16_t* rawX, int16_t* rawY) {
+  *rawY = DISPLAY_TOUCH_MIN_X_CODE + (x * TOUCH_QUEUE_X_SPAN + TOUCH_QUEUE_X_SPAN / 2) / DISPLAY_WIDTH;
+  *rawX = DISPLAY_TOUCH_MAX_Y_CODE - (y * TOUCH_QUEUE_Y_SPAN + TOUCH_QUEUE_Y_SPAN / 2) / DISPLAY_HEIGHT;
+}
+
+// Adds count samples at pixel (x, y).
+static void touchQueue_testTouch(int16_t x, int16_t y, uint32_t count) {
+  int16_t rawX, rawY;
+  touchQueue_testRaw(x, y, &rawX, &rawY);
+  for (uint32_t i = 0; i < count; i++)
+    touchQueue_addSample(rawX, rawY, TOUCH_QUEUE_TEST_Z);
+}
+
+// Takes the next event and checks it.
+static bool touchQueue_testExpect(touchQueue_eventType_t type, int16_t x, int16_t y) {
+  touchQueue_event_t event;
+  if (!touchQueue_getEvent(&event)) {
+    printf("touchQueue_runTest: no event, expected type %d at (%d, %d).\n\r", type, x, y);
+    return false;
+  }
+  if (event.type != type || event.x != x || event.y != y) {
+    printf("touchQueue_runTest: event type %d at (%d, %d), expected type %d at (%d, %d).\n\r",
+        event.type, event.x, event.y, type, x, y);
+    return false;
+  }
+  return true;
+}
+
+// Checks that no event is waiting.
+static bool touchQueue_testExpectNone(const char* after) {
+  touchQueue_event_t event;
+  if (!touchQueue_getEvent(&event))
+    return true;
+  printf("touchQueue_runTest: unexpected event type %d at (%d, %d) after %s.\n\r", event.type, event.x, event.y, after);
+  return false;
+}
+
+bool touchQueue_runTest() {
+  bool success = true;
+  touchQueue_reset();
+  // The fixed-point mapping against the exact quotient, truncated and clamped, for every raw code.
+  for (int32_t code = 0; code <= TOUCH_QUEUE_TEST_RAW_MAX; code++) {
+    int32_t exactX = (code - DISPLAY_TOUCH_MIN_X_CODE) * DISPLAY_WIDTH / TOUCH_QUEUE_X_SPAN;
+    int32_t exactY = (DISPLAY_TOUCH_MAX_Y_CODE - code) * DISPLAY_HEIGHT / TOUCH_QUEUE_Y_SPAN;
+    exactX = (exactX < 0) ? 0 : (exactX >= DISPLAY_WIDTH) ? DISPLAY_WIDTH - 1 : exactX;
+    exactY = (exactY < 0) ? 0 : (exactY >= DISPLAY_HEIGHT) ? DISPLAY_HEIGHT - 1 : exactY;
+    if (touchQueue_mapX(code) != exactX || touchQueue_mapY(code) != exactY) {
+      printf("touchQueue_runTest: code %ld maps to (%d, %d), expected (%ld, %ld).\n\r", (long) code,
+          touchQueue_mapX(code), touchQueue_mapY(code), (long) exactX, (long) exactY);
+      success = false;
+      break;
+    }
+  }
+  // Too short for a press: nothing at all.
+  touchQueue_testTouch(100, 100, TOUCH_QUEUE_MEDIAN_SIZE - 1);
+  touchQueue_endTouch();
+  success &= touchQueue_testExpectNone("a touch too short for a press");
+  // Press, a spike, jitter under the hysteresis, a move, release.
+  touchQueue_testTouch(100, 100, TOUCH_QUEUE_TEST_HOLD_SAMPLES);
+  success &= touchQueue_testExpect(touchQueue_press_e, 100, 100);
+  int16_t rawX, rawY;
+  touchQueue_testRaw(100, 100, &rawX, &rawY);
+  touchQueue_addSample(rawX + TOUCH_QUEUE_TEST_SPIKE, rawY - TOUCH_QUEUE_TEST_SPIKE, TOUCH_QUEUE_TEST_Z);
+  touchQueue_testTouch(100, 100, TOUCH_QUEUE_TEST_HOLD_SAMPLES);
+  success &= touchQueue_testExpectNone("a one-sample spike");
+  touchQueue_testTouch(100 + TOUCH_QUEUE_MOVE_HYSTERESIS - 1, 100, TOUCH_QUEUE_TEST_HOLD_SAMPLES);
+  success &= touchQueue_testExpectNone("jitter under the hysteresis");
+  touchQueue_testTouch(150, 80, TOUCH_QUEUE_TEST_HOLD_SAMPLES);
+  success &= touchQueue_testExpect(touchQueue_move_e, 150, 80);
+  success &= touchQueue_testExpectNone("the move");
+  touchQueue_endTouch();
+  success &= touchQueue_testExpect(touchQueue_release_e, 150, 80);
+  // The corners of the screen survive the packing.
+  touchQueue_testTouch(DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1, TOUCH_QUEUE_MEDIAN_SIZE);
+  touchQueue_endTouch();
+  touchQueue_testTouch(0, 0, TOUCH_QUEUE_MEDIAN_SIZE);
+  touchQueue_endTouch();
+  touchQueue_event_t event;
+  success &= touchQueue_getPressOrRelease(&event) && event.type == touchQueue_press_e &&
+      event.x == DISPLAY_WIDTH - 1 && event.y == DISPLAY_HEIGHT - 1 && event.z == TOUCH_QUEUE_TEST_Z;
+  success &= touchQueue_testExpect(touchQueue_release_e, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+  success &= touchQueue_testExpect(touchQueue_press_e, 0, 0);
+  success &= touchQueue_testExpect(touchQueue_release_e, 0, 0);
+  touchQueue_reset();
+  printf("touchQueue_runTest %s.\n\r", success ? "passed" : "failed");
+  return success;
+}
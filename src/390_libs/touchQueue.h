@@ -0,0 +1,63 @@
+#ifndef TOUCHQUEUE_H_
+#define TOUCHQUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Touch events for the games, so they no longer poll display_isTouched() and count out the touch
+// controller's settling time in states of their own.
+//
+// touchQueue_service() runs from the timer ISR (isr_function()). Each call drains the STMPE610's sample
+// FIFO in SPI bursts (display_readTouchSamples()), filters the samples and publishes:
+//   press:   once TOUCH_QUEUE_MEDIAN_SIZE samples of a new touch are in (the first ones are the noisiest);
+//   move:    when the filtered point is TOUCH_QUEUE_MOVE_HYSTERESIS pixels or more from the last event's;
+//   release: when the panel is no longer touched and the FIFO is empty, at the last event's point.
+// A touch that ends before it has enough samples for a press is treated as noise and publishes nothing.
+// Each axis is filtered with a running median of the last TOUCH_QUEUE_MEDIAN_SIZE samples, which drops
+// the single-sample spikes of a resistive panel, and mapped to LCD coordinates in fixed point (the same
+// pixel as display_getTouchedPoint(), without its floating-point divides).
+//
+// The events go through an spscRing: the ISR is the producer, and one consumer (a tick function or the
+// main loop) at a time takes them with touchQueue_getEvent() or touchQueue_getPressOrRelease().
+
+#define TOUCH_QUEUE_SIZE 64               // Events that can wait (a power of two).
+#define TOUCH_QUEUE_MEDIAN_SIZE 3         // Samples in the median filter, and samples before a press.
+#define TOUCH_QUEUE_MOVE_HYSTERESIS 3     // Pixels the point must move (in x or y) for a move event.
+#define TOUCH_QUEUE_BURST_SIZE 32         // Most samples read per SPI burst; a fuller FIFO takes several.
+
+typedef enum {
+  touchQueue_press_e,      // A finger is down at (x, y).
+  touchQueue_move_e,       // The finger has moved to (x, y).
+  touchQueue_release_e     // The finger has lifted; (x, y) is where it last was.
+} touchQueue_eventType_t;
+
+typedef struct {
+  touchQueue_eventType_t type;
+  int16_t x, y;            // LCD coordinates, inside the screen.
+  uint8_t z;               // Pressure of the last sample (0 for a release).
+} touchQueue_event_t;
+
+// Call after display_init() and before the ISR starts calling touchQueue_service().
+// Empties the queue and throws away whatever is in the controller's FIFO.
+void touchQueue_init();
+
+// Producer: reads and filters the new samples and publishes the events. Call from the timer ISR.
+void touchQueue_service();
+
+// Consumer: takes the oldest event. Returns false if there is none.
+bool touchQueue_getEvent(touchQueue_event_t* event);
+
+// Consumer: like touchQueue_getEvent(), but skips move events, for games that only act on taps.
+bool touchQueue_getPressOrRelease(touchQueue_event_t* event);
+
+// Consumer: throws away the events waiting, e.g. touches made while a game was not listening.
+void touchQueue_clear();
+
+// Events dropped because the queue was full.
+uint32_t touchQueue_overflowCount();
+
+// Feeds scripted samples through the filter and checks the events and the fixed-point mapping.
+// Does not touch the controller, but leaves the queue empty and the filter reset.
+bool touchQueue_runTest();
+
+#endif /* TOUCHQUEUE_H_ */
@@ -4,11 +4,11 @@
 #include <stdio.h>
 #include "supportFiles/display.h"
 #include "supportFiles/utils.h"
+#include "src/390_libs/touchQueue.h"
 
 
 #define ELAPSED_TICK 1
 #define ELAPSED_SECOND 1000/50 // 1 second: 1000/ Timer Period in ms
-#define ADC_COUNTER_MAX_VALUE 50/50 // 50 ms for the adc: divided by Timer Period in ms
 #define AUTO_COUNTER_MAX_VALUE 500/50 // half a second in ms, used to detect when to start auto-incrementing : divide by Timer Period in ms
 #define RATE_COUNTER_MAX_VALUE 100/50 // 100 ms; every 1 tenth of a second increment the clock during auto-increment : divide by Timer Period in ms
 
@@ -17,7 +17,6 @@ enum clockControl_st_t {
     init_st,                 // Start here, transition out of this state on the first tick.
     never_touched_st,        // Wait here until the first touch - clock is disabled until set.
     waiting_for_touch_st,    // waiting for touch, clock is enabled and running.
-    adc_Counter_running_st,     // waiting for the touch-controller ADC to settle.
     auto_Counter_running_st,   // waiting for the auto-update delay to expire
                              // (user is holding down button for auto-inc/dec)
     rate_Counter_running_st,   // waiting for the rate-timer to expire to know when to perform the auto inc/dec.
@@ -25,12 +24,35 @@ enum clockControl_st_t {
     inc_Second_st
 } currentState;
 
+// The touch as the events from touchQueue have left it. The queue only publishes a press once the
+// touch controller has settled, so there is no ADC counter to run here any more.
+static bool touchDown = false;     // the finger is on the screen
+static bool touchPressed = false;  // a press has come in that the state machine has not acted on yet
+static int16_t touchX, touchY;     // where the finger is (or was last)
+
 // Initialize clockControl currentState
 void clockControl_init() {
     currentState = init_st;
 
 }
 
+// Takes the events that came in since the last tick. A tap can press and release between two ticks,
+// so the press is remembered in touchPressed until a waiting state acts on it.
+static void clockControl_readTouchEvents() {
+    touchQueue_event_t event;
+    while (touchQueue_getEvent(&event)) {
+        if (event.type == touchQueue_press_e)
+        {
+            touchDown = true;
+            touchPressed = true;
+        }
+        else if (event.type == touchQueue_release_e)
+            touchDown = false;
+        touchX = event.x;
+        touchY = event.y;
+    }
+}
+
 void debugStatePrint() {
   static clockControl_st_t previousState;
   static bool firstPass = true;
@@ -50,9 +72,6 @@ void debugStatePrint() {
       case waiting_for_touch_st:
         printf("waiting_for_touch_st\n\r");
         break;
-      case adc_Counter_running_st:
-        printf("adc_Counter_running_st\n\r");
-        break;
       case auto_Counter_running_st:
         printf("auto_Counter_running_st\n\r");
         break;
@@ -76,8 +95,9 @@ void clockControl_tick() {
     //insert start timers here to time tick function
 
 
+    clockControl_readTouchEvents();
+
     //declare counters
-    static uint adcCounter =0;
     static uint autoCounter =0;
     static uint rateCounter =0;
     // Counter to count 1 second of elapsed time
@@ -90,20 +110,23 @@ void clockControl_tick() {
         break;
 
     case never_touched_st:
-        //when display is touched, begin clock by going to waiting_for_touch_st
-        if (display_isTouched())
-            currentState = waiting_for_touch_st;
+        //when display is touched, begin clock; the touch also counts as an inc/dec, as when it goes through waiting_for_touch_st
+        if (touchPressed)
+        {
+            touchPressed = false;
+            currentState = auto_Counter_running_st;
+        }
         else
             currentState = never_touched_st;
         break;
 
 
     case waiting_for_touch_st:
-        // if display is touched, transition to adc_Counter_running_st
-        if (display_isTouched())
+        // if display is touched, transition to auto_Counter_running_st
+        if (touchPressed)
         {
-            display_clearOldTouchData();
-            currentState = adc_Counter_running_st;
+            touchPressed = false;
+            currentState = auto_Counter_running_st;
         }
 
          // if 1 second has elapsed, go to inc_Second_st
@@ -116,26 +139,6 @@ void clockControl_tick() {
             currentState = waiting_for_touch_st;
         break;
 
-    case adc_Counter_running_st:
-        // if finger is released while adc counter is counting, and adc_counter is max, go to wait state and increment touched button
-        if (!display_isTouched() && adcCounter == ADC_COUNTER_MAX_VALUE)
-        {
-            currentState = waiting_for_touch_st;
-            clockDisplay_performIncDec();
-            //reset second Counter
-                     secCounter = 0;
-        }
-         // else if finger is still held down after ADC_MAX go to auto counter state
-        else if (display_isTouched() && adcCounter == ADC_COUNTER_MAX_VALUE)
-        {
-            currentState = auto_Counter_running_st;
-        }
-
-        else
-            // return to current state
-            currentState = adc_Counter_running_st;
-        break;
-
     case inc_Second_st:
         //after actions have completed, go directly back to waiting for touch state
         currentState = waiting_for_touch_st;
@@ -143,18 +146,18 @@ void clockControl_tick() {
 
     case auto_Counter_running_st:
         // if finger is released while auto counter is running (before half a second), go to waiting for touch and increment display
-        if (!display_isTouched())
+        if (!touchDown)
         {
             currentState = waiting_for_touch_st;
-            clockDisplay_performIncDec();
+            clockDisplay_performIncDecAt(touchX, touchY);
             //reset second Counter
              secCounter = 0;
         }
         // if auto_conter running reaches it's max, go to rate counter running
-        else if (display_isTouched() && autoCounter == AUTO_COUNTER_MAX_VALUE)
+        else if (autoCounter == AUTO_COUNTER_MAX_VALUE)
         {
             currentState = rate_Counter_running_st;
-            clockDisplay_performIncDec();
+            clockDisplay_performIncDecAt(touchX, touchY);
         }
 
         else
@@ -164,7 +167,7 @@ void clockControl_tick() {
 
 
     case rate_Counter_running_st:
-        if (!display_isTouched())
+        if (!touchDown)
         {
             // if finger is released, go back to wait state
               currentState = waiting_for_touch_st;
@@ -173,7 +176,7 @@ void clockControl_tick() {
         }
 
         // if after rateCounterMAX, finger is still held down, go to rate counter expired state and update display there
-        else if (display_isTouched() && rateCounter >= RATE_COUNTER_MAX_VALUE - ELAPSED_TICK)
+        else if (rateCounter >= RATE_COUNTER_MAX_VALUE - ELAPSED_TICK)
             currentState = rate_Counter_expired_st;
         else
             // return to current state
@@ -182,7 +185,7 @@ void clockControl_tick() {
 
 
     case rate_Counter_expired_st:
-        if (!display_isTouched())
+        if (!touchDown)
         {
             // if finger is released, go to waiting for touch state instead of back to rate_Counter_running
             currentState = waiting_for_touch_st;
@@ -194,7 +197,7 @@ void clockControl_tick() {
         {
             // return back to rate_Counter_running state and update display
             currentState = rate_Counter_running_st;
-            clockDisplay_performIncDec();
+            clockDisplay_performIncDecAt(touchX, touchY);
         }
         break;
 
@@ -208,7 +211,6 @@ void clockControl_tick() {
     switch (currentState) {
     case init_st:
         //initialize variables
-        adcCounter = 0;
         autoCounter = 0;
         rateCounter = 0;
         secCounter =0;
@@ -218,15 +220,10 @@ void clockControl_tick() {
         break;
     case waiting_for_touch_st:
         //set counters equal to zero
-        adcCounter  = 0;
         autoCounter = 0;
         rateCounter = 0;
         secCounter++;
         break;
-    case adc_Counter_running_st:
-        //increment adc_Counter
-        adcCounter++;
-        break;
     case auto_Counter_running_st:
         //increment autoCounter
         autoCounter++;
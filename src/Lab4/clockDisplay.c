@@ -209,9 +209,11 @@ void clockDisplay_performIncDec()
 
 	//get display touch coordinates:
     display_getTouchedPoint(&x, &y, &z);
+    clockDisplay_performIncDecAt(x, y);
+}
 
-
-
+void clockDisplay_performIncDecAt(int16_t x, int16_t y)
+{
     //find the coordinate based on 6 possible touch locations
 
 	// touch coordinates will be in either 1 of 6 places
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 // Called only once - performs any necessary inits.
 // This is a good place to draw the triangles and any other
@@ -14,6 +15,9 @@ void clockDisplay_updateTimeDisplay(bool forceUpdateAll);
 // depending upon the touched region.
 void clockDisplay_performIncDec();
 
+// Performs the increment or decrement for a touch at (x, y), e.g. from a touchQueue event.
+void clockDisplay_performIncDecAt(int16_t x, int16_t y);
+
 // Advances the time forward by 1 second and update the display.
 void clockDisplay_advanceTimeOneSecond();
 
@@ -11,6 +11,7 @@
 #include "clockControl.h"
 #include "clockDisplay.h"
 #include "supportFiles/display.h"
+#include "src/390_libs/touchQueue.h"
 
 #define TOTAL_SECONDS 60
 // The formula for computing the load value is based upon the formula from 4.1.1 (calculating timer intervals)
@@ -38,6 +39,8 @@ int main()
     interrupts_enableTimerGlobalInts();
     // Initialization of the clock display is not time-dependent, do it outside of the state machine.
     clockDisplay_init();
+    // Touches arrive as events from the ISR from here on.
+    touchQueue_init();
     // Start the private ARM timer running.
     interrupts_startArmPrivateTimer();
     // Enable interrupts at the ARM.
@@ -51,8 +54,10 @@ int main()
     return 0;
 }
 
-// The clockControl_tick() function is now called directly by the timer interrupt service routine.
+// The clockControl_tick() function is now called directly by the timer interrupt service routine,
+// right after the touch samples that came in since the last tick have been turned into events.
 void isr_function() {
+    touchQueue_service();
     clockControl_tick();
    isr_functionCallCount++;
     // Add the necessary code here.
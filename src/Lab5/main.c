@@ -7,6 +7,7 @@
 #include "ticTacToeControl.h"
 #include "minimax.h"
 #include "src/Lab3/intervalTimer.h"
+#include "src/390_libs/touchQueue.h"
 
 #include "xparameters.h"
 
@@ -18,9 +19,14 @@
 #define TIMER_PERIOD 100E-3 // You can change this value to a value that you select.
 #define TIMER_CLOCK_FREQUENCY (XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)
 #define TIMER_LOAD_VALUE ((TIMER_PERIOD * TIMER_CLOCK_FREQUENCY) - 1.0)
+#define RUN_MINIMAX_BENCHMARK // Comment out to start the game without timing minimax first.
 
 int main()
 {
+#ifdef RUN_MINIMAX_BENCHMARK
+    // Uses interval timer 0; done before the game so it does not hold up a tick.
+    minimax_runBenchmark();
+#endif
     // Initialize the GPIO LED driver and print out an error message if it fails (argument = true).
        // You need to init the LEDs so that LD4 can function as a heartbeat.
     leds_init(true);
@@ -35,6 +41,8 @@ int main()
     // Initialization of the clock display is not time-dependent, do it outside of the state machine.
     ticTacToeDisplay_init();
     ticTacToeControl_init();
+    // Touches arrive as events from the ISR from here on.
+    touchQueue_init();
     //clockDisplay_init();
     // Keep track of your personal interrupt count. Want to make sure that you don't miss any interrupts.
      int32_t personalInterruptCount = 0;
@@ -58,6 +66,7 @@ int main()
    printf("internal interrupt count: %ld\n\r", personalInterruptCount);
    return 0;
 }
+// Turns the touch samples that came in since the last tick into events for ticTacToeControl_tick().
 void isr_function() {
-
+    touchQueue_service();
 }
@@ -1,7 +1,9 @@
 #include "minimax.h"
 #include <stdbool.h>
 #include<stdio.h>
+#include <string.h>
 #include "src/Lab3/intervalTimer.h"
+#include "minimaxTable.h"
 #define MAX_TABLE_SIZE 9 // Max array size of move score table
 #define R_0 0  // row 0
 #define R_1 1  // row 1
@@ -12,7 +14,103 @@
 #define STARTING_MIN_SCORE -15 //Arbitrary value that is lower than -10 to record highest score
 #define STARTING_MAX_SCORE 20 // Arbitrary value that is higher than 10 to record lowest score
 
-minimax_move_t choice; // Global choice variable to get the final choice after calling minimax
+// The game minimax.h configures is tic-tac-toe itself: the only one the perfect-play table covers.
+#define IS_TIC_TAC_TOE (MINIMAX_BOARD_ROWS == 3 && MINIMAX_BOARD_COLUMNS == 3 && MINIMAX_WIN_LENGTH == 3)
+#if MINIMAX_BOARD_ROWS * (MINIMAX_BOARD_COLUMNS + 1) > MINIMAX_MAX_BOARD_BITS
+#error "The board does not fit in a minimax bitboard (see MINIMAX_MAX_BOARD_BITS)."
+#endif
+
+// The search works on bitboards: one mask per player, square (row, column) is bit row * stride + column
+// with stride = columns + 1. The spare bit at the end of each row is never set, so a line shifted along a
+// row or a diagonal cannot wrap around into the next row.
+#define MAX_SQUARES MINIMAX_MAX_BOARD_BITS
+#define MAX_WINDOWS (4 * MAX_SQUARES) // Lines of winLength squares: at most one per square and direction
+#define DIRECTION_COUNT 4 // along a row, down a column, and the two diagonals
+#define MAX_WIN_LENGTH 6 // Longest line windowWeights has a weight for
+
+// Search scores. X maximizes and O minimizes, as before, with room between the wins for the heuristic.
+typedef int32_t minimax_value_t;
+#define WIN_VALUE 1000000 // X wins (O's win is the negative), now or later
+#define DRAW_VALUE 0
+#define INFINITE_VALUE (WIN_VALUE + 1)
+
+// Deadline: once every DEADLINE_CHECK_NODES positions the search reads counter 0 of interval timer 1 (the
+// low 32 bits of its cascaded count, which wrap after 42 s at 100 MHz) and compares it with a tick count
+// worked out once per move, instead of converting the count to seconds each time.
+#define DEADLINE_TIMER INTERVAL_TIMER_TIMER_1
+#define DEADLINE_CHECK_NODES 256 // A power of two
+#ifdef MINIMAX_HOST_TEST
+#define DEADLINE_TIMER_HZ 100000000 // As on the board
+static uint32_t readDeadlineTimer(); // From the host stand-ins at the end of the file
+#else
+#include "xparameters.h"
+#include "xil_io.h"
+#define DEADLINE_TIMER_HZ XPAR_AXI_TIMER_1_CLOCK_FREQ_HZ
+#define DEADLINE_TIMER_TCR0_OFFSET 0x08 // Counter 0 register of the AXI timer
+
+static inline uint32_t readDeadlineTimer()
+{
+    return Xil_In32(XPAR_AXI_TIMER_1_BASEADDR + DEADLINE_TIMER_TCR0_OFFSET);
+}
+#endif
+
+// Transposition table: positions already searched, indexed by a multiplicative hash of the two masks and
+// the player to move. A stored score only answers a search at most as deep as the one that stored it, so
+// the table is kept from one move to the next (and cleared when the game changes). On the board it is sized
+// for the game minimax.h configures: for tic-tac-toe the perfect-play table answers every real game and the
+// search only backs it up. The host tests and the benchmark play 4x4 and 5x5 as well.
+#ifdef MINIMAX_HOST_TEST
+#define TABLE_INDEX_BITS 14 // 16384 entries, 256 KB
+#elif MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS <= 9
+#define TABLE_INDEX_BITS 10 // 1024 entries, 16 KB
+#else
+#define TABLE_INDEX_BITS 12 // 4096 entries, 64 KB
+#endif
+#define TABLE_SIZE (1 << TABLE_INDEX_BITS)
+#define TABLE_HASH_X 2654435761u // Knuth's multiplicative hash (2^32 / golden ratio)
+#define TABLE_HASH_O 2246822519u // Another odd multiplier, so the two masks do not cancel out
+#define TABLE_KEY_VALID 0x80000000 // Set in every stored x (never a square), so an empty entry never matches
+#define TABLE_KEY_X_TO_MOVE 0x80000000 // Set in the stored o when X is to move
+#define NO_MOVE 0xFF
+
+// What a stored score means: the value itself, or a bound on it from a search that was cut off.
+enum minimax_bound_t {
+    minimax_exact_e,   // the position's value (at that depth)
+    minimax_lower_e,   // the value is at least the score (a cut-off found a move this good)
+    minimax_upper_e    // the value is at most the score (no move beat alpha)
+};
+
+typedef struct {
+    minimax_mask_t x;        // X's squares and TABLE_KEY_VALID
+    minimax_mask_t o;        // O's squares and TABLE_KEY_X_TO_MOVE
+    minimax_value_t score;
+    uint8_t depth;           // moves searched below the position
+    uint8_t bound;           // minimax_bound_t
+    uint8_t move;            // the best square found (its bit), searched first next time; or NO_MOVE
+} minimax_tableEntry_t;
+
+// The m,n,k-game being searched: the one minimax.h configures, except while the tests and the benchmark
+// play others.
+typedef struct {
+    uint8_t rows, columns, winLength;
+    uint8_t stride;                          // bits per row: columns + 1
+    uint8_t squareCount;
+    minimax_mask_t allSquares;
+    uint8_t shifts[DIRECTION_COUNT];         // from a square to the next one of a line, in each direction
+    uint8_t order[MAX_SQUARES];              // square bits in the order they are tried below the root
+    uint8_t windowCount;
+    minimax_mask_t windows[MAX_WINDOWS];     // every line of winLength squares
+} minimax_game_t;
+
+// Heuristic: a line only one player has squares on is worth 8^(squares - 1) to that player, far below a win.
+static const minimax_value_t windowWeights[MAX_WIN_LENGTH] = {0, 1, 8, 64, 512, 4096};
+
+static minimax_game_t game;
+static minimax_tableEntry_t transpositionTable[TABLE_SIZE];
+static uint32_t nodeCount = 0; // Positions visited by minimax(), for the benchmark
+static uint32_t deadlineTicks = 0; // On DEADLINE_TIMER, or 0 for no deadline
+static bool deadlinePassed = false;
+static bool deadlineTimerReady = false;
 
 void minimax_initBoard(minimax_board_t* board)
 {
@@ -40,198 +138,745 @@ bool minimax_isGameOver(minimax_score_t score)
     return true;
 }
 
+// Sets up the masks of a rows x columns game with winLength in a row, and empties the transposition table.
+// False if the game does not fit the bitboard.
+static bool setGame(uint8_t rows, uint8_t columns, uint8_t winLength)
+{
+    if (rows * (columns + 1) > MINIMAX_MAX_BOARD_BITS || winLength < 2 || winLength > MAX_WIN_LENGTH ||
+        (winLength > rows && winLength > columns))
+        return false;
+    game.rows = rows;
+    game.columns = columns;
+    game.winLength = winLength;
+    game.stride = columns + 1;
+    game.squareCount = rows * columns;
+    game.shifts[0] = 1;                  // along the row
+    game.shifts[1] = game.stride;        // down the column
+    game.shifts[2] = game.stride + 1;    // down and to the right
+    game.shifts[3] = game.stride - 1;    // down and to the left
+    game.allSquares = 0;
+    game.windowCount = 0;
+    // Every line: a first square, and a direction that keeps all winLength squares on the board.
+    const int8_t rowSteps[DIRECTION_COUNT] = {0, 1, 1, 1};
+    const int8_t columnSteps[DIRECTION_COUNT] = {1, 0, 1, -1};
+    for (uint8_t row = 0; row < rows; row++)
+    {
+        for (uint8_t column = 0; column < columns; column++)
+        {
+            game.allSquares |= (minimax_mask_t) 1 << (row * game.stride + column);
+            for (uint8_t d = 0; d < DIRECTION_COUNT; d++)
+            {
+                int8_t lastRow = row + rowSteps[d] * (winLength - 1);
+                int8_t lastColumn = column + columnSteps[d] * (winLength - 1);
+                if (lastRow >= rows || lastColumn < 0 || lastColumn >= columns)
+                    continue;
+                minimax_mask_t window = 0;
+                for (uint8_t i = 0; i < winLength; i++)
+                    window |= (minimax_mask_t) 1 << ((row + rowSteps[d] * i) * game.stride + column + columnSteps[d] * i);
+                game.windows[game.windowCount++] = window;
+            }
+        }
+    }
+    // Move order: the squares on the most lines first (on 3x3 the center, then the corners, then the edges),
+    // so the strong moves come first and alpha-beta cuts off more of the tree. Ties in row-major order.
+    uint8_t linesOn[MAX_SQUARES];
+    uint8_t count = 0;
+    for (uint8_t row = 0; row < rows; row++)
+    {
+        for (uint8_t column = 0; column < columns; column++)
+        {
+            uint8_t bit = row * game.stride + column;
+            uint8_t lines = 0;
+            for (uint8_t w = 0; w < game.windowCount; w++)
+                lines += (game.windows[w] >> bit) & 1;
+            uint8_t i = count++;
+            for (; i > 0 && linesOn[i - 1] < lines; i--)
+            {
+                game.order[i] = game.order[i - 1];
+                linesOn[i] = linesOn[i - 1];
+            }
+            game.order[i] = bit;
+            linesOn[i] = lines;
+        }
+    }
+    memset(transpositionTable, 0, sizeof(transpositionTable));
+    return true;
+}
+
+// Sets up the game minimax.h configures: on first use, and after the tests or the benchmark played others.
+static void useConfiguredGame()
+{
+    if (game.rows != MINIMAX_BOARD_ROWS || game.columns != MINIMAX_BOARD_COLUMNS || game.winLength != MINIMAX_WIN_LENGTH)
+        setGame(MINIMAX_BOARD_ROWS, MINIMAX_BOARD_COLUMNS, MINIMAX_WIN_LENGTH);
+}
+
+// Packs the board into one mask per player.
+static void toMasks(minimax_board_t* board, minimax_mask_t* x, minimax_mask_t* o)
+{
+    *x = 0;
+    *o = 0;
+    for (uint8_t row = 0; row < MINIMAX_BOARD_ROWS; row++)
+    {
+        for (uint8_t column = 0; column < MINIMAX_BOARD_COLUMNS; column++)
+        {
+            minimax_mask_t bit = (minimax_mask_t) 1 << (row * game.stride + column);
+            if (board->squares[row][column] == MINIMAX_X_SQUARE)
+                *x |= bit;
+            else if (board->squares[row][column] == MINIMAX_O_SQUARE)
+                *o |= bit;
+        }
+    }
+}
+
+// True if the player's squares complete a line: a bit only survives winLength - 1 shifts and ANDs in a
+// direction if it starts winLength in a row.
+static bool isWin(minimax_mask_t mask)
+{
+    for (uint8_t d = 0; d < DIRECTION_COUNT; d++)
+    {
+        minimax_mask_t run = mask;
+        for (uint8_t i = 1; i < game.winLength && run; i++)
+            run &= mask >> (i * game.shifts[d]);
+        if (run)
+            return true;
+    }
+    return false;
+}
+
 minimax_score_t minimax_computeBoardScore(minimax_board_t* board, bool player_is_x)
 {
-	// If player is X, Search every possible winning sequence and return X winning score if true
-    if (player_is_x)
+    useConfiguredGame();
+    minimax_mask_t x, o;
+    toMasks(board, &x, &o);
+	// Only the player who moved last can have just won
+    if (player_is_x && isWin(x))
+        return MINIMAX_X_WINNING_SCORE; // X wins
+    if (!player_is_x && isWin(o))
+        return MINIMAX_O_WINNING_SCORE; // O wins
+    // a full board is a draw, otherwise the game goes on
+    return ((x | o) == game.allSquares) ? MINIMAX_DRAW_SCORE : MINIMAX_NOT_ENDGAME;
+}
+
+// Value for X of a position the search stops in before the end: the lines each player can still complete.
+static minimax_value_t evaluate(minimax_mask_t x, minimax_mask_t o)
+{
+    minimax_value_t value = 0;
+    for (uint8_t w = 0; w < game.windowCount; w++)
     {
-        // search for any row sequence
-        if ((board->squares[R_0][C_0] == MINIMAX_X_SQUARE && board->squares[R_0][C_1] == MINIMAX_X_SQUARE && board->squares[R_0][C_2] == MINIMAX_X_SQUARE) ||
-            (board->squares[R_1][C_0] == MINIMAX_X_SQUARE && board->squares[R_1][C_1] == MINIMAX_X_SQUARE && board->squares[R_1][C_2] == MINIMAX_X_SQUARE) ||
-            (board->squares[R_2][C_0] == MINIMAX_X_SQUARE && board->squares[R_2][C_1] == MINIMAX_X_SQUARE && board->squares[R_2][C_2] == MINIMAX_X_SQUARE) ||
-            //search for any column sequence
-            (board->squares[R_0][C_0] == MINIMAX_X_SQUARE && board->squares[R_1][C_0] == MINIMAX_X_SQUARE && board->squares[R_2][C_0] == MINIMAX_X_SQUARE) ||
-            (board->squares[R_0][C_1] == MINIMAX_X_SQUARE && board->squares[R_1][C_1] == MINIMAX_X_SQUARE && board->squares[R_2][C_1] == MINIMAX_X_SQUARE) ||
-            (board->squares[R_0][C_2] == MINIMAX_X_SQUARE && board->squares[R_1][C_2] == MINIMAX_X_SQUARE && board->squares[R_2][C_2] == MINIMAX_X_SQUARE) ||
-            // search diagonal sequences
-            (board->squares[R_0][C_0] == MINIMAX_X_SQUARE && board->squares[R_1][C_1] == MINIMAX_X_SQUARE && board->squares[R_2][C_2] == MINIMAX_X_SQUARE) ||
-            (board->squares[R_2][C_0] == MINIMAX_X_SQUARE && board->squares[R_1][C_1] == MINIMAX_X_SQUARE && board->squares[R_0][C_2] == MINIMAX_X_SQUARE))
-            return MINIMAX_X_WINNING_SCORE; // X wins
+        minimax_mask_t window = game.windows[w];
+        if (!(o & window))
+            value += windowWeights[__builtin_popcount(x & window)];
+        else if (!(x & window))
+            value -= windowWeights[__builtin_popcount(o & window)];
+    }
+    return value;
+}
 
+// Alpha-beta search of the position with x_to_move to play, depth moves deep. X maximizes and O minimizes.
+// Returns the exact value if it lies between alpha and beta; otherwise a bound beyond the one it crossed.
+// Once the deadline has passed it returns at once, with a score the caller throws away.
+static minimax_value_t minimax(minimax_mask_t x, minimax_mask_t o, bool x_to_move, uint8_t depth,
+    minimax_value_t alpha, minimax_value_t beta)
+{
+    if ((++nodeCount & (DEADLINE_CHECK_NODES - 1)) == 0 && deadlineTicks > 0 &&
+        readDeadlineTimer() >= deadlineTicks)
+        deadlinePassed = true;
+    if (deadlinePassed)
+        return DRAW_VALUE;
+    // check score of current board based on who played last
+    if (isWin(x_to_move ? o : x))
+        return x_to_move ? -WIN_VALUE : WIN_VALUE;
+    if ((x | o) == game.allSquares)
+        return DRAW_VALUE;
+    if (depth == 0)
+        return evaluate(x, o);
+
+    // Seen before, at least as deep? An exact score is the answer; a bound is if it falls outside the window.
+    // Otherwise the move that was best then is searched first.
+    minimax_tableEntry_t* entry =
+        &transpositionTable[((x * TABLE_HASH_X) ^ (o * TABLE_HASH_O) ^ x_to_move) >> (32 - TABLE_INDEX_BITS)];
+    minimax_mask_t keyX = x | TABLE_KEY_VALID;
+    minimax_mask_t keyO = o | (x_to_move ? TABLE_KEY_X_TO_MOVE : 0);
+    uint8_t firstMove = NO_MOVE;
+    if (entry->x == keyX && entry->o == keyO)
+    {
+        if (entry->depth >= depth &&
+            (entry->bound == minimax_exact_e ||
+             (entry->bound == minimax_lower_e && entry->score >= beta) ||
+             (entry->bound == minimax_upper_e && entry->score <= alpha)))
+            return entry->score;
+        firstMove = entry->move;
     }
 
-    else // player is O
+    minimax_value_t original_alpha = alpha;
+    minimax_value_t original_beta = beta;
+    minimax_value_t best_score = x_to_move ? -INFINITE_VALUE : INFINITE_VALUE;
+    uint8_t best_move = NO_MOVE;
+    for (int8_t i = (firstMove == NO_MOVE) ? 0 : -1; i < game.squareCount && alpha < beta; i++)
     {
-        // search for any row sequence
-        if ((board->squares[R_0][C_0] == MINIMAX_O_SQUARE && board->squares[R_0][C_1] == MINIMAX_O_SQUARE && board->squares[R_0][C_2] == MINIMAX_O_SQUARE) ||
-			(board->squares[R_1][C_0] == MINIMAX_O_SQUARE && board->squares[R_1][C_1] == MINIMAX_O_SQUARE && board->squares[R_1][C_2] == MINIMAX_O_SQUARE) ||
-			(board->squares[R_2][C_0] == MINIMAX_O_SQUARE && board->squares[R_2][C_1] == MINIMAX_O_SQUARE && board->squares[R_2][C_2] == MINIMAX_O_SQUARE) ||
-			//search for any column sequence
-			(board->squares[R_0][C_0] == MINIMAX_O_SQUARE && board->squares[R_1][C_0] == MINIMAX_O_SQUARE && board->squares[R_2][C_0] == MINIMAX_O_SQUARE) ||
-			(board->squares[R_0][C_1] == MINIMAX_O_SQUARE && board->squares[R_1][C_1] == MINIMAX_O_SQUARE && board->squares[R_2][C_1] == MINIMAX_O_SQUARE) ||
-			(board->squares[R_0][C_2] == MINIMAX_O_SQUARE && board->squares[R_1][C_2] == MINIMAX_O_SQUARE && board->squares[R_2][C_2] == MINIMAX_O_SQUARE) ||
-			// search diagonal sequences
-			(board->squares[R_0][C_0] == MINIMAX_O_SQUARE && board->squares[R_1][C_1] == MINIMAX_O_SQUARE && board->squares[R_2][C_2] == MINIMAX_O_SQUARE) ||
-			(board->squares[R_2][C_0] == MINIMAX_O_SQUARE && board->squares[R_1][C_1] == MINIMAX_O_SQUARE && board->squares[R_0][C_2] == MINIMAX_O_SQUARE))
-			return MINIMAX_O_WINNING_SCORE; // O wins
+        uint8_t bit = (i < 0) ? firstMove : game.order[i];
+        minimax_mask_t square = (minimax_mask_t) 1 << bit;
+        if (((x | o) & square) || (i >= 0 && bit == firstMove))
+            continue;
+        if (x_to_move)
+        {
+            minimax_value_t score = minimax(x | square, o, false, depth - 1, alpha, beta);
+            if (score > best_score)
+            {
+                best_score = score;
+                best_move = bit;
+            }
+            if (score > alpha)
+                alpha = score;
+        }
+        else
+        {
+            minimax_value_t score = minimax(x, o | square, true, depth - 1, alpha, beta);
+            if (score < best_score)
+            {
+                best_score = score;
+                best_move = bit;
+            }
+            if (score < beta)
+                beta = score;
+        }
     }
+    if (deadlinePassed)
+        return DRAW_VALUE;
+
+    // Always replace: the newest position is the likeliest to come up again.
+    entry->x = keyX;
+    entry->o = keyO;
+    entry->score = best_score;
+    entry->depth = depth;
+    entry->move = best_move;
+    if (best_score <= original_alpha)
+        entry->bound = minimax_upper_e;
+    else if (best_score >= original_beta)
+        entry->bound = minimax_lower_e;
+    else
+        entry->bound = minimax_exact_e;
+    return best_score;
+}
+
+// Iterative deepening: searches one move deep, then two, and so on to the end of the game, until
+// budgetSeconds (0 for no limit) runs out; the move is the one of the deepest search that finished.
+// Each search tries the squares at the root in row-major order, each with a window that only lets a strictly
+// better score through, so once it reaches the end of the game it picks, among equally good moves, the same
+// one as the full-tree search always did.
+static uint8_t searchMove(minimax_mask_t x, minimax_mask_t o, bool x_to_move, double budgetSeconds,
+    minimax_searchStatistics_t* statistics)
+{
+    nodeCount = 0;
+    deadlinePassed = false;
+    deadlineTicks = (uint32_t) (budgetSeconds * DEADLINE_TIMER_HZ);
+    if (budgetSeconds > 0)
+    {
+        if (!deadlineTimerReady)
+            deadlineTimerReady = (intervalTimer_init(DEADLINE_TIMER) == INTERVAL_TIMER_STATUS_OK);
+        intervalTimer_reset(DEADLINE_TIMER);
+        intervalTimer_start(DEADLINE_TIMER);
+    }
+    uint8_t emptyCount = game.squareCount - __builtin_popcount(x | o);
+    uint8_t choice = NO_MOVE;
+    uint8_t depthReached = 0;
+    for (uint8_t depth = 1; depth <= emptyCount && !deadlinePassed; depth++)
+    {
+        minimax_value_t best_score = x_to_move ? -INFINITE_VALUE : INFINITE_VALUE;
+        uint8_t depthChoice = NO_MOVE;
+        for (uint8_t row = 0; row < game.rows; row++)
+        {
+            for (uint8_t column = 0; column < game.columns; column++)
+            {
+                uint8_t bit = row * game.stride + column;
+                minimax_mask_t square = (minimax_mask_t) 1 << bit;
+                if ((x | o) & square)
+                    continue;
+                minimax_value_t score;
+                if (x_to_move)
+                    score = minimax(x | square, o, false, depth - 1, best_score, INFINITE_VALUE);
+                else
+                    score = minimax(x, o | square, true, depth - 1, -INFINITE_VALUE, best_score);
+                if (x_to_move ? (score > best_score) : (score < best_score))
+                {
+                    best_score = score;
+                    depthChoice = bit;
+                }
+            }
+        }
+        if (!deadlinePassed)
+        {
+            choice = depthChoice;
+            depthReached = depth;
+        }
+    }
+    if (budgetSeconds > 0)
+        intervalTimer_stop(DEADLINE_TIMER);
+    // Not even one move deep in time (or no square left): the first empty square, so the game goes on.
+    for (uint8_t bit = 0; choice == NO_MOVE && bit < game.rows * game.stride; bit++)
+    {
+        if ((game.allSquares & ~(x | o)) & ((minimax_mask_t) 1 << bit))
+            choice = bit;
+    }
+    if (statistics)
+    {
+        statistics->nodes = nodeCount;
+        statistics->depth = depthReached;
+        statistics->solved = (depthReached == emptyCount);
+    }
+    return choice;
+}
+
+void minimax_searchNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* row, uint8_t* column)
+{
+    useConfiguredGame();
+    minimax_mask_t x, o;
+    toMasks(board, &x, &o);
+    uint8_t bit = searchMove(x, o, current_player_is_x, MINIMAX_SEARCH_BUDGET_MS / 1000.0, NULL);
+    *row = bit / game.stride;
+    *column = bit % game.stride;
+}
+
+// Finds the move in the perfect-play table (see minimaxTable.h): the board's canonical index, a binary search,
+// and the move mapped back from the canonical board. False if the position is not in the table, i.e. it is
+// over, not legal, or current_player_is_x is not the player the board says is to move; always false for
+// any game but tic-tac-toe.
+static bool lookUpNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* square)
+{
+#if IS_TIC_TAC_TOE
+    uint8_t squares[MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS];
+    int8_t balance = 0; // X squares minus O squares
+    for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS; i++)
+    {
+        squares[i] = board->squares[i / MINIMAX_BOARD_COLUMNS][i % MINIMAX_BOARD_COLUMNS];
+        balance += (squares[i] == MINIMAX_X_SQUARE) - (squares[i] == MINIMAX_O_SQUARE);
+    }
+    if (balance != (current_player_is_x ? 0 : 1))
+        return false;
+    // Canonical index: the smallest index over the symmetries (digits from the last square down).
+    uint16_t key = UINT16_MAX;
+    uint8_t symmetry = 0;
+    for (uint8_t s = 0; s < MINIMAX_TABLE_SYMMETRY_COUNT; s++)
+    {
+        uint16_t index = 0;
+        for (int8_t i = MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS - 1; i >= 0; i--)
+            index = index * 3 + squares[minimaxTable_symmetries[s][i]];
+        if (index < key)
+        {
+            key = index;
+            symmetry = s;
+        }
+    }
+    uint16_t low = 0, high = minimaxTable_positionCount;
+    while (low < high)
+    {
+        uint16_t middle = (low + high) / 2;
+        if (minimaxTable_positions[middle] < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == minimaxTable_positionCount || minimaxTable_positions[low] != key)
+        return false;
+    *square = minimaxTable_symmetries[symmetry][minimaxTable_moves[low]];
+    return true;
+#else
+    (void) board;
+    (void) current_player_is_x;
+    (void) square;
+    return false;
+#endif
+}
 
+// One lookup for every position a game of tic-tac-toe can reach; the search (within its budget) for
+// anything else, including every position of a larger game.
+void minimax_computeNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* row, uint8_t* column)
+{
+    uint8_t square;
+    if (!lookUpNextMove(board, current_player_is_x, &square))
+    {
+        minimax_searchNextMove(board, current_player_is_x, row, column);
+        return;
+    }
+    *row = square / MINIMAX_BOARD_COLUMNS;
+    *column = square % MINIMAX_BOARD_COLUMNS;
+}
+
+//Print board routine
+void printboard(minimax_board_t* board)
+{
+	//For all rows and columns
+    for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS; i++)
+    {
+        for (uint8_t j = 0; j < MINIMAX_BOARD_COLUMNS; j++)
+        {
+			//Print an X or an O to the console
+            if (board->squares[i][j] == MINIMAX_X_SQUARE)
+                printf("X");
+            else if (board->squares[i][j] == MINIMAX_O_SQUARE)
+                printf("O");
+            else
+                printf(" ");
+        }
+        printf("\n");
+    }
+
+}
+
+/******************************************************************************************
+ ************************************** Test code ******************************************
+ ******************************************************************************************/
+
+#define BENCHMARK_TIMER INTERVAL_TIMER_TIMER_0
+#define TACTIC_BUDGET_SECONDS 0.1 // Plenty for the few moves ahead a tactic needs, on any board
+
+// A position on a board of its own (rows of 'X', 'O' and '.') and the square the player to move must take.
+typedef struct {
+    uint8_t rows, columns, winLength;
+    const char* squares;
+    bool x_to_move;
+    uint8_t row, column;
+} minimax_tactic_t;
+
+static const minimax_tactic_t tactics[] = {
+    {4, 4, 3, "XX.." "OO.." "...." "....", true, 0, 2},                   // X completes 3 before O can
+    {4, 4, 4, "XXX." "OO.." "...." "....", false, 0, 3},                  // O blocks 4 in a row
+    {4, 4, 4, "O..X" "O.X." "...." "XO..", false, 2, 1},                  // O blocks the diagonal
+    {5, 5, 4, "....." "OXXX." ".O..." "....." ".....", false, 1, 4},      // O blocks the open end
+    {5, 5, 4, "....." ".XXX." "OOO.." "....." ".....", true, 1, 0},       // X wins (or at 1,4) before O can
+};
+#define TACTIC_COUNT (sizeof(tactics) / sizeof(tactics[0]))
+
+// The search, within TACTIC_BUDGET_SECONDS, plays each tactic's square, or another one that wins at once
+// if that one does.
+static uint32_t testTactics()
+{
+    uint32_t errors = 0;
+    for (uint8_t t = 0; t < TACTIC_COUNT; t++)
+    {
+        const minimax_tactic_t* tactic = &tactics[t];
+        setGame(tactic->rows, tactic->columns, tactic->winLength);
+        minimax_mask_t x = 0, o = 0;
+        for (uint8_t i = 0; i < game.squareCount; i++)
+        {
+            minimax_mask_t bit = (minimax_mask_t) 1 << ((i / game.columns) * game.stride + i % game.columns);
+            if (tactic->squares[i] == 'X')
+                x |= bit;
+            else if (tactic->squares[i] == 'O')
+                o |= bit;
+        }
+        minimax_mask_t player = tactic->x_to_move ? x : o;
+        minimax_mask_t expected = (minimax_mask_t) 1 << (tactic->row * game.stride + tactic->column);
+        minimax_searchStatistics_t statistics;
+        uint8_t bit = searchMove(x, o, tactic->x_to_move, TACTIC_BUDGET_SECONDS, &statistics);
+        uint8_t row = bit / game.stride, column = bit % game.stride;
+        bool winsToo = isWin(player | expected) && isWin(player | ((minimax_mask_t) 1 << bit));
+        if ((row != tactic->row || column != tactic->column) && !winsToo)
+        {
+            errors++;
+            printf("minimax_runTest: %dx%d, %d in a row: %c plays %d,%d instead of %d,%d (%d moves deep).\n\r",
+                tactic->rows, tactic->columns, tactic->winLength, tactic->x_to_move ? 'X' : 'O', row, column,
+                tactic->row, tactic->column, statistics.depth);
+        }
+    }
+    printf("minimax_runTest: %lu tactics, %lu missed.\n\r", (unsigned long) TACTIC_COUNT, (unsigned long) errors);
+    useConfiguredGame();
+    return errors;
+}
+
+#if IS_TIC_TAC_TOE
+// The full-tree search this file used to run, kept as the reference the new one must agree with.
+#define POSITION_COUNT 19683 // 3^9 ways to fill the squares
+
+static minimax_move_t referenceChoice; // The reference's move, set by its top-level call (which returns last)
+static uint32_t referenceNodeCount = 0;
+
+static minimax_score_t referenceBoardScore(minimax_board_t* board, bool player_is_x)
+{
+    uint8_t player = player_is_x ? MINIMAX_X_SQUARE : MINIMAX_O_SQUARE;
+    // search every row, column and diagonal for the player that moved last
+    if ((board->squares[R_0][C_0] == player && board->squares[R_0][C_1] == player && board->squares[R_0][C_2] == player) ||
+        (board->squares[R_1][C_0] == player && board->squares[R_1][C_1] == player && board->squares[R_1][C_2] == player) ||
+        (board->squares[R_2][C_0] == player && board->squares[R_2][C_1] == player && board->squares[R_2][C_2] == player) ||
+        (board->squares[R_0][C_0] == player && board->squares[R_1][C_0] == player && board->squares[R_2][C_0] == player) ||
+        (board->squares[R_0][C_1] == player && board->squares[R_1][C_1] == player && board->squares[R_2][C_1] == player) ||
+        (board->squares[R_0][C_2] == player && board->squares[R_1][C_2] == player && board->squares[R_2][C_2] == player) ||
+        (board->squares[R_0][C_0] == player && board->squares[R_1][C_1] == player && board->squares[R_2][C_2] == player) ||
+        (board->squares[R_2][C_0] == player && board->squares[R_1][C_1] == player && board->squares[R_0][C_2] == player))
+        return player_is_x ? MINIMAX_X_WINNING_SCORE : MINIMAX_O_WINNING_SCORE;
     // check to see if board is full:
     for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS; i++)
     {
         for (uint8_t k = 0; k < MINIMAX_BOARD_COLUMNS; k++)
         {
             if (board->squares[i][k] == MINIMAX_EMPTY_SQUARE)
-                // game is not over
                 return MINIMAX_NOT_ENDGAME;
         }
     }
-
-    // game is a draw
     return MINIMAX_DRAW_SCORE;
-
-
 }
 
-minimax_score_t minimax(minimax_board_t* board, bool current_player_is_x)
+static minimax_score_t referenceMinimax(minimax_board_t* board, bool current_player_is_x)
 {
-    
-
-    // check score of current board based on who played last
-    minimax_score_t current_score = minimax_computeBoardScore(board, !current_player_is_x);
-    // if game is over return to parent caller the score of the player who originally made the move
+    referenceNodeCount++;
+    minimax_score_t current_score = referenceBoardScore(board, !current_player_is_x);
     if (minimax_isGameOver(current_score))
         return current_score;
-
-    //game is not over, recurse:
-    // initialize move-score table with two arrays
-    //move array
+    // move-score table
     minimax_move_t moves[MAX_TABLE_SIZE];
-    //score array
     minimax_score_t scores[MAX_TABLE_SIZE];
     int16_t move_score_table_size = 0;
-	// For all rows and columns:
     for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS; i++)
     {
         for (uint8_t k = 0; k < MINIMAX_BOARD_COLUMNS; k++)
         {
             if (board->squares[i][k] == MINIMAX_EMPTY_SQUARE)
             {
-                // make move based on who's playing
-                if (current_player_is_x)
-                    board->squares[i][k] = MINIMAX_X_SQUARE;
-                else
-                    board->squares[i][k] = MINIMAX_O_SQUARE;
-				// recursively call minimax from the opponents' possible moves
-                current_score = minimax(board, !current_player_is_x);
-                //add score to scores table
-                scores[move_score_table_size] = current_score;
-                //add move to moves table
+                board->squares[i][k] = current_player_is_x ? MINIMAX_X_SQUARE : MINIMAX_O_SQUARE;
+                scores[move_score_table_size] = referenceMinimax(board, !current_player_is_x);
                 moves[move_score_table_size].row = i;
                 moves[move_score_table_size].column = k;
-                //increment table size variable:
                 move_score_table_size++;
-                //return square to empty
                 board->squares[i][k] = MINIMAX_EMPTY_SQUARE;
             }
-
         }
     }
-
-    // return final score depending on which player is playing:
-    //declare two variable to keep track of largest score in move-score table
-    // x_score is initialized to -15 to keep track of largest value
-    // y_score is initialized to 20 to keep track of smallest value
-    minimax_score_t x_score = STARTING_MIN_SCORE;
-    minimax_score_t y_score = STARTING_MAX_SCORE;
-    if (current_player_is_x)
+    // the first best score in the table wins
+    minimax_score_t best_score = current_player_is_x ? STARTING_MIN_SCORE : STARTING_MAX_SCORE;
+    for (uint8_t j = 0; j < move_score_table_size; j++)
     {
-        for (uint8_t j = 0; j < move_score_table_size; j++)
+        if (current_player_is_x ? (scores[j] > best_score) : (scores[j] < best_score))
         {
-            if (scores[j] > x_score)
-            {
-                // record highest score
-                x_score = scores[j];
-                //update choice variable
-                choice.row = moves[j].row;
-                choice.column = moves[j].column;
-                // update current score
-                current_score = x_score;
-            }
-
+            best_score = scores[j];
+            referenceChoice = moves[j];
         }
+    }
+    return best_score;
+}
 
+// Fills the board from a base-3 position number (digit = square value), true if it is a legal position
+// that is not over yet (X moves first, so X has as many squares as O or one more).
+static bool positionToBoard(uint32_t position, minimax_board_t* board, bool* x_to_move)
+{
+    int8_t balance = 0; // X squares minus O squares
+    for (uint8_t square = 0; square < MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS; square++, position /= 3)
+    {
+        uint8_t value = position % 3;
+        board->squares[square / MINIMAX_BOARD_COLUMNS][square % MINIMAX_BOARD_COLUMNS] = value;
+        balance += (value == MINIMAX_X_SQUARE) - (value == MINIMAX_O_SQUARE);
     }
+    if (balance != 0 && balance != 1)
+        return false;
+    *x_to_move = (balance == 0);
+    return !minimax_isGameOver(minimax_computeBoardScore(board, true)) &&
+        !minimax_isGameOver(minimax_computeBoardScore(board, false));
+}
 
-    else
+// Value of the position for the player to move, by the search run to the end of the game (X maximizes).
+static minimax_value_t searchValue(minimax_board_t* board, bool x_to_move)
+{
+    minimax_mask_t x, o;
+    toMasks(board, &x, &o);
+    deadlineTicks = 0;
+    deadlinePassed = false;
+    return minimax(x, o, x_to_move, game.squareCount, -INFINITE_VALUE, INFINITE_VALUE);
+}
+
+// Every legal position still in play, for the player to move: the search, with no deadline, plays the same
+// square as the reference, and the table's move keeps the value the search gives the position.
+static uint32_t testTicTacToe()
+{
+    uint32_t positions = 0;
+    uint32_t errors = 0;
+    uint32_t tableErrors = 0;
+    uint32_t sameSquare = 0;
+    minimax_board_t board;
+    bool x_to_move;
+    for (uint32_t position = 0; position < POSITION_COUNT; position++)
     {
-        for (uint8_t n = 0; n < move_score_table_size; n++)
+        if (!positionToBoard(position, &board, &x_to_move))
+            continue;
+        positions++;
+        minimax_mask_t x, o;
+        toMasks(&board, &x, &o);
+        uint8_t bit = searchMove(x, o, x_to_move, 0, NULL);
+        uint8_t row = bit / game.stride, column = bit % game.stride;
+        referenceMinimax(&board, x_to_move);
+        if (row != referenceChoice.row || column != referenceChoice.column)
         {
-            if (scores[n] < y_score)
+            if (errors++ == 0)
             {
-                // record lowest score
-                y_score = scores[n];
-                //update choice variable
-                choice.row = moves[n].row;
-                choice.column = moves[n].column;
-                //update current score
-                current_score = y_score;
+                printf("minimax_runTest: %c to move plays %d,%d instead of %d,%d on\n", x_to_move ? 'X' : 'O', row, column,
+                    referenceChoice.row, referenceChoice.column);
+                printboard(&board);
             }
-
         }
-
+        uint8_t square;
+        bool found = lookUpNextMove(&board, x_to_move, &square);
+        uint8_t tableRow = square / MINIMAX_BOARD_COLUMNS, tableColumn = square % MINIMAX_BOARD_COLUMNS;
+        bool valid = found && board.squares[tableRow][tableColumn] == MINIMAX_EMPTY_SQUARE;
+        if (valid)
+        {
+            minimax_value_t value = searchValue(&board, x_to_move);
+            board.squares[tableRow][tableColumn] = x_to_move ? MINIMAX_X_SQUARE : MINIMAX_O_SQUARE;
+            valid = (searchValue(&board, !x_to_move) == value);
+            board.squares[tableRow][tableColumn] = MINIMAX_EMPTY_SQUARE;
+            sameSquare += (tableRow == row && tableColumn == column);
+        }
+        if (!valid && tableErrors++ == 0)
+        {
+            printf("minimax_runTest: the table %s for %c on\n", found ? "has a losing or taken square" : "has no move",
+                x_to_move ? 'X' : 'O');
+            printboard(&board);
+        }
     }
+    printf("minimax_runTest: %lu positions, %lu moves unlike the full search, %lu table moves worse than the search's "
+        "(%lu the same square).\n\r", (unsigned long) positions, (unsigned long) errors,
+        (unsigned long) tableErrors, (unsigned long) sameSquare);
+    return errors + tableErrors;
+}
+#endif
+
+bool minimax_runTest()
+{
+    uint32_t errors = testTactics();
+#if IS_TIC_TAC_TOE
+    errors += testTicTacToe();
+#endif
+    printf("minimax_runTest %s.\n\r", errors ? "failed" : "passed");
+    return errors == 0;
+}
 
-    return current_score;
+#if IS_TIC_TAC_TOE
+// How benchmarkMove() finds the move.
+enum minimax_benchmark_t {
+    minimax_fullTree_e,   // the full-tree search this file used to run
+    minimax_search_e,     // the search, to the end of the game
+    minimax_lookUp_e      // minimax_computeNextMove(): the perfect-play table
+};
 
+// Times one move with the interval timer; returns seconds and the positions searched.
+static double benchmarkMove(minimax_board_t* board, bool x_to_move, minimax_benchmark_t how, uint32_t* nodes)
+{
+    uint8_t row, column;
+    minimax_mask_t x, o;
+    toMasks(board, &x, &o);
+    nodeCount = 0;
+    referenceNodeCount = 0;
+    intervalTimer_reset(BENCHMARK_TIMER);
+    intervalTimer_start(BENCHMARK_TIMER);
+    if (how == minimax_fullTree_e)
+        referenceMinimax(board, x_to_move);
+    else if (how == minimax_search_e)
+        searchMove(x, o, x_to_move, 0, NULL);
+    else
+        minimax_computeNextMove(board, x_to_move, &row, &column);
+    intervalTimer_stop(BENCHMARK_TIMER);
+    *nodes = (how == minimax_fullTree_e) ? referenceNodeCount : nodeCount;
+    return intervalTimer_getTotalDurationInSeconds(BENCHMARK_TIMER);
 }
 
-void minimax_computeNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* row, uint8_t* column)
+// The empty board, and the reply to a corner: the deepest searches a game asks for.
+static void benchmarkTicTacToe()
 {
+    minimax_board_t boards[2];
+    minimax_initBoard(&boards[0]);
+    minimax_initBoard(&boards[1]);
+    boards[1].squares[R_0][C_0] = MINIMAX_X_SQUARE;
+    const char* names[2] = {"empty board, X to move", "X in a corner, O to move"};
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        uint32_t referenceNodes, nodes, warmNodes, lookUpNodes;
+        double referenceSeconds = benchmarkMove(&boards[i], i == 0, minimax_fullTree_e, &referenceNodes);
+        memset(transpositionTable, 0, sizeof(transpositionTable)); // a cold table, as on the first move of the first game
+        double seconds = benchmarkMove(&boards[i], i == 0, minimax_search_e, &nodes);
+        double warmSeconds = benchmarkMove(&boards[i], i == 0, minimax_search_e, &warmNodes);
+        double lookUpSeconds = benchmarkMove(&boards[i], i == 0, minimax_lookUp_e, &lookUpNodes);
+        printf("minimax %s: full tree %lu nodes %.3f ms, alpha-beta %lu nodes %.3f ms (%lu nodes %.3f ms with the "
+            "transposition table warm), table lookup %lu nodes %.4f ms.\n\r", names[i], (unsigned long) referenceNodes,
+            referenceSeconds * 1000, (unsigned long) nodes, seconds * 1000, (unsigned long) warmNodes, warmSeconds * 1000,
+            (unsigned long) lookUpNodes, lookUpSeconds * 1000);
+    }
+}
+#endif
 
-	// If board is empty, minimax should not run to save time.
-	
-	//Check for an occupied square before calling minimax:
-    for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS; i++)
+// The first move of each game under each budget, from an empty transposition table: how many moves ahead
+// the iterative deepening gets, and how fast it visits positions.
+static void benchmarkBudgets()
+{
+    static const uint8_t games[][3] = {{3, 3, 3}, {4, 4, 3}, {4, 4, 4}, {5, 5, 4}}; // rows, columns, in a row
+    static const uint16_t budgetsMs[] = {10, 40, 100};
+    for (uint8_t g = 0; g < sizeof(games) / sizeof(games[0]); g++)
+    {
+        for (uint8_t b = 0; b < sizeof(budgetsMs) / sizeof(budgetsMs[0]); b++)
         {
-            for (uint8_t j = 0; j < MINIMAX_BOARD_COLUMNS; j++)
-            {
-               if (board->squares[i][j] != MINIMAX_EMPTY_SQUARE)
-               {
-                   minimax(board, current_player_is_x);
-                   *row = choice.row;
-                   *column = choice.column;
-                  return;
-               }
-
-            }
-
+            setGame(games[g][0], games[g][1], games[g][2]);
+            minimax_searchStatistics_t statistics;
+            intervalTimer_reset(BENCHMARK_TIMER);
+            intervalTimer_start(BENCHMARK_TIMER);
+            uint8_t bit = searchMove(0, 0, true, budgetsMs[b] / 1000.0, &statistics);
+            intervalTimer_stop(BENCHMARK_TIMER);
+            double seconds = intervalTimer_getTotalDurationInSeconds(BENCHMARK_TIMER);
+            printf("minimax %dx%d, %d in a row, %3d ms budget: %2d moves deep%s, %7lu nodes in %6.2f ms, "
+                "%6.0f k nodes/s, plays %d,%d.\n\r", games[g][0], games[g][1], games[g][2], budgetsMs[b],
+                statistics.depth, statistics.solved ? " (solved)" : "", (unsigned long) statistics.nodes,
+                seconds * 1000, statistics.nodes / seconds / 1000, bit / game.stride, bit % game.stride);
         }
+    }
+    useConfiguredGame();
+}
+
+void minimax_runBenchmark()
+{
+    intervalTimer_init(BENCHMARK_TIMER);
+    useConfiguredGame();
+#if IS_TIC_TAC_TOE
+    benchmarkTicTacToe();
+#endif
+    benchmarkBudgets();
+}
 
-    // board is empty, choose top left as move.
-    *row = 0;
-    *column = 0;
+#ifdef MINIMAX_HOST_TEST
+#include <time.h>
 
+// The Lab3 interval timers on the host, from the monotonic clock. Like the hardware ones, they can be read
+// while they run (the deadline needs that).
+static struct timespec hostTimerStart[INTERVAL_TIMER_TIMER_2 + 1];
+static double hostTimerSeconds[INTERVAL_TIMER_TIMER_2 + 1];
+static bool hostTimerRunning[INTERVAL_TIMER_TIMER_2 + 1];
 
+static double hostTimerRunSeconds(uint32_t timerNumber)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - hostTimerStart[timerNumber].tv_sec) + (now.tv_nsec - hostTimerStart[timerNumber].tv_nsec) * 1e-9;
 }
 
-//Print board routine
-void printboard(minimax_board_t* board)
+intervalTimer_status_t intervalTimer_init(uint32_t) { return INTERVAL_TIMER_STATUS_OK; }
+void intervalTimer_reset(uint32_t timerNumber) { hostTimerSeconds[timerNumber] = 0; }
+void intervalTimer_start(uint32_t timerNumber)
 {
-	//For all rows and columns
-    for (uint8_t i = 0; i < MINIMAX_BOARD_ROWS; i++)
-    {
-        for (uint8_t j = 0; j < MINIMAX_BOARD_COLUMNS; j++)
-        {
-			//Print an X or an O to the console
-            if (board->squares[i][j] == MINIMAX_X_SQUARE)
-                printf("X");
-            else if (board->squares[i][j] == MINIMAX_O_SQUARE)
-                printf("O");
-            else
-                printf(" "); 
-        }
-        printf("\n");
-    }
+    clock_gettime(CLOCK_MONOTONIC, &hostTimerStart[timerNumber]);
+    hostTimerRunning[timerNumber] = true;
+}
+void intervalTimer_stop(uint32_t timerNumber)
+{
+    hostTimerSeconds[timerNumber] += hostTimerRunSeconds(timerNumber);
+    hostTimerRunning[timerNumber] = false;
+}
+double intervalTimer_getTotalDurationInSeconds(uint32_t timerNumber)
+{
+    return hostTimerSeconds[timerNumber] + (hostTimerRunning[timerNumber] ? hostTimerRunSeconds(timerNumber) : 0);
+}
+static uint32_t readDeadlineTimer()
+{
+    return (uint32_t) (intervalTimer_getTotalDurationInSeconds(DEADLINE_TIMER) * DEADLINE_TIMER_HZ);
+}
 
+int main()
+{
+    bool success = minimax_runTest();
+    minimax_runBenchmark();
+    return success ? 0 : 1;
 }
+#endif
@@ -1,7 +1,25 @@
 #include <stdint.h>
-// Defines the boundaries of the tic-tac-toe board.
+// Defines the boundaries of the tic-tac-toe board, and how many in a row win. Any m,n,k-game that fits a
+// bitboard (MINIMAX_MAX_BOARD_BITS) can be built instead with -D, e.g. 4x4 with 4 in a row; the display
+// and the perfect-play table are for 3x3 with 3 in a row, and other games always go to the search.
+#ifndef MINIMAX_BOARD_ROWS
 #define MINIMAX_BOARD_ROWS 3
+#endif
+#ifndef MINIMAX_BOARD_COLUMNS
 #define MINIMAX_BOARD_COLUMNS 3
+#endif
+#ifndef MINIMAX_WIN_LENGTH
+#define MINIMAX_WIN_LENGTH 3
+#endif
+
+// A board is two masks of MINIMAX_BOARD_ROWS * (MINIMAX_BOARD_COLUMNS + 1) bits (5x5 takes 30).
+#define MINIMAX_MAX_BOARD_BITS 31
+
+// Time the search may take for one move, read from interval timer 1. Well inside the 100 ms tick of the
+// Lab5 main, so ticTacToeControl_tick() never runs into the next tick.
+#ifndef MINIMAX_SEARCH_BUDGET_MS
+#define MINIMAX_SEARCH_BUDGET_MS 40
+#endif
 
 // These are the values in the board to represent who is occupying what square.
 #define MINIMAX_X_SQUARE 2    // player-square means X occupies the square.
@@ -33,6 +51,16 @@ typedef struct {
 // Define a score type.
 typedef int16_t minimax_score_t;
 
+// One bit per square, for each player.
+typedef uint32_t minimax_mask_t;
+
+// What one search did.
+typedef struct {
+    uint32_t nodes;    // positions visited
+    uint8_t depth;     // moves ahead of the last search that finished
+    bool solved;       // that search reached the end of the game, so the move is a perfect one
+} minimax_searchStatistics_t;
+
 // This routine is not recursive but will invoke the recursive minimax function.
 // You will call this function from the controlling state machine that you will implement in a later milestone.
 // It computes the row and column of the next move based upon:
@@ -44,8 +72,17 @@ typedef int16_t minimax_score_t;
 // minimax_computeNextMove directly passes the current_player_is_x argument into the minimax() (helper) function.
 // To assign values to the row and column arguments, you must use the following syntax in the body of the function:
 // *row = move_row; *column = move_column; (for example).
+// The move comes from the perfect-play table (minimaxTable.h): a lookup instead of a search. It keeps the
+// position's value, as the search would, though among equally good squares it may pick another one.
+// Positions that are not in the table (a board no game reaches) go to minimax_searchNextMove().
 void minimax_computeNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* row, uint8_t* column);
 
+// The alpha-beta search the table was checked against: the same arguments, and among equally good moves
+// the first in row-major order. Searches one move deeper at a time until the end of the game or
+// MINIMAX_SEARCH_BUDGET_MS, and plays the move of the deepest search that finished; positions it stops
+// in before the end are scored by the lines each player could still complete.
+void minimax_searchNextMove(minimax_board_t* board, bool current_player_is_x, uint8_t* row, uint8_t* column);
+
 // Determine that the game is over by looking at the score.
 bool minimax_isGameOver(minimax_score_t score);
 
@@ -62,3 +99,16 @@ minimax_score_t minimax_computeBoardScore(minimax_board_t* board, bool player_is
 
 // Init the board to all empty squares.
 void minimax_initBoard(minimax_board_t* board);
+
+// Checks that the search takes an immediate win and blocks an immediate loss on 4x4 and 5x5 boards. For
+// tic-tac-toe, also on every legal position that is still in play (4520), for the player to move: that the
+// search, run to the end of the game, picks the same square as the plain full-tree search, and that the
+// table's move keeps the value the search gives the position. Takes a while on the board; on the host:
+//   g++ -x c++ -O2 -I. -DMINIMAX_HOST_TEST src/Lab5/minimax.c src/Lab5/minimaxTable.c
+bool minimax_runTest();
+
+// Times the move on the empty board and on the reply to a corner with interval timer 0: the full-tree
+// search that was replaced, the alpha-beta search and the table lookup, with the positions each visits.
+// Then the first move of 3x3, 4x4 and 5x5 games under budgets of 10, 40 and 100 ms: the depth reached,
+// the positions visited and how many per second.
+void minimax_runBenchmark();
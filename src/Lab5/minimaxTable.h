@@ -0,0 +1,38 @@
+#ifndef MINIMAXTABLE_H_
+#define MINIMAXTABLE_H_
+
+#include <stdint.h>
+
+// The perfect-play table minimax_computeNextMove() looks moves up in. minimaxTable.c is generated by
+// tools/minimaxTable/minimaxTable.c, which solves the game; minimax_runTest() checks it against the search.
+//
+// A position's index is the sum over squares of value * 3^square, with the values of minimax.h
+// (empty 0, O 1, X 2) and square = row * 3 + column. The 8 symmetries of the board map a position onto
+// 8 (not always different) boards; the table holds one entry per class, under the smallest of their indexes
+// (the canonical index), for every legal position that is not over. The player to move follows from the
+// board: X if both have as many squares, O if X has one more.
+//
+// minimaxTable_positions[] holds the canonical indexes in ascending order (for a binary search), and
+// minimaxTable_moves[] the square to play on the canonical board. Symmetry s takes square
+// minimaxTable_symmetries[s][i] of a board to square i of its image, so if the canonical board is the image
+// under s, the move on the board itself is minimaxTable_symmetries[s][move].
+
+#define MINIMAX_TABLE_SYMMETRY_COUNT 8
+
+// Identity, three rotations, two mirrors and two diagonal flips.
+static const uint8_t minimaxTable_symmetries[MINIMAX_TABLE_SYMMETRY_COUNT][9] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8},   // identity
+    {6, 3, 0, 7, 4, 1, 8, 5, 2},   // quarter turn clockwise
+    {8, 7, 6, 5, 4, 3, 2, 1, 0},   // half turn
+    {2, 5, 8, 1, 4, 7, 0, 3, 6},   // quarter turn counter-clockwise
+    {2, 1, 0, 5, 4, 3, 8, 7, 6},   // mirror left to right
+    {6, 7, 8, 3, 4, 5, 0, 1, 2},   // mirror top to bottom
+    {0, 3, 6, 1, 4, 7, 2, 5, 8},   // flip on the main diagonal
+    {8, 5, 2, 7, 4, 1, 6, 3, 0}    // flip on the other diagonal
+};
+
+extern const uint16_t minimaxTable_positionCount;
+extern const uint16_t minimaxTable_positions[];
+extern const uint8_t minimaxTable_moves[];
+
+#endif /* MINIMAXTABLE_H_ */
@@ -5,12 +5,12 @@
 #include <stdio.h>
 #include "supportFiles/display.h"
 #include "minimax.h"
+#include "src/390_libs/touchQueue.h"
 
 #define WELCOME_SCRREN_ERASE_X 20 // Starting x-coordinate for the welcome screen message
 #define WELCOME_SCRREN_ERASE_Y 100 // Starting x-coordinate for the welcome screen message
 #define WELCOME_SCREEN_ERASE_SIZE 2 // Text size of Welcome Screen
-#define MAXIMUM_MOVES 9 // Maximum amount of moves in any given game. Used to determine a tie
-#define ADC_COUNTER_MAX_VALUE 100/100 // 50 ms for the adc: divided by Timer Period in ms
+#define MAXIMUM_MOVES (MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS) // Maximum amount of moves in any given game. Used to determine a tie
 #define AUTOPLAY_CNTR_MAX_VALUE 4000/100// 4 second delay before computer begins game automatically: 4000/ Timer Period in ms
 #define WELCOME_SCREEN_CNTR_MAX_VALUE 5000/100 // 5 second delay before welcome screen disappears 5000/ Timer Period in ms
 #define RESET_GAME_SEQUENCE 0x1 // Sequence used to read button 0 when player wants to reset game
@@ -20,7 +20,6 @@ enum ticTacToeControl_st_t {
     never_touched_st,        // Wait here for a while to give user a chance to play first
     computer_move_st,       // Computer takes its move in this state
     waiting_for_move_st,    // waiting for move of human player
-    adc_Counter_running_st,     // waiting for the touch-controller ADC to settle
     game_over_st,            // Total number of moves has reached 9, or a player has won. Remain in this state until reset button is pressed
     waiting_release_st      // State waiting for player to release finger before drawing move
 
@@ -38,8 +37,9 @@ void ticTacToeControl_tick()
 
 	// variable to store total moves in game
     static uint8_t move_count; 
+    // Touch event being handled. touchQueue only publishes a press once the touch controller has settled.
+    touchQueue_event_t touch;
     // Counters
-    static uint adcCounter; // counter for adc Touchpad
     static uint8_t autoplay_counter; // counter that when expired, computer plays first
     static uint8_t welcomescreen_counter; // counter for welcome screen delay
     static bool player_is_X; // True means human player is X
@@ -77,9 +77,11 @@ void ticTacToeControl_tick()
 
                  //initialize Counters
                  autoplay_counter=0;
-                 adcCounter =0;
                  welcomescreen_counter = 0;
 
+                 // forget touches made during the welcome screen
+                 touchQueue_clear();
+
 				 // update state to first state of game
 				 currentState = never_touched_st;   
 
@@ -91,32 +93,16 @@ void ticTacToeControl_tick()
 			//state at beginning of game
         case never_touched_st:
 
-            // Cover rare case where player touches screen at same time autoplay counter expires
-            if (display_isTouched() && autoplay_counter == AUTOPLAY_CNTR_MAX_VALUE)
+            // if player touches screen before autoplay counter expires (or on the tick it expires)
+            if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_press_e)
             {
-                //Go ahead and play as if counter didn't expire (play as X):
-                
+                // Play as X, the move is made when the finger is released
                 player_is_X = true;
-                
-                //Start adcCounter
-                display_clearOldTouchData();
-                currentState = adc_Counter_running_st;
-
-            }
-            
-            // if player touches screen before autoplay counter expires
-            else if (display_isTouched() && autoplay_counter < AUTOPLAY_CNTR_MAX_VALUE)
-            {
-                // Play as X
-                player_is_X = true;
-                
-                //Start adcCounter
-                display_clearOldTouchData();
-                currentState = adc_Counter_running_st;
+                currentState = waiting_release_st;
             }
             
             // If autoplay counter expires before screen is touched, computer is X, and go to computer move st
-            else if (!display_isTouched() && autoplay_counter == AUTOPLAY_CNTR_MAX_VALUE)
+            else if (autoplay_counter == AUTOPLAY_CNTR_MAX_VALUE)
             {
 				// Play as O
                 player_is_X = false;
@@ -135,34 +121,15 @@ void ticTacToeControl_tick()
 			//if total moves has reached maximum moves, the game is over
             if (move_count == MAXIMUM_MOVES)
               currentState = game_over_st;
-            // if display is touched, transition to adc_Counter_running_st
-            else if (display_isTouched())
-            {
-                display_clearOldTouchData();
-                currentState = adc_Counter_running_st;
-            }
+            // if display is touched, wait for the release
+            else if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_press_e)
+                currentState = waiting_release_st;
 
             else
                 // remain in current state
                 currentState = waiting_for_move_st;
             break;
 
-			// state when adc Converter is settling and registering a touch
-        case adc_Counter_running_st:
-
-			// if the adc Converter has settled, read touch coordinates and register selection if valid
-            if (adcCounter == ADC_COUNTER_MAX_VALUE)
-            {
-                currentState = waiting_release_st;
-                //reset adcCounter
-                adcCounter = 0;
-   
-            }
-
-            else // adcCounter is not expired
-                // return to current state to increment adcCounter
-                currentState = adc_Counter_running_st;
-            break;
 			//state where computer takes it's turn
         case computer_move_st:
 			// go to computer move state if game is not over:
@@ -178,13 +145,13 @@ void ticTacToeControl_tick()
 			//state where waiting release of player finger
         case waiting_release_st:
 			// when it's released play the player's move
-            if (!display_isTouched())
+            if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_release_e)
             {
 				//Temporary variables to store the square selection
                 uint8_t row;
                 uint8_t column;
                   // decide which square was touched
-                  ticTacToeDisplay_touchScreenComputeBoardRowColumn(&row, &column);
+                  ticTacToeDisplay_computeBoardRowColumn(touch.x, touch.y, &row, &column);
 
                    //if player selected an empty square, the player can play. If not, ignore it:
                     if (game_board.squares[row][column] == MINIMAX_EMPTY_SQUARE)
@@ -245,7 +212,9 @@ void ticTacToeControl_tick()
 
                  //reset Counters
                  autoplay_counter=0;
-                 adcCounter =0;
+
+                 // forget touches made while the game was over
+                 touchQueue_clear();
 
                   //reset game board score
                   game_score = MINIMAX_NOT_ENDGAME;
@@ -279,10 +248,6 @@ void ticTacToeControl_tick()
             case waiting_for_move_st:
                 //do nothing, just wait
                 break;
-            case adc_Counter_running_st:
-                //increment adc_Counter
-                adcCounter++;
-                break;
             case waiting_release_st:
                 // do nothing, just wait
                 break;
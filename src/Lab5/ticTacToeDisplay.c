@@ -79,7 +79,7 @@ void ticTacToeDisplay_drawX(uint8_t row, uint8_t column, bool erase)
     }
 
     //draw first diagonal line from top left
-    display_drawLine(diagonal_1_Xstart, diagonal_1_Ystart, diagonal_1_Xstart + (COLUMN_WIDTH) - EXCESS_PADDING*(X_PADDING_HORIZONTAL),diagonal_1_Ystart + ROW_HEIGHT) - EXCESS_PADDING*(X_PADDING_VERTICAL),DISPLAY_YELLOW);
+    display_drawLine(diagonal_1_Xstart, diagonal_1_Ystart, diagonal_1_Xstart + (COLUMN_WIDTH) - EXCESS_PADDING*(X_PADDING_HORIZONTAL),diagonal_1_Ystart + (ROW_HEIGHT) - EXCESS_PADDING*(X_PADDING_VERTICAL),DISPLAY_YELLOW);
 
     //draw second diagonal line from bottom left
     display_drawLine(diagonal_2_Xstart,diagonal_2_Ystart, diagonal_2_Xstart + (COLUMN_WIDTH) - EXCESS_PADDING*(X_PADDING_HORIZONTAL), diagonal_1_Ystart,DISPLAY_YELLOW);
@@ -115,7 +115,11 @@ void ticTacToeDisplay_touchScreenComputeBoardRowColumn(uint8_t* row, uint8_t* co
 
     //get display touch coordinates:
     display_getTouchedPoint(&x, &y, &z);
+    ticTacToeDisplay_computeBoardRowColumn(x, y, row, column);
+}
 
+void ticTacToeDisplay_computeBoardRowColumn(int16_t x, int16_t y, uint8_t* row, uint8_t* column)
+{
     //find the row coordinate
     if (y < ROW_HEIGHT)
         *row = ROW_0;
@@ -17,6 +17,9 @@ void ticTacToeDisplay_drawO(uint8_t row, uint8_t column, bool erase);
 // according to where the user touched the board.
 void ticTacToeDisplay_touchScreenComputeBoardRowColumn(uint8_t* row, uint8_t* column);
 
+// Sets the row and column arguments for a touch at (x, y), e.g. from a touchQueue event.
+void ticTacToeDisplay_computeBoardRowColumn(int16_t x, int16_t y, uint8_t* row, uint8_t* column);
+
 // Runs a test of the display. Does the following.
 // Draws the board. Each time you touch one of the screen areas, the screen will paint
 // an X or an O, depending on whether switch 0 (SW0) is slid up (O) or down (X).
@@ -3,7 +3,7 @@
 #include "simonDisplay.h"
 #include "supportFiles/display.h"
 #include "supportFiles/utils.h"
-#define ADC_COUNTER_MAX_VALUE 100/100 // 100 ms for the adc: divided by Timer Period in ms
+#include "src/390_libs/touchQueue.h"
 
 
 //Run_Test() #define statements:
@@ -18,12 +18,12 @@
 //A boolean that only this state machine can see; used to enable and disable state machine
 static bool enable_flag = false; // initialize to false for disable
 static bool finger_removed = false; // initialize to false (no touch has happened)
+static uint8_t region_No = 0; // region of the last touch, computed where the press was
 
 // States for the buttonHandler state machine.
 enum buttonHandler_st_t {
     init_st, //Initial state of the state machine
     never_touched_st, // State that button handler waits in until the display is touched
-    adc_Counter_running_st, // State for the adc to settle
     waiting_release_st, // State that waits until user releases finger to register a touch
     final_st //Final state before returning to init_st
 
@@ -31,15 +31,9 @@ enum buttonHandler_st_t {
 
 uint8_t buttonHandler_getRegionNumber()
 {
-    //declare 3 local variables to read touch coordinates.
-        int16_t x;
-        int16_t y;
-        uint8_t z;
-
-    //get display touch coordinates:
-        display_getTouchedPoint(&x, &y, &z);
-
-        return simonDisplay_computeRegionNumber(x,y);
+    // The touch controller may no longer hold the point once the finger is up, so the region is the one
+    // computed from the press event.
+    return region_No;
 }
 
 
@@ -82,8 +76,8 @@ void buttonHandler_init()
 // Standard tick function.
 void buttonHandler_tick()
 {
-    static uint8_t adcCounter; // counter for adc Touchpad
-    static uint8_t region_No; // variable used to compute region number
+    // Touch event being handled. touchQueue only publishes a press once the touch controller has settled.
+    touchQueue_event_t touch;
 
     switch(currentState)
     {
@@ -95,7 +89,6 @@ void buttonHandler_tick()
         {
             currentState = never_touched_st;
             //initialize variables
-            adcCounter = 0;
             region_No = 0;
             finger_removed = false;
         }
@@ -111,38 +104,18 @@ void buttonHandler_tick()
 		//Check to make sure enable flag is still valid, to not hang in a state
 		if (!enable_flag)
 			currentState = init_st; // Return to init state if flag is disabled
-		//If display is touched, proceed to adc_Counter_running_st
-        else if (display_isTouched())
+		//If display is touched, draw the touched region and wait for the release
+        else if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_press_e)
         {
-
-            display_clearOldTouchData();
-            currentState = adc_Counter_running_st;
+            region_No = simonDisplay_computeRegionNumber(touch.x, touch.y); // compute region number
+            simonDisplay_drawSquare( region_No, false); // false means do not erase
+            currentState = waiting_release_st; //Transition to next states
         }
 
         else
 			//Remain in current state
             currentState = never_touched_st;
     }
-    break;
-
-	// State for the adc to settle
-    case adc_Counter_running_st:
-    {      
-		   //Check to make sure enable flag is still valid, to not hang in a state
-		   if (!enable_flag)
-			  currentState = init_st; // Return to init state if flag is disabled
-		   //Check to see if adcCounter expired
-		   else if (adcCounter == ADC_COUNTER_MAX_VALUE)
-           {
-			   
-               region_No = buttonHandler_getRegionNumber(); // compute region number
-               simonDisplay_drawSquare( region_No, false); // false means do not erase
-               currentState = waiting_release_st; //Transition to next states
-           }
-           else
-            currentState = adc_Counter_running_st;
-
-    }
     break;
 
 	// State that waits until user releases finger to register a touch
@@ -153,7 +126,7 @@ void buttonHandler_tick()
         if (!enable_flag)
             currentState = init_st;
 
-		else if (!display_isTouched())
+		else if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_release_e)
         {
             //finger is removed
             finger_removed = true;
@@ -192,9 +165,6 @@ void buttonHandler_tick()
     case never_touched_st:
         ;// do nothing
         break;
-    case adc_Counter_running_st:
-        adcCounter++;
-        break;
     case waiting_release_st:
          ;// do nothing
         break;
@@ -213,6 +183,7 @@ void buttonHandler_tick()
 void buttonHandler_runTest(int16_t touchCountArg) {
     int16_t touchCount = 0;                 // Keep track of the number of touches.
     display_init();                         // Always have to init the display.
+    touchQueue_init();                      // No ISR here: the loop services the touch queue before each tick.
     display_fillScreen(DISPLAY_BLACK);      // Clear the display.
     // Draw all the buttons for the first time so the buttonHandler doesn't need to do this in an init state.
     // Ultimately, simonControl will do this when the game first starts up.
@@ -220,6 +191,7 @@ void buttonHandler_runTest(int16_t touchCountArg) {
     buttonHandler_init();                   // Initialize the button handler state machine
     buttonHandler_enable();
     while (touchCount < touchCountArg) {    // Loop here while touchCount is less than the touchCountArg
+        touchQueue_service();               // Turn the new touch samples into events.
         buttonHandler_tick();               // Advance the state machine.
         utils_msDelay(RUN_TEST_TICK_PERIOD_IN_MS);
         if (buttonHandler_releaseDetected()) {  // If a release is detected, then the screen was touched.
@@ -229,9 +201,11 @@ void buttonHandler_runTest(int16_t touchCountArg) {
             // Interlocked behavior: handshake with the button handler (now disabled).
             buttonHandler_disable();
             utils_msDelay(RUN_TEST_TICK_PERIOD_IN_MS);
+            touchQueue_service();
             buttonHandler_tick();               // Advance the state machine.
             buttonHandler_enable();             // Interlocked behavior: enable the buttonHandler.
             utils_msDelay(RUN_TEST_TICK_PERIOD_IN_MS);
+            touchQueue_service();
             buttonHandler_tick();               // Advance the state machine.
         }
     }
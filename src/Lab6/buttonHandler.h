@@ -1,7 +1,7 @@
 #ifndef BUTTONHANDLER_H_
 #define BUTTONHANDLER_H_
 #include <stdint.h>
-// Get the simon region numbers. See the source code for the region numbering scheme.
+// Get the simon region number of the last touch (where it was pressed). See simonDisplay for the region numbering scheme.
 uint8_t buttonHandler_getRegionNumber();
 
 // Turn on the state machine. Part of the interlock.
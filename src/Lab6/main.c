@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 #include "supportFiles/display.h"
+#include "src/390_libs/touchQueue.h"
 
 #include "xparameters.h"
 
@@ -42,6 +43,8 @@ int main()
     interrupts_enableTimerGlobalInts();
     // Initialization of the clock display is not time-dependent, do it outside of the state machine.
     display_init();
+    // Touches arrive as events from the ISR from here on.
+    touchQueue_init();
     display_fillScreen(DISPLAY_BLACK);
     buttonHandler_init();
     flashSequence_init();
@@ -72,7 +75,8 @@ int main()
    printf("internal interrupt count: %ld\n\r", personalInterruptCount);
    return 0;
 }
+// Turns the touch samples that came in since the last tick into events for the state machines.
 void isr_function() {
-
+    touchQueue_service();
 }
 
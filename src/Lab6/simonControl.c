@@ -4,6 +4,7 @@
 #include "simonDisplay.h"
 #include "globals.h"
 #include "supportFiles/display.h"
+#include "src/390_libs/touchQueue.h"
 #include<stdbool.h>
 #include <stdlib.h>
 
@@ -19,7 +20,6 @@
 #define MESSAGE_COUNTER_MAX_VALUE 4000/100 // Duration for the timer to display longest sequence, or level player achieved
 #define LEVEL_UP_COUNTER_MAX_VALUE 3000/100 // Duration for the timer to allow the player to touch the screen to continue playing
 
-#define ADC_COUNTER_MAX_VALUE 100/100 // 100 ms for the adc: divided by Timer Period in ms
 #define ARRAY_OFFSET 1 // Offset value for taking into account that array indexes begin at 0, not 1
 #define LONGEST_SEQUENCE_ARRAY_SIZE 20 // Enough characters to print message to display
 #define WELCOME_VERTICAL_OFFSET_TOUCH_TO_START 80 // A little space to separate text from main welcome text
@@ -27,7 +27,6 @@
 #define INCREMENT_SEQUENCE_VALUE 1 // incrementSequence variable always gets incremented by 1 
 
 static bool player_quit = false; // A boolean indicating that the player chose not to continue with the game
-static bool game_intro = false; // A boolean to tell the state machine if the game is in the welcome to simon process. True = game hasn't started, False = game has started
 static uint8_t randomSequence[MAX_SEQUENCE_LENGTH] = {0}; // A variable that will keep track of the current random sequence
 
 // States for the simonControl state machine.
@@ -40,7 +39,6 @@ enum simonControl_st_t {
     error_check_st, // State to see if an error was detected from the verifySequence state machine
     delay_message_st, // State to delay messages on the display
     waiting_next_level_st, // State where the user can choose to advance a level or not
-    adc_Counter_running_st, // State to allow the adc to settle
     waiting_release_st, // State waiting release for player to continue play
 
 } currentState_control;
@@ -143,7 +141,9 @@ void simonControl_tick()
 {
     static uint8_t message_counter = 0; // counter for delay messages on screen
     static uint8_t level_up_counter = 0; // counter that times out if the user doesn't decide to level up (by not touching the screen)
-    static uint8_t adcCounter = 0;        // counter for adc Touchpad
+    // Touch event being handled, while buttonHandler is disabled (one of us takes events at a time).
+    // touchQueue only publishes a press once the touch controller has settled.
+    touchQueue_event_t touch;
     static uint8_t seedCounter = 0;       // counter for random number generator. Used at start of game
     switch (currentState_control)
     {
@@ -154,7 +154,9 @@ void simonControl_tick()
 
 		//Initialize variables
         player_quit = false;
-        game_intro = true;
+
+        //Forget touches made during the last game's messages
+        touchQueue_clear();
 
 		//Display welcome message
         printWelcome(false); // false means do not erase
@@ -165,10 +167,9 @@ void simonControl_tick()
     case welcome_screen_st:
     {
 		// Remain in state until screen is touched
-        if(display_isTouched())
+        if(touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_press_e)
         {
-            display_clearOldTouchData();
-            currentState_control = adc_Counter_running_st; // transition to adc Counter running state
+            currentState_control = welcome_waiting_release_st; // transition to welcome waiting release state
             srand(seedCounter); // generate a seed for random number generator
 
             //generate random sequence of length 4
@@ -188,15 +189,12 @@ void simonControl_tick()
     case welcome_waiting_release_st:
     {
         //Remain in state until display is released
-        if(!display_isTouched())
+        if(touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_release_e)
         {
             //Once released, erase what's on screen and transition to flash_enable_st
             printWelcome(true); // true means erase
 
             currentState_control = flash_enable_st;
-
-            //Game has begun, so set game_intro to false
-            game_intro = false;
         }
         else
             currentState_control = welcome_waiting_release_st;
@@ -217,6 +215,9 @@ void simonControl_tick()
             //Disable flash state machine to advance it
             flashSequence_disable();
 
+            //Touches made while the sequence flashed are not part of the answer
+            touchQueue_clear();
+
             //Draw buttons
             simonDisplay_drawAllButtons();
         }
@@ -329,6 +330,9 @@ void simonControl_tick()
                 //print "Touch for next level" on screen
                 printTouchNextLevel(false); // false means do not erase
 
+                //Only touches made from now on answer it
+                touchQueue_clear();
+
             }
             //Reset message counter:
             message_counter = 0;
@@ -346,10 +350,9 @@ void simonControl_tick()
     case waiting_next_level_st:
     {
 		//Remain in current state until screen is touched or the level_up_counter expires
-        if (display_isTouched())
+        if (touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_press_e)
         {
-            display_clearOldTouchData();
-            currentState_control = adc_Counter_running_st;
+            currentState_control = waiting_release_st;
 
             //Reset level_up_counter as it will be used again in waiting_release_st
             level_up_counter = 0;
@@ -376,29 +379,10 @@ void simonControl_tick()
     }
     break;
 
-    case adc_Counter_running_st:
-    {
-        if (adcCounter == ADC_COUNTER_MAX_VALUE)
-        {
-            //If the game was just started, go to a different waiting release state to handle the release correctly
-            if(game_intro)
-                currentState_control = welcome_waiting_release_st;
-            else
-                currentState_control = waiting_release_st;
-
-            //Reset adcCounter
-            adcCounter = 0;
-        }
-        else
-            currentState_control = adc_Counter_running_st;
-
-    }
-    break;
-
     case waiting_release_st:
     {
         //Check if a release happened
-        if(!display_isTouched())
+        if(touchQueue_getPressOrRelease(&touch) && touch.type == touchQueue_release_e)
         {
             //Erase current message on screen
             printTouchNextLevel(true); // true means erase
@@ -470,10 +454,6 @@ void simonControl_tick()
         //incremenet level_up_counter
         level_up_counter++;
         break;
-    case adc_Counter_running_st:
-        //increment adcCounter
-        adcCounter++;
-        break;
     case waiting_release_st:
         //increment level_up_counter
         level_up_counter++;
@@ -4,6 +4,7 @@
 #include"globals.h"
 #include "src/Lab2/buttons.h"
 #include "supportFiles/display.h"
+#include "src/390_libs/touchQueue.h"
 #include "supportFiles/utils.h"
 #include<stdbool.h>
 #include<stdint.h>
@@ -315,6 +316,7 @@ void verifySequence_printInfoMessage(verifySequence_infoMessage_t messageType) {
 // by tapping an incorrect color.
 void verifySequence_runTest() {
 	display_init();  // Always must do this.
+	touchQueue_init();  // No ISR here: the loops service the touch queue before each tick.
 	buttons_init();  // Need to use the push-button package so user can quit.
 	int16_t sequenceLength = 1;  // Start out with a sequence length of 1.
 	verifySequence_printInstructions(sequenceLength, false);  // Tell the user what to do.
@@ -329,6 +331,7 @@ void verifySequence_runTest() {
 							  // Need to hold button until it quits as you might be stuck in a delay.
 	while (!(buttons_read() & BUTTONS_BTN0_MASK)) {
 		// verifySequence uses the buttonHandler state machine so you need to "tick" both of them.
+		touchQueue_service();   // Turn the new touch samples into events.
 		verifySequence_tick();  // Advance the verifySequence state machine.
 		buttonHandler_tick();   // Advance the buttonHandler state machine.
 		utils_msDelay(TICK_PERIOD_IN_MS);       // Wait for a tick period.
@@ -351,6 +354,7 @@ void verifySequence_runTest() {
 			utils_msDelay(MESSAGE_WAIT_MS);                            // Let the user read the instructions.
 			verifySequence_drawButtons();                              // Draw the buttons.
 			verifySequence_disable();                                  // Interlock: first step of handshake.
+			touchQueue_service();
 			verifySequence_tick();
 			buttonHandler_tick();                                       // Advance the verifySequence machine.
 			utils_msDelay(TICK_PERIOD_IN_MS);                          // Wait for tick period.
@@ -0,0 +1,10 @@
+#ifndef SOUNDS_H_
+#define SOUNDS_H_
+
+#include <stdint.h>
+
+// The sound pack (see src/390_libs/soundPack.h), linked in by sounds.S.
+extern const uint8_t sounds_pack[];
+extern const uint8_t sounds_packEnd[];  // One past its last byte.
+
+#endif /* SOUNDS_H_ */
@@ -37,6 +37,14 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include "arduinoTypes.h"
 #include "xgpio.h"
+#include <string.h>
+
+#define GFX_BLIT_TEXT_SIZE_MAX 8  // Larger opaque text is drawn square by square, as before.
+#define GFX_TEXT_STRIP_CHARS 54   // Characters in one opaque strip (a 320-pixel line of size 1 text).
+#define GFX_TEXT_STRIP_BYTES ((6 * GFX_TEXT_STRIP_CHARS + 7) / 8 * 8)  // One size 1 strip: 41 bytes by 8 rows.
+
+// Built by drawText(): the 1-bit image of a run of opaque characters.
+static uint8_t textStrip[GFX_TEXT_STRIP_BYTES * GFX_BLIT_TEXT_SIZE_MAX];
 
 //#ifdef __AVR__
 // #include <avr/pgmspace.h>
@@ -367,6 +375,31 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y,
   }
 }
 
+// Added: draws each run of characters that stays on one line with one drawText().
+// The cursor ends up where write(uint8_t) would leave it, character by character.
+size_t Adafruit_GFX::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (n < size) {
+    if (buffer[n] == '\n' || buffer[n] == '\r') {
+      write(buffer[n++]);
+      continue;
+    }
+    int16_t x = cursor_x, y = cursor_y;
+    size_t start = n;
+    while (n < size && buffer[n] != '\n' && buffer[n] != '\r') {
+      n++;
+      cursor_x += textsize*6;
+      if (wrap && (cursor_x > (_width - textsize*6))) {
+        cursor_y += textsize*8;
+        cursor_x = 0;
+        break;
+      }
+    }
+    drawText(x, y, buffer + start, n - start, textcolor, textbgcolor, textsize);
+  }
+  return size;
+}
+
 #if ARDUINO >= 100
 size_t Adafruit_GFX::write(uint8_t c) {
 #else
@@ -393,13 +426,86 @@ void Adafruit_GFX::write(uint8_t c) {
 // Draw a character
 void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
 			    uint16_t color, uint16_t bg, uint8_t size) {
+  drawText(x, y, &c, 1, color, bg, size);
+}
 
-  if((x >= _width)            || // Clip right
-     (y >= _height)           || // Clip bottom
-     ((x + 6 * size - 1) < 0) || // Clip left
-     ((y + 8 * size - 1) < 0))   // Clip top
+// Added: draws length characters side by side, as drawChar() would one at a time.
+// With a background (bg != color) every pixel of the cells is written, so a run
+// of them goes out as one 1-bit strip through blitMono(): one transfer per line
+// of text instead of one per pixel. Without one, each glyph row goes out as its
+// runs of lit pixels, each a single fillRect() (or drawPixel()).
+void Adafruit_GFX::drawText(int16_t x, int16_t y, const uint8_t *text,
+			    size_t length, uint16_t color, uint16_t bg, uint8_t size) {
+  while (length > 0 && (x + 6 * size - 1) < 0) {  // Clip left, whole characters.
+    x += 6 * size;
+    text++;
+    length--;
+  }
+  if((length == 0) || (x >= _width) || (y >= _height) || // Clip right, bottom
+     ((y + 8 * size - 1) < 0))                            // Clip top
     return;
+  if (length > (size_t)((_width - x + 6 * size - 1) / (6 * size)))  // The rest is off the right edge.
+    length = (_width - x + 6 * size - 1) / (6 * size);
+
+  if (bg != color && size <= GFX_BLIT_TEXT_SIZE_MAX) {
+    // textStrip holds 8 * size rows of at most this many characters (fewer than a whole line at sizes 7 and 8).
+    size_t stripChars = sizeof(textStrip) / (8 * size) * 8 / (6 * size);
+    if (stripChars > GFX_TEXT_STRIP_CHARS)
+      stripChars = GFX_TEXT_STRIP_CHARS;
+    while (length > 0) {
+      size_t count = length < stripChars ? length : stripChars;
+      int16_t w = 6 * size * count, byteWidth = (w + 7) / 8;
+      for (int8_t j = 0; j < 8; j++) {  // Build one scaled glyph row, then copy it size times.
+        uint8_t *row = textStrip + j * size * byteWidth;
+        memset(row, 0, byteWidth);
+        for (size_t k = 0; k < count; k++) {
+          const unsigned char *glyph = font + text[k] * 5;
+          for (int8_t i = 0; i < 5; i++) {  // The sixth column is blank.
+            if (!(pgm_read_byte(glyph + i) & (1 << j))) continue;
+            int16_t column = (6 * k + i) * size;
+            for (uint8_t n = 0; n < size; n++, column++)
+              row[column >> 3] |= 128 >> (column & 7);
+          }
+        }
+        for (uint8_t copy = 1; copy < size; copy++)
+          memcpy(row + copy * byteWidth, row, byteWidth);
+      }
+      blitMono(x, y, textStrip, w, 8 * size, color, bg);
+      x += w;
+      text += count;
+      length -= count;
+    }
+    return;
+  }
 
+  if (bg == color) {
+    for (size_t k = 0; k < length; k++, x += 6 * size) {
+      const unsigned char *glyph = font + text[k] * 5;
+      for (int8_t j = 0; j < 8; j++) {
+        for (int8_t i = 0; i < 5; ) {
+          if (!(pgm_read_byte(glyph + i) & (1 << j))) {
+            i++;
+            continue;
+          }
+          int8_t first = i;
+          while (i < 5 && (pgm_read_byte(glyph + i) & (1 << j))) i++;
+          if (size == 1 && i - first == 1)
+            drawPixel(x + first, y + j, color);
+          else
+            fillRect(x + first * size, y + j * size, (i - first) * size, size, color);
+        }
+      }
+    }
+    return;
+  }
+
+  for (size_t k = 0; k < length; k++, x += 6 * size)  // Too big for a strip.
+    drawGlyph(x, y, text[k], color, bg, size);
+}
+
+// The original drawChar(): square by square.
+void Adafruit_GFX::drawGlyph(int16_t x, int16_t y, unsigned char c,
+			     uint16_t color, uint16_t bg, uint8_t size) {
   for (int8_t i=0; i<6; i++ ) {
     uint8_t line;
     if (i == 5) 
@@ -453,6 +559,14 @@ uint8_t Adafruit_GFX::getRotation(void) {
   return rotation;
 }
 
+int16_t Adafruit_GFX::getCursorX(void) {
+  return cursor_x;
+}
+
+int16_t Adafruit_GFX::getCursorY(void) {
+  return cursor_y;
+}
+
 void Adafruit_GFX::setRotation(uint8_t x) {
   rotation = (x & 3);
   switch(rotation) {
@@ -482,4 +596,43 @@ void Adafruit_GFX::invertDisplay(bool i) {
   // Do nothing, must be subclassed if supported
 }
 
+void Adafruit_GFX::blit(int16_t x, int16_t y, int16_t w, int16_t h,
+			const uint16_t *pixels) {
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      drawPixel(x + i, y + j, *pixels++);
+}
+
+void Adafruit_GFX::blitMono(int16_t x, int16_t y, const uint8_t *bitmap,
+			    int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  int16_t byteWidth = (w + 7) / 8;
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      drawPixel(x + i, y + j,
+        (bitmap[j * byteWidth + i / 8] & (128 >> (i & 7))) ? color : bg);
+}
+
+GFXcanvas1::GFXcanvas1(int16_t w, int16_t h, uint8_t *bitmap) :
+  Adafruit_GFX(w, h) {
+  setBitmap(bitmap, w, h);
+}
+
+void GFXcanvas1::setBitmap(uint8_t *bitmap, int16_t w, int16_t h) {
+  buffer    = bitmap;
+  _width    = w;
+  _height   = h;
+  byteWidth = (w + 7) / 8;
+}
+
+void GFXcanvas1::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+  uint8_t *byte = &buffer[y * byteWidth + x / 8];
+  if (color) *byte |= 128 >> (x & 7);
+  else       *byte &= ~(128 >> (x & 7));
+}
+
+void GFXcanvas1::fillScreen(uint16_t color) {
+  memset(buffer, color ? 0xFF : 0x00, byteWidth * _height);
+}
+
 
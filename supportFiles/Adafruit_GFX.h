@@ -33,7 +33,13 @@ class Adafruit_GFX : public Print {
     drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
     fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
     fillScreen(uint16_t color),
-    invertDisplay(bool i);
+    invertDisplay(bool i),
+    // Added: write every pixel of a block, as RGB565 pixels row by row (blit) or as a 1-bit image in
+    // drawBitmap()'s layout with set bits in color and clear bits in bg (blitMono). The generic
+    // versions go pixel by pixel; Adafruit_TFTLCD streams each block through one address window.
+    blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels),
+    blitMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h,
+      uint16_t color, uint16_t bg);
 
   // These exist only with Adafruit_GFX (no subclass overrides)
   void
@@ -55,6 +61,8 @@ class Adafruit_GFX : public Print {
       int16_t w, int16_t h, uint16_t color),
     drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
       uint16_t bg, uint8_t size),
+    drawText(int16_t x, int16_t y, const uint8_t *text, size_t length,
+      uint16_t color, uint16_t bg, uint8_t size),  // Added: a run of characters, see the .cpp.
     setCursor(int16_t x, int16_t y),
     setTextColor(uint16_t c),
     setTextColor(uint16_t c, uint16_t bg),
@@ -67,6 +75,8 @@ class Adafruit_GFX : public Print {
 #else
   virtual void   write(uint8_t);
 #endif
+  using Print::write;
+  virtual size_t write(const uint8_t *buffer, size_t size);  // Added: draws a string a run at a time.
 
   int16_t
     height(void),
@@ -74,7 +84,14 @@ class Adafruit_GFX : public Print {
 
   uint8_t getRotation(void);
 
+  int16_t
+    getCursorX(void),  // Added so display.cpp can move text state between the LCD and the frame buffer.
+    getCursorY(void);
+
  protected:
+  void
+    drawGlyph(int16_t x, int16_t y, unsigned char c, uint16_t color,
+      uint16_t bg, uint8_t size);  // Added: drawChar() square by square.
   const int16_t
     WIDTH, HEIGHT;   // This is the 'raw' display w/h - never changes
   int16_t
@@ -89,4 +106,25 @@ class Adafruit_GFX : public Print {
     wrap; // If set, 'wrap' text at right edge of display
 };
 
+// Added: a 1-bit image to draw into, in drawBitmap()'s layout (rows of (w + 7) / 8 bytes, most
+// significant bit leftmost). Any color but 0 sets a bit. The caller owns the bitmap.
+// Leave it in rotation 0: the bitmap's layout does not rotate.
+class GFXcanvas1 : public Adafruit_GFX {
+
+ public:
+
+  GFXcanvas1(int16_t w, int16_t h, uint8_t *bitmap);
+
+  // Draws into another bitmap from now on.
+  void setBitmap(uint8_t *bitmap, int16_t w, int16_t h);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillScreen(uint16_t color);
+
+ private:
+
+  uint8_t *buffer;
+  int16_t byteWidth;  // Of a row.
+};
+
 #endif // _ADAFRUIT_GFX_H
@@ -138,6 +138,8 @@ class Adafruit_STMPE610{
   uint8_t bufferSize(void);
   TS_Point getPoint(void);
   void clearOldTouchData();  // Removes all current touch data from the FIFO.
+  // Reads up to maxCount samples from the FIFO in one SPI transaction. Returns how many were read.
+  uint8_t readDataBurst(int16_t *x, int16_t *y, uint8_t *z, uint8_t maxCount);
 
  private:
   uint8_t spiIn();
@@ -712,6 +712,89 @@ void Adafruit_TFTLCD::pushColors(uint16_t *data, uint8_t len, bool first) {
 //  CS_IDLE;
 }
 
+// Issues the GRAM write command; pixel data follows in data mode.
+void Adafruit_TFTLCD::writeMemoryCommand(void) {
+  LCD_setCommandMode();
+  if(driver == ID_932X) write8(0x00);
+  if (driver == ID_9341) {
+    write8(0x2C);
+  } else {
+    write8(0x22);
+  }
+  LCD_setDataMode();
+}
+
+// Restores the full-screen address window after a block, like fillRect().
+void Adafruit_TFTLCD::endWindow(void) {
+  if(driver == ID_932X) setAddrWindow(0, 0, _width - 1, _height - 1);
+  else                  setLR();
+}
+
+// Clips a w x h block at (x, y) to the screen. Returns false if none of it shows,
+// otherwise opens the address window on the visible corners (x1, y1)-(x2, y2).
+bool Adafruit_TFTLCD::clipWindow(int16_t x, int16_t y, int16_t w, int16_t h,
+  int16_t *x1, int16_t *y1, int16_t *x2, int16_t *y2) {
+  *x2 = x + w - 1;
+  *y2 = y + h - 1;
+  if((w <= 0) || (h <= 0) || (x >= _width) || (y >= _height) ||
+     (*x2 < 0) || (*y2 < 0)) return false;
+  *x1 = x < 0 ? 0 : x;
+  *y1 = y < 0 ? 0 : y;
+  if(*x2 >= _width)  *x2 = _width - 1;
+  if(*y2 >= _height) *y2 = _height - 1;
+  setAddrWindow(*x1, *y1, *x2, *y2);
+  return true;
+}
+
+void Adafruit_TFTLCD::writePixels(const uint16_t *data, uint32_t len, bool first) {
+  uint16_t color;
+  if(first) writeMemoryCommand();
+  else      LCD_setDataMode();
+  while(len--) {
+    color = *data++;
+    write8(color >> 8);
+    write8(color);
+  }
+}
+
+// Streams the visible part of a block of pixels, row by row, as one transfer.
+void Adafruit_TFTLCD::blit(int16_t x, int16_t y, int16_t w, int16_t h,
+  const uint16_t *pixels) {
+  int16_t x1, y1, x2, y2;
+  if(!clipWindow(x, y, w, h, &x1, &y1, &x2, &y2)) return;
+  writeMemoryCommand();
+  for(int16_t row = y1; row <= y2; row++) {
+    const uint16_t *p = pixels + (int32_t)(row - y) * w + (x1 - x);
+    for(int16_t n = x2 - x1 + 1; n > 0; n--) {
+      uint16_t color = *p++;
+      write8(color >> 8);
+      write8(color);
+    }
+  }
+  endWindow();
+}
+
+// Expands a 1-bit image to color/bg on the fly, as one transfer.
+void Adafruit_TFTLCD::blitMono(int16_t x, int16_t y, const uint8_t *bitmap,
+  int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  int16_t x1, y1, x2, y2;
+  uint8_t hi = color >> 8, lo = color, bgHi = bg >> 8, bgLo = bg;
+  int16_t byteWidth = (w + 7) / 8;
+  if(!clipWindow(x, y, w, h, &x1, &y1, &x2, &y2)) return;
+  writeMemoryCommand();
+  for(int16_t row = y1; row <= y2; row++) {
+    const uint8_t *line = bitmap + (row - y) * byteWidth;
+    for(int16_t i = x1 - x; i <= x2 - x; i++) {
+      if(line[i >> 3] & (128 >> (i & 7))) {
+        write8(hi); write8(lo);
+      } else {
+        write8(bgHi); write8(bgLo);
+      }
+    }
+  }
+  endWindow();
+}
+
 void Adafruit_TFTLCD::setRotation(uint8_t x) {
 
   // Call parent rotation func first -- sets up rotation flags, etc.
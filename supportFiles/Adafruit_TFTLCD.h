@@ -41,6 +41,11 @@ class Adafruit_TFTLCD : public Adafruit_GFX {
        // These methods are public in order for BMP examples to work:
   void     setAddrWindow(int x1, int y1, int x2, int y2);
   void     pushColors(uint16_t *data, uint8_t len, bool first);
+       // Added: pushColors() without the 255-pixel limit, and blocks streamed through one window.
+  void     writePixels(const uint16_t *data, uint32_t len, bool first);
+  void     blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels);
+  void     blitMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h,
+             uint16_t color, uint16_t bg);
 
   uint16_t color565(uint8_t r, uint8_t g, uint8_t b),
            readPixel(int16_t x, int16_t y),
@@ -72,7 +77,11 @@ class Adafruit_TFTLCD : public Adafruit_GFX {
            writeRegisterPair(uint8_t aH, uint8_t aL, uint16_t d),
 #endif
            setLR(void),
-           flood(uint16_t color, uint32_t len);
+           flood(uint16_t color, uint32_t len),
+           writeMemoryCommand(void),
+           endWindow(void);
+  bool     clipWindow(int16_t x, int16_t y, int16_t w, int16_t h,
+             int16_t *x1, int16_t *y1, int16_t *x2, int16_t *y2);
   uint8_t  driver;
 
 #ifndef read8
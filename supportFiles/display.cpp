@@ -8,6 +8,7 @@
 #include "display.h"
 #include "Adafruit_TFTLCD.h"
 #include "Adafruit_STMPE610.h"
+#include "frameBuffer.h"
 #include <stdbool.h>
 
 // Just define these values here. They won't change in practice and I want to avoid
@@ -27,6 +28,10 @@
 static bool initFlag = false;  // Only allow init to be called once.
 static Adafruit_TFTLCD lcdDisplay = Adafruit_TFTLCD();  // Handle to the LCD display.
 static Adafruit_STMPE610 touchController = Adafruit_STMPE610();
+static FrameBuffer *frameBuffer = NULL;  // Made by display_useFrameBuffer(true).
+static Adafruit_GFX *gfx = &lcdDisplay;  // Where the drawing functions draw.
+static GFXcanvas1 sprite = GFXcanvas1(0, 0, NULL);  // Draws into display_beginSprite()'s bitmap.
+static Adafruit_GFX *spriteSavedGfx = NULL;         // Where drawing went before display_beginSprite().
 
 // Will only execute the body once.
 void display_init() {
@@ -39,31 +44,31 @@ void display_init() {
 
 // These are functions related to display. Functionality comes from Adafruit_GFX.
 void display_drawPixel(int16_t x0, int16_t y0, uint16_t color) {
-  lcdDisplay.drawPixel(x0, y0, color);
+  gfx->drawPixel(x0, y0, color);
 }
 
 void display_drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
-  lcdDisplay.drawLine(x0, y0, x1, y1, color);
+  gfx->drawLine(x0, y0, x1, y1, color);
 }
 
 void display_drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
-  lcdDisplay.drawFastVLine(x, y, h, color);
+  gfx->drawFastVLine(x, y, h, color);
 }
 
 void display_drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
-  lcdDisplay.drawFastHLine(x, y, w, color);
+  gfx->drawFastHLine(x, y, w, color);
 }
 
 void display_drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
-  lcdDisplay.drawRect(x, y, w, h, color);
+  gfx->drawRect(x, y, w, h, color);
 }
 
 void display_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
-  lcdDisplay.fillRect(x, y, w, h, color);
+  gfx->fillRect(x, y, w, h, color);
 }
 
 void display_fillScreen(uint16_t color) {
-  lcdDisplay.fillScreen(color);
+  gfx->fillScreen(color);
 }
 
 void display_invertDisplay(bool i) {
@@ -71,65 +76,81 @@ void display_invertDisplay(bool i) {
 }
 
 void display_drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-  lcdDisplay.drawCircle(x0, y0, r, color);
+  gfx->drawCircle(x0, y0, r, color);
 }
 
 void display_fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-  lcdDisplay.fillCircle(x0, y0, r, color);
+  gfx->fillCircle(x0, y0, r, color);
 }
 
 void display_drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 int16_t x2, int16_t y2, uint16_t color) {
-  lcdDisplay.drawTriangle(x0, y0, x1, y1, x2, y2, color);
+  gfx->drawTriangle(x0, y0, x1, y1, x2, y2, color);
 }
 
 void display_fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 int16_t x2, int16_t y2, uint16_t color) {
-  lcdDisplay.fillTriangle(x0, y0, x1, y1, x2, y2, color);
+  gfx->fillTriangle(x0, y0, x1, y1, x2, y2, color);
 }
 
 void display_drawRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h,
 int16_t radius, uint16_t color) {
-  lcdDisplay.drawRoundRect(x0, y0, w, h, radius, color);
+  gfx->drawRoundRect(x0, y0, w, h, radius, color);
 }
 
 void display_fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h,
 int16_t radius, uint16_t color) {
-  lcdDisplay.fillRoundRect(x0, y0, w, h, radius, color);
+  gfx->fillRoundRect(x0, y0, w, h, radius, color);
 }
 
 void display_drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
 int16_t w, int16_t h, uint16_t color) {
-  lcdDisplay.drawBitmap(x, y, bitmap, w, h, color);
+  gfx->drawBitmap(x, y, bitmap, w, h, color);
 }
 
 void display_drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
 uint16_t bg, uint8_t size) {
-  lcdDisplay.drawChar(x, y, c, color, bg, size);
+  gfx->drawChar(x, y, c, color, bg, size);
 }
 
+void display_blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels) {
+  gfx->blit(x, y, w, h, pixels);
+}
+
+void display_blitMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h,
+uint16_t color, uint16_t bg) {
+  gfx->blitMono(x, y, bitmap, w, h, color, bg);
+}
+
+// Text settings go to the LCD and to the frame buffer, so either can take over the drawing.
 void display_setCursor(int16_t x, int16_t y) {
   lcdDisplay.setCursor(x, y);
+  if (frameBuffer) frameBuffer->setCursor(x, y);
 }
 
 void display_setTextColor(uint16_t c) {
   lcdDisplay.setTextColor(c);
+  if (frameBuffer) frameBuffer->setTextColor(c);
 }
 
 void display_setTextColor(uint16_t c, uint16_t bg) {
   lcdDisplay.setTextColor(c, bg);
+  if (frameBuffer) frameBuffer->setTextColor(c, bg);
 }
 
 void display_setTextSize(uint8_t s) {
   lcdDisplay.setTextSize(s);
+  if (frameBuffer) frameBuffer->setTextSize(s);
 }
 
 void display_setTextWrap(bool w) {
   lcdDisplay.setTextWrap(w);
+  if (frameBuffer) frameBuffer->setTextWrap(w);
 }
 
 void display_setRotation(uint8_t r) {
   lcdDisplay.setRotation(r);
+  if (frameBuffer) frameBuffer->setRotation(r);
 }
 
 int16_t display_height() {
@@ -140,77 +161,128 @@ int16_t display_width() {
   return lcdDisplay.width();
 }
 
+// Sends a window of the frame buffer to the LCD.
+static void display_setWindow(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  lcdDisplay.setAddrWindow(x0, y0, x1, y1);
+}
+
+static void display_pushPixels(const uint16_t *pixels, uint32_t count, bool first) {
+  lcdDisplay.writePixels(pixels, count, first);
+}
+
+static const frameBuffer_backend_t display_lcdBackend = {display_setWindow, display_pushPixels};
+
+// Moves the text cursor from one drawing target to the other.
+static void display_drawTo(Adafruit_GFX *target) {
+  target->setCursor(gfx->getCursorX(), gfx->getCursorY());
+  gfx = target;
+}
+
+void display_useFrameBuffer(bool enable) {
+  if (enable && frameBuffer == NULL) {
+    uint16_t *pixels = (uint16_t *) malloc(DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint16_t));
+    if (pixels == NULL) return;  // Keep drawing straight to the LCD.
+    frameBuffer = new FrameBuffer(DISPLAY_HEIGHT, DISPLAY_WIDTH, pixels);  // Unrotated, like the LCD.
+    frameBuffer->setRotation(lcdDisplay.getRotation());
+  }
+  if (enable && gfx != frameBuffer) {
+    frameBuffer->invalidate();  // The LCD may show anything: the first flush paints all of it.
+    display_drawTo(frameBuffer);
+  } else if (!enable && gfx != &lcdDisplay) {
+    display_flush();
+    display_drawTo(&lcdDisplay);
+  }
+}
+
+void display_flush() {
+  if (gfx == frameBuffer)
+    frameBuffer->flush(&display_lcdBackend);
+}
+
+void display_beginSprite(uint8_t *bitmap, int16_t w, int16_t h) {
+  if (gfx == &sprite) return;  // Already drawing into one.
+  sprite.setBitmap(bitmap, w, h);
+  sprite.fillScreen(DISPLAY_BLACK);
+  spriteSavedGfx = gfx;
+  gfx = &sprite;
+}
+
+void display_endSprite() {
+  if (gfx != &sprite) return;
+  gfx = spriteSavedGfx;
+}
+
 // Obscure function name = just packs the RGB data into a 16-bit int.
 uint16_t display_color565(uint8_t r, uint8_t g, uint8_t b) {
   return lcdDisplay.color565(r, g, b);
 }
 
 size_t display_println(const char str[]) {
-  return lcdDisplay.println(str);
+  return gfx->println(str);
 }
 
 size_t display_println(char c) {
-  return lcdDisplay.println(c);
+  return gfx->println(c);
 }
 
 size_t display_println(unsigned char c, int base) {
-  return lcdDisplay.println(c, base);
+  return gfx->println(c, base);
 }
 
 size_t display_println(int num, int base) {
-  return lcdDisplay.println(num, base);
+  return gfx->println(num, base);
 }
 
 size_t display_println(unsigned int num, int base) {
-  return lcdDisplay.println(num, base);
+  return gfx->println(num, base);
 }
 
 size_t display_println(long num, int base) {
-  return lcdDisplay.println(num, base);
+  return gfx->println(num, base);
 }
 
 size_t display_println(unsigned long num, int base) {
-  return lcdDisplay.println(num, base);
+  return gfx->println(num, base);
 }
 
 size_t display_println(double num, int fieldWidth) {
-  return lcdDisplay.println(num, fieldWidth);
+  return gfx->println(num, fieldWidth);
 }
 
 size_t display_println(void) {
-  return lcdDisplay.println();
+  return gfx->println();
 }
 
 size_t display_print(const char str[]) {
-	return lcdDisplay.print(str);
+	return gfx->print(str);
 }
 
 size_t display_print(char c) {
-	return lcdDisplay.print(c);
+	return gfx->print(c);
 }
 
 size_t display_print(unsigned char c, int base) {
-	return lcdDisplay.print(c, base);
+	return gfx->print(c, base);
 }
 
 size_t display_print(int num, int base) {
-	return lcdDisplay.print(num, base);
+	return gfx->print(num, base);
 }
 
 size_t display_print(unsigned int num, int base) {
-	return lcdDisplay.print(num, base);
+	return gfx->print(num, base);
 }
 
 size_t display_print(long num, int base) {
-	return lcdDisplay.print(num, base);
+	return gfx->print(num, base);
 }
 
 size_t display_print(unsigned long num, int base) {
-	return lcdDisplay.print(num, base);
+	return gfx->print(num, base);
 }
 
 size_t display_print(double num, int fieldWidth) {
-	return lcdDisplay.print(num, fieldWidth);
+	return gfx->print(num, fieldWidth);
 }
 
 
@@ -224,10 +296,10 @@ bool display_isTouched(void) {
 // These min and max values correspond to the edges of the LCD panel.
 // x runs from the min value at the bottom, max value at the top.
 // y runs from the min value at the left, max value at the right.
-#define MIN_Y_TOUCH_POINT 280.0
-#define MAX_Y_TOUCH_POINT 3900.0
-#define MIN_X_TOUCH_POINT 350.0
-#define MAX_X_TOUCH_POINT 3950.0
+#define MIN_Y_TOUCH_POINT ((double) DISPLAY_TOUCH_MIN_Y_CODE)
+#define MAX_Y_TOUCH_POINT ((double) DISPLAY_TOUCH_MAX_Y_CODE)
+#define MIN_X_TOUCH_POINT ((double) DISPLAY_TOUCH_MIN_X_CODE)
+#define MAX_X_TOUCH_POINT ((double) DISPLAY_TOUCH_MAX_X_CODE)
 // Maps the touch-screen coordinates back to the LCD coordinate space.
 void display_mapToLcdCoordinates(int16_t *x, int16_t *y) {
     // Swap incoming x and y to match with the LCD panel.
@@ -259,6 +331,11 @@ void display_clearOldTouchData() {
   touchController.clearOldTouchData();
 }
 
+// Raw samples, one SPI burst.
+uint8_t display_readTouchSamples(int16_t x[], int16_t y[], uint8_t z[], uint8_t maxCount) {
+  return touchController.readDataBurst(x, y, z, maxCount);
+}
+
 // Display test routines, just adapted from the original Adafruit code.
 
 // quick hack for min - to be used for these test functions only.
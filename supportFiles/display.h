@@ -48,6 +48,32 @@ typedef uint16_t display_pixel_t; // Standard pixel type.
 // Constructs the necessary LCD and touch-controller objects and performs necessary initializations.
 void display_init();
 
+// Optional shadow frame buffer (see frameBuffer.h). While it is in use, the drawing and print functions
+// below only update memory and note what changed; nothing reaches the LCD until display_flush().
+// The first flush after enabling it repaints the whole screen (black until drawn on).
+// Disabling it flushes, then drawing goes straight to the LCD again.
+void display_useFrameBuffer(bool enable);
+
+// Sends the changed parts of the frame buffer to the LCD (does nothing without the frame buffer).
+void display_flush();
+
+// Draws a w x h block of pixels (row by row) at (x, y). On the LCD this is one address window and
+// one stream of pixel data, where drawing the pixels one at a time sets up a window for each.
+void display_blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels);
+
+// Like display_blit(), for a 1-bit image in display_drawBitmap()'s layout (rows of (w + 7) / 8 bytes,
+// most significant bit leftmost): set bits are drawn in color, clear bits in bg.
+// Text with a background color (display_setTextColor(c, bg)) goes out this way, a string at a time.
+void display_blitMono(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h,
+    uint16_t color, uint16_t bg);
+
+// Between these two, the drawing functions draw into bitmap (w x h, display_blitMono()'s layout,
+// cleared first, coordinates from its upper-left corner) instead of the display. Any color but
+// DISPLAY_BLACK sets a bit. Use it to draw a sprite once, then display_blitMono() it where needed.
+// Text in a sprite starts at its upper-left corner, with the default text settings.
+void display_beginSprite(uint8_t* bitmap, int16_t w, int16_t h);
+void display_endSprite();
+
 // The functionality for these functions comes from Adafruit_GFX.cpp and Adafruit_TFTLCD.cpp.
 void
   display_drawPixel(int16_t x0, int16_t y0, uint16_t color),
@@ -125,6 +151,17 @@ bool display_isTouched(void);
 void display_getTouchedPoint(int16_t *x, int16_t *y, uint8_t *z);
 // Throws away all previous touch data.
 void display_clearOldTouchData();
+// Reads up to maxCount raw samples (oldest first, not mapped to LCD coordinates) from the touch
+// controller's FIFO in one SPI burst. Returns the number read (0 if the FIFO is empty).
+uint8_t display_readTouchSamples(int16_t x[], int16_t y[], uint8_t z[], uint8_t maxCount);
+
+// Raw touch-controller codes at the edges of the LCD, used by display_getTouchedPoint() to map samples.
+// The panel is mounted rotated: its y runs along the LCD's x (left to right) and its x along the LCD's y
+// (bottom to top).
+#define DISPLAY_TOUCH_MIN_X_CODE 350   // Raw y at the left edge.
+#define DISPLAY_TOUCH_MAX_X_CODE 3950  // Raw y at the right edge.
+#define DISPLAY_TOUCH_MIN_Y_CODE 280   // Raw x at the bottom edge.
+#define DISPLAY_TOUCH_MAX_Y_CODE 3900  // Raw x at the top edge.
 
 
 #endif /* DISPLAY_H_ */
@@ -0,0 +1,250 @@
+/*
+ * frameBuffer.cpp
+ *
+ * See frameBuffer.h.
+ */
+
+#include <string.h>
+#include "frameBuffer.h"
+
+// Bus bytes to send a rectangle on its own.
+static uint32_t frameBuffer_cost(const frameBuffer_rect_t *r) {
+  uint32_t area = (uint32_t) (r->x1 - r->x0 + 1) * (uint32_t) (r->y1 - r->y0 + 1);
+  return FRAME_BUFFER_WINDOW_BYTES + area * FRAME_BUFFER_BYTES_PER_PIXEL;
+}
+
+// Smallest rectangle holding both.
+static frameBuffer_rect_t frameBuffer_union(const frameBuffer_rect_t *a, const frameBuffer_rect_t *b) {
+  frameBuffer_rect_t u;
+  u.x0 = a->x0 < b->x0 ? a->x0 : b->x0;
+  u.y0 = a->y0 < b->y0 ? a->y0 : b->y0;
+  u.x1 = a->x1 > b->x1 ? a->x1 : b->x1;
+  u.y1 = a->y1 > b->y1 ? a->y1 : b->y1;
+  return u;
+}
+
+// A rectangle that holds nothing yet; store() grows it.
+static frameBuffer_rect_t frameBuffer_empty() {
+  frameBuffer_rect_t r = {INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN};
+  return r;
+}
+
+// True if the two share a pixel.
+static bool frameBuffer_overlaps(const frameBuffer_rect_t *a, const frameBuffer_rect_t *b) {
+  return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+// True if outer holds all of inner.
+static bool frameBuffer_contains(const frameBuffer_rect_t *outer, const frameBuffer_rect_t *inner) {
+  return outer->x0 <= inner->x0 && outer->y0 <= inner->y0 && outer->x1 >= inner->x1 && outer->y1 >= inner->y1;
+}
+
+FrameBuffer::FrameBuffer(int16_t w, int16_t h, uint16_t *pixels) : Adafruit_GFX(w, h) {
+  this->pixels = pixels;
+  memset(pixels, 0, (size_t) w * h * sizeof(uint16_t));
+  memset(&stats, 0, sizeof(stats));
+  invalidate();
+}
+
+void FrameBuffer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+  uint16_t *pixel = &pixels[(int32_t) y * _width + x];
+  if (*pixel == color) return;
+  *pixel = color;
+  stats.pixelsChanged++;
+  frameBuffer_rect_t r = {x, y, x, y};
+  markDirty(r);
+}
+
+void FrameBuffer::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void FrameBuffer::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+// Clips, fills, and marks dirty only the bounding box of the pixels that actually changed.
+void FrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  int16_t x1 = x + w - 1, y1 = y + h - 1;
+  if (w <= 0 || h <= 0 || x1 < 0 || y1 < 0 || x >= _width || y >= _height) return;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 >= _width) x1 = _width - 1;
+  if (y1 >= _height) y1 = _height - 1;
+
+  frameBuffer_rect_t changed = frameBuffer_empty();
+  for (int16_t row = y; row <= y1; row++)
+    for (int16_t column = x; column <= x1; column++)
+      store(column, row, color, &changed);
+  markChanged(changed);
+}
+
+void FrameBuffer::blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels) {
+  frameBuffer_rect_t changed = frameBuffer_empty();
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      store(x + i, y + j, *pixels++, &changed);
+  markChanged(changed);
+}
+
+void FrameBuffer::blitMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color,
+    uint16_t bg) {
+  int16_t byteWidth = (w + 7) / 8;
+  frameBuffer_rect_t changed = frameBuffer_empty();
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      store(x + i, y + j, (bitmap[j * byteWidth + i / 8] & (128 >> (i & 7))) ? color : bg, &changed);
+  markChanged(changed);
+}
+
+// Writes one pixel (if it is on the screen) and grows changed to hold it if its color changed.
+void FrameBuffer::store(int16_t x, int16_t y, uint16_t color, frameBuffer_rect_t *changed) {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+  uint16_t *pixel = &pixels[(int32_t) y * _width + x];
+  if (*pixel == color) return;
+  *pixel = color;
+  stats.pixelsChanged++;
+  if (x < changed->x0) changed->x0 = x;
+  if (x > changed->x1) changed->x1 = x;
+  if (y < changed->y0) changed->y0 = y;
+  if (y > changed->y1) changed->y1 = y;
+}
+
+// Marks the bounding box of a block's changed pixels dirty, if any changed.
+void FrameBuffer::markChanged(frameBuffer_rect_t changed) {
+  if (changed.x0 <= changed.x1)
+    markDirty(changed);
+}
+
+void FrameBuffer::setRotation(uint8_t r) {
+  Adafruit_GFX::setRotation(r);
+  invalidate();
+}
+
+uint16_t FrameBuffer::readPixel(int16_t x, int16_t y) {
+  if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return 0;
+  return pixels[(int32_t) y * _width + x];
+}
+
+void FrameBuffer::invalidate() {
+  memset(dirtyCount, 0, sizeof(dirtyCount));
+  frameBuffer_rect_t screen = {0, 0, (int16_t) (_width - 1), (int16_t) (_height - 1)};
+  markDirty(screen);
+}
+
+// Splits rect (on the screen) at the band boundaries.
+void FrameBuffer::markDirty(frameBuffer_rect_t rect) {
+  for (int16_t y = rect.y0; y <= rect.y1;) {
+    uint32_t band = y / FRAME_BUFFER_BAND_ROWS;
+    int16_t bandEnd = (int16_t) ((band + 1) * FRAME_BUFFER_BAND_ROWS - 1);
+    frameBuffer_rect_t part = {rect.x0, y, rect.x1, rect.y1 < bandEnd ? rect.y1 : bandEnd};
+    markBandDirty(band, part);
+    y = part.y1 + 1;
+  }
+}
+
+// Keeps rect in its band. With the band full, merges the two rectangles whose union costs the least extra.
+void FrameBuffer::markBandDirty(uint32_t band, frameBuffer_rect_t rect) {
+  frameBuffer_rect_t *rects = dirty[band];
+  for (uint32_t i = 0; i < dirtyCount[band]; i++) {
+    if (frameBuffer_contains(&rects[i], &rect)) return;  // Most pixel writes land here.
+  }
+  keep(band, rect);
+  if (dirtyCount[band] <= FRAME_BUFFER_BAND_RECTS)
+    return;
+  uint32_t bestI = 0, bestJ = 1;
+  uint32_t bestExtra = UINT32_MAX;
+  for (uint32_t i = 0; i < dirtyCount[band]; i++) {
+    for (uint32_t j = i + 1; j < dirtyCount[band]; j++) {
+      frameBuffer_rect_t u = frameBuffer_union(&rects[i], &rects[j]);
+      uint32_t extra = frameBuffer_cost(&u) - frameBuffer_cost(&rects[i]) - frameBuffer_cost(&rects[j]);
+      if (extra < bestExtra) {
+        bestExtra = extra;
+        bestI = i;
+        bestJ = j;
+      }
+    }
+  }
+  frameBuffer_rect_t u = frameBuffer_union(&rects[bestI], &rects[bestJ]);
+  rects[bestJ] = rects[--dirtyCount[band]];  // bestJ > bestI, so this never moves rects[bestI] away.
+  rects[bestI] = rects[--dirtyCount[band]];
+  keep(band, u);
+}
+
+// Adds rect to its band, merged with every rectangle there that it overlaps or is cheaper to send with.
+void FrameBuffer::keep(uint32_t band, frameBuffer_rect_t rect) {
+  frameBuffer_rect_t *rects = dirty[band];
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (uint32_t i = 0; i < dirtyCount[band]; i++) {
+      frameBuffer_rect_t u = frameBuffer_union(&rects[i], &rect);
+      if (frameBuffer_overlaps(&rects[i], &rect) ||
+          frameBuffer_cost(&u) <= frameBuffer_cost(&rects[i]) + frameBuffer_cost(&rect)) {
+        rect = u;
+        rects[i] = rects[--dirtyCount[band]];  // The union replaces it; look again, it may reach others now.
+        merged = true;
+        break;
+      }
+    }
+  }
+  rects[dirtyCount[band]++] = rect;
+}
+
+// Sends one rectangle with one address window.
+void FrameBuffer::send(const frameBuffer_backend_t *backend, const frameBuffer_rect_t *r) {
+  uint32_t w = r->x1 - r->x0 + 1;
+  backend->setWindow(r->x0, r->y0, r->x1, r->y1);
+  for (int16_t row = r->y0; row <= r->y1; row++)
+    backend->pushPixels(&pixels[(int32_t) row * _width + r->x0], w, row == r->y0);
+  stats.windowCount++;
+  stats.pixelsSent += w * (uint32_t) (r->y1 - r->y0 + 1);
+  stats.bytesSent += frameBuffer_cost(r);
+}
+
+// The bands top to bottom, or the whole screen at once if that costs less. A rectangle that the band
+// boundaries split (same columns, one right below the other) is joined up again first.
+void FrameBuffer::flush(const frameBuffer_backend_t *backend) {
+  uint32_t bandCount = (_height + FRAME_BUFFER_BAND_ROWS - 1) / FRAME_BUFFER_BAND_ROWS;
+  frameBuffer_rect_t screen = {0, 0, (int16_t) (_width - 1), (int16_t) (_height - 1)};
+  for (uint32_t band = 0; band + 1 < bandCount; band++) {
+    for (uint32_t i = 0; i < dirtyCount[band]; i++) {
+      frameBuffer_rect_t *r = &dirty[band][i];
+      for (uint32_t below = band + 1; below < bandCount && r->y1 == (int16_t) (below * FRAME_BUFFER_BAND_ROWS - 1); below++) {
+        uint32_t j = 0;
+        while (j < dirtyCount[below] && !(dirty[below][j].y0 == r->y1 + 1 && dirty[below][j].x0 == r->x0 &&
+            dirty[below][j].x1 == r->x1))
+          j++;
+        if (j == dirtyCount[below])
+          break;
+        r->y1 = dirty[below][j].y1;
+        dirty[below][j] = dirty[below][--dirtyCount[below]];
+      }
+    }
+  }
+  uint32_t cost = 0;
+  for (uint32_t band = 0; band < bandCount; band++)
+    for (uint32_t i = 0; i < dirtyCount[band]; i++)
+      cost += frameBuffer_cost(&dirty[band][i]);
+  if (cost > frameBuffer_cost(&screen)) {
+    send(backend, &screen);
+  } else {
+    for (uint32_t band = 0; band < bandCount; band++)
+      for (uint32_t i = 0; i < dirtyCount[band]; i++)
+        send(backend, &dirty[band][i]);
+  }
+  memset(dirtyCount, 0, sizeof(dirtyCount));
+  stats.flushCount++;
+}
+
+uint32_t FrameBuffer::dirtyRectCount() {
+  uint32_t count = 0;
+  for (uint32_t band = 0; band < FRAME_BUFFER_MAX_BANDS; band++)
+    count += dirtyCount[band];
+  return count;
+}
+
+const frameBuffer_statistics_t *FrameBuffer::statistics() {
+  return &stats;
+}
@@ -0,0 +1,101 @@
+/*
+ * frameBuffer.h
+ *
+ * A shadow copy of the screen in memory (RGB565: 150 KB for 320x240, which lives in DDR).
+ * The Adafruit_GFX primitives draw into it and only record which rectangles changed;
+ * flush() then sends each changed rectangle to the LCD with one address-window setup,
+ * instead of one (or, for drawPixel(), several) per primitive.
+ *
+ * The screen is split into bands of FRAME_BUFFER_BAND_ROWS rows, each with its own list of dirty
+ * rectangles. Within a band, rectangles are merged when they overlap, or when sending their union costs
+ * no more bus bytes than sending them separately (FRAME_BUFFER_WINDOW_BYTES per window plus two bytes
+ * per pixel); so no pixel is sent twice, and when a band's list is full the merge that costs the least
+ * never grows a rectangle beyond its band. flush() sends the whole screen as one window instead whenever
+ * that costs less than the rectangles. Writes that leave a pixel's color unchanged do not mark it dirty.
+ *
+ * Where the pixels go is up to a frameBuffer_backend_t: display.cpp sends them to the TFT, and
+ * tools/displayFlush counts bus bytes on the host.
+ */
+
+#ifndef FRAMEBUFFER_H_
+#define FRAMEBUFFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Adafruit_GFX.h"
+
+#define FRAME_BUFFER_BAND_ROWS 16         // Rows of a band.
+#define FRAME_BUFFER_MAX_BANDS 20         // Bands of the longer side (320 rows in portrait).
+#define FRAME_BUFFER_BAND_RECTS 8         // Beyond this, the two rectangles of a band that merge cheapest are merged.
+#define FRAME_BUFFER_WINDOW_BYTES 11      // ILI9341: column and page address commands (1 + 4 bytes each), memory write.
+#define FRAME_BUFFER_BYTES_PER_PIXEL 2    // RGB565 over the 8-bit bus.
+
+// A rectangle, corners inclusive.
+typedef struct {
+  int16_t x0, y0;
+  int16_t x1, y1;
+} frameBuffer_rect_t;
+
+// Where flush() sends the dirty rectangles: an address window (corners inclusive, in rotated
+// coordinates, like Adafruit_TFTLCD::setAddrWindow()), then its pixels row by row. first is true
+// for the first pixels of a window.
+typedef struct {
+  void (*setWindow)(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+  void (*pushPixels)(const uint16_t* pixels, uint32_t count, bool first);
+} frameBuffer_backend_t;
+
+// Counts since the frame buffer was made.
+typedef struct {
+  uint32_t flushCount;
+  uint32_t windowCount;       // Rectangles sent.
+  uint64_t pixelsChanged;     // Pixel writes that changed a color.
+  uint64_t pixelsSent;
+  uint64_t bytesSent;         // Bus bytes, by the FRAME_BUFFER_WINDOW_BYTES/FRAME_BUFFER_BYTES_PER_PIXEL model.
+} frameBuffer_statistics_t;
+
+class FrameBuffer : public Adafruit_GFX {
+
+ public:
+
+  // w and h are the unrotated size (like Adafruit_TFTLCD: 240x320); pixels holds w * h of them.
+  // Starts black, with the whole screen dirty.
+  FrameBuffer(int16_t w, int16_t h, uint16_t *pixels);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels);
+  void blitMono(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+
+  // The stored pixels only mean something in one rotation: changing it makes the whole screen dirty.
+  void setRotation(uint8_t r);
+
+  // Sends every dirty rectangle to backend and forgets them.
+  void flush(const frameBuffer_backend_t *backend);
+
+  // The color stored at (x, y) (0 outside the screen).
+  uint16_t readPixel(int16_t x, int16_t y);
+
+  // Marks the whole screen dirty, e.g. when the LCD may not show what the buffer holds.
+  void invalidate();
+
+  uint32_t dirtyRectCount();
+  const frameBuffer_statistics_t *statistics();
+
+ private:
+
+  void store(int16_t x, int16_t y, uint16_t color, frameBuffer_rect_t *changed);
+  void markChanged(frameBuffer_rect_t changed);
+  void markDirty(frameBuffer_rect_t rect);
+  void markBandDirty(uint32_t band, frameBuffer_rect_t rect);
+  void keep(uint32_t band, frameBuffer_rect_t rect);
+  void send(const frameBuffer_backend_t *backend, const frameBuffer_rect_t *r);
+
+  uint16_t *pixels;                                     // _width * _height, row by row.
+  frameBuffer_rect_t dirty[FRAME_BUFFER_MAX_BANDS][FRAME_BUFFER_BAND_RECTS + 1];  // One spare while merging.
+  uint8_t dirtyCount[FRAME_BUFFER_MAX_BANDS];
+  frameBuffer_statistics_t stats;
+};
+
+#endif /* FRAMEBUFFER_H_ */
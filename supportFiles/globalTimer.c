@@ -59,6 +59,11 @@ u64 globalTimer_getTimerValue(void) {
   return timerValue;                           // That should be it.
 }
 
+// Single read, for short durations measured where the 64-bit read is too slow (e.g., in the ISR).
+u32 globalTimer_getLowerTimerValue(void) {
+  return globalTimer_readRegister(GLOBAL_TIMER_LOWER_COUNTER_REGISTER);
+}
+
 // Used to set individual control register bits.
 void globalTimer_setControlRegisterBit(u8 bitNumber) {
   // Read the control register first so you can OR specific bits and leave others untouched.
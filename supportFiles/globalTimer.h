@@ -28,6 +28,10 @@
 // Returns the current value for the 64-bit ARM global timer.
 u64 globalTimer_getTimerValue(void);
 
+// Returns the lower 32 bits of the global timer with a single register read.
+// Enough to time anything shorter than 2^32 ticks (about 13 seconds); use unsigned subtraction.
+u32 globalTimer_getLowerTimerValue(void);
+
 // Starts the timer counter.
 void globalTimer_startTimer(bool printStatusFlag);
 
@@ -13,6 +13,10 @@
 #include "intervalTimer.h"
 #endif
 
+#ifdef INTERRUPTS_ENABLE_ISR_TIMING
+#include "src/390_libs/isrTiming.h"
+#endif
+
 //static queue_t debugAdcQueue;
 //#define ADC_QUEUE_SIZE 100000
 //
@@ -188,6 +192,12 @@ void sysMonIsr(void *CallBackRef) {
 // ******************************* Timer ISR ***************************************
 // *********************************************************************************
 void timerIsr(void* callBackRef){
+#ifdef INTERRUPTS_ENABLE_ISR_TIMING  // Read the counters first so nothing else is counted as latency.
+  // The private timer counts down from its load value and fired when it reached 0,
+  // so the ticks it has counted since then are the entry latency.
+  u32 isrEntryLatency = (privateTimerLoadValue - interrupts_getPrivateTimerCounterValue()) * (privateTimerPrescaler + 1);
+  u32 isrEntryTime = globalTimer_getLowerTimerValue();
+#endif
 #ifdef ENABLE_INTERVAL_TIMER_0_IN_TIMER_ISR  // Enable interval timing when this is defined.
 	intervalTimer_start(INTERRUPT_CUMULATIVE_ISR_INTERVAL_TIMER_NUMBER);
 #endif
@@ -207,6 +217,9 @@ void timerIsr(void* callBackRef){
 
 #ifdef ENABLE_INTERVAL_TIMER_0_IN_TIMER_ISR   // Enable interval timing when this is defined.
   intervalTimer_stop(INTERRUPT_CUMULATIVE_ISR_INTERVAL_TIMER_NUMBER);
+#endif
+#ifdef INTERRUPTS_ENABLE_ISR_TIMING
+  isrTiming_record(isrEntryLatency, globalTimer_getLowerTimerValue() - isrEntryTime);
 #endif
   XScuTimer_ClearInterruptStatus(&TimerInstance);
 }
@@ -320,6 +333,10 @@ int initTimerInterrupts() {
 // if printFailedStatusFlag is true, it prints out diagnostic messages if something goes awry.
 int interrupts_initAll(bool printFailedStatusFlag) {
 //	initAdcQueue();
+#ifdef INTERRUPTS_ENABLE_ISR_TIMING
+  globalTimer_startTimer(false);     // Times the ISR duration.
+  isrTiming_init(ZYBO_BUS_CLOCK);    // The private and global timers both count at the bus clock.
+#endif
   int status;  // General Xilinx status.
   // Lookup the GIC device and get its handle.
   GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
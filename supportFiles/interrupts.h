@@ -21,6 +21,9 @@
 // Uses interval timer 0 to measure time spent in ISR.
 #define ENABLE_INTERVAL_TIMER_0_IN_TIMER_ISR 1
 
+// Records the entry latency and duration of every timer interrupt in histograms (see src/390_libs/isrTiming.h).
+#define INTERRUPTS_ENABLE_ISR_TIMING 1
+
 //queue_data_t interrupts_popAdcQueueData();
 //bool interrupts_adcQueueEmpty();
 //queue_size_t interrupts_adcQueueElementCount();
@@ -0,0 +1,470 @@
+// Measures the shadow frame buffer (supportFiles/frameBuffer.h) on the host: draws a few scenes the way
+// the labs do, once straight to a model of the LCD bus and once into the frame buffer with a flush after
+// each update, and prints the bus bytes each way against the pixels that actually changed.
+// The flushes go to a host backend that keeps its own copy of the LCD's memory, which is compared
+// with the frame buffer after every flush; the run fails on any difference.
+//
+// Bus bytes follow Adafruit_TFTLCD on the ILI9341: drawPixel() costs two address commands, a memory
+// write and the pixel (13 bytes); drawFastHLine/VLine(), fillRect() and fillScreen() cost an address
+// window, a memory write, two bytes per pixel and the setLR() that follows (8 bytes), and so do blit() and
+// blitMono() (and so opaque text, a run of characters at a time).
+// Before the scenes, text drawn a string at a time (Adafruit_GFX::drawText()) is compared pixel for pixel
+// with the same text drawn the original way, character by character and square by square.
+// Build and run (from the repository root):
+//   g++ -x c++ -O2 -I. -IsupportFiles -Itools/displayFlush/stubs -o displayFlush tools/displayFlush/displayFlush.c
+//       supportFiles/frameBuffer.cpp supportFiles/Adafruit_GFX.cpp supportFiles/Print.cpp supportFiles/WString.cpp
+//   ./displayFlush
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "supportFiles/display.h"
+#include "supportFiles/frameBuffer.h"
+
+#define DISPLAY_FLUSH_ROTATION 1                  // Landscape, as display_init() sets it.
+#define DISPLAY_FLUSH_ADDRESS_BYTES 10            // Column and page address commands, 1 + 4 bytes each.
+#define DISPLAY_FLUSH_MEMORY_WRITE_BYTES 1        // The memory-write command.
+#define DISPLAY_FLUSH_SET_LR_BYTES 8              // Two writeRegisterPair() calls after each fill.
+#define DISPLAY_FLUSH_PIXEL_BYTES 2
+
+// Adafruit_TFTLCD's bus traffic, without an LCD: counts the bytes each primitive would send.
+class DirectLcd : public Adafruit_GFX {
+
+ public:
+
+  uint64_t bytes;
+  uint32_t transfers;                             // Address windows set up.
+
+  DirectLcd() : Adafruit_GFX(DISPLAY_HEIGHT, DISPLAY_WIDTH) {
+    bytes = 0;
+    transfers = 0;
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t) {
+    if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+    bytes += DISPLAY_FLUSH_ADDRESS_BYTES + DISPLAY_FLUSH_MEMORY_WRITE_BYTES + DISPLAY_FLUSH_PIXEL_BYTES;
+    transfers++;
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillRect(x, y, 1, h, color);
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t) {
+    int16_t x1 = x + w - 1, y1 = y + h - 1;
+    if (w <= 0 || h <= 0 || x1 < 0 || y1 < 0 || x >= _width || y >= _height) return;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 >= _width) x1 = _width - 1;
+    if (y1 >= _height) y1 = _height - 1;
+    uint32_t area = (uint32_t) (x1 - x + 1) * (uint32_t) (y1 - y + 1);
+    bytes += DISPLAY_FLUSH_ADDRESS_BYTES + DISPLAY_FLUSH_MEMORY_WRITE_BYTES + area * DISPLAY_FLUSH_PIXEL_BYTES +
+        DISPLAY_FLUSH_SET_LR_BYTES;
+    transfers++;
+  }
+
+  void fillScreen(uint16_t color) {
+    fillRect(0, 0, _width, _height, color);
+  }
+
+  void blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *) {
+    fillRect(x, y, w, h, 0);
+  }
+
+  void blitMono(int16_t x, int16_t y, const uint8_t *, int16_t w, int16_t h, uint16_t, uint16_t) {
+    fillRect(x, y, w, h, 0);
+  }
+};
+
+// The host backend: the LCD's memory, written through an address window like the ILI9341.
+static uint16_t lcdMemory[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static frameBuffer_rect_t lcdWindow;
+static int16_t lcdX, lcdY;                         // Next pixel in the window.
+static uint64_t lcdBytes;
+
+static void displayFlush_setWindow(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  lcdWindow.x0 = x0;
+  lcdWindow.y0 = y0;
+  lcdWindow.x1 = x1;
+  lcdWindow.y1 = y1;
+  lcdBytes += DISPLAY_FLUSH_ADDRESS_BYTES;
+}
+
+static void displayFlush_pushPixels(const uint16_t *pixels, uint32_t count, bool first) {
+  if (first) {
+    lcdX = lcdWindow.x0;
+    lcdY = lcdWindow.y0;
+    lcdBytes += DISPLAY_FLUSH_MEMORY_WRITE_BYTES;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    lcdMemory[(int32_t) lcdY * DISPLAY_WIDTH + lcdX] = pixels[i];
+    if (++lcdX > lcdWindow.x1) {
+      lcdX = lcdWindow.x0;
+      lcdY++;
+    }
+  }
+  lcdBytes += count * DISPLAY_FLUSH_PIXEL_BYTES;
+}
+
+static const frameBuffer_backend_t hostBackend = {displayFlush_setWindow, displayFlush_pushPixels};
+
+// One scene: draws update number step on gfx and returns false after the last one. Step 0 sets the
+// scene up (e.g. clears the screen) and is not counted.
+typedef bool (*displayFlush_scene_t)(Adafruit_GFX *gfx, uint32_t step);
+
+#define DISPLAY_FLUSH_CLOCK_TEXT_SIZE 6           // As Lab 4 draws it.
+#define DISPLAY_FLUSH_CLOCK_X 16
+#define DISPLAY_FLUSH_CLOCK_Y 96
+#define DISPLAY_FLUSH_CLOCK_SECONDS 60
+#define DISPLAY_FLUSH_TIME_SIZE 9                 // "hh:mm:ss" and its zero.
+
+// Lab 4: a minute of a clock that erases (in black) and redraws (in green) only the characters that change.
+static bool displayFlush_clock(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > DISPLAY_FLUSH_CLOCK_SECONDS)
+    return false;
+  char previous[DISPLAY_FLUSH_TIME_SIZE], current[DISPLAY_FLUSH_TIME_SIZE];
+  uint32_t seconds = 12 * 3600 + 59 * 60 + 30 + step;
+  snprintf(current, sizeof(current), "%2u:%02u:%02u", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+  seconds--;
+  snprintf(previous, sizeof(previous), "%2u:%02u:%02u", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+  gfx->setTextSize(DISPLAY_FLUSH_CLOCK_TEXT_SIZE);
+  if (step == 0)
+    gfx->fillScreen(DISPLAY_BLACK);
+  for (uint32_t i = 0; i + 1 < DISPLAY_FLUSH_TIME_SIZE; i++) {
+    if (step != 0 && previous[i] == current[i])
+      continue;
+    int16_t x = DISPLAY_FLUSH_CLOCK_X + i * DISPLAY_CHAR_WIDTH * DISPLAY_FLUSH_CLOCK_TEXT_SIZE;
+    if (step != 0)
+      gfx->drawChar(x, DISPLAY_FLUSH_CLOCK_Y, previous[i], DISPLAY_BLACK, DISPLAY_BLACK, DISPLAY_FLUSH_CLOCK_TEXT_SIZE);
+    gfx->drawChar(x, DISPLAY_FLUSH_CLOCK_Y, current[i], DISPLAY_GREEN, DISPLAY_GREEN, DISPLAY_FLUSH_CLOCK_TEXT_SIZE);
+  }
+  return true;
+}
+
+#define DISPLAY_FLUSH_BOARD_CELLS 3
+#define DISPLAY_FLUSH_BOARD_MOVES 9
+#define DISPLAY_FLUSH_MARK_INSET 15               // Pixels between a mark and its cell's edges.
+
+// Lab 5: the tic-tac-toe board, then nine moves of X (two lines) and O (a circle).
+static bool displayFlush_ticTacToe(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > DISPLAY_FLUSH_BOARD_MOVES)
+    return false;
+  int16_t cellWidth = gfx->width() / DISPLAY_FLUSH_BOARD_CELLS, cellHeight = gfx->height() / DISPLAY_FLUSH_BOARD_CELLS;
+  if (step == 0) {
+    gfx->fillScreen(DISPLAY_BLACK);
+    for (int16_t i = 1; i < DISPLAY_FLUSH_BOARD_CELLS; i++) {
+      gfx->drawFastVLine(i * cellWidth, 0, gfx->height(), DISPLAY_WHITE);
+      gfx->drawFastHLine(0, i * cellHeight, gfx->width(), DISPLAY_WHITE);
+    }
+    return true;
+  }
+  static const uint8_t moves[DISPLAY_FLUSH_BOARD_MOVES] = {4, 0, 2, 6, 3, 5, 1, 7, 8};
+  uint8_t cell = moves[step - 1];
+  int16_t x0 = (cell % DISPLAY_FLUSH_BOARD_CELLS) * cellWidth + DISPLAY_FLUSH_MARK_INSET;
+  int16_t y0 = (cell / DISPLAY_FLUSH_BOARD_CELLS) * cellHeight + DISPLAY_FLUSH_MARK_INSET;
+  int16_t x1 = x0 + cellWidth - 2 * DISPLAY_FLUSH_MARK_INSET, y1 = y0 + cellHeight - 2 * DISPLAY_FLUSH_MARK_INSET;
+  if (step % 2) {
+    gfx->drawLine(x0, y0, x1, y1, DISPLAY_YELLOW);
+    gfx->drawLine(x0, y1, x1, y0, DISPLAY_YELLOW);
+  } else {
+    gfx->drawCircle((x0 + x1) / 2, (y0 + y1) / 2, (y1 - y0) / 2, DISPLAY_CYAN);
+  }
+  return true;
+}
+
+#define DISPLAY_FLUSH_X_SIZE 63                   // The tic-tac-toe X sprite, corner to corner.
+#define DISPLAY_FLUSH_X_HEIGHT 69
+#define DISPLAY_FLUSH_O_RADIUS 26
+#define DISPLAY_FLUSH_O_SIZE (2 * DISPLAY_FLUSH_O_RADIUS + 1)
+
+// Lab 5 with sprites: the X and O drawn once into 1-bit images, each move blitted as one block.
+static bool displayFlush_marks(Adafruit_GFX *gfx, uint32_t step) {
+  static uint8_t xSprite[(DISPLAY_FLUSH_X_SIZE + 7) / 8 * DISPLAY_FLUSH_X_HEIGHT];
+  static uint8_t oSprite[(DISPLAY_FLUSH_O_SIZE + 7) / 8 * DISPLAY_FLUSH_O_SIZE];
+  if (step > DISPLAY_FLUSH_BOARD_MOVES)
+    return false;
+  int16_t cellWidth = gfx->width() / DISPLAY_FLUSH_BOARD_CELLS, cellHeight = gfx->height() / DISPLAY_FLUSH_BOARD_CELLS;
+  if (step == 0) {
+    GFXcanvas1 canvas(DISPLAY_FLUSH_X_SIZE, DISPLAY_FLUSH_X_HEIGHT, xSprite);
+    canvas.fillScreen(0);
+    canvas.drawLine(0, 0, DISPLAY_FLUSH_X_SIZE - 1, DISPLAY_FLUSH_X_HEIGHT - 1, 1);
+    canvas.drawLine(0, DISPLAY_FLUSH_X_HEIGHT - 1, DISPLAY_FLUSH_X_SIZE - 1, 0, 1);
+    canvas.setBitmap(oSprite, DISPLAY_FLUSH_O_SIZE, DISPLAY_FLUSH_O_SIZE);
+    canvas.fillScreen(0);
+    canvas.drawCircle(DISPLAY_FLUSH_O_RADIUS, DISPLAY_FLUSH_O_RADIUS, DISPLAY_FLUSH_O_RADIUS, 1);
+    return displayFlush_ticTacToe(gfx, step);
+  }
+  static const uint8_t moves[DISPLAY_FLUSH_BOARD_MOVES] = {4, 0, 2, 6, 3, 5, 1, 7, 8};
+  uint8_t cell = moves[step - 1];
+  int16_t x = (cell % DISPLAY_FLUSH_BOARD_CELLS) * cellWidth, y = (cell / DISPLAY_FLUSH_BOARD_CELLS) * cellHeight;
+  if (step % 2)
+    gfx->blitMono(x + (cellWidth - DISPLAY_FLUSH_X_SIZE) / 2, y + (cellHeight - DISPLAY_FLUSH_X_HEIGHT) / 2, xSprite,
+        DISPLAY_FLUSH_X_SIZE, DISPLAY_FLUSH_X_HEIGHT, DISPLAY_YELLOW, DISPLAY_BLACK);
+  else
+    gfx->blitMono(x + (cellWidth - DISPLAY_FLUSH_O_SIZE) / 2, y + (cellHeight - DISPLAY_FLUSH_O_SIZE) / 2, oSprite,
+        DISPLAY_FLUSH_O_SIZE, DISPLAY_FLUSH_O_SIZE, DISPLAY_CYAN, DISPLAY_BLACK);
+  return true;
+}
+
+#define DISPLAY_FLUSH_TEXT_LINES 28
+
+// Status text with a background color, a line at a time (drawChar() fills every pixel of the cell).
+static bool displayFlush_text(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > DISPLAY_FLUSH_TEXT_LINES)
+    return false;
+  if (step == 0) {
+    gfx->fillScreen(DISPLAY_BLACK);
+    gfx->setCursor(0, 0);
+    gfx->setTextSize(1);
+    gfx->setTextColor(DISPLAY_WHITE, DISPLAY_BLUE);
+    return true;
+  }
+  gfx->print("tick ");
+  gfx->print((int) step);
+  gfx->println(": hits 3, shots 17, health 5");
+  return true;
+}
+
+// Lab 4's clock drawn with a background color instead: the new characters overwrite the old ones.
+static bool displayFlush_clockOverwrite(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > DISPLAY_FLUSH_CLOCK_SECONDS)
+    return false;
+  char previous[DISPLAY_FLUSH_TIME_SIZE], current[DISPLAY_FLUSH_TIME_SIZE];
+  uint32_t seconds = 12 * 3600 + 59 * 60 + 30 + step;
+  snprintf(current, sizeof(current), "%2u:%02u:%02u", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+  seconds--;
+  snprintf(previous, sizeof(previous), "%2u:%02u:%02u", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+  if (step == 0)
+    gfx->fillScreen(DISPLAY_BLACK);
+  for (uint32_t i = 0; i + 1 < DISPLAY_FLUSH_TIME_SIZE; i++) {
+    if (step != 0 && previous[i] == current[i])
+      continue;
+    int16_t x = DISPLAY_FLUSH_CLOCK_X + i * DISPLAY_CHAR_WIDTH * DISPLAY_FLUSH_CLOCK_TEXT_SIZE;
+    gfx->drawChar(x, DISPLAY_FLUSH_CLOCK_Y, current[i], DISPLAY_GREEN, DISPLAY_BLACK, DISPLAY_FLUSH_CLOCK_TEXT_SIZE);
+  }
+  return true;
+}
+
+// The text of runningModes_printRunTimeStatistics() (made-up numbers), in white; over black if opaque.
+static void displayFlush_drawStatistics(Adafruit_GFX *gfx, bool opaque) {
+  gfx->setTextSize(1);
+  if (opaque)
+    gfx->setTextColor(DISPLAY_WHITE, DISPLAY_BLACK);
+  else
+    gfx->setTextColor(DISPLAY_WHITE);
+  gfx->setCursor(0, 0);
+  gfx->print("Elements remaining in ADC queue:"); gfx->print(0); gfx->println(); gfx->println();
+  gfx->print("ADC values dropped (buffer full):"); gfx->print(0); gfx->println(); gfx->println();
+  gfx->print("Measured run time in seconds: "); gfx->print(12.34); gfx->println(); gfx->println();
+  gfx->print("Cumulative run time in timerIsr: "); gfx->print(3.21); gfx->print(" (");
+  gfx->print(26.01); gfx->println("%)"); gfx->println();
+  gfx->print("Cumulative run-time in detector: "); gfx->print(5.67); gfx->print(" (");
+  gfx->print(45.95); gfx->println("%)"); gfx->println();
+  gfx->print("Total interrupts:            "); gfx->println(1234000); gfx->println();
+  gfx->print("Detector invocation count: "); gfx->println(1233987); gfx->println();
+  gfx->print("Detector invocations per second: "); gfx->println(99999.0); gfx->println();
+  gfx->print("Detector invocation to interrupt ratio: "); gfx->println(0.99); gfx->println();
+  gfx->print("Worst-case ticks per interrupt: "); gfx->print(3); gfx->print(" of "); gfx->println(7);
+  gfx->println();
+  gfx->print("ISR latency p99/max (us): "); gfx->print(1.25); gfx->print(" / "); gfx->println(3.50);
+  gfx->print("ISR duration p99/max (us): "); gfx->print(4.75); gfx->print(" / "); gfx->println(9.25);
+}
+
+static bool displayFlush_statistics(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > 1)
+    return false;
+  if (step == 0)
+    gfx->fillScreen(DISPLAY_BLACK);
+  else
+    displayFlush_drawStatistics(gfx, false);
+  return true;
+}
+
+static bool displayFlush_statisticsOverBlack(Adafruit_GFX *gfx, uint32_t step) {
+  if (step > 1)
+    return false;
+  if (step == 0)
+    gfx->fillScreen(DISPLAY_BLACK);
+  else
+    displayFlush_drawStatistics(gfx, true);
+  return true;
+}
+
+#define DISPLAY_FLUSH_CIRCLE_RADIUS 20
+
+// The filled circles of display_testFilledCircles(), a column per update.
+static bool displayFlush_circles(Adafruit_GFX *gfx, uint32_t step) {
+  int16_t x = DISPLAY_FLUSH_CIRCLE_RADIUS + (step - 1) * 2 * DISPLAY_FLUSH_CIRCLE_RADIUS;
+  if (step > 0 && x >= gfx->width())
+    return false;
+  if (step == 0) {
+    gfx->fillScreen(DISPLAY_BLACK);
+    return true;
+  }
+  for (int16_t y = DISPLAY_FLUSH_CIRCLE_RADIUS; y < gfx->height(); y += 2 * DISPLAY_FLUSH_CIRCLE_RADIUS)
+    gfx->fillCircle(x, y, DISPLAY_FLUSH_CIRCLE_RADIUS, DISPLAY_RED);
+  return true;
+}
+
+typedef struct {
+  const char *name;
+  displayFlush_scene_t draw;
+} displayFlush_sceneEntry_t;
+
+static const displayFlush_sceneEntry_t scenes[] = {
+  {"clock", displayFlush_clock},
+  {"clockBg", displayFlush_clockOverwrite},
+  {"ticTacToe", displayFlush_ticTacToe},
+  {"marks", displayFlush_marks},
+  {"text", displayFlush_text},
+  {"stats", displayFlush_statistics},
+  {"statsBg", displayFlush_statisticsOverBlack},
+  {"circles", displayFlush_circles},
+};
+#define DISPLAY_FLUSH_SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+// Checks that the LCD's memory holds what the frame buffer does.
+static bool displayFlush_lcdMatches(FrameBuffer *frameBuffer) {
+  for (int16_t y = 0; y < DISPLAY_HEIGHT; y++) {
+    for (int16_t x = 0; x < DISPLAY_WIDTH; x++) {
+      if (lcdMemory[(int32_t) y * DISPLAY_WIDTH + x] != frameBuffer->readPixel(x, y)) {
+        printf("The LCD differs from the frame buffer at (%d, %d).\n", x, y);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Text the original way: write() draws each character with drawGlyph(), i.e. the old drawChar().
+class GlyphByGlyph : public FrameBuffer {
+
+ public:
+
+  GlyphByGlyph(uint16_t *pixels) : FrameBuffer(DISPLAY_HEIGHT, DISPLAY_WIDTH, pixels) {
+  }
+
+  size_t write(uint8_t c) {
+    if (c == '\n') {
+      cursor_y += textsize * DISPLAY_CHAR_HEIGHT;
+      cursor_x = 0;
+    } else if (c != '\r') {
+      if (!((cursor_x >= _width) || (cursor_y >= _height) || (cursor_x + DISPLAY_CHAR_WIDTH * textsize - 1 < 0) ||
+          (cursor_y + DISPLAY_CHAR_HEIGHT * textsize - 1 < 0)))
+        drawGlyph(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+      cursor_x += textsize * DISPLAY_CHAR_WIDTH;
+      if (wrap && (cursor_x > (_width - textsize * DISPLAY_CHAR_WIDTH))) {
+        cursor_y += textsize * DISPLAY_CHAR_HEIGHT;
+        cursor_x = 0;
+      }
+    }
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) {
+    for (size_t i = 0; i < size; i++)
+      write(buffer[i]);
+    return size;
+  }
+};
+
+#define DISPLAY_FLUSH_TEXT_SIZE_COUNT 6
+#define DISPLAY_FLUSH_CHARACTER_COUNT 255 // The font has no glyph for 255.
+
+// Draws every character, wrapping, plus strings that start off the left edge and run off the right one,
+// and one that fills a whole line from the left edge (the widest strip at sizes 7 and 8).
+static void displayFlush_drawAllText(Adafruit_GFX *gfx, uint8_t size, bool opaque) {
+  static const int16_t startX[] = {-13, 0, 5, 250};
+  gfx->fillScreen(DISPLAY_BLUE);
+  gfx->setTextSize(size);
+  if (opaque)
+    gfx->setTextColor(DISPLAY_YELLOW, DISPLAY_BLACK);
+  else
+    gfx->setTextColor(DISPLAY_YELLOW);
+  uint8_t text[DISPLAY_FLUSH_CHARACTER_COUNT];
+  for (uint32_t c = 0; c < DISPLAY_FLUSH_CHARACTER_COUNT; c++)
+    text[c] = c;
+  gfx->setTextWrap(true);
+  gfx->setCursor(1, -3);
+  gfx->write(text, DISPLAY_FLUSH_CHARACTER_COUNT);
+  gfx->setTextWrap(false);
+  for (uint32_t i = 0; i < sizeof(startX) / sizeof(startX[0]); i++) {
+    gfx->setCursor(startX[i], gfx->height() - (i + 1) * DISPLAY_CHAR_HEIGHT * size + 2);
+    gfx->print("Total interrupts:\r 1234000");
+  }
+  gfx->setCursor(0, gfx->height() / 2);
+  gfx->print("ABCDEFGHIJ");
+}
+
+// Checks drawText() against the character-by-character original, opaque and transparent, at several sizes.
+static bool displayFlush_textMatches() {
+  static uint16_t expected[DISPLAY_WIDTH * DISPLAY_HEIGHT], actual[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+  static const uint8_t sizes[DISPLAY_FLUSH_TEXT_SIZE_COUNT] = {1, 2, 3, 7, 8, 9};
+  bool success = true;
+  for (uint32_t s = 0; s < DISPLAY_FLUSH_TEXT_SIZE_COUNT; s++) {
+    for (int opaque = 0; opaque < 2; opaque++) {
+      GlyphByGlyph reference(expected);
+      FrameBuffer frameBuffer(DISPLAY_HEIGHT, DISPLAY_WIDTH, actual);
+      reference.setRotation(DISPLAY_FLUSH_ROTATION);
+      frameBuffer.setRotation(DISPLAY_FLUSH_ROTATION);
+      displayFlush_drawAllText(&reference, sizes[s], opaque);
+      displayFlush_drawAllText(&frameBuffer, sizes[s], opaque);
+      if (memcmp(expected, actual, sizeof(actual)) != 0 || reference.getCursorX() != frameBuffer.getCursorX() ||
+          reference.getCursorY() != frameBuffer.getCursorY()) {
+        printf("Text of size %u (%s) differs from the original.\n", sizes[s], opaque ? "opaque" : "transparent");
+        success = false;
+      }
+    }
+  }
+  return success;
+}
+
+int main() {
+  static uint16_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+  bool success = displayFlush_textMatches();
+  printf("%-10s %7s %10s %10s %10s %8s %7s %14s\n", "scene", "updates", "direct tx", "direct B", "flushed B",
+      "windows", "saving", "B/changed px");
+  for (uint32_t s = 0; s < DISPLAY_FLUSH_SCENE_COUNT; s++) {
+    DirectLcd direct;
+    direct.setRotation(DISPLAY_FLUSH_ROTATION);
+    FrameBuffer frameBuffer(DISPLAY_HEIGHT, DISPLAY_WIDTH, pixels);
+    frameBuffer.setRotation(DISPLAY_FLUSH_ROTATION);
+    frameBuffer.flush(&hostBackend);  // The first flush paints the whole (black) screen: not part of the scene.
+    scenes[s].draw(&direct, 0);
+    scenes[s].draw(&frameBuffer, 0);
+    frameBuffer.flush(&hostBackend);
+    uint64_t startBytes = lcdBytes, startDirectBytes = direct.bytes;
+    uint32_t startTransfers = direct.transfers;
+    frameBuffer_statistics_t start = *frameBuffer.statistics();
+
+    uint32_t step = 1;
+    for (; scenes[s].draw(&direct, step); step++) {
+      scenes[s].draw(&frameBuffer, step);
+      frameBuffer.flush(&hostBackend);
+      if (!displayFlush_lcdMatches(&frameBuffer)) {
+        success = false;
+        break;
+      }
+    }
+
+    const frameBuffer_statistics_t *stats = frameBuffer.statistics();
+    uint64_t flushed = lcdBytes - startBytes;
+    uint64_t changed = stats->pixelsChanged - start.pixelsChanged;
+    if (flushed != stats->bytesSent - start.bytesSent) {
+      printf("%s: the backend counted %llu bytes, the frame buffer %llu.\n", scenes[s].name,
+          (unsigned long long) flushed, (unsigned long long) (stats->bytesSent - start.bytesSent));
+      success = false;
+    }
+    uint64_t directBytes = direct.bytes - startDirectBytes;
+    printf("%-10s %7u %10u %10llu %10llu %8u %6.1fx %14.2f\n", scenes[s].name, step - 1,
+        direct.transfers - startTransfers, (unsigned long long) directBytes, (unsigned long long) flushed,
+        stats->windowCount - start.windowCount, (double) directBytes / (flushed ? flushed : 1),
+        (double) flushed / (changed ? changed : 1));
+  }
+  printf("displayFlush %s.\n", success ? "passed" : "failed");
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
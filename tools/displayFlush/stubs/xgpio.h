@@ -0,0 +1,6 @@
+#ifndef XGPIO_H
+#define XGPIO_H
+
+// Host stand-in for the Xilinx BSP header: Adafruit_GFX.cpp includes it but uses nothing from it.
+
+#endif /* XGPIO_H */
@@ -0,0 +1,17 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+// Host stand-in for the Xilinx BSP header: just the fixed-width types the display code uses.
+
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#endif /* XIL_TYPES_H */
@@ -0,0 +1,71 @@
+#ifndef HOSTDISPLAY_H_
+#define HOSTDISPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A virtual TFT and touch panel, so that display.h (and everything drawn through it) runs on a workstation.
+// Nothing above the bus is replaced: display.cpp, Adafruit_TFTLCD.cpp and Adafruit_STMPE610.cpp are
+// compiled as they are and linked against host versions of the two lowest layers:
+//   hostLcd.c   implements lcd.h: an ILI9341 that decodes the 8-bit bus (address window, memory write,
+//               MADCTL rotation, inversion) into an RGB565 memory, counting every byte and command.
+//   hostTouch.c implements spi.h: an STMPE610 (chip ID, touch status, sample FIFO) fed by scripted touches,
+//               and utils.h: delays advance a simulated clock instead of spinning.
+// The clock also advances with every SPI byte, so code that polls display_isTouched() sees time pass.
+//
+// Build a program that draws through display.h with (from the repository root):
+//   g++ -x c++ -I. -IsupportFiles -Itools/hostDisplay/stubs <program> tools/hostDisplay/hostLcd.c
+//       tools/hostDisplay/hostTouch.c supportFiles/display.cpp supportFiles/Adafruit_TFTLCD.cpp
+//       supportFiles/Adafruit_STMPE610.cpp supportFiles/frameBuffer.cpp supportFiles/Adafruit_GFX.cpp
+//       supportFiles/Print.cpp supportFiles/WString.cpp
+// (leave out supportFiles/utils.cpp, lcd.c and spi.c). tools/hostDisplay/hostDisplayBench.c is an example.
+
+// Bus traffic since hostDisplay_resetCounts().
+typedef struct {
+  uint64_t busBytes;        // Every byte written on the 8-bit bus (write8() calls and repeated write strobes).
+  uint32_t commands;        // Bytes written in command mode: register writes, address sets, memory writes.
+  uint32_t memoryWrites;    // Memory-write commands: one per drawPixel(), fill or streamed block.
+  uint64_t pixelsWritten;   // Pixels stored into the panel's memory.
+  uint32_t errors;          // Bus sequences the panel would not accept (e.g. half a pixel before a command).
+} hostDisplay_counts_t;
+
+// Zeroes the counts, e.g. at the start of a frame.
+void hostDisplay_resetCounts();
+
+// Copies the counts since the last reset.
+void hostDisplay_getCounts(hostDisplay_counts_t* counts);
+
+// The panel as it looks in its current rotation: display_width() x display_height() pixels.
+int16_t hostDisplay_width();
+int16_t hostDisplay_height();
+
+// The RGB565 color seen at (x, y) (0 outside the panel).
+uint16_t hostDisplay_readPixel(int16_t x, int16_t y);
+
+// A checksum (FNV-1a) of everything the panel shows, for comparing runs.
+uint32_t hostDisplay_checksum();
+
+// Writes what the panel shows to a binary PPM (P6). Returns false if the file could not be written.
+bool hostDisplay_savePpm(const char* path);
+
+// Simulated time in microseconds: advanced by utils_msDelay()/utils_microsecondDelay(), LCD_delay(),
+// every SPI byte and hostDisplay_advance().
+uint64_t hostDisplay_getMicroseconds();
+void hostDisplay_advance(uint32_t microseconds);
+
+// Scripted touches, in screen coordinates (what display_getTouchedPoint() returns), at simulated times.
+// Events must be added in time order. While touched, the controller adds a sample to its FIFO every
+// HOST_DISPLAY_TOUCH_SAMPLE_US (see hostTouch.c).
+bool hostDisplay_touchAt(uint64_t microseconds, int16_t x, int16_t y, uint8_t z);
+bool hostDisplay_releaseAt(uint64_t microseconds);
+
+// Adds the events of a script file, one per line, times in milliseconds after startMicroseconds:
+//   <ms> touch <x> <y> [z]
+//   <ms> release
+// Blank lines and lines starting with # are skipped. Returns false (and prints why) on a bad line.
+bool hostDisplay_loadTouchScript(const char* path, uint64_t startMicroseconds);
+
+// Forgets every scripted event and lifts the finger.
+void hostDisplay_clearTouches();
+
+#endif /* HOSTDISPLAY_H_ */
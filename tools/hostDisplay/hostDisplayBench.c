@@ -0,0 +1,555 @@
+// Renders the labs' screens on the virtual TFT (hostDisplay.h) and reports what each frame costs on the bus.
+// Every scene draws through the real display stack, first straight to the LCD and then through the shadow
+// frame buffer (display_useFrameBuffer(), with a display_flush() per frame); both must end on the same
+// picture. For each, it prints the bytes and commands of the setup and of the frames that follow, and a
+// checksum of the final picture.
+//
+// Before the scenes, the touch path is checked: scripted touches all over the screen must come back from
+// display_getTouchedPoint() exactly, and land in the right tic-tac-toe square. The simon scene is driven by
+// touches too: simonDisplay_runTest() runs as on the board, waiting for the script's touches and releases.
+// Then the touch queue (touchQueue.h) is serviced on a simulated timer tick through a scripted touch, drag and
+// lift, which must come back as one press, one move and one release at the scripted points; the SPI time a
+// FIFO sample costs is printed for burst reads and for readData() one sample at a time.
+//
+// A baseline written with -w holds each scene's bus bytes and checksum; -b compares a run with it and fails
+// if a scene sends more bytes (a rendering regression) or ends on a different picture (a redraw regression).
+//
+// Build and run (from the repository root):
+//   g++ -x c++ -O2 -I. -IsupportFiles -Itools/hostDisplay/stubs -o hostDisplayBench
+//       tools/hostDisplay/hostDisplayBench.c tools/hostDisplay/hostLcd.c tools/hostDisplay/hostTouch.c
+//       supportFiles/display.cpp supportFiles/Adafruit_TFTLCD.cpp supportFiles/Adafruit_STMPE610.cpp
+//       supportFiles/frameBuffer.cpp supportFiles/Adafruit_GFX.cpp supportFiles/Print.cpp supportFiles/WString.cpp
+//       src/Lab4/clockDisplay.c src/Lab5/ticTacToeDisplay.c src/Lab6/simonDisplay.c src/Lab7/wamDisplay.c
+//       src/390M3T1/histogram.c src/390_libs/profiler.c src/390_libs/displayQueue.c
+//       src/390_libs/touchQueue.c src/390_libs/spscRing.c
+//   ./hostDisplayBench -b tools/hostDisplay/baseline.txt
+//
+// Usage: hostDisplayBench [options]
+//   -b file   compare with a baseline; fail on more bus bytes or a different picture.
+//   -w file   write the baseline.
+//   -o dir    write each scene's final picture as dir/<scene>.ppm.
+//   -t file   drive the simon scene with this touch script instead of the built-in one (see hostDisplay.h;
+//             times from the start of the scene). It needs a touch to start, then four more:
+//             tools/hostDisplay/simonTouches.txt holds the built-in ones.
+//   -v        print every frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "supportFiles/display.h"
+#include "supportFiles/utils.h"
+#include "src/Lab2/buttons.h"
+#include "src/Lab2/switches.h"
+#include "src/Lab4/clockDisplay.h"
+#include "src/Lab5/ticTacToeDisplay.h"
+#include "src/Lab6/simonDisplay.h"
+#include "src/Lab7/wamDisplay.h"
+#include "src/390M3T1/histogram.h"
+#include "src/390_libs/filter.h"
+#include "src/390_libs/displayQueue.h"
+#include "src/390_libs/touchQueue.h"
+#include "hostDisplay.h"
+
+#define HOST_DISPLAY_BENCH_TOUCH_GRID 7           // Pixels between the checked touch points.
+#define HOST_DISPLAY_BENCH_TOUCH_DELAY_MS 50      // What the games wait between clearing old touch data and reading.
+#define HOST_DISPLAY_BENCH_TOUCH_Z 64
+#define HOST_DISPLAY_BENCH_TOUCH_START_MS 1000    // display_init() spends 750 ms in the LCD's power-up delays.
+#define HOST_DISPLAY_BENCH_TOUCH_HOLD_MS 200      // How long the built-in simon script holds each touch.
+#define HOST_DISPLAY_BENCH_TOUCH_GAP_MS 300       // From one touch to the next.
+#define HOST_DISPLAY_BENCH_TOUCH_TIMEOUT_S 10     // A script with too few touches leaves the simon demo waiting.
+#define HOST_DISPLAY_BENCH_SIMON_TOUCHES 4        // One in each region.
+#define HOST_DISPLAY_BENCH_QUEUE_TICK_MS 50       // touchQueue_service() period, as from the Lab4 timer ISR.
+#define HOST_DISPLAY_BENCH_QUEUE_DRAG_MS 120      // From the touch to the drag.
+#define HOST_DISPLAY_BENCH_QUEUE_LIFT_MS 250      // From the touch to the lift.
+#define HOST_DISPLAY_BENCH_QUEUE_END_MS 400       // Ticks run until then.
+#define HOST_DISPLAY_BENCH_QUEUE_EVENTS 3         // Press, move, release.
+#define HOST_DISPLAY_BENCH_CLOCK_FRAMES 75        // Seconds: across the first minute's rollover.
+#define HOST_DISPLAY_BENCH_HISTOGRAM_FRAMES 20
+#define HOST_DISPLAY_BENCH_QUEUE_BUDGET_BYTES 8192   // Bus bytes the display queue may start commands within per loop iteration.
+#define HOST_DISPLAY_BENCH_QUEUE_ITERATIONS 4        // Loop iterations (frames) per histogram update.
+#define HOST_DISPLAY_BENCH_LINE_SIZE 256
+#define HOST_DISPLAY_BENCH_MAX_SCENES 16
+
+/****************************** What the UI modules link against ******************************/
+
+// No buttons or switches on the host: the scenes call the display functions themselves.
+int32_t buttons_read() {
+  return 0;
+}
+
+int32_t switches_read() {
+  return 0;
+}
+
+// Only histogram_plotUserFrequencyPower()'s error report reads the filters.
+double filter_getCurrentPowerValue(uint16_t) {
+  return 0;
+}
+
+/****************************** Scenes ******************************/
+
+// A scene draws its setup for frame 0, then one frame per call until it returns false.
+typedef struct {
+  const char* name;
+  bool (*draw)(uint32_t frame);
+  bool frameBuffer;                               // Can be drawn through the frame buffer too.
+} hostDisplayBench_scene_t;
+
+static uint32_t hostDisplayBench_random = 1;      // Fixed seed: every run draws the same frames.
+
+static uint32_t hostDisplayBench_nextRandom() {
+  hostDisplayBench_random = hostDisplayBench_random * 1664525 + 1013904223;
+  return hostDisplayBench_random >> 8;
+}
+
+// The clock counting up from 12:59:59, a second per frame.
+static bool hostDisplayBench_clock(uint32_t frame) {
+  if (frame == 0) {
+    clockDisplay_init();
+    clockDisplay_updateTimeDisplay(true);
+    return true;
+  }
+  if (frame > HOST_DISPLAY_BENCH_CLOCK_FRAMES)
+    return false;
+  clockDisplay_advanceTimeOneSecond();
+  return true;
+}
+
+// The receiver's power histogram, with new powers each frame.
+static bool hostDisplayBench_histogram(uint32_t frame) {
+  if (frame == 0) {
+    hostDisplayBench_random = 1;
+    histogram_init(FILTER_FREQUENCY_COUNT);
+    return true;
+  }
+  if (frame > HOST_DISPLAY_BENCH_HISTOGRAM_FRAMES)
+    return false;
+  double powers[FILTER_FREQUENCY_COUNT];
+  for (uint32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    powers[i] = 1.0 + hostDisplayBench_nextRandom() % 100000;
+  histogram_plotUserFrequencyPower(powers);
+  return true;
+}
+
+// The display queue's clock in the bench: bus bytes sent in this frame.
+static uint64_t hostDisplayBench_busBytes() {
+  hostDisplay_counts_t counts;
+  hostDisplay_getCounts(&counts);
+  return counts.busBytes;
+}
+
+// The same histogram updates drawn through the display queue, as runningModes.c does: a frame is one main-loop
+// iteration with a budget of bus bytes, and new powers come every few iterations. Max B is the longest the
+// detector is held off, to compare with the histogram scene's; bars that change faster than the queue drains
+// are drawn once, so the final picture matches it.
+static bool hostDisplayBench_histogramQueued(uint32_t frame) {
+  if (frame == 0) {
+    displayQueue_init(hostDisplayBench_busBytes);
+    histogram_useDisplayQueue(false);
+    hostDisplayBench_histogram(frame);
+    histogram_useDisplayQueue(true);
+    return true;
+  }
+  uint32_t update = (frame - 1) / HOST_DISPLAY_BENCH_QUEUE_ITERATIONS + 1;
+  if ((frame - 1) % HOST_DISPLAY_BENCH_QUEUE_ITERATIONS == 0 && update <= HOST_DISPLAY_BENCH_HISTOGRAM_FRAMES)
+    hostDisplayBench_histogram(update);
+  else if (update > HOST_DISPLAY_BENCH_HISTOGRAM_FRAMES && displayQueue_pendingCount() == 0) {
+    histogram_useDisplayQueue(false);
+    return false;
+  }
+  displayQueue_run(HOST_DISPLAY_BENCH_QUEUE_BUDGET_BYTES);
+  return true;
+}
+
+#define HOST_DISPLAY_BENCH_BOARD_SQUARES 9
+
+// A game of tic-tac-toe filling the board, then every mark erased.
+static bool hostDisplayBench_ticTacToe(uint32_t frame) {
+  static const uint8_t moves[HOST_DISPLAY_BENCH_BOARD_SQUARES] = {4, 0, 8, 2, 6, 3, 5, 7, 1};
+  if (frame == 0) {
+    ticTacToeDisplay_init();
+    display_fillScreen(DISPLAY_BLACK);
+    ticTacToeDisplay_drawBoardLines();
+    return true;
+  }
+  uint32_t move = (frame - 1) % HOST_DISPLAY_BENCH_BOARD_SQUARES;
+  bool erase = frame > HOST_DISPLAY_BENCH_BOARD_SQUARES;
+  if (frame > 2 * HOST_DISPLAY_BENCH_BOARD_SQUARES)
+    return false;
+  uint8_t row = moves[move] / 3, column = moves[move] % 3;
+  if (move % 2 == 0)
+    ticTacToeDisplay_drawX(row, column, erase);
+  else
+    ticTacToeDisplay_drawO(row, column, erase);
+  return true;
+}
+
+// Each simon region lit up and put back.
+static bool hostDisplayBench_simon(uint32_t frame) {
+  if (frame == 0) {
+    display_init();
+    display_fillScreen(DISPLAY_BLACK);
+    simonDisplay_drawAllButtons();
+    return true;
+  }
+  uint8_t region = (frame - 1) / 2;
+  if (region >= HOST_DISPLAY_BENCH_SIMON_TOUCHES)
+    return false;
+  if (frame % 2) {
+    simonDisplay_drawSquare(region, false);
+  } else {
+    simonDisplay_drawSquare(region, true);
+    simonDisplay_drawButton(region, false);
+  }
+  return true;
+}
+
+// Whack-a-mole's boards for 9, 6 and 4 moles, then the game-over screen.
+static bool hostDisplayBench_wam(uint32_t frame) {
+  static const wamDisplay_moleCount_e moleCounts[] = {wamDisplay_moleCount_9, wamDisplay_moleCount_6,
+      wamDisplay_moleCount_4};
+  const uint32_t boards = sizeof(moleCounts) / sizeof(moleCounts[0]);
+  if (frame == 0) {
+    display_init();
+    display_fillScreen(DISPLAY_BLACK);
+    wamDisplay_resetAllScoresAndLevel();
+    wamDisplay_drawSplashScreen();
+    return true;
+  }
+  if (frame <= boards) {
+    display_fillScreen(DISPLAY_BLACK);
+    wamDisplay_selectMoleCount(moleCounts[frame - 1]);
+    wamDisplay_setHitScore(frame * 3);
+    wamDisplay_incrementMissScore();
+    wamDisplay_incrementLevel();
+    wamDisplay_drawMoleBoard();
+    return true;
+  }
+  if (frame > boards + 1)
+    return false;
+  display_fillScreen(DISPLAY_BLACK);
+  wamDisplay_drawGameOverScreen();
+  return true;
+}
+
+static const char* hostDisplayBench_touchScript = NULL;  // -t, or NULL for the built-in touches.
+
+static void hostDisplayBench_touchTimeout(int) {
+  fprintf(stderr, "simonTouch: still waiting for touches after %d s.\n", HOST_DISPLAY_BENCH_TOUCH_TIMEOUT_S);
+  _exit(EXIT_FAILURE);
+}
+
+// simonDisplay_runTest() as it runs on the board, touched by the script: one frame, the whole run.
+static bool hostDisplayBench_simonTouch(uint32_t frame) {
+  if (frame == 0) {
+    hostDisplay_clearTouches();
+    return true;
+  }
+  if (frame > 1)
+    return false;
+  uint64_t start = hostDisplay_getMicroseconds();
+  if (hostDisplayBench_touchScript) {
+    if (!hostDisplay_loadTouchScript(hostDisplayBench_touchScript, start))
+      exit(EXIT_FAILURE);
+  } else {
+    // A touch and release to start, then the middle of each region.
+    static const int16_t points[HOST_DISPLAY_BENCH_SIMON_TOUCHES + 1][2] = {
+        {DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2}, {DISPLAY_WIDTH / 4, DISPLAY_HEIGHT / 4},
+        {3 * DISPLAY_WIDTH / 4, DISPLAY_HEIGHT / 4}, {DISPLAY_WIDTH / 4, 3 * DISPLAY_HEIGHT / 4},
+        {3 * DISPLAY_WIDTH / 4, 3 * DISPLAY_HEIGHT / 4}};
+    for (uint32_t i = 0; i <= HOST_DISPLAY_BENCH_SIMON_TOUCHES; i++) {
+      uint64_t at = start + (HOST_DISPLAY_BENCH_TOUCH_START_MS + (uint64_t) i * HOST_DISPLAY_BENCH_TOUCH_GAP_MS) * 1000;
+      hostDisplay_touchAt(at, points[i][0], points[i][1], HOST_DISPLAY_BENCH_TOUCH_Z);
+      hostDisplay_releaseAt(at + HOST_DISPLAY_BENCH_TOUCH_HOLD_MS * 1000);
+    }
+  }
+  signal(SIGALRM, hostDisplayBench_touchTimeout);
+  alarm(HOST_DISPLAY_BENCH_TOUCH_TIMEOUT_S);
+  simonDisplay_runTest(HOST_DISPLAY_BENCH_SIMON_TOUCHES);
+  alarm(0);
+  return true;
+}
+
+static const hostDisplayBench_scene_t scenes[] = {
+  {"clock", hostDisplayBench_clock, true},
+  {"histogram", hostDisplayBench_histogram, true},
+  {"histQueue", hostDisplayBench_histogramQueued, false},
+  {"ticTacToe", hostDisplayBench_ticTacToe, true},
+  {"simon", hostDisplayBench_simon, true},
+  {"wam", hostDisplayBench_wam, true},
+  {"simonTouch", hostDisplayBench_simonTouch, false},
+};
+#define HOST_DISPLAY_BENCH_SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+/****************************** Touch check ******************************/
+
+// Touches at (x, y) the way the games read a touch; true if the same point comes back.
+static bool hostDisplayBench_touchReturns(int16_t x, int16_t y) {
+  hostDisplay_touchAt(hostDisplay_getMicroseconds(), x, y, HOST_DISPLAY_BENCH_TOUCH_Z);
+  bool touched = display_isTouched();
+  display_clearOldTouchData();
+  utils_msDelay(HOST_DISPLAY_BENCH_TOUCH_DELAY_MS);
+  int16_t touchedX, touchedY;
+  uint8_t z;
+  display_getTouchedPoint(&touchedX, &touchedY, &z);
+  hostDisplay_releaseAt(hostDisplay_getMicroseconds());
+  bool released = !display_isTouched();
+  if (touched && released && touchedX == x && touchedY == y && z == HOST_DISPLAY_BENCH_TOUCH_Z)
+    return true;
+  fprintf(stderr, "A touch at (%d, %d) came back as (%d, %d)%s%s.\n", x, y, touchedX, touchedY,
+      touched ? "" : ", not touched", released ? "" : ", not released");
+  return false;
+}
+
+static bool hostDisplayBench_touchMatches() {
+  display_init();
+  bool success = true;
+  for (int16_t y = 0; y < DISPLAY_HEIGHT && success; y += HOST_DISPLAY_BENCH_TOUCH_GRID)
+    for (int16_t x = 0; x < DISPLAY_WIDTH && success; x += HOST_DISPLAY_BENCH_TOUCH_GRID)
+      success = hostDisplayBench_touchReturns(x, y);
+  success = success && hostDisplayBench_touchReturns(DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+  for (uint8_t square = 0; square < HOST_DISPLAY_BENCH_BOARD_SQUARES && success; square++) {
+    uint8_t expectedRow = square / 3, expectedColumn = square % 3;
+    int16_t x = (2 * expectedColumn + 1) * DISPLAY_WIDTH / 6, y = (2 * expectedRow + 1) * DISPLAY_HEIGHT / 6;
+    hostDisplay_touchAt(hostDisplay_getMicroseconds(), x, y, HOST_DISPLAY_BENCH_TOUCH_Z);
+    display_clearOldTouchData();
+    utils_msDelay(HOST_DISPLAY_BENCH_TOUCH_DELAY_MS);
+    uint8_t row, column;
+    ticTacToeDisplay_touchScreenComputeBoardRowColumn(&row, &column);
+    hostDisplay_releaseAt(hostDisplay_getMicroseconds());
+    if (row != expectedRow || column != expectedColumn) {
+      fprintf(stderr, "A touch at (%d, %d) hit tic-tac-toe square %d, %d instead of %d, %d.\n", x, y, row, column,
+          expectedRow, expectedColumn);
+      success = false;
+    }
+  }
+  hostDisplay_clearTouches();
+  return success;
+}
+
+// touchQueue_service() on a simulated tick: a touch, a drag and a lift are one press, one move and one release.
+static bool hostDisplayBench_touchQueueEvents() {
+  bool success = touchQueue_runTest();
+  touchQueue_init();
+  static const int16_t points[HOST_DISPLAY_BENCH_QUEUE_EVENTS][2] = {
+      {DISPLAY_WIDTH / 3, DISPLAY_HEIGHT / 4}, {2 * DISPLAY_WIDTH / 3, 3 * DISPLAY_HEIGHT / 4},
+      {2 * DISPLAY_WIDTH / 3, 3 * DISPLAY_HEIGHT / 4}};
+  static const touchQueue_eventType_t types[HOST_DISPLAY_BENCH_QUEUE_EVENTS] = {
+      touchQueue_press_e, touchQueue_move_e, touchQueue_release_e};
+  uint64_t start = hostDisplay_getMicroseconds();
+  hostDisplay_touchAt(start, points[0][0], points[0][1], HOST_DISPLAY_BENCH_TOUCH_Z);
+  hostDisplay_touchAt(start + HOST_DISPLAY_BENCH_QUEUE_DRAG_MS * 1000, points[1][0], points[1][1],
+      HOST_DISPLAY_BENCH_TOUCH_Z);
+  hostDisplay_releaseAt(start + HOST_DISPLAY_BENCH_QUEUE_LIFT_MS * 1000);
+  while (hostDisplay_getMicroseconds() < start + HOST_DISPLAY_BENCH_QUEUE_END_MS * 1000) {
+    utils_msDelay(HOST_DISPLAY_BENCH_QUEUE_TICK_MS);
+    touchQueue_service();
+  }
+  touchQueue_event_t event;
+  for (uint32_t i = 0; i < HOST_DISPLAY_BENCH_QUEUE_EVENTS; i++) {
+    if (!touchQueue_getEvent(&event)) {
+      fprintf(stderr, "touchQueue: event %u is missing.\n", i);
+      success = false;
+      break;
+    }
+    if (event.type != types[i] || event.x != points[i][0] || event.y != points[i][1]) {
+      fprintf(stderr, "touchQueue: event %u is type %d at (%d, %d), expected type %d at (%d, %d).\n", i, event.type,
+          event.x, event.y, types[i], points[i][0], points[i][1]);
+      success = false;
+    }
+  }
+  if (touchQueue_getEvent(&event)) {
+    fprintf(stderr, "touchQueue: unexpected event type %d at (%d, %d).\n", event.type, event.x, event.y);
+    success = false;
+  }
+  hostDisplay_clearTouches();
+  touchQueue_init();
+  return success;
+}
+
+// Holds a touch until the FIFO has a burst of samples in it.
+static void hostDisplayBench_fillTouchFifo() {
+  display_clearOldTouchData();
+  hostDisplay_touchAt(hostDisplay_getMicroseconds(), DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2, HOST_DISPLAY_BENCH_TOUCH_Z);
+  utils_msDelay(TOUCH_QUEUE_BURST_SIZE * 5);  // hostTouch.c samples every 5 ms.
+}
+
+// SPI time per FIFO sample: TOUCH_QUEUE_BURST_SIZE samples in one burst, then as many with readData().
+static void hostDisplayBench_touchFifoCost() {
+  int16_t x[TOUCH_QUEUE_BURST_SIZE], y[TOUCH_QUEUE_BURST_SIZE];
+  uint8_t z[TOUCH_QUEUE_BURST_SIZE];
+  hostDisplayBench_fillTouchFifo();
+  uint64_t start = hostDisplay_getMicroseconds();
+  uint8_t count = display_readTouchSamples(x, y, z, TOUCH_QUEUE_BURST_SIZE);
+  double burst = count ? (double) (hostDisplay_getMicroseconds() - start) / count : 0;
+  hostDisplay_clearTouches();
+  hostDisplayBench_fillTouchFifo();
+  start = hostDisplay_getMicroseconds();
+  for (uint8_t i = 0; i < count; i++)
+    display_getTouchedPoint(&x[i], &y[i], &z[i]);
+  double single = count ? (double) (hostDisplay_getMicroseconds() - start) / count : 0;
+  hostDisplay_clearTouches();
+  display_clearOldTouchData();
+  printf("touch FIFO: %u samples, %.1f us/sample in one burst, %.1f us/sample one at a time.\n", count, burst, single);
+}
+
+/****************************** Running and comparing ******************************/
+
+typedef struct {
+  char name[HOST_DISPLAY_BENCH_LINE_SIZE];
+  uint64_t busBytes;
+  uint32_t checksum;
+} hostDisplayBench_result_t;
+
+static hostDisplayBench_result_t results[HOST_DISPLAY_BENCH_MAX_SCENES];
+static uint32_t resultCount = 0;
+static bool hostDisplayBench_verbose = false;
+
+// Draws a scene; the frames' counts are added up. Returns false if the panel saw a bad bus sequence.
+static bool hostDisplayBench_run(const hostDisplayBench_scene_t* scene, bool frameBuffer) {
+  hostDisplay_counts_t setup, frame, total;
+  memset(&total, 0, sizeof(total));
+  uint64_t maxFrameBytes = 0;
+  uint32_t frames = 0;
+  display_useFrameBuffer(frameBuffer);
+  hostDisplay_resetCounts();
+  scene->draw(0);
+  display_flush();
+  hostDisplay_getCounts(&setup);
+  bool success = setup.errors == 0;
+  while (true) {
+    hostDisplay_resetCounts();
+    if (!scene->draw(frames + 1))
+      break;
+    display_flush();
+    hostDisplay_getCounts(&frame);
+    frames++;
+    total.busBytes += frame.busBytes;
+    total.commands += frame.commands;
+    total.memoryWrites += frame.memoryWrites;
+    total.pixelsWritten += frame.pixelsWritten;
+    success = success && frame.errors == 0;
+    if (frame.busBytes > maxFrameBytes)
+      maxFrameBytes = frame.busBytes;
+    if (hostDisplayBench_verbose)
+      printf("  frame %3u %10llu B %8u commands %7u writes %9llu px\n", frames,
+          (unsigned long long) frame.busBytes, frame.commands, frame.memoryWrites,
+          (unsigned long long) frame.pixelsWritten);
+  }
+  display_useFrameBuffer(false);
+
+  hostDisplayBench_result_t* result = &results[resultCount++];
+  snprintf(result->name, sizeof(result->name), "%s%s", scene->name, frameBuffer ? "/fb" : "");
+  result->busBytes = setup.busBytes + total.busBytes;
+  result->checksum = hostDisplay_checksum();
+  uint32_t perFrame = frames ? frames : 1;
+  printf("%-14s %10llu %9u %6u %12llu %12llu %10llu %10u  %08x\n", result->name,
+      (unsigned long long) setup.busBytes, setup.commands, frames, (unsigned long long) total.busBytes,
+      (unsigned long long) (total.busBytes / perFrame), (unsigned long long) maxFrameBytes,
+      total.commands / perFrame, result->checksum);
+  if (!success)
+    fprintf(stderr, "%s: the panel saw bus sequences it would not accept.\n", result->name);
+  return success;
+}
+
+static bool hostDisplayBench_writeBaseline(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "# hostDisplayBench baseline: scene, bus bytes (setup and frames), checksum of the final picture.\n");
+  for (uint32_t i = 0; i < resultCount; i++)
+    fprintf(file, "%s %llu %08x\n", results[i].name, (unsigned long long) results[i].busBytes, results[i].checksum);
+  return fclose(file) == 0;
+}
+
+static bool hostDisplayBench_compareBaseline(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  bool success = true;
+  char line[HOST_DISPLAY_BENCH_LINE_SIZE];
+  while (fgets(line, sizeof(line), file)) {
+    char name[HOST_DISPLAY_BENCH_LINE_SIZE];
+    unsigned long long busBytes;
+    unsigned checksum;
+    if (line[0] == '#' || sscanf(line, "%255s %llu %x", name, &busBytes, &checksum) != 3)
+      continue;
+    const hostDisplayBench_result_t* result = NULL;
+    for (uint32_t i = 0; i < resultCount; i++)
+      if (strcmp(results[i].name, name) == 0)
+        result = &results[i];
+    if (result == NULL) {
+      printf("%s: in the baseline but not drawn.\n", name);
+      continue;
+    }
+    if (result->busBytes != busBytes)
+      printf("%s: %llu bus bytes, %llu in the baseline (%+.1f%%).\n", name, (unsigned long long) result->busBytes,
+          busBytes, 100.0 * ((double) result->busBytes - busBytes) / (busBytes ? busBytes : 1));
+    if (result->busBytes > busBytes)
+      success = false;
+    if (result->checksum != checksum) {
+      printf("%s: the final picture differs from the baseline's.\n", name);
+      success = false;
+    }
+  }
+  fclose(file);
+  return success;
+}
+
+static void hostDisplayBench_usage(const char* program) {
+  fprintf(stderr, "Usage: %s [-b baseline] [-w baseline] [-o directory] [-t touchScript] [-v]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+  const char* baseline = NULL;
+  const char* newBaseline = NULL;
+  const char* pictures = NULL;
+  int option;
+  while ((option = getopt(argc, argv, "b:w:o:t:v")) != -1) {
+    switch (option) {
+    case 'b': baseline = optarg; break;
+    case 'w': newBaseline = optarg; break;
+    case 'o': pictures = optarg; break;
+    case 't': hostDisplayBench_touchScript = optarg; break;
+    case 'v': hostDisplayBench_verbose = true; break;
+    default: hostDisplayBench_usage(argv[0]); return EXIT_FAILURE;
+    }
+  }
+
+  bool success = hostDisplayBench_touchMatches();
+  success = hostDisplayBench_touchQueueEvents() && success;
+  hostDisplayBench_touchFifoCost();
+  printf("%-14s %10s %9s %6s %12s %12s %10s %10s  %8s\n", "scene", "setup B", "setup cmd", "frames", "frames B",
+      "B/frame", "max B", "cmd/frame", "checksum");
+  for (uint32_t s = 0; s < HOST_DISPLAY_BENCH_SCENE_COUNT; s++) {
+    success = hostDisplayBench_run(&scenes[s], false) && success;
+    uint32_t direct = results[resultCount - 1].checksum;
+    if (pictures) {
+      char path[HOST_DISPLAY_BENCH_LINE_SIZE];
+      snprintf(path, sizeof(path), "%s/%s.ppm", pictures, scenes[s].name);
+      if (!hostDisplay_savePpm(path)) {
+        perror(path);
+        success = false;
+      }
+    }
+    if (scenes[s].frameBuffer) {
+      success = hostDisplayBench_run(&scenes[s], true) && success;
+      if (results[resultCount - 1].checksum != direct) {
+        fprintf(stderr, "%s: the frame buffer ends on a different picture.\n", scenes[s].name);
+        success = false;
+      }
+    }
+  }
+  if (newBaseline)
+    success = hostDisplayBench_writeBaseline(newBaseline) && success;
+  if (baseline)
+    success = hostDisplayBench_compareBaseline(baseline) && success;
+  printf("hostDisplayBench %s.\n", success ? "passed" : "failed");
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
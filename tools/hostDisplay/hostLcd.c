@@ -0,0 +1,257 @@
+// lcd.h on the host: an ILI9341 at the end of the 8-bit bus. See hostDisplay.h.
+//
+// The panel decodes what Adafruit_TFTLCD sends, as the controller does: a byte written in command mode
+// starts a command and the data bytes that follow are its parameters. The column and page address
+// commands set the window, the memory write streams pixels into it (column by column, then page by page,
+// wrapping inside the window), MADCTL maps window coordinates onto the 240x320 memory, and the inversion
+// commands invert what is shown. Other commands are counted and their parameters ignored.
+
+#include <stdio.h>
+#include <string.h>
+#include "supportFiles/lcd.h"
+#include "hostDisplay.h"
+
+#define HOST_LCD_WIDTH 240                // The controller's memory, in its own (unrotated) orientation.
+#define HOST_LCD_HEIGHT 320
+#define HOST_LCD_NOP 0x00
+#define HOST_LCD_INVERT_OFF 0x20
+#define HOST_LCD_INVERT_ON 0x21
+#define HOST_LCD_COLUMN_ADDRESS_SET 0x2A
+#define HOST_LCD_PAGE_ADDRESS_SET 0x2B
+#define HOST_LCD_MEMORY_WRITE 0x2C
+#define HOST_LCD_MADCTL 0x36
+#define HOST_LCD_MADCTL_MY 0x80           // Pages run bottom to top.
+#define HOST_LCD_MADCTL_MX 0x40           // Columns run right to left.
+#define HOST_LCD_MADCTL_MV 0x20           // Columns and pages exchanged (landscape).
+#define HOST_LCD_ADDRESS_PARAMETERS 4     // Start and end, high byte first.
+
+static uint16_t hostLcd_memory[HOST_LCD_WIDTH * HOST_LCD_HEIGHT];
+static hostDisplay_counts_t hostLcd_counts;
+static bool hostLcd_commandMode = false;
+static uint8_t hostLcd_bus = 0;                 // The last byte written; a write strobe sends it again.
+static uint8_t hostLcd_command = HOST_LCD_NOP;  // The command the data bytes belong to.
+static uint32_t hostLcd_parameterCount = 0;     // Data bytes since the command.
+static uint8_t hostLcd_parameters[HOST_LCD_ADDRESS_PARAMETERS];
+static uint8_t hostLcd_madctl = 0;
+static bool hostLcd_inverted = false;
+static uint16_t hostLcd_columnStart = 0, hostLcd_columnEnd = HOST_LCD_WIDTH - 1;
+static uint16_t hostLcd_pageStart = 0, hostLcd_pageEnd = HOST_LCD_HEIGHT - 1;
+static uint16_t hostLcd_column = 0, hostLcd_page = 0;  // Where the next pixel of a memory write goes.
+static uint8_t hostLcd_pixelHigh = 0;
+
+// Window coordinates are limited to the memory as MADCTL orients it.
+static uint16_t hostLcd_columnCount() {
+  return (hostLcd_madctl & HOST_LCD_MADCTL_MV) ? HOST_LCD_HEIGHT : HOST_LCD_WIDTH;
+}
+
+static uint16_t hostLcd_pageCount() {
+  return (hostLcd_madctl & HOST_LCD_MADCTL_MV) ? HOST_LCD_WIDTH : HOST_LCD_HEIGHT;
+}
+
+// The memory word at a window position, under the current MADCTL.
+static uint16_t* hostLcd_cell(uint16_t column, uint16_t page) {
+  uint16_t x = column, y = page;
+  if (hostLcd_madctl & HOST_LCD_MADCTL_MV) {
+    x = page;
+    y = column;
+  }
+  if (hostLcd_madctl & HOST_LCD_MADCTL_MX)
+    x = HOST_LCD_WIDTH - 1 - x;
+  if (hostLcd_madctl & HOST_LCD_MADCTL_MY)
+    y = HOST_LCD_HEIGHT - 1 - y;
+  return &hostLcd_memory[(uint32_t) y * HOST_LCD_WIDTH + x];
+}
+
+// Stores a pixel of a memory write and steps to the next one, wrapping inside the window.
+static void hostLcd_storePixel(uint16_t color) {
+  if (hostLcd_column < hostLcd_columnCount() && hostLcd_page < hostLcd_pageCount())
+    *hostLcd_cell(hostLcd_column, hostLcd_page) = color;
+  else
+    hostLcd_counts.errors++;  // The window reaches off the panel.
+  hostLcd_counts.pixelsWritten++;
+  if (++hostLcd_column > hostLcd_columnEnd) {
+    hostLcd_column = hostLcd_columnStart;
+    if (++hostLcd_page > hostLcd_pageEnd)
+      hostLcd_page = hostLcd_pageStart;
+  }
+}
+
+// A byte in command mode: the previous command is over.
+static void hostLcd_commandByte(uint8_t value) {
+  if (hostLcd_command == HOST_LCD_MEMORY_WRITE && hostLcd_parameterCount % 2)
+    hostLcd_counts.errors++;  // Half a pixel.
+  hostLcd_counts.commands++;
+  hostLcd_command = value;
+  hostLcd_parameterCount = 0;
+  switch (value) {
+  case HOST_LCD_MEMORY_WRITE:
+    hostLcd_counts.memoryWrites++;
+    hostLcd_column = hostLcd_columnStart;
+    hostLcd_page = hostLcd_pageStart;
+    break;
+  case HOST_LCD_INVERT_OFF:
+    hostLcd_inverted = false;
+    break;
+  case HOST_LCD_INVERT_ON:
+    hostLcd_inverted = true;
+    break;
+  }
+}
+
+// A byte in data mode: a parameter of the current command, or half a pixel.
+static void hostLcd_dataByte(uint8_t value) {
+  uint32_t index = hostLcd_parameterCount++;
+  switch (hostLcd_command) {
+  case HOST_LCD_MEMORY_WRITE:
+    if (index % 2 == 0)
+      hostLcd_pixelHigh = value;
+    else
+      hostLcd_storePixel((uint16_t) (hostLcd_pixelHigh << 8) | value);
+    break;
+  case HOST_LCD_COLUMN_ADDRESS_SET:
+  case HOST_LCD_PAGE_ADDRESS_SET:
+    if (index >= HOST_LCD_ADDRESS_PARAMETERS)
+      break;
+    hostLcd_parameters[index] = value;
+    if (index == HOST_LCD_ADDRESS_PARAMETERS - 1) {
+      uint16_t start = (uint16_t) (hostLcd_parameters[0] << 8) | hostLcd_parameters[1];
+      uint16_t end = (uint16_t) (hostLcd_parameters[2] << 8) | hostLcd_parameters[3];
+      if (start > end)
+        hostLcd_counts.errors++;
+      if (hostLcd_command == HOST_LCD_COLUMN_ADDRESS_SET) {
+        hostLcd_columnStart = start;
+        hostLcd_columnEnd = end;
+      } else {
+        hostLcd_pageStart = start;
+        hostLcd_pageEnd = end;
+      }
+    }
+    break;
+  case HOST_LCD_MADCTL:
+    if (index == 0)
+      hostLcd_madctl = value;
+    break;
+  }
+}
+
+// Every byte on the bus goes through here, whether written or strobed again.
+static void hostLcd_busByte(uint8_t value) {
+  hostLcd_bus = value;
+  hostLcd_counts.busBytes++;
+  if (hostLcd_commandMode)
+    hostLcd_commandByte(value);
+  else
+    hostLcd_dataByte(value);
+}
+
+/****************************** lcd.h ******************************/
+
+void LCD_init() {
+}
+
+void LCD_setCommandMode() {
+  hostLcd_commandMode = true;
+}
+
+void LCD_setDataMode() {
+  hostLcd_commandMode = false;
+}
+
+void LCD_assertRd() {
+}
+
+void LCD_negateRd() {
+}
+
+void LCD_assertWr() {
+}
+
+void LCD_negateWr() {
+}
+
+void LCD_delay(uint16_t delay) {
+  hostDisplay_advance(delay * 1000);
+}
+
+void LCD_delayMicroseconds(uint16_t delay) {
+  hostDisplay_advance(delay);
+}
+
+void LCD_delay10Nanoseconds(uint16_t) {
+}
+
+void LCD_write8(uint8_t value) {
+  hostLcd_busByte(value);
+}
+
+// Nothing is read back: the display code only reads the ID, which begin() does not need.
+uint8_t LCD_read8() {
+  return 0;
+}
+
+void LCD_strobeWriteLine() {
+  hostLcd_busByte(hostLcd_bus);
+}
+
+void LCD_setReadDataDirection() {
+}
+
+void LCD_setWriteDataDirection() {
+}
+
+/****************************** hostDisplay.h ******************************/
+
+void hostDisplay_resetCounts() {
+  memset(&hostLcd_counts, 0, sizeof(hostLcd_counts));
+}
+
+void hostDisplay_getCounts(hostDisplay_counts_t* counts) {
+  *counts = hostLcd_counts;
+}
+
+int16_t hostDisplay_width() {
+  return hostLcd_columnCount();
+}
+
+int16_t hostDisplay_height() {
+  return hostLcd_pageCount();
+}
+
+uint16_t hostDisplay_readPixel(int16_t x, int16_t y) {
+  if (x < 0 || y < 0 || x >= hostDisplay_width() || y >= hostDisplay_height())
+    return 0;
+  uint16_t color = *hostLcd_cell(x, y);
+  return hostLcd_inverted ? (uint16_t) ~color : color;
+}
+
+#define HOST_LCD_FNV_OFFSET 2166136261u
+#define HOST_LCD_FNV_PRIME 16777619u
+
+uint32_t hostDisplay_checksum() {
+  uint32_t hash = HOST_LCD_FNV_OFFSET;
+  for (int16_t y = 0; y < hostDisplay_height(); y++) {
+    for (int16_t x = 0; x < hostDisplay_width(); x++) {
+      uint16_t color = hostDisplay_readPixel(x, y);
+      hash = (hash ^ (color >> 8)) * HOST_LCD_FNV_PRIME;
+      hash = (hash ^ (color & 0xFF)) * HOST_LCD_FNV_PRIME;
+    }
+  }
+  return hash;
+}
+
+// RGB565 to 8 bits per channel, the top bits repeated into the bottom ones so white stays white.
+bool hostDisplay_savePpm(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == NULL)
+    return false;
+  fprintf(file, "P6\n%d %d\n255\n", hostDisplay_width(), hostDisplay_height());
+  for (int16_t y = 0; y < hostDisplay_height(); y++) {
+    for (int16_t x = 0; x < hostDisplay_width(); x++) {
+      uint16_t color = hostDisplay_readPixel(x, y);
+      uint8_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+      uint8_t rgb[3] = {(uint8_t) (r << 3 | r >> 2), (uint8_t) (g << 2 | g >> 4), (uint8_t) (b << 3 | b >> 2)};
+      fwrite(rgb, 1, sizeof(rgb), file);
+    }
+  }
+  return fclose(file) == 0;
+}
@@ -0,0 +1,306 @@
+// spi.h and utils.h on the host: an STMPE610 touch controller at the end of the SPI bus, scripted touches,
+// and the simulated clock. See hostDisplay.h.
+//
+// The controller answers what Adafruit_STMPE610 asks of it. A transaction (slave select asserted, then
+// cleared) starts with a register address: with the top bit set it is a read, and the value comes back
+// on the third byte (the driver sends the address and a dummy byte, then reads), and every further byte
+// reads the register again (a burst); otherwise the next byte is written to the register. Modeled: the chip ID (0x0811), the touched bit of TSC_CTRL, the sample
+// FIFO (FIFO_STA, FIFO_SIZE, reset) and the data register, which gives a sample's four bytes one read at
+// a time and then drops it. Other registers just keep what was written.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "supportFiles/spi.h"
+#include "supportFiles/utils.h"
+#include "supportFiles/display.h"
+#include "hostDisplay.h"
+
+#define HOST_DISPLAY_TOUCH_SAMPLE_US 5000   // A sample every 5 ms while touched (4 averaged, 1 ms delay, settling).
+#define HOST_TOUCH_SPI_BYTE_US 8            // 8 bits at the driver's 1 MHz SPI clock.
+#define HOST_TOUCH_FIFO_SIZE 128            // Samples the controller holds.
+#define HOST_TOUCH_MAX_EVENTS 1024          // Scripted touches and releases yet to play.
+#define HOST_TOUCH_SAMPLE_BYTES 4           // x and y (12 bits each) and z, through the data register.
+#define HOST_TOUCH_READ 0x80                // Set in the address byte of a read.
+#define HOST_TOUCH_CHIP_ID_HIGH 0x00
+#define HOST_TOUCH_CHIP_ID_LOW 0x01
+#define HOST_TOUCH_TSC_CTRL 0x40
+#define HOST_TOUCH_TSC_CTRL_TOUCHED 0x80
+#define HOST_TOUCH_FIFO_STA 0x4B
+#define HOST_TOUCH_FIFO_STA_RESET 0x01
+#define HOST_TOUCH_FIFO_STA_OFLOW 0x80
+#define HOST_TOUCH_FIFO_STA_FULL 0x40
+#define HOST_TOUCH_FIFO_STA_EMPTY 0x20
+#define HOST_TOUCH_FIFO_SIZE_REGISTER 0x4C
+#define HOST_TOUCH_DATA 0x57                // The driver reads TSC_DATA as 0xD7: the read bit and 0x57.
+#define HOST_TOUCH_RAW_MAX 4095             // 12-bit samples.
+
+// display_mapToLcdCoordinates() (display.cpp) turns raw samples into screen coordinates with these;
+// the scripted screen coordinates are turned into samples the other way.
+#define HOST_TOUCH_MIN_Y ((double) DISPLAY_TOUCH_MIN_Y_CODE)
+#define HOST_TOUCH_MAX_Y ((double) DISPLAY_TOUCH_MAX_Y_CODE)
+#define HOST_TOUCH_MIN_X ((double) DISPLAY_TOUCH_MIN_X_CODE)
+#define HOST_TOUCH_MAX_X ((double) DISPLAY_TOUCH_MAX_X_CODE)
+#define HOST_TOUCH_LCD_WIDTH ((double) DISPLAY_WIDTH)
+#define HOST_TOUCH_LCD_HEIGHT ((double) DISPLAY_HEIGHT)
+
+typedef struct {
+  uint64_t time;       // Microseconds.
+  bool touched;        // false: the finger lifts.
+  int16_t x, y;
+  uint8_t z;
+} hostTouch_event_t;
+
+typedef struct {
+  uint8_t bytes[HOST_TOUCH_SAMPLE_BYTES];
+} hostTouch_sample_t;
+
+static uint64_t hostTouch_now = 0;
+static hostTouch_event_t hostTouch_events[HOST_TOUCH_MAX_EVENTS];
+static uint32_t hostTouch_eventCount = 0;
+static uint32_t hostTouch_nextEvent = 0;
+static bool hostTouch_touched = false;
+static hostTouch_sample_t hostTouch_current;    // What the panel reads while touched.
+static uint64_t hostTouch_nextSampleTime = 0;
+static hostTouch_sample_t hostTouch_fifo[HOST_TOUCH_FIFO_SIZE];
+static uint32_t hostTouch_fifoHead = 0, hostTouch_fifoCount = 0;
+static uint32_t hostTouch_dataByte = 0;         // Which byte of the oldest sample the data register gives next.
+static bool hostTouch_fifoOverflow = false;
+static bool hostTouch_fifoHeldInReset = false;
+static uint8_t hostTouch_registers[256];
+static bool hostTouch_selected = false;
+static uint32_t hostTouch_transferIndex = 0;    // Bytes since the slave select was asserted.
+static uint8_t hostTouch_address = 0;
+
+// Clamps to the 12 bits of a sample.
+static uint16_t hostTouch_raw(double value) {
+  if (value < 0)
+    return 0;
+  if (value > HOST_TOUCH_RAW_MAX)
+    return HOST_TOUCH_RAW_MAX;
+  return (uint16_t) value;
+}
+
+// Screen coordinates to a raw sample, aimed at the middle of the pixel so that the truncation in
+// display_mapToLcdCoordinates() gives back exactly the scripted point.
+static hostTouch_sample_t hostTouch_makeSample(int16_t x, int16_t y, uint8_t z) {
+  double xStep = (HOST_TOUCH_MAX_X - HOST_TOUCH_MIN_X) / HOST_TOUCH_LCD_WIDTH;
+  double yStep = (HOST_TOUCH_MAX_Y - HOST_TOUCH_MIN_Y) / HOST_TOUCH_LCD_HEIGHT;
+  // The panel's axes are swapped: its y is the screen's x, and its x runs bottom to top.
+  uint16_t rawY = hostTouch_raw(HOST_TOUCH_MIN_X + x * xStep + xStep / 2);
+  uint16_t rawX = hostTouch_raw(HOST_TOUCH_MAX_Y - (y * yStep + yStep / 2));
+  hostTouch_sample_t sample;
+  sample.bytes[0] = rawX >> 4;
+  sample.bytes[1] = (uint8_t) ((rawX & 0x0F) << 4 | rawY >> 8);
+  sample.bytes[2] = rawY & 0xFF;
+  sample.bytes[3] = z;
+  return sample;
+}
+
+static void hostTouch_resetFifo() {
+  hostTouch_fifoHead = 0;
+  hostTouch_fifoCount = 0;
+  hostTouch_dataByte = 0;
+  hostTouch_fifoOverflow = false;
+}
+
+static void hostTouch_pushSample() {
+  if (hostTouch_fifoHeldInReset)
+    return;
+  if (hostTouch_fifoCount == HOST_TOUCH_FIFO_SIZE) {
+    hostTouch_fifoOverflow = true;
+    return;
+  }
+  hostTouch_fifo[(hostTouch_fifoHead + hostTouch_fifoCount++) % HOST_TOUCH_FIFO_SIZE] = hostTouch_current;
+}
+
+// Plays the scripted events and takes the samples that are due by now.
+static void hostTouch_update() {
+  while (true) {
+    uint64_t eventTime = hostTouch_nextEvent < hostTouch_eventCount ?
+        hostTouch_events[hostTouch_nextEvent].time : UINT64_MAX;
+    if (hostTouch_touched && hostTouch_nextSampleTime <= hostTouch_now && hostTouch_nextSampleTime < eventTime) {
+      hostTouch_pushSample();
+      hostTouch_nextSampleTime += HOST_DISPLAY_TOUCH_SAMPLE_US;
+    } else if (eventTime <= hostTouch_now) {
+      const hostTouch_event_t* event = &hostTouch_events[hostTouch_nextEvent++];
+      if (event->touched) {
+        if (!hostTouch_touched)
+          hostTouch_nextSampleTime = event->time;  // A new touch is sampled at once; a moving one keeps its pace.
+        hostTouch_current = hostTouch_makeSample(event->x, event->y, event->z);
+      }
+      hostTouch_touched = event->touched;
+    } else {
+      return;
+    }
+  }
+}
+
+static uint8_t hostTouch_readRegister(uint8_t address) {
+  switch (address) {
+  case HOST_TOUCH_CHIP_ID_HIGH:
+    return 0x08;
+  case HOST_TOUCH_CHIP_ID_LOW:
+    return 0x11;
+  case HOST_TOUCH_TSC_CTRL:
+    return (hostTouch_registers[address] & ~HOST_TOUCH_TSC_CTRL_TOUCHED) |
+        (hostTouch_touched ? HOST_TOUCH_TSC_CTRL_TOUCHED : 0);
+  case HOST_TOUCH_FIFO_STA:
+    return (hostTouch_fifoHeldInReset ? HOST_TOUCH_FIFO_STA_RESET : 0) |
+        (hostTouch_fifoCount == 0 ? HOST_TOUCH_FIFO_STA_EMPTY : 0) |
+        (hostTouch_fifoCount == HOST_TOUCH_FIFO_SIZE ? HOST_TOUCH_FIFO_STA_FULL : 0) |
+        (hostTouch_fifoOverflow ? HOST_TOUCH_FIFO_STA_OFLOW : 0);
+  case HOST_TOUCH_FIFO_SIZE_REGISTER:
+    return hostTouch_fifoCount;
+  case HOST_TOUCH_DATA: {
+    if (hostTouch_fifoCount == 0)
+      return 0;
+    uint8_t value = hostTouch_fifo[hostTouch_fifoHead].bytes[hostTouch_dataByte];
+    if (++hostTouch_dataByte == HOST_TOUCH_SAMPLE_BYTES) {
+      hostTouch_dataByte = 0;
+      hostTouch_fifoHead = (hostTouch_fifoHead + 1) % HOST_TOUCH_FIFO_SIZE;
+      hostTouch_fifoCount--;
+    }
+    return value;
+  }
+  default:
+    return hostTouch_registers[address];
+  }
+}
+
+static void hostTouch_writeRegister(uint8_t address, uint8_t value) {
+  hostTouch_registers[address] = value;
+  if (address == HOST_TOUCH_FIFO_STA) {
+    hostTouch_fifoHeldInReset = value & HOST_TOUCH_FIFO_STA_RESET;
+    if (hostTouch_fifoHeldInReset)
+      hostTouch_resetFifo();
+  }
+}
+
+/****************************** spi.h ******************************/
+
+void spi_begin() {
+}
+
+void spi_setBitOrder(uint8_t) {
+}
+
+void spi_setClockDivider(uint8_t) {
+}
+
+void spi_setTransmissionMode(uint8_t) {
+}
+
+void spi_delay(uint32_t) {
+}
+
+void spi_setTouchScreenControllerSlaveSelect() {
+  hostTouch_selected = true;
+  hostTouch_transferIndex = 0;
+}
+
+void spi_clearAllSlaveSelects() {
+  hostTouch_selected = false;
+}
+
+uint8_t spi_transfer(uint8_t value) {
+  hostDisplay_advance(HOST_TOUCH_SPI_BYTE_US);
+  if (!hostTouch_selected)
+    return 0;
+  uint32_t index = hostTouch_transferIndex++;
+  if (index == 0) {
+    hostTouch_address = value;
+    return 0;
+  }
+  if (hostTouch_address & HOST_TOUCH_READ)
+    return index >= 2 ? hostTouch_readRegister(hostTouch_address & ~HOST_TOUCH_READ) : 0;
+  if (index == 1)
+    hostTouch_writeRegister(hostTouch_address, value);
+  return 0;
+}
+
+/****************************** utils.h ******************************/
+
+void utils_msDelay(long ms) {
+  hostDisplay_advance(ms * 1000);
+}
+
+void utils_microsecondDelay(long microSecondDelay) {
+  hostDisplay_advance(microSecondDelay);
+}
+
+/****************************** hostDisplay.h ******************************/
+
+uint64_t hostDisplay_getMicroseconds() {
+  return hostTouch_now;
+}
+
+void hostDisplay_advance(uint32_t microseconds) {
+  hostTouch_now += microseconds;
+  hostTouch_update();
+}
+
+static bool hostTouch_addEvent(uint64_t microseconds, bool touched, int16_t x, int16_t y, uint8_t z) {
+  if (hostTouch_eventCount == HOST_TOUCH_MAX_EVENTS && hostTouch_nextEvent > 0) {  // Make room: drop the played ones.
+    hostTouch_eventCount -= hostTouch_nextEvent;
+    memmove(hostTouch_events, &hostTouch_events[hostTouch_nextEvent], hostTouch_eventCount * sizeof(hostTouch_event_t));
+    hostTouch_nextEvent = 0;
+  }
+  if (hostTouch_eventCount == HOST_TOUCH_MAX_EVENTS ||
+      (hostTouch_eventCount > 0 && microseconds < hostTouch_events[hostTouch_eventCount - 1].time))
+    return false;
+  hostTouch_event_t event = {microseconds, touched, x, y, z};
+  hostTouch_events[hostTouch_eventCount++] = event;
+  hostTouch_update();
+  return true;
+}
+
+bool hostDisplay_touchAt(uint64_t microseconds, int16_t x, int16_t y, uint8_t z) {
+  return hostTouch_addEvent(microseconds, true, x, y, z);
+}
+
+bool hostDisplay_releaseAt(uint64_t microseconds) {
+  return hostTouch_addEvent(microseconds, false, 0, 0, 0);
+}
+
+#define HOST_TOUCH_SCRIPT_LINE_SIZE 256
+#define HOST_TOUCH_DEFAULT_Z 64            // Pressure when a script does not give one.
+
+bool hostDisplay_loadTouchScript(const char* path, uint64_t startMicroseconds) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "hostDisplay: cannot open %s.\n", path);
+    return false;
+  }
+  char line[HOST_TOUCH_SCRIPT_LINE_SIZE];
+  uint32_t lineNumber = 0;
+  bool success = true;
+  while (success && fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    char* text = line + strspn(line, " \t");
+    if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0')
+      continue;
+    double ms;
+    char action[16];
+    int x, y, z = HOST_TOUCH_DEFAULT_Z;
+    int fields = sscanf(text, "%lf %15s %d %d %d", &ms, action, &x, &y, &z);
+    uint64_t microseconds = startMicroseconds + (uint64_t) (ms * 1000);
+    if (fields >= 4 && ms >= 0 && strcmp(action, "touch") == 0)
+      success = hostDisplay_touchAt(microseconds, x, y, z);
+    else if (fields == 2 && ms >= 0 && strcmp(action, "release") == 0)
+      success = hostDisplay_releaseAt(microseconds);
+    else
+      success = false;
+    if (!success)
+      fprintf(stderr, "hostDisplay: %s:%u: expected \"<ms> touch <x> <y> [z]\" or \"<ms> release\", in time order.\n",
+          path, lineNumber);
+  }
+  fclose(file);
+  return success;
+}
+
+void hostDisplay_clearTouches() {
+  hostTouch_eventCount = 0;
+  hostTouch_nextEvent = 0;
+  hostTouch_touched = false;
+}
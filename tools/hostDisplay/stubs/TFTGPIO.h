@@ -0,0 +1,7 @@
+#ifndef TFTGPIO_H_
+#define TFTGPIO_H_
+
+// Host stand-in: lcd.h includes TFTGPIO.h (supportFiles/tftGpio.h on the board's case-insensitive build),
+// but nothing from it is used once hostLcd.c replaces lcd.c.
+
+#endif /* TFTGPIO_H_ */
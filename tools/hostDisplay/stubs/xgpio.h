@@ -0,0 +1,6 @@
+#ifndef XGPIO_H
+#define XGPIO_H
+
+// Host stand-in for the Xilinx BSP header: lcd.h includes it, but hostLcd.c replaces the GPIO calls.
+
+#endif /* XGPIO_H */
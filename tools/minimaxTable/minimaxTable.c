@@ -0,0 +1,163 @@
+// Solves tic-tac-toe once and writes the perfect-play table that minimax_computeNextMove() looks moves up
+// in (see src/Lab5/minimaxTable.h for the format). Every legal position that is not over, reduced to one
+// per symmetry class, gets the move to play: one that keeps the position's value, winning as soon as it
+// can and losing as late as it can, the first such square in row-major order of the canonical board.
+// minimax_runTest() checks every entry against the search. Build and regenerate (from the repository root):
+//   g++ -x c++ -O2 -I. -o minimaxTable tools/minimaxTable/minimaxTable.c
+//   ./minimaxTable src/Lab5/minimaxTable.c
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/Lab5/minimax.h"
+#include "src/Lab5/minimaxTable.h"
+
+#define MINIMAX_TABLE_SQUARES (MINIMAX_BOARD_ROWS * MINIMAX_BOARD_COLUMNS)
+#define MINIMAX_TABLE_POSITIONS 19683     // 3^9: every way to fill the squares.
+#define MINIMAX_TABLE_WIN 100             // Score of a win on the board, less one per move it takes.
+#define MINIMAX_TABLE_UNKNOWN INT16_MIN
+#define MINIMAX_TABLE_PER_LINE 12         // Entries per line of output.
+
+static const uint8_t lines[8][3] = {
+  {0, 1, 2}, {3, 4, 5}, {6, 7, 8}, {0, 3, 6}, {1, 4, 7}, {2, 5, 8}, {0, 4, 8}, {2, 4, 6}};
+
+static int16_t scores[MINIMAX_TABLE_POSITIONS];   // Negamax scores, for the player to move.
+static uint16_t powers[MINIMAX_TABLE_SQUARES];    // 3^square.
+
+static void decode(uint16_t position, uint8_t squares[]) {
+  for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++, position /= 3)
+    squares[i] = position % 3;
+}
+
+static bool wins(const uint8_t squares[], uint8_t player) {
+  for (uint8_t i = 0; i < 8; i++)
+    if (squares[lines[i][0]] == player && squares[lines[i][1]] == player && squares[lines[i][2]] == player)
+      return true;
+  return false;
+}
+
+// X squares minus O squares: 0 means X is to move, 1 means O is; anything else cannot happen.
+static int8_t balance(const uint8_t squares[]) {
+  int8_t count = 0;
+  for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++)
+    count += (squares[i] == MINIMAX_X_SQUARE) - (squares[i] == MINIMAX_O_SQUARE);
+  return count;
+}
+
+static bool isOver(const uint8_t squares[]) {
+  if (wins(squares, MINIMAX_X_SQUARE) || wins(squares, MINIMAX_O_SQUARE))
+    return true;
+  for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++)
+    if (squares[i] == MINIMAX_EMPTY_SQUARE)
+      return false;
+  return true;
+}
+
+// Score for the player to move (memoized): a win in n moves is MINIMAX_TABLE_WIN - n, a loss the negative.
+static int16_t solve(uint16_t position) {
+  if (scores[position] != MINIMAX_TABLE_UNKNOWN)
+    return scores[position];
+  uint8_t squares[MINIMAX_TABLE_SQUARES];
+  decode(position, squares);
+  uint8_t player = balance(squares) == 0 ? MINIMAX_X_SQUARE : MINIMAX_O_SQUARE;
+  uint8_t opponent = player == MINIMAX_X_SQUARE ? MINIMAX_O_SQUARE : MINIMAX_X_SQUARE;
+  int16_t best;
+  if (wins(squares, opponent)) {
+    best = -MINIMAX_TABLE_WIN;
+  } else {
+    best = 0;  // A full board is a draw.
+    bool first = true;
+    for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++) {
+      if (squares[i] != MINIMAX_EMPTY_SQUARE)
+        continue;
+      int16_t score = -solve(position + player * powers[i]);
+      score -= (score > 0) - (score < 0);  // One move further away.
+      if (first || score > best)
+        best = score;
+      first = false;
+    }
+  }
+  return scores[position] = best;
+}
+
+// The smallest index of the position under the symmetries, and the symmetry that gives it.
+static uint16_t canonical(const uint8_t squares[], uint8_t* symmetry) {
+  uint16_t smallest = UINT16_MAX;
+  for (uint8_t s = 0; s < MINIMAX_TABLE_SYMMETRY_COUNT; s++) {
+    uint16_t index = 0;
+    for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++)
+      index += squares[minimaxTable_symmetries[s][i]] * powers[i];
+    if (index < smallest) {
+      smallest = index;
+      *symmetry = s;
+    }
+  }
+  return smallest;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s output.c\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  for (uint32_t i = 0; i < MINIMAX_TABLE_POSITIONS; i++)
+    scores[i] = MINIMAX_TABLE_UNKNOWN;
+  powers[0] = 1;
+  for (uint8_t i = 1; i < MINIMAX_TABLE_SQUARES; i++)
+    powers[i] = powers[i - 1] * 3;
+
+  // Ascending positions, keeping the canonical ones: the keys come out sorted.
+  static uint16_t keys[MINIMAX_TABLE_POSITIONS];
+  static uint8_t moves[MINIMAX_TABLE_POSITIONS];
+  uint32_t count = 0, legal = 0;
+  for (uint32_t position = 0; position < MINIMAX_TABLE_POSITIONS; position++) {
+    uint8_t squares[MINIMAX_TABLE_SQUARES];
+    decode(position, squares);
+    int8_t toMove = balance(squares);
+    if ((toMove != 0 && toMove != 1) || isOver(squares))
+      continue;
+    legal++;
+    uint8_t symmetry;
+    if (canonical(squares, &symmetry) != position)
+      continue;
+    uint8_t player = toMove == 0 ? MINIMAX_X_SQUARE : MINIMAX_O_SQUARE;
+    int16_t best = solve(position);
+    for (uint8_t i = 0; i < MINIMAX_TABLE_SQUARES; i++) {
+      if (squares[i] != MINIMAX_EMPTY_SQUARE)
+        continue;
+      int16_t score = -solve(position + player * powers[i]);
+      score -= (score > 0) - (score < 0);
+      if (score == best) {
+        keys[count] = position;
+        moves[count++] = i;
+        break;
+      }
+    }
+  }
+
+  FILE* file = fopen(argv[1], "w");
+  if (!file) {
+    perror(argv[1]);
+    return EXIT_FAILURE;
+  }
+  fprintf(file, "// Generated by tools/minimaxTable/minimaxTable.c; do not edit. See minimaxTable.h.\n");
+  fprintf(file, "// %lu canonical positions (of %lu legal positions that are not over).\n\n",
+      (unsigned long) count, (unsigned long) legal);
+  fprintf(file, "#include \"minimaxTable.h\"\n\n");
+  fprintf(file, "const uint16_t minimaxTable_positionCount = %lu;\n\n", (unsigned long) count);
+  fprintf(file, "const uint16_t minimaxTable_positions[] = {");
+  for (uint32_t i = 0; i < count; i++)
+    fprintf(file, "%s%5u,", i % MINIMAX_TABLE_PER_LINE ? " " : "\n    ", keys[i]);
+  fprintf(file, "\n};\n\nconst uint8_t minimaxTable_moves[] = {");
+  for (uint32_t i = 0; i < count; i++)
+    fprintf(file, "%s%u,", i % (2 * MINIMAX_TABLE_PER_LINE) ? " " : "\n    ", moves[i]);
+  fprintf(file, "\n};\n");
+  if (fclose(file) != 0) {
+    perror(argv[1]);
+    return EXIT_FAILURE;
+  }
+  printf("%s: %lu positions, %lu bytes.\n", argv[1], (unsigned long) count,
+      (unsigned long) (count * (sizeof(keys[0]) + sizeof(moves[0]))));
+  return EXIT_SUCCESS;
+}
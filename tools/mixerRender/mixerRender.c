@@ -0,0 +1,182 @@
+// Plays a scripted stretch of a game through the mixer (see src/390_libs/mixer.h) using the real
+// sound assets, and writes what the speaker would get to a WAV file (48 kHz, mono, 16 bit) for listening.
+// The script overlaps the sounds the way a fire fight does: the trigger held down, a hit, the low-health
+// warning, an empty clip and a reload. It prints the clip count and peak, and fails if any sample clipped
+// or the hit or the low-health warning is cut short by voice stealing. Build and run (from the repository root):
+//   g++ -x c++ -O2 -I. -o mixerRender tools/mixerRender/mixerRender.c src/390_libs/mixer.c
+//       src/390_libs/adpcm.c src/390_libs/soundPack.c -x none src/sounds/sounds.S && ./mixerRender mixed.wav
+//
+// Options:
+//   -g gain   gain of every sound in 1/256ths (default MIXER_GAIN_UNITY, as the game plays them).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "src/390_libs/mixer.h"
+#include "src/390_libs/soundPack.h"
+#include "src/sounds/sounds.h"
+
+#define MIXER_RENDER_SAMPLE_RATE 48000                            // All of the game's sounds.
+#define MIXER_RENDER_MS_TO_SAMPLES(ms) ((ms) * (MIXER_RENDER_SAMPLE_RATE / 1000))
+#define MIXER_RENDER_DURATION MIXER_RENDER_MS_TO_SAMPLES(2500)    // Long enough for the reload to finish.
+#define MIXER_RENDER_WAV_HEADER_SIZE 44
+
+// A sound of the script, by its name in the sound pack. mustFinish marks the ones the player has to hear whole.
+typedef struct {
+  const char* name;
+  uint32_t soundId;
+  const char* packName;
+  bool mustFinish;
+} mixerRender_sound_t;
+
+enum { mixerRender_fire_e, mixerRender_hit_e, mixerRender_lowHealth_e, mixerRender_click_e, mixerRender_reload_e };
+
+static const mixerRender_sound_t sounds[] = {
+  {"fire", mixerRender_fire_e, "bcfire01_48k", false},
+  {"hit", mixerRender_hit_e, "ouch48k", true},
+  {"low health", mixerRender_lowHealth_e, "low_health", true},
+  {"click", mixerRender_click_e, "gunEmpty48k", false},
+  {"reload", mixerRender_reload_e, "powerUp48k", false},
+};
+
+// When each sound starts, in order.
+typedef struct {
+  uint32_t ms;
+  uint32_t sound;
+} mixerRender_event_t;
+
+static const mixerRender_event_t script[] = {
+  {0, mixerRender_fire_e},          // Trigger held: a shot every 120 ms until the clip is empty.
+  {120, mixerRender_fire_e},
+  {240, mixerRender_fire_e},
+  {250, mixerRender_hit_e},         // Shot by the other team...
+  {360, mixerRender_fire_e},
+  {400, mixerRender_lowHealth_e},   // ...which leaves us low on health.
+  {480, mixerRender_fire_e},
+  {600, mixerRender_fire_e},
+  {1000, mixerRender_click_e},      // Out of bullets.
+  {1200, mixerRender_reload_e},
+};
+#define MIXER_RENDER_EVENT_COUNT (sizeof(script) / sizeof(script[0]))
+#define MIXER_RENDER_SOUND_COUNT (sizeof(sounds) / sizeof(sounds[0]))
+
+// Writes a little-endian field.
+static void mixerRender_writeLittleEndian(uint8_t* bytes, uint32_t value, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++)
+    bytes[i] = (uint8_t) (value >> (8 * i));
+}
+
+// Writes mono 16-bit samples as a WAV file.
+static bool mixerRender_writeWav(const char* fileName, const int16_t pcm[], uint32_t sampleCount) {
+  FILE* file = fopen(fileName, "wb");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  uint32_t dataSize = sampleCount * sizeof(int16_t);
+  uint8_t header[MIXER_RENDER_WAV_HEADER_SIZE];
+  memcpy(header, "RIFF", 4);
+  mixerRender_writeLittleEndian(header + 4, MIXER_RENDER_WAV_HEADER_SIZE - 8 + dataSize, 4);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  mixerRender_writeLittleEndian(header + 16, 16, 4);                                 // fmt chunk size.
+  mixerRender_writeLittleEndian(header + 20, 1, 2);                                  // PCM.
+  mixerRender_writeLittleEndian(header + 22, 1, 2);                                  // Mono.
+  mixerRender_writeLittleEndian(header + 24, MIXER_RENDER_SAMPLE_RATE, 4);
+  mixerRender_writeLittleEndian(header + 28, MIXER_RENDER_SAMPLE_RATE * sizeof(int16_t), 4);  // Bytes per second.
+  mixerRender_writeLittleEndian(header + 32, sizeof(int16_t), 2);                    // Bytes per frame.
+  mixerRender_writeLittleEndian(header + 34, 16, 2);                                 // Bits per sample.
+  memcpy(header + 36, "data", 4);
+  mixerRender_writeLittleEndian(header + 40, dataSize, 4);
+  uint8_t sample[sizeof(int16_t)];
+  bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+  for (uint32_t i = 0; ok && i < sampleCount; i++) {
+    mixerRender_writeLittleEndian(sample, (uint16_t) pcm[i], sizeof(sample));
+    ok = fwrite(sample, 1, sizeof(sample), file) == sizeof(sample);
+  }
+  if (fclose(file) != 0 || !ok) {
+    perror(fileName);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  uint16_t gain = MIXER_GAIN_UNITY;
+  int option;
+  while ((option = getopt(argc, argv, "g:")) != -1) {
+    switch (option) {
+    case 'g': gain = (uint16_t) strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "Usage: %s [-g gain] output.wav\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "Usage: %s [-g gain] output.wav\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for (uint32_t s = 0; s < MIXER_RENDER_SOUND_COUNT; s++) {
+    if (soundPack_find(sounds_pack, sounds[s].packName) == NULL) {
+      fprintf(stderr, "%s is not in the sound pack.\n", sounds[s].packName);
+      return EXIT_FAILURE;
+    }
+  }
+
+  int16_t* pcm = (int16_t*) calloc(MIXER_RENDER_DURATION, sizeof(int16_t));
+  int8_t voiceOf[MIXER_RENDER_SOUND_COUNT];       // Voice each sound last started on.
+  bool cutShort[MIXER_RENDER_SOUND_COUNT] = {false};
+  for (uint32_t s = 0; s < MIXER_RENDER_SOUND_COUNT; s++)
+    voiceOf[s] = MIXER_NO_VOICE;
+
+  // Render a block at a time, as sound_tick() does, starting each sound at the block it falls in.
+  mixer_init();
+  uint32_t next = 0;
+  for (uint32_t position = 0; position < MIXER_RENDER_DURATION; position += MIXER_BLOCK_SIZE) {
+    while (next < MIXER_RENDER_EVENT_COUNT && MIXER_RENDER_MS_TO_SAMPLES(script[next].ms) <= position) {
+      const mixerRender_sound_t* sound = &sounds[script[next].sound];
+      const soundPack_entry_t* entry = soundPack_find(sounds_pack, sound->packName);
+      int8_t voice = mixer_play(sound->soundId, soundPack_data(sounds_pack, entry), entry->sampleCount, gain);
+      // A voice that another sound was still using has been taken over.
+      for (uint32_t s = 0; s < MIXER_RENDER_SOUND_COUNT; s++) {
+        if (s != sound->soundId && voiceOf[s] == voice) {
+          cutShort[s] = true;
+          voiceOf[s] = MIXER_NO_VOICE;
+          printf("%5u ms: %s took over the voice of %s.\n", script[next].ms, sound->name, sounds[s].name);
+        }
+      }
+      voiceOf[sound->soundId] = voice;
+      next++;
+    }
+    // Finished sounds give their voice back.
+    for (uint32_t s = 0; s < MIXER_RENDER_SOUND_COUNT; s++) {
+      if (voiceOf[s] != MIXER_NO_VOICE && !mixer_isVoiceBusy(voiceOf[s]))
+        voiceOf[s] = MIXER_NO_VOICE;
+    }
+    uint32_t count = MIXER_RENDER_DURATION - position < MIXER_BLOCK_SIZE ? MIXER_RENDER_DURATION - position : MIXER_BLOCK_SIZE;
+    mixer_render(pcm + position, count);  // Leaves the rest zero (silence) once every voice is done.
+  }
+
+  int32_t peak = 0;
+  for (uint32_t i = 0; i < MIXER_RENDER_DURATION; i++) {
+    int32_t magnitude = pcm[i] < 0 ? -pcm[i] : pcm[i];
+    if (magnitude > peak)
+      peak = magnitude;
+  }
+  printf("%u samples, peak %d, %u clipped, gain %u/%u.\n", (unsigned) MIXER_RENDER_DURATION, peak,
+      mixer_getClipCount(), gain, MIXER_GAIN_UNITY);
+
+  bool success = mixerRender_writeWav(argv[optind], pcm, MIXER_RENDER_DURATION);
+  if (mixer_getClipCount() != 0)
+    success = false;
+  for (uint32_t s = 0; s < MIXER_RENDER_SOUND_COUNT; s++) {
+    if (sounds[s].mustFinish && cutShort[s]) {
+      printf("%s was cut short.\n", sounds[s].name);
+      success = false;
+    }
+  }
+  free(pcm);
+  printf("mixerRender %s.\n", success ? "passed" : "failed");
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
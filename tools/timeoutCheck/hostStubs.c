@@ -0,0 +1,42 @@
+#include "supportFiles/intervalTimer.h"
+#include "supportFiles/leds.h"
+#include "supportFiles/mio.h"
+#include "supportFiles/utils.h"
+#include "src/390M3T2/trigger.h"
+
+// Host versions of the hardware lockoutTimer.c, hitLedTimer.c and gun.c link against. None of it
+// affects the timing: the LEDs and pins are write-only here, and the trigger inputs the gun reads
+// are driven by timeoutCheck.c.
+
+int leds_init(bool) {
+  return 0;
+}
+
+void leds_write(int) {}
+
+int mio_init(bool) {
+  return 0;
+}
+
+void mio_writePin(u8, u8) {}
+
+void mio_setPinAsOutput(u8) {}
+
+void utils_msDelay(long) {}
+
+// Only the board tests (lockoutTimer_runTest()) time anything with these.
+intervalTimer_status_t intervalTimer_init(uint32_t) {
+  return INTERVAL_TIMER_STATUS_OK;
+}
+
+void intervalTimer_reset(uint32_t) {}
+void intervalTimer_start(uint32_t) {}
+void intervalTimer_stop(uint32_t) {}
+
+double intervalTimer_getTotalDurationInSeconds(uint32_t) {
+  return 0.0;
+}
+
+// The gun only needs these to exist.
+void trigger_init() {}
+void trigger_enable() {}
@@ -0,0 +1,295 @@
+// Host check of the timeouts that moved onto the timer wheel: the lockout, the hit LED, the gun's
+// force and auto reload and the game's respawn delay. The real lockoutTimer.c, hitLedTimer.c, gun.c
+// and game.c run on the real wheel, ticked on the phases of isr.c's tick table, and every expiry is
+// compared, to the 1 kHz tick, with the counter the state machine used before the wheel:
+// - lockoutTimer_tick() and hitLedTimer_tick() noticed start() on their next tick and reset the counter;
+// - the gun and the game reset it on the transition into the timed state;
+// - every tick of the timed state (the entry tick included) incremented it in the action switch;
+// - the next transitions ended the state once it reached the limit (>=), or passed it for the gun's
+//   reloads (reloadTimer > FORCE_RELOAD_TIME, reloadTimer > AUTO_RELOAD_TIME).
+//
+// Build (from the repository root):
+//   g++ -x c++ -I. -Itools/timeoutCheck/stubs -o timeoutCheck tools/timeoutCheck/timeoutCheck.c
+//       tools/timeoutCheck/hostStubs.c src/390M3T2/lockoutTimer.c src/390M3T2/hitLedTimer.c
+//       src/390M5/gun.c src/390M5/game.c src/390_libs/timerWheel.c
+//
+// Prints one line per expiry and returns 0 if all of them matched.
+
+#include <stdio.h>
+#include "src/390M3T2/detector.h"
+#include "src/390M3T2/hitLedTimer.h"
+#include "src/390M3T2/lockoutTimer.h"
+#include "src/390M3T2/transmitter.h"
+#include "src/390M3T2/trigger.h"
+#include "src/390M5/game.h"
+#include "src/390M5/gun.h"
+#include "src/390M5/soundutil.h"
+#include "src/390_libs/timerWheel.h"
+
+#define TIMEOUT_CHECK_INTERRUPTS_PER_TICK TIMER_WHEEL_TICK_RATE_DIVIDER  // 100 kHz interrupts per 1 kHz tick.
+#define TIMEOUT_CHECK_WHEEL_PHASE 3        // Phases of isr.c's tick table.
+#define TIMEOUT_CHECK_GAME_PHASE 23
+#define TIMEOUT_CHECK_GUN_PHASE 33
+#define TIMEOUT_CHECK_OLD_LOCKOUT_PHASE 3  // Phases lockoutTimer_tick() and hitLedTimer_tick() had.
+#define TIMEOUT_CHECK_OLD_HIT_LED_PHASE 13
+
+#define TIMEOUT_CHECK_FORCE_RELOAD_TIME 3000  // Same as gun.c.
+#define TIMEOUT_CHECK_AUTO_RELOAD_TIME 2000   // Same as gun.c.
+#define TIMEOUT_CHECK_RESPAWN_DELAY 5000      // Same as game.c.
+#define TIMEOUT_CHECK_CLIP_SIZE 10            // Shots before the gun auto-reloads (same as gun.c).
+#define TIMEOUT_CHECK_HITS_PER_LIFE 5         // The 5th hit loses a life (see game.c).
+
+#define TIMEOUT_CHECK_SETTLE_TICKS 10      // Lets the state machines leave init_st before a timeout starts.
+#define TIMEOUT_CHECK_SHOT_TICKS 200       // How long the stand-in transmitter runs per shot.
+#define TIMEOUT_CHECK_RESTART_TICKS 100    // A second start() this long after the first, while still timing.
+#define TIMEOUT_CHECK_HIT_GAP_TICKS 700    // Between hits, so each hit LED timeout ends first.
+#define TIMEOUT_CHECK_MAX_TICKS 10000      // Longest a timeout may take to expire.
+#define TIMEOUT_CHECK_NOT_YET 0            // Expiry tick of a timeout that has not expired (ticks start at 1).
+
+// One converted timeout and the old counter it is checked against.
+typedef struct {
+  const char* name;
+  uint32_t limit;             // The old counter's limit.
+  bool strict;                // The old transitions compared with > instead of >=.
+  uint32_t phase;             // Interrupt the old counter was ticked on.
+  bool (*active)();           // True while the converted module is timing (NULL: timeoutCheck_expired() reports).
+  bool wasActive;             // active() at the end of the previous tick.
+  bool pending;               // start() was called and the old tick function has not noticed it yet.
+  bool counting;              // The old state machine is in the timed state.
+  uint32_t counter;           // The old counter.
+  uint32_t oldExpiry;         // Tick the old counter expired on.
+  uint32_t newExpiry;         // Tick the converted module expired on.
+} timeoutCheck_timeout_t;
+
+static bool timeoutCheck_respawning() {
+  return !game_runDetection();
+}
+
+static timeoutCheck_timeout_t timeoutCheck_lockout = {"lockoutTimer", LOCKOUT_TIMER_EXPIRE_VALUE, false,
+    TIMEOUT_CHECK_OLD_LOCKOUT_PHASE, lockoutTimer_running};
+static timeoutCheck_timeout_t timeoutCheck_hitLed = {"hitLedTimer", HIT_LED_TIMER_EXPIRE_VALUE, false,
+    TIMEOUT_CHECK_OLD_HIT_LED_PHASE, hitLedTimer_running};
+static timeoutCheck_timeout_t timeoutCheck_forceReload = {"gun force reload", TIMEOUT_CHECK_FORCE_RELOAD_TIME, true,
+    TIMEOUT_CHECK_GUN_PHASE, NULL};
+static timeoutCheck_timeout_t timeoutCheck_autoReload = {"gun auto reload", TIMEOUT_CHECK_AUTO_RELOAD_TIME, true,
+    TIMEOUT_CHECK_GUN_PHASE, NULL};
+static timeoutCheck_timeout_t timeoutCheck_respawn = {"game respawn", TIMEOUT_CHECK_RESPAWN_DELAY, false,
+    TIMEOUT_CHECK_GAME_PHASE, timeoutCheck_respawning};
+static timeoutCheck_timeout_t* const timeoutCheck_timeouts[] = {&timeoutCheck_lockout, &timeoutCheck_hitLed,
+    &timeoutCheck_forceReload, &timeoutCheck_autoReload, &timeoutCheck_respawn};
+#define TIMEOUT_CHECK_TIMEOUT_COUNT (sizeof(timeoutCheck_timeouts) / sizeof(timeoutCheck_timeouts[0]))
+
+static uint32_t timeoutCheck_tick;                      // 1 kHz ticks since the start (the current one).
+static bool timeoutCheck_success = true;
+static uint32_t timeoutCheck_expiryCount;
+
+// The gun's inputs and the tick the stand-in transmitter stops on.
+static bool timeoutCheck_wantsToShoot;
+static bool timeoutCheck_triggerPressed;
+static uint32_t timeoutCheck_transmitterStopTick;
+static uint32_t timeoutCheck_shotDoneTick;              // Tick the gun saw the transmitter stop (went to shot_st).
+static timeoutCheck_timeout_t* timeoutCheck_gunReload;  // Reload the gun goes into after the last shot (NULL: none).
+
+// The old start(): only noticed by the next tick, and ignored while already timing.
+static void timeoutCheck_oldStart(timeoutCheck_timeout_t* timeout) {
+  if (!timeout->counting)
+    timeout->pending = true;
+}
+
+// The old transition into the timed state: reset the counter.
+static void timeoutCheck_oldEnter(timeoutCheck_timeout_t* timeout) {
+  timeout->pending = false;
+  timeout->counting = true;
+  timeout->counter = 0;
+}
+
+// The old tick: transitions (notice start(), or end the state), then the action (count).
+static void timeoutCheck_oldTick(timeoutCheck_timeout_t* timeout) {
+  if (timeout->pending)
+    timeoutCheck_oldEnter(timeout);
+  if (!timeout->counting)
+    return;
+  if (timeout->strict ? timeout->counter > timeout->limit : timeout->counter >= timeout->limit) {
+    timeout->counting = false;
+    timeout->oldExpiry = timeoutCheck_tick;
+    return;
+  }
+  timeout->counter++;
+}
+
+// Records the tick a timeout without an active() expired on.
+static void timeoutCheck_expired(timeoutCheck_timeout_t* timeout) {
+  if (timeout->newExpiry == TIMEOUT_CHECK_NOT_YET)
+    timeout->newExpiry = timeoutCheck_tick;
+}
+
+// Runs one 1 kHz tick, interrupt by interrupt. action (if not NULL) runs before interrupt actionInterrupt,
+// the way the main loop calls in between interrupts.
+static void timeoutCheck_runTick(void (*action)(), uint32_t actionInterrupt) {
+  timeoutCheck_tick++;
+  for (uint32_t interrupt = 0; interrupt < TIMEOUT_CHECK_INTERRUPTS_PER_TICK; interrupt++) {
+    if (action && interrupt == actionInterrupt)
+      action();
+    if (interrupt == TIMEOUT_CHECK_WHEEL_PHASE)
+      timerWheel_tick();
+    if (interrupt == TIMEOUT_CHECK_GAME_PHASE)
+      game_tick();
+    if (interrupt == TIMEOUT_CHECK_GUN_PHASE) {
+      gun_tick();
+      // shot_st took one tick and reset the counter on its way into the reload state.
+      if (timeoutCheck_gunReload && timeoutCheck_shotDoneTick + 1 == timeoutCheck_tick)
+        timeoutCheck_oldEnter(timeoutCheck_gunReload);
+    }
+    for (uint32_t i = 0; i < TIMEOUT_CHECK_TIMEOUT_COUNT; i++) {
+      if (timeoutCheck_timeouts[i]->phase == interrupt)
+        timeoutCheck_oldTick(timeoutCheck_timeouts[i]);
+    }
+  }
+  for (uint32_t i = 0; i < TIMEOUT_CHECK_TIMEOUT_COUNT; i++) {
+    timeoutCheck_timeout_t* timeout = timeoutCheck_timeouts[i];
+    if (!timeout->active)
+      continue;
+    bool active = timeout->active();
+    if (timeout->wasActive && !active)
+      timeoutCheck_expired(timeout);
+    timeout->wasActive = active;
+  }
+}
+
+static void timeoutCheck_runTicks(uint32_t ticks) {
+  for (uint32_t i = 0; i < ticks; i++)
+    timeoutCheck_runTick(NULL, 0);
+}
+
+// Runs until both the module and the old counter have expired, then compares the two ticks.
+static void timeoutCheck_runUntilExpired(timeoutCheck_timeout_t* timeout) {
+  for (uint32_t i = 0; i < TIMEOUT_CHECK_MAX_TICKS; i++) {
+    if (timeout->oldExpiry != TIMEOUT_CHECK_NOT_YET && timeout->newExpiry != TIMEOUT_CHECK_NOT_YET)
+      break;
+    timeoutCheck_runTick(NULL, 0);
+  }
+  bool match = timeout->oldExpiry != TIMEOUT_CHECK_NOT_YET && timeout->oldExpiry == timeout->newExpiry;
+  printf("%-17s expired on tick %6lu, the old counter on tick %6lu%s\n", timeout->name, (unsigned long) timeout->newExpiry,
+      (unsigned long) timeout->oldExpiry, match ? "" : "  MISMATCH");
+  if (!match)
+    timeoutCheck_success = false;
+  timeoutCheck_expiryCount++;
+  timeout->oldExpiry = timeout->newExpiry = TIMEOUT_CHECK_NOT_YET;
+}
+
+/*********************************** Stand-ins for the gun's inputs ***********************************/
+
+bool trigger_wantsToShoot() {
+  return timeoutCheck_wantsToShoot;
+}
+
+bool trigger_debouncePressed() {
+  return timeoutCheck_triggerPressed;
+}
+
+void trigger_clearWantsToShoot() {
+  timeoutCheck_wantsToShoot = false;
+}
+
+void transmitter_run() {
+  timeoutCheck_transmitterStopTick = timeoutCheck_tick + TIMEOUT_CHECK_SHOT_TICKS;
+}
+
+bool transmitter_running() {
+  if (timeoutCheck_tick < timeoutCheck_transmitterStopTick)
+    return true;
+  timeoutCheck_shotDoneTick = timeoutCheck_tick;
+  return false;
+}
+
+// Every hit comes from player 0 (not the healing channel).
+uint8_t detector_getPlayerNumber() {
+  return 0;
+}
+
+// The sounds mark the transitions: a hit (which starts the hit LED), a lost life (into respawn_st)
+// and the end of a reload.
+void soundutil_play(sound_sounds_t sound) {
+  if (sound == sound_hit_e || sound == sound_low_health_e)
+    timeoutCheck_oldStart(&timeoutCheck_hitLed);
+  else if (sound == sound_loseLife_e)
+    timeoutCheck_oldEnter(&timeoutCheck_respawn);
+  else if (sound == sound_gunReload_e && timeoutCheck_gunReload)
+    timeoutCheck_expired(timeoutCheck_gunReload);
+}
+
+/******************************************** The scenarios ********************************************/
+
+static void timeoutCheck_startLockout() {
+  lockoutTimer_start();
+  timeoutCheck_oldStart(&timeoutCheck_lockout);
+}
+
+static void timeoutCheck_shoot() {
+  timeoutCheck_wantsToShoot = true;
+}
+
+// Starts the lockout on every interrupt around the wheel's phase, then once more while it runs.
+static void timeoutCheck_checkLockout() {
+  static const uint32_t startInterrupts[] = {0, TIMEOUT_CHECK_WHEEL_PHASE - 1, TIMEOUT_CHECK_WHEEL_PHASE,
+      TIMEOUT_CHECK_WHEEL_PHASE + 1, TIMEOUT_CHECK_INTERRUPTS_PER_TICK / 2, TIMEOUT_CHECK_INTERRUPTS_PER_TICK - 1};
+  for (uint32_t i = 0; i < sizeof(startInterrupts) / sizeof(startInterrupts[0]); i++) {
+    timeoutCheck_runTick(timeoutCheck_startLockout, startInterrupts[i]);
+    if (i == 0) {
+      timeoutCheck_runTicks(TIMEOUT_CHECK_RESTART_TICKS);
+      timeoutCheck_runTick(timeoutCheck_startLockout, 0);  // Must not extend the lockout.
+    }
+    timeoutCheck_runUntilExpired(&timeoutCheck_lockout);
+  }
+}
+
+// Hits the player until a life is lost: every hit lights the LED (the second one while it is still on),
+// and the last one starts the respawn delay.
+static void timeoutCheck_checkHitsAndRespawn() {
+  timeoutCheck_runTick(game_setShot, 0);
+  timeoutCheck_runTicks(TIMEOUT_CHECK_RESTART_TICKS);
+  timeoutCheck_runTick(game_setShot, 0);  // Must not extend the LED.
+  timeoutCheck_runUntilExpired(&timeoutCheck_hitLed);
+  for (uint32_t hit = 2; hit < TIMEOUT_CHECK_HITS_PER_LIFE - 1; hit++) {
+    timeoutCheck_runTicks(TIMEOUT_CHECK_HIT_GAP_TICKS);
+    timeoutCheck_runTick(game_setShot, 0);
+    timeoutCheck_runUntilExpired(&timeoutCheck_hitLed);
+  }
+  timeoutCheck_runTicks(TIMEOUT_CHECK_HIT_GAP_TICKS);
+  timeoutCheck_runTick(game_setShot, 0);
+  timeoutCheck_runUntilExpired(&timeoutCheck_respawn);
+}
+
+// Fires one shot and waits for the gun to finish it. reload is the old counter of the reload it goes into.
+static void timeoutCheck_fire(timeoutCheck_timeout_t* reload) {
+  timeoutCheck_gunReload = reload;
+  timeoutCheck_runTick(timeoutCheck_shoot, 0);
+  timeoutCheck_runTicks(TIMEOUT_CHECK_SHOT_TICKS + TIMEOUT_CHECK_SETTLE_TICKS);
+}
+
+// Holds the trigger through a force reload, then empties the clip (releasing the trigger after each shot)
+// for an auto reload.
+static void timeoutCheck_checkReloads() {
+  timeoutCheck_triggerPressed = true;
+  timeoutCheck_fire(&timeoutCheck_forceReload);
+  timeoutCheck_runUntilExpired(&timeoutCheck_forceReload);
+  timeoutCheck_triggerPressed = false;
+  for (uint32_t shot = 1; shot < TIMEOUT_CHECK_CLIP_SIZE; shot++)
+    timeoutCheck_fire(NULL);
+  timeoutCheck_fire(&timeoutCheck_autoReload);
+  timeoutCheck_runUntilExpired(&timeoutCheck_autoReload);
+}
+
+int main() {
+  timerWheel_init();
+  lockoutTimer_init();
+  hitLedTimer_init();
+  gun_init();
+  game_init();
+  timeoutCheck_runTicks(TIMEOUT_CHECK_SETTLE_TICKS);
+  timeoutCheck_checkLockout();
+  timeoutCheck_checkHitsAndRespawn();
+  timeoutCheck_checkReloads();
+  printf("timeoutCheck %s (%lu expiries checked).\n", timeoutCheck_success ? "passed" : "FAILED", (unsigned long) timeoutCheck_expiryCount);
+  return timeoutCheck_success ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <time.h>
+#include "supportFiles/globalTimer.h"
+#include "supportFiles/intervalTimer.h"
+#include "src/390M3T2/transmitter.h"
+#include "src/390M3T2/trigger.h"
+#include "src/390M3T2/sound.h"
+#include "src/390M5/game.h"
+#include "src/390M5/gun.h"
+
+// Host versions of what the receiver path (isr.c, detector.c, lockoutTimer.c) links against besides
+// the DSP code. The replay has no transmitter, trigger, speaker or game: their tick functions do nothing
+// and every detection counts. The timers read the host's monotonic clock.
+
+#define HOST_STUBS_NANOSECONDS_PER_SECOND 1000000000ULL
+
+// Nanoseconds on the host's monotonic clock.
+static uint64_t hostStubs_nanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * HOST_STUBS_NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+// Only the receiver is replayed.
+void transmitter_tick() {}
+void trigger_tick() {}
+void sound_tick() {}
+void game_tick() {}
+void gun_tick() {}
+
+// Always alive, so every hit is reported.
+bool game_runDetection() {
+  return true;
+}
+
+// The global timer counts at its ZYBO rate, so GLOBAL_TIMER_TICKS_PER_SECOND still converts it.
+u64 globalTimer_getTimerValue(void) {
+  return hostStubs_nanoseconds() * (GLOBAL_TIMER_TICKS_PER_SECOND / 1000000) / 1000;
+}
+
+u32 globalTimer_getLowerTimerValue(void) {
+  return (u32) globalTimer_getTimerValue();
+}
+
+void globalTimer_startTimer(bool) {}
+void globalTimer_stopTimer(bool) {}
+
+// One interval timer is enough for lockoutTimer_runTest().
+static uint64_t intervalTimerStart;
+static uint64_t intervalTimerTotal;
+
+intervalTimer_status_t intervalTimer_init(uint32_t) {
+  intervalTimerTotal = 0;
+  return INTERVAL_TIMER_STATUS_OK;
+}
+
+void intervalTimer_reset(uint32_t) {
+  intervalTimerTotal = 0;
+}
+
+void intervalTimer_start(uint32_t) {
+  intervalTimerStart = hostStubs_nanoseconds();
+}
+
+void intervalTimer_stop(uint32_t) {
+  intervalTimerTotal += hostStubs_nanoseconds() - intervalTimerStart;
+}
+
+double intervalTimer_getTotalDurationInSeconds(uint32_t) {
+  return (double) intervalTimerTotal / HOST_STUBS_NANOSECONDS_PER_SECOND;
+}
@@ -0,0 +1,9 @@
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+// Host stand-in for the Xilinx BSP header: the ZYBO values that globalTimer.h builds its constants from.
+
+#define XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ 650000000
+#define XPAR_GLOBAL_TMR_BASEADDR 0xF8F00200
+
+#endif /* XPARAMETERS_H */
@@ -0,0 +1,325 @@
+// Offline replay of a recorded ADC trace through the receiver code as it runs on the board:
+// every sample goes through isr_function() (which buffers it and runs the tick functions, so the
+// lockout timer counts trace time) and detector() drains the buffer in batches, as the main loop does.
+// Nothing is paced: the trace runs as fast as the host allows.
+//
+// Prints each hit with the sample it was detected on, the hit counts and the throughput, and can write
+// the power of every channel for every decimated sample. The hits and counts go to stdout and depend
+// only on the trace and options, so a run can be diffed against a reference run after a DSP change;
+// the throughput goes to stderr.
+//
+// Build (from the repository root):
+//   g++ -x c++ -O2 -I. -Itools/traceReplay/stubs -o traceReplay tools/traceReplay/traceReplay.c
+//       tools/traceReplay/hostStubs.c src/390M3T2/detector.c src/390M3T2/isr.c src/390M3T2/lockoutTimer.c
+//       src/390_libs/filter.c src/390_libs/queue.c src/390_libs/spscRing.c src/390_libs/tickScheduler.c
+//       src/390_libs/timerWheel.c src/390_libs/cfar.c src/390_libs/profiler.c
+//
+// Usage: traceReplay [options] trace
+//   trace     .wav: PCM (8 or 16 bit, first channel), mapped onto the 12-bit ADC range.
+//             anything else: raw little-endian 16-bit words holding 12-bit ADC codes.
+//             Either way the samples are taken to be 100 kHz, the ADC rate.
+//   -b count  samples per detector() call (default 200, 2 ms; the main loop's usual lag).
+//   -s player ignore hits on this player's frequency, as when it is our own.
+//   -f pfa    false-alarm probability of the adaptive threshold (see cfar.h).
+//   -p file   write the channel powers as CSV: sample, seconds, player 0 .. 9. Slow; leave it off for throughput.
+//   -z        print the profiler zones (FIR, IIR bank, detection, ...) after the replay. The zones are only
+//             compiled in with -DPROFILER_DEBUG on the build line above.
+//   -g        write a synthetic trace to the trace file instead (each player shooting once; see below).
+//
+// The synthetic trace is a self-check of the harness: replaying it must report one hit per player, in order.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "src/390M3T2/detector.h"
+#include "src/390M3T2/isr.h"
+#include "src/390M3T2/lockoutTimer.h"
+#include "src/390M3T2/transmitter.h"
+#include "src/390_libs/filter.h"
+#include "src/390_libs/profiler.h"
+#include "supportFiles/interrupts.h"
+#include "supportFiles/globalTimer.h"
+
+#define TRACE_REPLAY_SAMPLE_RATE 100000         // ADC samples per second (the ISR rate).
+#define TRACE_REPLAY_DEFAULT_BATCH 200          // Samples per detector() call.
+#define TRACE_REPLAY_MAX_BATCH 65536            // Must stay under the ADC buffer size in isr.c.
+#define TRACE_REPLAY_ADC_MAX 4095               // Largest 12-bit code.
+#define TRACE_REPLAY_ADC_BITS 12
+#define TRACE_REPLAY_NO_PLAYER -1               // No -s option.
+#define TRACE_REPLAY_NANOSECONDS_PER_SECOND 1e9
+
+// Synthetic trace: noise around mid-scale, then one 200 ms shot per player, a second apart.
+#define TRACE_REPLAY_SYNTH_FIRST_SHOT 50000     // Samples before the first shot (after the noise floors settle).
+#define TRACE_REPLAY_SYNTH_SHOT_SPACING 100000  // Samples from one shot to the next (longer than the lockout).
+#define TRACE_REPLAY_SYNTH_AMPLITUDE 200        // Half the square wave's peak-to-peak, in ADC codes.
+#define TRACE_REPLAY_SYNTH_NOISE 40             // Peak noise, in ADC codes.
+
+// WAV header fields.
+#define TRACE_REPLAY_WAV_PCM 1                  // Format tag of uncompressed PCM.
+#define TRACE_REPLAY_WAV_CHUNK_HEADER 8         // Id and size.
+#define TRACE_REPLAY_WAV_RIFF_HEADER 12         // "RIFF", size, "WAVE".
+
+static uint16_t* trace;                 // The ADC codes being replayed.
+static uint32_t traceLength;            // Number of them.
+static uint32_t replayIndex;            // The sample isr_function() reads next.
+static uint64_t vectorCount;            // Power vectors seen by the observer.
+static uint32_t hitCount;               // Hits reported.
+static FILE* powerFile = NULL;          // -p output, if any.
+
+// The ISR reads the trace instead of the XADC.
+uint32_t interrupts_getAdcData() {
+  return trace[replayIndex];
+}
+
+// Called by the detector with every decimated sample. The game would clear the hit once it had
+// counted it; the replay does it here, so the next shot after the lockout is seen.
+static void traceReplay_observePowerVector(const double power[], bool hit, uint8_t hitPlayer) {
+  // The decimated sample is computed when the last of its FILTER_FIR_DECIMATION_FACTOR inputs arrives.
+  uint64_t sample = (vectorCount + 1) * FILTER_FIR_DECIMATION_FACTOR - 1;
+  vectorCount++;
+
+  if (powerFile != NULL) {
+    fprintf(powerFile, "%llu,%.5f", (unsigned long long) sample, (double) sample / TRACE_REPLAY_SAMPLE_RATE);
+    for (uint8_t player = 0; player < FILTER_FREQUENCY_COUNT; player++)
+      fprintf(powerFile, ",%g", power[player]);
+    fprintf(powerFile, "\n");
+  }
+
+  if (hit) {
+    printf("hit: player %u at sample %llu (%.5f s)\n", hitPlayer, (unsigned long long) sample,
+        (double) sample / TRACE_REPLAY_SAMPLE_RATE);
+    hitCount++;
+    detector_clearHit();
+  }
+}
+
+// Reads a little-endian field.
+static uint32_t traceReplay_readLittleEndian(const uint8_t* bytes, uint32_t size) {
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < size; i++)
+    value |= (uint32_t) bytes[i] << (8 * i);
+  return value;
+}
+
+// Converts the data chunk of a PCM WAV file to ADC codes. Returns false (after printing why) if it can't.
+static bool traceReplay_loadWav(const uint8_t* bytes, uint32_t size) {
+  uint32_t channels = 0, bitsPerSample = 0, sampleRate = 0;
+  const uint8_t* data = NULL;
+  uint32_t dataSize = 0;
+
+  // Walk the chunks for "fmt " and "data".
+  for (uint32_t offset = TRACE_REPLAY_WAV_RIFF_HEADER; offset + TRACE_REPLAY_WAV_CHUNK_HEADER <= size; ) {
+    const uint8_t* chunk = bytes + offset;
+    uint32_t chunkSize = traceReplay_readLittleEndian(chunk + 4, 4);
+    const uint8_t* body = chunk + TRACE_REPLAY_WAV_CHUNK_HEADER;
+    uint32_t available = size - offset - TRACE_REPLAY_WAV_CHUNK_HEADER;
+    if (chunkSize > available)
+      chunkSize = available;  // Truncated recording: use what is there.
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+      if (traceReplay_readLittleEndian(body, 2) != TRACE_REPLAY_WAV_PCM) {
+        fprintf(stderr, "Only PCM WAV files are supported.\n");
+        return false;
+      }
+      channels = traceReplay_readLittleEndian(body + 2, 2);
+      sampleRate = traceReplay_readLittleEndian(body + 4, 4);
+      bitsPerSample = traceReplay_readLittleEndian(body + 14, 2);
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      data = body;
+      dataSize = chunkSize;
+    }
+    offset += TRACE_REPLAY_WAV_CHUNK_HEADER + chunkSize + (chunkSize & 1);  // Chunks are padded to even sizes.
+  }
+
+  if (data == NULL || channels == 0 || (bitsPerSample != 8 && bitsPerSample != 16)) {
+    fprintf(stderr, "Expected an 8 or 16 bit PCM WAV file with fmt and data chunks.\n");
+    return false;
+  }
+  if (sampleRate != TRACE_REPLAY_SAMPLE_RATE)
+    fprintf(stderr, "Warning: the WAV file is %u Hz; replaying it as %u Hz.\n", sampleRate, TRACE_REPLAY_SAMPLE_RATE);
+
+  // Keep the first channel and its top 12 bits, offset like the ADC (mid-scale is 2048).
+  uint32_t frameSize = channels * bitsPerSample / 8;
+  traceLength = dataSize / frameSize;
+  trace = (uint16_t*) malloc((size_t) traceLength * sizeof(uint16_t));
+  for (uint32_t i = 0; i < traceLength; i++) {
+    const uint8_t* frame = data + (size_t) i * frameSize;
+    if (bitsPerSample == 8)
+      trace[i] = frame[0] << (TRACE_REPLAY_ADC_BITS - 8);                         // Unsigned.
+    else
+      trace[i] = (traceReplay_readLittleEndian(frame, 2) ^ 0x8000) >> (16 - TRACE_REPLAY_ADC_BITS);  // Signed.
+  }
+  return true;
+}
+
+// Loads the trace file. Returns false (after printing why) if it can't.
+static bool traceReplay_load(const char* fileName) {
+  FILE* file = fopen(fileName, "rb");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t* bytes = (uint8_t*) malloc(size > 0 ? size : 1);
+  bool ok = fread(bytes, 1, size, file) == (size_t) size;
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "Could not read %s.\n", fileName);
+    free(bytes);
+    return false;
+  }
+
+  if (size >= TRACE_REPLAY_WAV_RIFF_HEADER && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WAVE", 4) == 0) {
+    ok = traceReplay_loadWav(bytes, size);
+  } else {
+    // Raw ADC codes; anything above 12 bits is not from the ADC.
+    traceLength = size / sizeof(uint16_t);
+    trace = (uint16_t*) malloc((size_t) traceLength * sizeof(uint16_t));
+    for (uint32_t i = 0; i < traceLength; i++)
+      trace[i] = traceReplay_readLittleEndian(bytes + 2 * i, 2) & TRACE_REPLAY_ADC_MAX;
+  }
+  free(bytes);
+  return ok;
+}
+
+// Writes the synthetic trace as raw ADC codes: uniform noise around mid-scale, and each player in turn
+// firing one TRANSMITTER_WAVEFORM_WIDTH shot, a square wave with the transmitter's period for that player.
+static bool traceReplay_writeSynthetic(const char* fileName) {
+  FILE* file = fopen(fileName, "wb");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  uint32_t length = TRACE_REPLAY_SYNTH_FIRST_SHOT + FILTER_FREQUENCY_COUNT * TRACE_REPLAY_SYNTH_SHOT_SPACING;
+  uint32_t random = 1;  // Fixed seed: the trace is the same every time.
+  for (uint32_t i = 0; i < length; i++) {
+    random = random * 1664525 + 1013904223;
+    int32_t code = TRACE_REPLAY_ADC_MAX / 2 + 1
+        + (int32_t) (random >> 16) % (2 * TRACE_REPLAY_SYNTH_NOISE + 1) - TRACE_REPLAY_SYNTH_NOISE;
+    if (i >= TRACE_REPLAY_SYNTH_FIRST_SHOT) {
+      uint32_t shotSample = (i - TRACE_REPLAY_SYNTH_FIRST_SHOT) % TRACE_REPLAY_SYNTH_SHOT_SPACING;
+      uint32_t player = (i - TRACE_REPLAY_SYNTH_FIRST_SHOT) / TRACE_REPLAY_SYNTH_SHOT_SPACING;
+      uint32_t period = filter_frequencyTickTable[player];
+      if (shotSample < TRANSMITTER_WAVEFORM_WIDTH)
+        code += shotSample % period < period / 2 ? TRACE_REPLAY_SYNTH_AMPLITUDE : -TRACE_REPLAY_SYNTH_AMPLITUDE;
+    }
+    uint8_t bytes[2] = {(uint8_t) code, (uint8_t) (code >> 8)};
+    fwrite(bytes, 1, sizeof(bytes), file);
+  }
+  fclose(file);
+  printf("Wrote %u samples: player 0 shoots at sample %u, each next player %u samples later.\n",
+      length, TRACE_REPLAY_SYNTH_FIRST_SHOT, TRACE_REPLAY_SYNTH_SHOT_SPACING);
+  return true;
+}
+
+// Seconds on the host's monotonic clock.
+static double traceReplay_seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / TRACE_REPLAY_NANOSECONDS_PER_SECOND;
+}
+
+static void traceReplay_usage(const char* program) {
+  fprintf(stderr, "Usage: %s [-b samplesPerCall] [-s ownPlayer] [-f falseAlarmProbability] [-p powers.csv] [-z] [-g] trace\n",
+      program);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t batch = TRACE_REPLAY_DEFAULT_BATCH;
+  int32_t ownPlayer = TRACE_REPLAY_NO_PLAYER;
+  double falseAlarmProbability = 0;  // 0: leave the detector's default.
+  const char* powerFileName = NULL;
+  bool profile = false;
+  bool synthesize = false;
+
+  int option;
+  while ((option = getopt(argc, argv, "b:s:f:p:zg")) != -1) {
+    switch (option) {
+    case 'b': batch = strtoul(optarg, NULL, 0); break;
+    case 's': ownPlayer = atoi(optarg); break;
+    case 'f': falseAlarmProbability = atof(optarg); break;
+    case 'p': powerFileName = optarg; break;
+    case 'z': profile = true; break;
+    case 'g': synthesize = true; break;
+    default: traceReplay_usage(argv[0]); return EXIT_FAILURE;
+    }
+  }
+  if (optind != argc - 1 || batch == 0 || batch > TRACE_REPLAY_MAX_BATCH
+      || ownPlayer >= FILTER_FREQUENCY_COUNT) {
+    traceReplay_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (synthesize)
+    return traceReplay_writeSynthetic(argv[optind]) ? EXIT_SUCCESS : EXIT_FAILURE;
+  if (!traceReplay_load(argv[optind]))
+    return EXIT_FAILURE;
+  if (powerFileName != NULL) {
+    powerFile = fopen(powerFileName, "w");
+    if (powerFile == NULL) {
+      perror(powerFileName);
+      return EXIT_FAILURE;
+    }
+    fprintf(powerFile, "sample,seconds");
+    for (uint8_t player = 0; player < FILTER_FREQUENCY_COUNT; player++)
+      fprintf(powerFile, ",player%u", player);
+    fprintf(powerFile, "\n");
+  }
+
+  // Same order as runningModes_initAll().
+  if (profile)
+    profiler_init(globalTimer_getTimerValue, GLOBAL_TIMER_TICKS_PER_SECOND);
+  isr_init();
+  lockoutTimer_init();
+  detector_init();
+  if (falseAlarmProbability > 0)
+    detector_setFalseAlarmProbability(falseAlarmProbability);
+  bool ignoreSelf = ownPlayer != TRACE_REPLAY_NO_PLAYER;
+  if (ignoreSelf)
+    detector_setSelfFrequency(ownPlayer);
+  detector_setPowerVectorObserver(traceReplay_observePowerVector);
+
+  // Interrupt by interrupt, with the main loop catching up every batch samples.
+  double start = traceReplay_seconds();
+  uint32_t pending = 0;
+  for (replayIndex = 0; replayIndex < traceLength; replayIndex++) {
+    isr_function();
+    if (++pending == batch) {
+      detector(true, ignoreSelf);
+      pending = 0;
+    }
+  }
+  detector(true, ignoreSelf);
+  double elapsed = traceReplay_seconds() - start;
+
+  if (powerFile != NULL)
+    fclose(powerFile);
+
+  // The deterministic part: compare against a reference run.
+  detector_hitCount_t hitCounts[FILTER_FREQUENCY_COUNT];
+  detector_getHitCounts(hitCounts);
+  printf("%u samples (%.3f s), %llu power vectors, %u hits\n", traceLength,
+      (double) traceLength / TRACE_REPLAY_SAMPLE_RATE, (unsigned long long) vectorCount, hitCount);
+  printf("hit counts:");
+  for (uint8_t player = 0; player < FILTER_FREQUENCY_COUNT; player++)
+    printf(" %u", hitCounts[player]);
+  printf("\n");
+  if (isr_adcBufferOverflowCount() != 0)
+    printf("ADC buffer overflowed: %u samples dropped\n", isr_adcBufferOverflowCount());
+
+  // Throughput includes the ISR side (buffering, tick functions) as well as the detector.
+  fprintf(stderr, "%.3f s: %.0f samples/s, %.1fx real time\n", elapsed, traceLength / elapsed,
+      (double) traceLength / TRACE_REPLAY_SAMPLE_RATE / elapsed);
+  if (profile) {
+#ifdef PROFILER_ENABLE
+    profiler_printReport();
+#else
+    fprintf(stderr, "No profiler zones: build with -DPROFILER_DEBUG.\n");
+#endif
+  }
+
+  free(trace);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+// Decodes every sound in the sound pack the way sound_tick() does (one sample at a time, plus
+// ADPCM_UNSIGNED_OFFSET) and compares it with the original wav2c array in assets/sounds.
+// Fails if a sound is missing or a different length, or its SNR is below SOUND_SNR_TEST_MINIMUM_SNR,
+// e.g. after a change to the decoder or a pack built without -m. Build and run (from the repository root):
+//   g++ -x c++ -O2 -I. -o soundSnrTest tools/wav2adpcm/soundSnrTest.c src/390_libs/adpcm.c
+//       src/390_libs/soundPack.c -x none src/sounds/sounds.S -x c++ assets/sounds/*.wav.c && ./soundSnrTest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "src/390_libs/adpcm.h"
+#include "src/390_libs/soundPack.h"
+#include "src/390M3T2/sound.h"
+#include "assets/sounds/bcfire01_48k.wav.h"
+#include "assets/sounds/gameBoyStartup.wav.h"
+#include "assets/sounds/gameOver48k.wav.h"
+#include "assets/sounds/gunEmpty48k.wav.h"
+#include "assets/sounds/healed.wav.h"
+#include "assets/sounds/healing_fixed.wav.h"
+#include "assets/sounds/low_health.wav.h"
+#include "assets/sounds/ouch48k.wav.h"
+#include "assets/sounds/pacmanDeath.wav.h"
+#include "assets/sounds/powerUp48k.wav.h"
+#include "assets/sounds/screamAndDie48k.wav.h"
+#include "src/sounds/sounds.h"
+
+#define SOUND_SNR_TEST_MINIMUM_SNR 18.0   // dB; the clipped sounds (ouch, gunEmpty) are the lowest, at about 21.
+
+// One original sound, and its name in the pack.
+typedef struct {
+  const char* name;
+  const uint16_t* original;
+  uint32_t originalSampleCount;
+} soundSnrTest_sound_t;
+
+#define SOUND_SNR_TEST_SOUND(wavName, WAV_NAME) {#wavName, wavName##_wav, WAV_NAME##_WAV_NUMBER_OF_SAMPLES}
+
+static const soundSnrTest_sound_t sounds[] = {
+  SOUND_SNR_TEST_SOUND(bcfire01_48k, BCFIRE01_48K),
+  SOUND_SNR_TEST_SOUND(gameBoyStartup, GAMEBOYSTARTUP),
+  SOUND_SNR_TEST_SOUND(gameOver48k, GAMEOVER48K),
+  SOUND_SNR_TEST_SOUND(gunEmpty48k, GUNEMPTY48K),
+  SOUND_SNR_TEST_SOUND(healed, HEALED),
+  SOUND_SNR_TEST_SOUND(healing_fixed, HEALING_FIXED),
+  SOUND_SNR_TEST_SOUND(low_health, LOW_HEALTH),
+  SOUND_SNR_TEST_SOUND(ouch48k, OUCH48K),
+  SOUND_SNR_TEST_SOUND(pacmanDeath, PACMANDEATH),
+  SOUND_SNR_TEST_SOUND(powerUp48k, POWERUP48K),
+  SOUND_SNR_TEST_SOUND(screamAndDie48k, SCREAMANDDIE48K),
+};
+#define SOUND_SNR_TEST_SOUND_COUNT (sizeof(sounds) / sizeof(sounds[0]))
+
+int main() {
+  bool success = true;
+  uint64_t originalBytes = 0, adpcmBytes = 0;
+  if (!soundPack_isValid(sounds_pack, sounds_packEnd - sounds_pack, SOUND_SAMPLE_RATE)) {
+    printf("The sound pack is not valid or not at %d Hz.\n", SOUND_SAMPLE_RATE);
+    return EXIT_FAILURE;
+  }
+  for (uint32_t s = 0; s < SOUND_SNR_TEST_SOUND_COUNT; s++) {
+    const soundSnrTest_sound_t* sound = &sounds[s];
+    const soundPack_entry_t* entry = soundPack_find(sounds_pack, sound->name);
+    if (entry == NULL) {
+      printf("%s is not in the sound pack.\n", sound->name);
+      success = false;
+      continue;
+    }
+    if (entry->sampleCount != sound->originalSampleCount) {
+      printf("%s: %u samples, the original has %u.\n", sound->name, entry->sampleCount, sound->originalSampleCount);
+      success = false;
+      continue;
+    }
+
+    // Both as signed samples, decoded one at a time like sound_tick().
+    int16_t* original = (int16_t*) malloc(sound->originalSampleCount * sizeof(int16_t));
+    int16_t* decoded = (int16_t*) malloc(sound->originalSampleCount * sizeof(int16_t));
+    adpcm_decoder_t decoder;
+    adpcm_decoderInit(&decoder, soundPack_data(sounds_pack, entry), entry->sampleCount);
+    for (uint32_t i = 0; i < sound->originalSampleCount; i++) {
+      uint16_t played = (uint16_t) (adpcm_decodeNext(&decoder) + ADPCM_UNSIGNED_OFFSET);
+      decoded[i] = (int16_t) (played - ADPCM_UNSIGNED_OFFSET);
+      original[i] = (int16_t) (sound->original[i] - ADPCM_UNSIGNED_OFFSET);
+    }
+    double snr = adpcm_snr(original, decoded, sound->originalSampleCount);
+    printf("%-16s %7u samples %7u bytes  SNR %5.1f dB\n", sound->name, sound->originalSampleCount, entry->size, snr);
+    if (snr < SOUND_SNR_TEST_MINIMUM_SNR) {
+      printf("%s: SNR is below %.1f dB.\n", sound->name, SOUND_SNR_TEST_MINIMUM_SNR);
+      success = false;
+    }
+    originalBytes += sound->originalSampleCount * sizeof(uint16_t);
+    adpcmBytes += entry->size;
+    free(original);
+    free(decoded);
+  }
+  printf("%llu bytes of ADPCM for %llu bytes of PCM.\n", (unsigned long long) adpcmBytes, (unsigned long long) originalBytes);
+  printf("soundSnrTest %s.\n", success ? "passed" : "failed");
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,342 @@
+// Converts sounds to IMA-ADPCM (see src/390_libs/adpcm.h), decodes them again and prints their SNR
+// against the input. With -p, all of them go into one sound pack (see src/390_libs/soundPack.h), which
+// is how the game carries its sounds: src/sounds/sounds.S links src/sounds/sounds.pack with .incbin.
+// Without -p, each sound is written as a C asset: <name>.adpcm.c, holding const uint8_t <name>_adpcm[],
+// and <name>.adpcm.h with its sample rate and sample count.
+//
+// The input is either a PCM WAV file (8 or 16 bit; the first channel is kept) or a C array written
+// by wav2c (unsigned 16-bit samples, silence at 32768), which is what the sounds were kept as before.
+//
+// Build and rebuild the pack after changing a sound in assets/sounds (from the repository root):
+//   g++ -x c++ -O2 -I. -o wav2adpcm tools/wav2adpcm/wav2adpcm.c src/390_libs/adpcm.c src/390_libs/soundPack.c
+//   ./wav2adpcm -m 18 -p src/sounds/sounds.pack assets/sounds/*.wav.c
+//
+// Options:
+//   -p pack   write every input into this sound pack (each must be at 48000 Hz, the codec rate).
+//   -o dir    where to write C assets (default: the current directory).
+//   -r rate   sample rate to record in the header for wav2c input (default 48000; WAV files carry their own).
+//   -m snr    fail (and write nothing) if the SNR is below this many dB.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "src/390_libs/adpcm.h"
+#include "src/390_libs/soundPack.h"
+
+#define WAV2ADPCM_DEFAULT_SAMPLE_RATE 48000   // All of the game's sounds: the only rate a pack may hold.
+#define WAV2ADPCM_BYTES_PER_LINE 16
+#define WAV2ADPCM_MAX_PATH 1024
+#define WAV2ADPCM_WAV_PCM 1                   // Format tag of uncompressed PCM.
+#define WAV2ADPCM_WAV_RIFF_HEADER 12          // "RIFF", size, "WAVE".
+#define WAV2ADPCM_WAV_CHUNK_HEADER 8          // Id and size.
+
+static int16_t* pcm;              // The input, signed.
+static uint32_t sampleCount;
+static uint32_t sampleRate;
+static uint32_t defaultSampleRate = WAV2ADPCM_DEFAULT_SAMPLE_RATE;  // For wav2c input.
+
+// One converted sound.
+typedef struct {
+  char name[WAV2ADPCM_MAX_PATH];
+  const char* inputBase;          // Input file name, without its directory.
+  uint8_t* data;                  // ADPCM blocks.
+  uint32_t size;
+  uint32_t sampleCount;
+  uint32_t sampleRate;
+} wav2adpcm_sound_t;
+
+// Reads a little-endian field.
+static uint32_t wav2adpcm_readLittleEndian(const uint8_t* bytes, uint32_t size) {
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < size; i++)
+    value |= (uint32_t) bytes[i] << (8 * i);
+  return value;
+}
+
+// Reads the first channel of a PCM WAV file.
+static bool wav2adpcm_readWav(const uint8_t* bytes, uint32_t size) {
+  uint32_t channels = 0, bitsPerSample = 0;
+  const uint8_t* data = NULL;
+  uint32_t dataSize = 0;
+  for (uint32_t offset = WAV2ADPCM_WAV_RIFF_HEADER; offset + WAV2ADPCM_WAV_CHUNK_HEADER <= size; ) {
+    const uint8_t* chunk = bytes + offset;
+    uint32_t chunkSize = wav2adpcm_readLittleEndian(chunk + 4, 4);
+    const uint8_t* body = chunk + WAV2ADPCM_WAV_CHUNK_HEADER;
+    uint32_t available = size - offset - WAV2ADPCM_WAV_CHUNK_HEADER;
+    if (chunkSize > available)
+      chunkSize = available;
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+      if (wav2adpcm_readLittleEndian(body, 2) != WAV2ADPCM_WAV_PCM) {
+        fprintf(stderr, "Only PCM WAV files are supported.\n");
+        return false;
+      }
+      channels = wav2adpcm_readLittleEndian(body + 2, 2);
+      sampleRate = wav2adpcm_readLittleEndian(body + 4, 4);
+      bitsPerSample = wav2adpcm_readLittleEndian(body + 14, 2);
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      data = body;
+      dataSize = chunkSize;
+    }
+    offset += WAV2ADPCM_WAV_CHUNK_HEADER + chunkSize + (chunkSize & 1);
+  }
+  if (data == NULL || channels == 0 || (bitsPerSample != 8 && bitsPerSample != 16)) {
+    fprintf(stderr, "Expected an 8 or 16 bit PCM WAV file with fmt and data chunks.\n");
+    return false;
+  }
+
+  uint32_t frameSize = channels * bitsPerSample / 8;
+  sampleCount = dataSize / frameSize;
+  pcm = (int16_t*) malloc((size_t) sampleCount * sizeof(int16_t));
+  for (uint32_t i = 0; i < sampleCount; i++) {
+    const uint8_t* frame = data + (size_t) i * frameSize;
+    if (bitsPerSample == 8)
+      pcm[i] = (int16_t) ((frame[0] - 128) << 8);  // 8-bit WAV is unsigned.
+    else
+      pcm[i] = (int16_t) wav2adpcm_readLittleEndian(frame, 2);
+  }
+  return true;
+}
+
+// Reads the numbers between the braces of a wav2c array.
+static bool wav2adpcm_readArray(const char* text) {
+  const char* p = strchr(text, '{');
+  if (p == NULL) {
+    fprintf(stderr, "Expected a WAV file or a C array.\n");
+    return false;
+  }
+  uint32_t capacity = 1024;
+  pcm = (int16_t*) malloc(capacity * sizeof(int16_t));
+  sampleCount = 0;
+  for (p++; *p != '\0' && *p != '}'; ) {
+    if (!isdigit((unsigned char) *p)) {
+      p++;
+      continue;
+    }
+    char* end;
+    long value = strtol(p, &end, 10);
+    p = end;
+    if (sampleCount == capacity) {
+      capacity *= 2;
+      pcm = (int16_t*) realloc(pcm, capacity * sizeof(int16_t));
+    }
+    pcm[sampleCount++] = (int16_t) (value - ADPCM_UNSIGNED_OFFSET);
+  }
+  return sampleCount > 0;
+}
+
+// Loads the input file.
+static bool wav2adpcm_read(const char* fileName) {
+  sampleRate = defaultSampleRate;  // A WAV file replaces it with its own.
+  FILE* file = fopen(fileName, "rb");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t* bytes = (uint8_t*) malloc(size + 1);
+  bool ok = fread(bytes, 1, size, file) == (size_t) size;
+  fclose(file);
+  bytes[size] = '\0';
+  if (ok) {
+    if (size >= WAV2ADPCM_WAV_RIFF_HEADER && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WAVE", 4) == 0)
+      ok = wav2adpcm_readWav(bytes, size);
+    else
+      ok = wav2adpcm_readArray((const char*) bytes);
+  }
+  free(bytes);
+  return ok;
+}
+
+// healed.wav.c -> healed, bcfire01_48k.wav -> bcfire01_48k.
+static void wav2adpcm_assetName(const char* fileName, char* name, uint32_t size) {
+  const char* base = strrchr(fileName, '/');
+  base = base == NULL ? fileName : base + 1;
+  snprintf(name, size, "%s", base);
+  char* extension = strstr(name, ".wav");
+  if (extension != NULL)
+    *extension = '\0';
+  for (char* c = name; *c != '\0'; c++) {
+    if (!isalnum((unsigned char) *c))
+      *c = '_';
+  }
+}
+
+// Converts one input, and checks its SNR. Returns false (and converts nothing) on failure.
+static bool wav2adpcm_convert(const char* inputName, double minimumSnr, wav2adpcm_sound_t* sound) {
+  if (!wav2adpcm_read(inputName))
+    return false;
+
+  uint32_t size = ADPCM_ENCODED_SIZE(sampleCount);
+  uint8_t* data = (uint8_t*) malloc(size);
+  adpcm_encode(pcm, sampleCount, data);
+
+  // Decode it the way sound_tick() will.
+  int16_t* decoded = (int16_t*) malloc((size_t) sampleCount * sizeof(int16_t));
+  adpcm_decoder_t decoder;
+  adpcm_decoderInit(&decoder, data, sampleCount);
+  for (uint32_t i = 0; i < sampleCount; i++)
+    decoded[i] = adpcm_decodeNext(&decoder);
+  double snr = adpcm_snr(pcm, decoded, sampleCount);
+  free(decoded);
+  free(pcm);
+
+  wav2adpcm_assetName(inputName, sound->name, sizeof(sound->name));
+  printf("%s: %u samples, %u bytes (was %u), SNR %.1f dB\n", sound->name, sampleCount, size,
+      (unsigned) (sampleCount * sizeof(int16_t)), snr);
+  if (snr < minimumSnr) {
+    fprintf(stderr, "%s: SNR is below %.1f dB; nothing written.\n", sound->name, minimumSnr);
+    free(data);
+    return false;
+  }
+  const char* inputBase = strrchr(inputName, '/');
+  sound->inputBase = inputBase == NULL ? inputName : inputBase + 1;
+  sound->data = data;
+  sound->size = size;
+  sound->sampleCount = sampleCount;
+  sound->sampleRate = sampleRate;
+  return true;
+}
+
+// Writes <name>.adpcm.c and <name>.adpcm.h.
+static bool wav2adpcm_writeC(const wav2adpcm_sound_t* sound, const char* outputDirectory) {
+  char upperName[WAV2ADPCM_MAX_PATH];
+  for (uint32_t i = 0; i < sizeof(upperName); i++) {
+    upperName[i] = toupper((unsigned char) sound->name[i]);
+    if (sound->name[i] == '\0')
+      break;
+  }
+
+  char path[2 * WAV2ADPCM_MAX_PATH];
+  snprintf(path, sizeof(path), "%s/%s.adpcm.c", outputDirectory, sound->name);
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "// This file was generated by executing this statement: wav2adpcm %s\n", sound->inputBase);
+  fprintf(file, "// IMA-ADPCM, see src/390_libs/adpcm.h.\n\n");
+  fprintf(file, "#include \"%s.adpcm.h\"  // Declares the array extern, so it links as C++ too.\n\n", sound->name);
+  fprintf(file, "const uint8_t %s_adpcm[%u] = {\n", sound->name, sound->size);
+  for (uint32_t i = 0; i < sound->size; i++) {
+    fprintf(file, "0x%02x%s", sound->data[i],
+        i + 1 == sound->size ? "\n" : (i + 1) % WAV2ADPCM_BYTES_PER_LINE == 0 ? ",\n" : ", ");
+  }
+  fprintf(file, "};\n");
+  fclose(file);
+
+  snprintf(path, sizeof(path), "%s/%s.adpcm.h", outputDirectory, sound->name);
+  file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "// This file was generated by executing this statement: wav2adpcm %s\n", sound->inputBase);
+  fprintf(file, "#include <stdint.h>\n");
+  fprintf(file, "extern const uint8_t %s_adpcm[];\n", sound->name);
+  fprintf(file, "#define %s_ADPCM_SAMPLE_RATE %u\n", upperName, sound->sampleRate);
+  fprintf(file, "#define %s_ADPCM_NUMBER_OF_SAMPLES %u\n", upperName, sound->sampleCount);
+  fprintf(file, "#define %s_ADPCM_SIZE %u\n", upperName, sound->size);
+  fclose(file);
+  return true;
+}
+
+// Rounds up to SOUND_PACK_ALIGNMENT.
+static uint32_t wav2adpcm_align(uint32_t offset) {
+  return (offset + SOUND_PACK_ALIGNMENT - 1) / SOUND_PACK_ALIGNMENT * SOUND_PACK_ALIGNMENT;
+}
+
+// Writes every sound into one pack: header, index, then the sounds, each aligned.
+static bool wav2adpcm_writePack(const wav2adpcm_sound_t sounds[], uint32_t count, const char* fileName) {
+  uint32_t size = sizeof(soundPack_header_t) + count * sizeof(soundPack_entry_t);
+  for (uint32_t i = 0; i < count; i++)
+    size = wav2adpcm_align(size) + sounds[i].size;
+  size = wav2adpcm_align(size);
+  uint32_t* words = (uint32_t*) calloc(size / sizeof(uint32_t), sizeof(uint32_t));  // Aligned for soundPack_isValid().
+  uint8_t* pack = (uint8_t*) words;
+
+  soundPack_header_t header = {SOUND_PACK_MAGIC, count};
+  memcpy(pack, &header, sizeof(header));
+  uint32_t offset = sizeof(soundPack_header_t) + count * sizeof(soundPack_entry_t);
+  for (uint32_t i = 0; i < count; i++) {
+    if (strlen(sounds[i].name) >= SOUND_PACK_NAME_SIZE) {
+      fprintf(stderr, "%s: the name is too long for a sound pack (%u characters at most).\n", sounds[i].name,
+          SOUND_PACK_NAME_SIZE - 1);
+      free(words);
+      return false;
+    }
+    if (sounds[i].sampleRate != WAV2ADPCM_DEFAULT_SAMPLE_RATE) {
+      fprintf(stderr, "%s: %u Hz; the game plays every sound in the pack at %u Hz.\n", sounds[i].name,
+          sounds[i].sampleRate, WAV2ADPCM_DEFAULT_SAMPLE_RATE);
+      free(words);
+      return false;
+    }
+    offset = wav2adpcm_align(offset);
+    soundPack_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    strcpy(entry.name, sounds[i].name);
+    entry.offset = offset;
+    entry.size = sounds[i].size;
+    entry.sampleCount = sounds[i].sampleCount;
+    entry.sampleRate = sounds[i].sampleRate;
+    memcpy(pack + sizeof(soundPack_header_t) + i * sizeof(soundPack_entry_t), &entry, sizeof(entry));
+    memcpy(pack + offset, sounds[i].data, sounds[i].size);
+    offset += sounds[i].size;
+  }
+  if (!soundPack_isValid(pack, size, WAV2ADPCM_DEFAULT_SAMPLE_RATE)) {
+    fprintf(stderr, "%s: the pack did not come out valid.\n", fileName);
+    free(words);
+    return false;
+  }
+
+  FILE* file = fopen(fileName, "wb");
+  bool ok = file != NULL && fwrite(pack, 1, size, file) == size;
+  if (file != NULL && fclose(file) != 0)
+    ok = false;
+  if (!ok)
+    perror(fileName);
+  else
+    printf("%s: %u sounds, %u bytes\n", fileName, count, size);
+  free(words);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  const char* outputDirectory = ".";
+  const char* packName = NULL;
+  double minimumSnr = -1;
+  int option;
+  while ((option = getopt(argc, argv, "o:p:r:m:")) != -1) {
+    switch (option) {
+    case 'o': outputDirectory = optarg; break;
+    case 'p': packName = optarg; break;
+    case 'r': defaultSampleRate = strtoul(optarg, NULL, 0); break;
+    case 'm': minimumSnr = atof(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-p pack | -o outputDirectory] [-r sampleRate] [-m minimumSnr] input.wav|input.wav.c...\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind == argc) {
+    fprintf(stderr, "Usage: %s [-p pack | -o outputDirectory] [-r sampleRate] [-m minimumSnr] input.wav|input.wav.c...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t count = argc - optind;
+  wav2adpcm_sound_t* sounds = (wav2adpcm_sound_t*) calloc(count, sizeof(wav2adpcm_sound_t));
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < count; i++) {
+    ok = wav2adpcm_convert(argv[optind + i], minimumSnr, &sounds[i]);
+    if (ok && packName == NULL)
+      ok = wav2adpcm_writeC(&sounds[i], outputDirectory);
+  }
+  if (ok && packName != NULL)
+    ok = wav2adpcm_writePack(sounds, count, packName);
+  for (uint32_t i = 0; i < count; i++)
+    free(sounds[i].data);
+  free(sounds);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}